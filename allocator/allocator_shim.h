@@ -170,6 +170,11 @@ BASE_EXPORT void InitializeAllocatorShim();
 BASE_EXPORT void EnablePartitionAllocMemoryReclaimer();
 
 BASE_EXPORT void ReconfigurePartitionAllocLazyCommit();
+
+// Enables huge pages for the malloc() partitions if
+// features::kPartitionAllocHugePages is enabled. Has to be called after
+// base::FeatureList is initialized.
+BASE_EXPORT void ReconfigurePartitionAllocHugePages();
 #endif
 
 #if BUILDFLAG(USE_BACKUP_REF_PTR)
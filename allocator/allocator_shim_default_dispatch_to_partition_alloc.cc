@@ -14,10 +14,12 @@
 #include "base/allocator/partition_allocator/partition_alloc_check.h"
 #include "base/allocator/partition_allocator/partition_alloc_config.h"
 #include "base/allocator/partition_allocator/partition_alloc_constants.h"
+#include "base/allocator/partition_allocator/partition_alloc_features.h"
 #include "base/allocator/partition_allocator/partition_root.h"
 #include "base/allocator/partition_allocator/partition_stats.h"
 #include "base/bits.h"
 #include "base/compiler_specific.h"
+#include "base/feature_list.h"
 #include "base/memory/nonscannable_memory.h"
 #include "base/no_destructor.h"
 #include "base/numerics/checked_math.h"
@@ -436,6 +438,16 @@ void ReconfigurePartitionAllocLazyCommit() {
   AlignedAllocator()->ConfigureLazyCommit();
 }
 
+void ReconfigurePartitionAllocHugePages() {
+  if (!base::FeatureList::IsEnabled(features::kPartitionAllocHugePages))
+    return;
+  Allocator()->EnableHugePagesIfSupported();
+  auto* original_root = OriginalAllocator();
+  if (original_root)
+    original_root->EnableHugePagesIfSupported();
+  AlignedAllocator()->EnableHugePagesIfSupported();
+}
+
 #if BUILDFLAG(USE_BACKUP_REF_PTR)
 alignas(base::ThreadSafePartitionRoot) uint8_t
     g_allocator_buffer_for_ref_count_config[sizeof(
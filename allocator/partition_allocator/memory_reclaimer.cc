@@ -4,6 +4,9 @@
 
 #include "base/allocator/partition_allocator/memory_reclaimer.h"
 
+#include <algorithm>
+#include <iterator>
+
 #include "base/allocator/partition_allocator/partition_alloc.h"
 #include "base/allocator/partition_allocator/partition_alloc_check.h"
 #include "base/allocator/partition_allocator/partition_alloc_config.h"
@@ -17,6 +20,13 @@ namespace base {
 
 namespace {
 
+// Periodic reclaim typically takes 100us-1ms, see |Start()|. Partitions left
+// over when a reclaim takes longer, e.g. with many partitions or lots of
+// unused system pages to discard, are purged at the next one.
+constexpr TimeDelta kPeriodicReclaimBudget = TimeDelta::FromMilliseconds(1);
+// Under memory pressure, trade more CPU time for memory.
+constexpr int kMemoryPressureBudgetFactor = 4;
+
 template <bool thread_safe>
 void Insert(std::set<PartitionRoot<thread_safe>*>* partitions,
             PartitionRoot<thread_safe>* partition) {
@@ -99,7 +109,7 @@ void PartitionAllocMemoryReclaimer::Start(
   // singleton.
   timer_->Start(
       FROM_HERE, kInterval,
-      BindRepeating(&PartitionAllocMemoryReclaimer::ReclaimPeriodically,
+      BindRepeating(&PartitionAllocMemoryReclaimer::ReclaimFromTimer,
                     Unretained(this)));
 }
 
@@ -110,19 +120,63 @@ void PartitionAllocMemoryReclaimer::ReclaimAll() {
   constexpr int kFlags = PartitionPurgeDecommitEmptySlotSpans |
                          PartitionPurgeDiscardUnusedSystemPages |
                          PartitionPurgeAggressiveReclaim;
-  Reclaim(kFlags);
+  Reclaim(kFlags, TimeDelta::Max());
 }
 
 void PartitionAllocMemoryReclaimer::ReclaimPeriodically() {
-  constexpr int kFlags = PartitionPurgeDecommitEmptySlotSpans |
-                         PartitionPurgeDiscardUnusedSystemPages;
-  Reclaim(kFlags);
+  MemoryPressureListener::MemoryPressureLevel memory_pressure_level;
+  {
+    AutoLock lock(lock_);
+    // Memory pressure monitors keep notifying while the pressure lasts, so
+    // only the notifications since the last reclaim matter.
+    memory_pressure_level = memory_pressure_level_;
+    memory_pressure_level_ = MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE;
+  }
+
+  int flags = PartitionPurgeDecommitEmptySlotSpans |
+              PartitionPurgeDiscardUnusedSystemPages;
+  TimeDelta budget = kPeriodicReclaimBudget;
+  if (memory_pressure_level ==
+      MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE) {
+    flags |= PartitionPurgeKeepWarmSlotSpans;
+  } else {
+    budget *= kMemoryPressureBudgetFactor;
+  }
+  Reclaim(flags, budget);
+}
+
+void PartitionAllocMemoryReclaimer::ReclaimFromTimer() {
+  // Created here rather than in |Start()|, to be on the sequence where
+  // notifications should be delivered.
+  if (!memory_pressure_listener_) {
+    memory_pressure_listener_ = std::make_unique<MemoryPressureListener>(
+        FROM_HERE,
+        BindRepeating(&PartitionAllocMemoryReclaimer::OnMemoryPressure,
+                      Unretained(this)));
+  }
+  ReclaimPeriodically();
 }
 
-void PartitionAllocMemoryReclaimer::Reclaim(int flags) {
+void PartitionAllocMemoryReclaimer::OnMemoryPressure(
+    MemoryPressureListener::MemoryPressureLevel level) {
+  {
+    AutoLock lock(lock_);
+    memory_pressure_level_ = std::max(memory_pressure_level_, level);
+  }
+  // Don't wait for the next periodic reclaim.
+  if (level == MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL)
+    ReclaimAll();
+}
+
+void PartitionAllocMemoryReclaimer::Reclaim(int flags, TimeDelta budget) {
   AutoLock lock(lock_);  // Has to protect from concurrent (Un)Register calls.
   TRACE_EVENT0("base", "PartitionAllocMemoryReclaimer::Reclaim()");
 
+  // Everything below counts against |budget|, though the scan and the thread
+  // cache purge can't be interrupted. Partition purge can, between buckets.
+  const TimeTicks deadline =
+      budget.is_max() ? TimeTicks::Max() : TimeTicks::Now() + budget;
+
   // PCScan quarantines freed slots. Trigger the scan first to let it call
   // FreeNoHooksImmediate on slots that pass the quarantine.
   //
@@ -148,18 +202,42 @@ void PartitionAllocMemoryReclaimer::Reclaim(int flags) {
     internal::ThreadCacheRegistry::Instance().PurgeAll();
 #endif
 
-  for (auto* partition : thread_safe_partitions_)
-    partition->PurgeMemory(flags);
-  for (auto* partition : thread_unsafe_partitions_)
-    partition->PurgeMemory(flags);
+  // Start where the previous reclaim ran out of budget, and always make
+  // progress. A partition left halfway through is resumed first.
+  const size_t num_partitions =
+      thread_safe_partitions_.size() + thread_unsafe_partitions_.size();
+  for (size_t i = 0; i < num_partitions; i++) {
+    size_t index = (next_partition_index_ + i) % num_partitions;
+    bool completed = PurgePartition(index, flags, deadline);
+    if (TimeTicks::Now() >= deadline) {
+      next_partition_index_ = completed ? (index + 1) % num_partitions : index;
+      break;
+    }
+  }
+}
+
+bool PartitionAllocMemoryReclaimer::PurgePartition(size_t index,
+                                                   int flags,
+                                                   TimeTicks deadline) {
+  if (index < thread_safe_partitions_.size()) {
+    return (*std::next(thread_safe_partitions_.begin(), index))
+        ->PurgeMemory(flags, deadline);
+  }
+  index -= thread_safe_partitions_.size();
+  PA_DCHECK(index < thread_unsafe_partitions_.size());
+  return (*std::next(thread_unsafe_partitions_.begin(), index))
+      ->PurgeMemory(flags, deadline);
 }
 
 void PartitionAllocMemoryReclaimer::ResetForTesting() {
   AutoLock lock(lock_);
 
   timer_ = nullptr;
+  memory_pressure_listener_ = nullptr;
   thread_safe_partitions_.clear();
   thread_unsafe_partitions_.clear();
+  memory_pressure_level_ = MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE;
+  next_partition_index_ = 0;
 }
 
 }  // namespace base
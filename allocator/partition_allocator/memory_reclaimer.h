@@ -9,9 +9,11 @@
 #include <set>
 
 #include "base/allocator/partition_allocator/partition_alloc_forward.h"
+#include "base/memory/memory_pressure_listener.h"
 #include "base/no_destructor.h"
 #include "base/sequenced_task_runner.h"
 #include "base/thread_annotations.h"
+#include "base/time/time.h"
 #include "base/timer/timer.h"
 
 namespace base {
@@ -23,6 +25,10 @@ namespace base {
 // context of the provided |SequencedTaskRunner|, meaning that the caller must
 // take care of this runner being compatible with the various partitions.
 //
+// Periodic reclaim has a time budget, and keeps a few empty slot spans
+// committed in the buckets which keep reusing them, unless the system is under
+// memory pressure. Critical memory pressure triggers |ReclaimAll()|.
+//
 // Singleton as this runs as long as the process is alive, and
 // having multiple instances would be wasteful.
 class BASE_EXPORT PartitionAllocMemoryReclaimer {
@@ -45,26 +51,43 @@ class BASE_EXPORT PartitionAllocMemoryReclaimer {
   void Start(scoped_refptr<SequencedTaskRunner> task_runner);
   // Triggers an explicit reclaim now reclaiming all free memory
   void ReclaimAll();
-  // Triggers an explicit reclaim now to reclaim as much free memory as
-  // possible.
+  // Triggers an explicit reclaim now, within a time budget. Partitions which
+  // are not reached are reclaimed first next time.
   void ReclaimPeriodically();
 
  private:
   PartitionAllocMemoryReclaimer();
   ~PartitionAllocMemoryReclaimer();
-  // |flags| is an OR of base::PartitionPurgeFlags
-  void Reclaim(int flags);
+  // |flags| is an OR of base::PartitionPurgeFlags. Stops once the time spent,
+  // including PCScan and thread cache purge, goes over |budget|. Partitions are
+  // only interrupted between buckets, so the budget can be exceeded by one
+  // bucket's worth of purging.
+  void Reclaim(int flags, TimeDelta budget);
   void ReclaimAndReschedule();
+  void ReclaimFromTimer();
+  // Returns false if |deadline| interrupted the purge, see
+  // |PartitionRoot::PurgeMemory()|.
+  bool PurgePartition(size_t index, int flags, TimeTicks deadline)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void OnMemoryPressure(MemoryPressureListener::MemoryPressureLevel level);
   void ResetForTesting();
 
   // Schedules periodic |Reclaim()|.
   std::unique_ptr<RepeatingTimer> timer_;
+  // Created and notified on the sequence of |timer_|.
+  std::unique_ptr<MemoryPressureListener> memory_pressure_listener_;
 
   Lock lock_;
   std::set<PartitionRoot<internal::ThreadSafe>*> thread_safe_partitions_
       GUARDED_BY(lock_);
   std::set<PartitionRoot<internal::NotThreadSafe>*> thread_unsafe_partitions_
       GUARDED_BY(lock_);
+  // Highest memory pressure level notified since the last periodic reclaim.
+  MemoryPressureListener::MemoryPressureLevel memory_pressure_level_
+      GUARDED_BY(lock_) = MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE;
+  // Partitions are indexed in |thread_safe_partitions_| first, then in
+  // |thread_unsafe_partitions_|.
+  size_t next_partition_index_ GUARDED_BY(lock_) = 0;
 
   friend class NoDestructor<PartitionAllocMemoryReclaimer>;
   friend class PartitionAllocMemoryReclaimerTest;
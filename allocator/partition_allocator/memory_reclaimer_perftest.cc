@@ -0,0 +1,103 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/allocator/partition_allocator/partition_alloc.h"
+#include "base/allocator/partition_allocator/partition_root.h"
+#include "base/cxx17_backports.h"
+#include "base/process/process_metrics.h"
+#include "base/time/time.h"
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+// Page fault counts are only available there.
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+
+namespace base {
+namespace {
+
+// Steady allocation load: bursts of allocations of a few sizes, each one
+// spanning several slot spans, all freed before the next burst. Memory is
+// reclaimed between bursts, as a worst case for the periodic reclaim, with the
+// flags it uses with and without memory pressure. The page faults are the
+// ones taken to commit empty slot spans again.
+constexpr TimeDelta kTimeLimit = TimeDelta::FromSeconds(2);
+constexpr size_t kBurstSizes[] = {1024, 2048, 4096, 8192};
+constexpr size_t kAllocationsPerSize = 16;
+
+constexpr char kMetricPrefixMemoryReclaimer[] = "MemoryReclaimer.";
+constexpr char kMetricThroughput[] = "throughput";
+constexpr char kMetricPageFaults[] = "page_faults";
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixMemoryReclaimer,
+                                         story_name);
+  reporter.RegisterImportantMetric(kMetricThroughput, "runs/s");
+  reporter.RegisterImportantMetric(kMetricPageFaults, "count/s");
+  return reporter;
+}
+
+void RunSteadyLoadTest(const std::string& story_name, int purge_flags) {
+  ThreadSafePartitionRoot root{{PartitionOptions::AlignedAlloc::kDisallowed,
+                                PartitionOptions::ThreadCache::kDisabled,
+                                PartitionOptions::Quarantine::kDisallowed,
+                                PartitionOptions::Cookie::kAllowed,
+                                PartitionOptions::BackupRefPtr::kDisabled,
+                                PartitionOptions::UseConfigurablePool::kNo}};
+  std::vector<void*> ptrs;
+  ptrs.reserve(base::size(kBurstSizes) * kAllocationsPerSize);
+
+  auto process_metrics = ProcessMetrics::CreateCurrentProcessMetrics();
+  PageFaultCounts page_faults_before;
+  ASSERT_TRUE(process_metrics->GetPageFaultCounts(&page_faults_before));
+
+  const TimeTicks start = TimeTicks::Now();
+  TimeTicks now;
+  size_t runs = 0;
+  do {
+    for (size_t size : kBurstSizes) {
+      for (size_t i = 0; i < kAllocationsPerSize; i++)
+        ptrs.push_back(root.Alloc(size, ""));
+    }
+    for (void* ptr : ptrs)
+      root.Free(ptr);
+    ptrs.clear();
+    root.PurgeMemory(purge_flags);
+
+    ++runs;
+    now = TimeTicks::Now();
+  } while (now - start < kTimeLimit);
+
+  PageFaultCounts page_faults_after;
+  ASSERT_TRUE(process_metrics->GetPageFaultCounts(&page_faults_after));
+
+  const double seconds = (now - start).InSecondsF();
+  auto reporter = SetUpReporter(story_name);
+  reporter.AddResult(kMetricThroughput, runs / seconds);
+  reporter.AddResult(
+      kMetricPageFaults,
+      (page_faults_after.minor - page_faults_before.minor) / seconds);
+}
+
+}  // namespace
+
+TEST(PartitionAllocMemoryReclaimerPerfTest, SteadyLoad) {
+  RunSteadyLoadTest("SteadyLoad", PartitionPurgeDecommitEmptySlotSpans |
+                                      PartitionPurgeDiscardUnusedSystemPages);
+}
+
+TEST(PartitionAllocMemoryReclaimerPerfTest, SteadyLoadKeepWarmSlotSpans) {
+  RunSteadyLoadTest("SteadyLoadKeepWarmSlotSpans",
+                    PartitionPurgeDecommitEmptySlotSpans |
+                        PartitionPurgeDiscardUnusedSystemPages |
+                        PartitionPurgeKeepWarmSlotSpans);
+}
+
+}  // namespace base
+
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
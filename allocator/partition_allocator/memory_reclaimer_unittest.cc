@@ -45,13 +45,18 @@ class PartitionAllocMemoryReclaimerTest : public ::testing::Test {
   void SetUp() override {
     PartitionAllocGlobalInit(HandleOOM);
     PartitionAllocMemoryReclaimer::Instance()->ResetForTesting();
-    allocator_ = std::make_unique<PartitionAllocator>();
-    allocator_->init({PartitionOptions::AlignedAlloc::kDisallowed,
-                      PartitionOptions::ThreadCache::kDisabled,
-                      PartitionOptions::Quarantine::kAllowed,
-                      PartitionOptions::Cookie::kAllowed,
-                      PartitionOptions::BackupRefPtr::kDisabled,
-                      PartitionOptions::UseConfigurablePool::kNo});
+    allocator_ = CreateAllocator();
+  }
+
+  static std::unique_ptr<PartitionAllocator> CreateAllocator() {
+    auto allocator = std::make_unique<PartitionAllocator>();
+    allocator->init({PartitionOptions::AlignedAlloc::kDisallowed,
+                     PartitionOptions::ThreadCache::kDisabled,
+                     PartitionOptions::Quarantine::kAllowed,
+                     PartitionOptions::Cookie::kAllowed,
+                     PartitionOptions::BackupRefPtr::kDisabled,
+                     PartitionOptions::UseConfigurablePool::kNo});
+    return allocator;
   }
 
   void TearDown() override {
@@ -71,6 +76,20 @@ class PartitionAllocMemoryReclaimerTest : public ::testing::Test {
     allocator_->root()->Free(data);
   }
 
+  void NotifyMemoryPressure(MemoryPressureListener::MemoryPressureLevel level) {
+    PartitionAllocMemoryReclaimer::Instance()->OnMemoryPressure(level);
+  }
+
+  void Reclaim(int flags, TimeDelta budget) {
+    PartitionAllocMemoryReclaimer::Instance()->Reclaim(flags, budget);
+  }
+
+  size_t NextPartitionIndex() {
+    auto* memory_reclaimer = PartitionAllocMemoryReclaimer::Instance();
+    AutoLock lock(memory_reclaimer->lock_);
+    return memory_reclaimer->next_partition_index_;
+  }
+
   test::TaskEnvironment task_environment_;
   std::unique_ptr<PartitionAllocator> allocator_;
 };
@@ -119,6 +138,64 @@ TEST_F(PartitionAllocMemoryReclaimerTest, DISABLED_Reclaim) {
   }
 }
 
+TEST_F(PartitionAllocMemoryReclaimerTest, KeepWarmSlotSpans) {
+  PartitionRoot<internal::ThreadSafe>* root = allocator_->root();
+  auto* memory_reclaimer = PartitionAllocMemoryReclaimer::Instance();
+
+  // The slot span is decommitted, as it was never reused.
+  AllocateAndFree();
+  size_t committed_before = root->get_total_size_of_committed_pages();
+  memory_reclaimer->ReclaimPeriodically();
+  EXPECT_LT(root->get_total_size_of_committed_pages(), committed_before);
+
+  // Now it was, and is kept committed.
+  AllocateAndFree();
+  committed_before = root->get_total_size_of_committed_pages();
+  memory_reclaimer->ReclaimPeriodically();
+  EXPECT_EQ(committed_before, root->get_total_size_of_committed_pages());
+
+  // Unless there is memory pressure.
+  AllocateAndFree();
+  committed_before = root->get_total_size_of_committed_pages();
+  NotifyMemoryPressure(MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE);
+  memory_reclaimer->ReclaimPeriodically();
+  EXPECT_LT(root->get_total_size_of_committed_pages(), committed_before);
+}
+
+TEST_F(PartitionAllocMemoryReclaimerTest, CriticalMemoryPressure) {
+  PartitionRoot<internal::ThreadSafe>* root = allocator_->root();
+
+  AllocateAndFree();
+  size_t committed_before = root->get_total_size_of_committed_pages();
+  NotifyMemoryPressure(MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL);
+  EXPECT_LT(root->get_total_size_of_committed_pages(), committed_before);
+}
+
+TEST_F(PartitionAllocMemoryReclaimerTest, RoundRobinWithinBudget) {
+  std::unique_ptr<PartitionAllocator> other_allocator = CreateAllocator();
+  EXPECT_EQ(0u, NextPartitionIndex());
+
+  // With no budget left, each reclaim purges a single partition, and the next
+  // one starts with the following partition.
+  Reclaim(PartitionPurgeDecommitEmptySlotSpans, TimeDelta());
+  EXPECT_EQ(1u, NextPartitionIndex());
+
+  // A partition interrupted between buckets is resumed first.
+  Reclaim(PartitionPurgeDiscardUnusedSystemPages, TimeDelta());
+  EXPECT_EQ(1u, NextPartitionIndex());
+
+  // Wraps around.
+  Reclaim(PartitionPurgeDecommitEmptySlotSpans, TimeDelta());
+  EXPECT_EQ(0u, NextPartitionIndex());
+
+  // Without a budget, all partitions are purged, and the next reclaim starts
+  // from the same one.
+  Reclaim(PartitionPurgeDecommitEmptySlotSpans |
+              PartitionPurgeDiscardUnusedSystemPages,
+          TimeDelta::Max());
+  EXPECT_EQ(0u, NextPartitionIndex());
+}
+
 // ThreadCache tests disabled when USE_BACKUP_REF_PTR is enabled, because the
 // "original" PartitionRoot has ThreadCache disabled.
 #if BUILDFLAG(USE_PARTITION_ALLOC_AS_MALLOC) && \
@@ -6,6 +6,7 @@
 
 #include <limits.h>
 
+#include <algorithm>
 #include <atomic>
 
 #include "base/allocator/partition_allocator/address_space_randomization.h"
@@ -301,6 +302,26 @@ void DiscardSystemPages(void* address, size_t length) {
   DiscardSystemPagesInternal(address, length);
 }
 
+bool AdviseHugePages(void* address, size_t length) {
+  PA_DCHECK(!(reinterpret_cast<uintptr_t>(address) & SystemPageOffsetMask()));
+  PA_DCHECK(!(length & SystemPageOffsetMask()));
+  return AdviseHugePagesInternal(address, length);
+}
+
+void AdviseNoHugePages(void* address, size_t length) {
+  PA_DCHECK(!(reinterpret_cast<uintptr_t>(address) & SystemPageOffsetMask()));
+  PA_DCHECK(!(length & SystemPageOffsetMask()));
+  AdviseNoHugePagesInternal(address, length);
+}
+
+size_t GetHugePageBackedSize(const uintptr_t* region_starts,
+                             size_t region_count,
+                             size_t region_length) {
+  PA_DCHECK(std::is_sorted(region_starts, region_starts + region_count));
+  return GetHugePageBackedSizeInternal(region_starts, region_count,
+                                       region_length);
+}
+
 bool ReserveAddressSpace(size_t size) {
   // To avoid deadlock, call only SystemAllocPages.
   internal::PartitionAutoLock guard(GetReserveLock());
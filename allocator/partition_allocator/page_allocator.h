@@ -229,6 +229,33 @@ BASE_EXPORT bool TryRecommitSystemPages(
 // based on the original page content, or a page of zeroes.
 BASE_EXPORT void DiscardSystemPages(void* address, size_t length);
 
+// Advises the system to back the pages starting at |address| and continuing
+// for |length| bytes with transparent huge pages. The hint itself doesn't
+// commit memory, but once the system forms a huge page (e.g. khugepaged on
+// Linux), all of it is backed, including the pages which were never written
+// to. To be eligible, a huge page-aligned range must be within the region, and
+// have the same permissions throughout.
+//
+// Discarding or decommitting part of a huge page splits it, see
+// |AdviseNoHugePages()|.
+//
+// Returns false if the system doesn't support transparent huge pages.
+BASE_EXPORT bool AdviseHugePages(void* address, size_t length);
+
+// Reverts |AdviseHugePages()|. The region will not be backed by new
+// transparent huge pages, even if they are enabled for all memory on the
+// system. Must only be called after a successful call to |AdviseHugePages()|.
+BASE_EXPORT void AdviseNoHugePages(void* address, size_t length);
+
+// Returns how many bytes are backed by transparent huge pages in the
+// |region_count| regions of |region_length| bytes starting at
+// |region_starts|, which must be sorted and not overlap. Reads
+// /proc/self/smaps, hence it is slow, and not precise when a mapping is only
+// partially covered by the regions. Returns 0 where this isn't supported.
+BASE_EXPORT size_t GetHugePageBackedSize(const uintptr_t* region_starts,
+                                         size_t region_count,
+                                         size_t region_length);
+
 // Rounds up |address| to the next multiple of |SystemPageSize()|. Returns
 // 0 for an |address| of 0.
 PAGE_ALLOCATOR_CONSTANTS_DECLARE_CONSTEXPR ALWAYS_INLINE uintptr_t
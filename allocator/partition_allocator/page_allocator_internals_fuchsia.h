@@ -232,6 +232,18 @@ bool TryRecommitSystemPagesInternal(
   return true;
 }
 
+bool AdviseHugePagesInternal(void* address, size_t length) {
+  return false;
+}
+
+void AdviseNoHugePagesInternal(void* address, size_t length) {}
+
+size_t GetHugePageBackedSizeInternal(const uintptr_t* region_starts,
+                                     size_t region_count,
+                                     size_t region_length) {
+  return 0;
+}
+
 }  // namespace base
 
 #endif  // BASE_ALLOCATOR_PARTITION_ALLOCATOR_PAGE_ALLOCATOR_INTERNALS_FUCHSIA_H_
@@ -31,6 +31,11 @@
 #if defined(OS_LINUX) || defined(OS_CHROMEOS)
 #include <sys/resource.h>
 #endif
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
 
 #include "base/allocator/partition_allocator/page_allocator.h"
 
@@ -133,6 +138,30 @@ bool UseMapJit() {
 }
 #endif  // defined(OS_MAC)
 
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+// Returns how many bytes of [start, end) are covered by the regions, see
+// GetHugePageBackedSize().
+size_t OverlapWithRegions(uintptr_t start,
+                          uintptr_t end,
+                          const uintptr_t* region_starts,
+                          size_t region_count,
+                          size_t region_length) {
+  const uintptr_t* const regions_end = region_starts + region_count;
+  // First region which ends after |start|.
+  const uintptr_t* region =
+      start < region_length
+          ? region_starts
+          : std::upper_bound(region_starts, regions_end, start - region_length);
+  size_t overlap = 0;
+  for (; region != regions_end && *region < end; ++region) {
+    uintptr_t overlap_start = std::max(start, *region);
+    uintptr_t overlap_end = std::min(end, *region + region_length);
+    overlap += overlap_end - overlap_start;
+  }
+  return overlap;
+}
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+
 }  // namespace
 
 // |mmap| uses a nearby address if the hint address is blocked.
@@ -357,6 +386,90 @@ void DiscardSystemPagesInternal(void* address, size_t length) {
 #endif
 }
 
+bool AdviseHugePagesInternal(void* address, size_t length) {
+#if defined(MADV_HUGEPAGE)
+  // Fails with EINVAL when the kernel doesn't support transparent huge pages.
+  return 0 == madvise(address, length, MADV_HUGEPAGE);
+#else
+  return false;
+#endif
+}
+
+void AdviseNoHugePagesInternal(void* address, size_t length) {
+#if defined(MADV_NOHUGEPAGE)
+  PA_PCHECK(0 == madvise(address, length, MADV_NOHUGEPAGE));
+#endif
+}
+
+size_t GetHugePageBackedSizeInternal(const uintptr_t* region_starts,
+                                     size_t region_count,
+                                     size_t region_length) {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+  if (!region_count)
+    return 0;
+  int fd = HANDLE_EINTR(open("/proc/self/smaps", O_RDONLY | O_CLOEXEC));
+  if (fd < 0)
+    return 0;
+
+  // Must not allocate, as this can be called from within malloc(). Lines which
+  // don't fit in |line| are truncated, which only affects file paths.
+  char buffer[4096];
+  char line[128];
+  size_t line_length = 0;
+  // Current mapping, and how much of it is covered by the regions.
+  uintptr_t mapping_start = 0;
+  uintptr_t mapping_end = 0;
+  size_t overlap = 0;
+  size_t huge_page_backed_size = 0;
+
+  ssize_t bytes_read;
+  while ((bytes_read = HANDLE_EINTR(read(fd, buffer, sizeof(buffer)))) > 0) {
+    for (ssize_t i = 0; i < bytes_read; i++) {
+      if (buffer[i] != '\n') {
+        if (line_length < sizeof(line) - 1)
+          line[line_length++] = buffer[i];
+        continue;
+      }
+      line[line_length] = '\0';
+      line_length = 0;
+
+      // A mapping starts with "<start>-<end> <permissions> ...", in lowercase
+      // hexadecimal, and is followed by its "<Field>: <value>" lines.
+      constexpr char kAnonHugePages[] = "AnonHugePages:";
+      if (!strncmp(line, kAnonHugePages, sizeof(kAnonHugePages) - 1)) {
+        if (!overlap)
+          continue;
+        size_t backed_size =
+            strtoull(line + sizeof(kAnonHugePages) - 1, nullptr, 10) * 1024;
+        // Assume that huge pages are spread evenly across the mapping when it
+        // is only partially covered.
+        size_t mapping_size = mapping_end - mapping_start;
+        if (overlap < mapping_size) {
+          backed_size = static_cast<size_t>(static_cast<double>(backed_size) *
+                                            overlap / mapping_size);
+        }
+        huge_page_backed_size += backed_size;
+      } else if ((line[0] >= '0' && line[0] <= '9') ||
+                 (line[0] >= 'a' && line[0] <= 'f')) {
+        char* separator;
+        mapping_start = strtoull(line, &separator, 16);
+        mapping_end =
+            *separator == '-' ? strtoull(separator + 1, nullptr, 16) : 0;
+        overlap = mapping_end > mapping_start
+                      ? OverlapWithRegions(mapping_start, mapping_end,
+                                           region_starts, region_count,
+                                           region_length)
+                      : 0;
+      }
+    }
+  }
+  IGNORE_EINTR(close(fd));
+  return huge_page_backed_size;
+#else
+  return 0;
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+}
+
 }  // namespace base
 
 #endif  // BASE_ALLOCATOR_PARTITION_ALLOCATOR_PAGE_ALLOCATOR_INTERNALS_POSIX_H_
@@ -54,6 +54,14 @@ const base::FeatureParam<BackupRefPtrEnabledProcesses>
 const Feature kPartitionAllocLazyCommit{"PartitionAllocLazyCommit",
                                         FEATURE_ENABLED_BY_DEFAULT};
 
+// If enabled, densely used super pages are backed by transparent huge pages,
+// where supported. See PartitionRoot::EnableHugePagesIfSupported().
+// This removes the guard pages of these super pages, including the ones which
+// protect PartitionAlloc's metadata from linear overflows. Don't enable it
+// without consulting the security team.
+const Feature kPartitionAllocHugePages{"PartitionAllocHugePages",
+                                       FEATURE_DISABLED_BY_DEFAULT};
+
 // If enabled, switches PCScan scheduling to a mutator-aware scheduler. Does not
 // affect whether PCScan is enabled itself.
 const Feature kPartitionAllocPCScanMUAwareScheduler{
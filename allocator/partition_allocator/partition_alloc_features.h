@@ -44,6 +44,7 @@ extern const BASE_EXPORT Feature kPartitionAllocPCScanImmediateFreeing;
 extern const BASE_EXPORT Feature kPartitionAllocPCScanEagerClearing;
 
 extern const BASE_EXPORT Feature kPartitionAllocLazyCommit;
+extern const BASE_EXPORT Feature kPartitionAllocHugePages;
 
 }  // namespace features
 }  // namespace base
@@ -13,8 +13,13 @@
 #include "base/allocator/partition_allocator/thread_cache.h"
 #include "base/bind.h"
 #include "base/callback.h"
+#include "base/containers/circular_deque.h"
+#include "base/cxx17_backports.h"
 #include "base/logging.h"
 #include "base/strings/stringprintf.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
 #include "base/threading/platform_thread.h"
 #include "base/time/time.h"
 #include "base/timer/lap_timer.h"
@@ -45,6 +50,22 @@ constexpr int kMultiBucketIncrement = 13;
 // Final size is 24 + (13 * 22) = 310 bytes.
 constexpr int kMultiBucketRounds = 22;
 
+// Mostly small objects, with some 1-4KiB ones, which are not cached by the
+// thread cache by default. Allocated in bursts which are larger than the
+// default limits of the thread cache buckets.
+constexpr size_t kMixedSizes[] = {16,  32,  48,  64,   96,   128,
+                                  256, 512, 1024, 2048, 3072, 4096};
+constexpr size_t kMixedBurstSize = 256;
+// The thread cache adapts its sizes at each periodic purge.
+constexpr base::TimeDelta kPeriodicPurgeInterval =
+    base::TimeDelta::FromMilliseconds(250);
+
+// Objects are handed from producer to consumer threads in chunks. Bounds the
+// number of chunks in flight, to keep memory usage in check when producers are
+// faster than consumers.
+constexpr size_t kProducerConsumerChunkSize = 1024;
+constexpr size_t kMaxPendingChunks = 16;
+
 constexpr char kMetricPrefixMemoryAllocation[] = "MemoryAllocation.";
 constexpr char kMetricThroughput[] = "throughput";
 constexpr char kMetricTimePerAllocation[] = "time_per_allocation";
@@ -60,7 +81,9 @@ perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
 enum class AllocatorType {
   kSystem,
   kPartitionAlloc,
-  kPartitionAllocWithThreadCache
+  kPartitionAllocWithThreadCache,
+  kPartitionAllocWithAdaptiveThreadCache,
+  kPartitionAllocWithBatchedFree
 };
 
 class Allocator {
@@ -102,7 +125,7 @@ class PartitionAllocator : public Allocator {
 ThreadSafePartitionRoot* g_partition_root = nullptr;
 class PartitionAllocatorWithThreadCache : public Allocator {
  public:
-  PartitionAllocatorWithThreadCache() {
+  PartitionAllocatorWithThreadCache(bool adaptive_sizing, bool batched_free) {
     if (!g_partition_root) {
       g_partition_root = new ThreadSafePartitionRoot(
           {PartitionOptions::AlignedAlloc::kDisallowed,
@@ -113,8 +136,14 @@ class PartitionAllocatorWithThreadCache : public Allocator {
            PartitionOptions::UseConfigurablePool::kNo});
     }
     internal::ThreadCacheRegistry::Instance().PurgeAll();
+    internal::ThreadCacheRegistry::Instance().SetAdaptiveSizingEnabled(
+        adaptive_sizing);
+    internal::ThreadCache::SetFreeBatchingEnabled(batched_free);
+  }
+  ~PartitionAllocatorWithThreadCache() override {
+    internal::ThreadCacheRegistry::Instance().SetAdaptiveSizingEnabled(false);
+    internal::ThreadCache::SetFreeBatchingEnabled(false);
   }
-  ~PartitionAllocatorWithThreadCache() override = default;
 
   void* Alloc(size_t size) override {
     return g_partition_root->AllocFlagsNoHooks(0, size, PartitionPageSize());
@@ -284,6 +313,126 @@ float MultiBucketWithFree(Allocator* allocator) {
   return timer.LapsPerSecond() * kMultiBucketRounds;
 }
 
+float MixedSizesWithFree(Allocator* allocator) {
+  std::vector<void*> elems(kMixedBurstSize);
+  size_t size_index = 0;
+
+  LapTimer timer(kWarmupRuns, kTimeLimit, kTimeCheckInterval);
+  do {
+    for (void*& elem : elems) {
+      elem = allocator->Alloc(kMixedSizes[size_index]);
+      CHECK_NE(elem, nullptr);
+      size_index = (size_index + 1) % base::size(kMixedSizes);
+    }
+    for (void* elem : elems)
+      allocator->Free(elem);
+    timer.NextLap();
+  } while (!timer.HasTimeLimitExpired());
+
+  return timer.LapsPerSecond() * kMixedBurstSize;
+}
+
+// Stands in for the periodic purge of the thread cache, which requires a task
+// runner.
+float PeriodicPurge(Allocator* allocator) {
+  auto& registry = internal::ThreadCacheRegistry::Instance();
+  LapTimer timer(0, kTimeLimit, 1);
+  do {
+    PlatformThread::Sleep(kPeriodicPurgeInterval);
+    registry.AdaptThreadCacheSizes(kPeriodicPurgeInterval);
+    registry.PurgeAll();
+    timer.NextLap();
+  } while (!timer.HasTimeLimitExpired());
+
+  return timer.LapsPerSecond();
+}
+
+// Hands chunks of allocated objects from a producer thread to a consumer
+// thread.
+class ProducerConsumerQueue {
+ public:
+  using Chunk = std::vector<void*>;
+
+  ProducerConsumerQueue() = default;
+  ProducerConsumerQueue(const ProducerConsumerQueue&) = delete;
+  ProducerConsumerQueue& operator=(const ProducerConsumerQueue&) = delete;
+
+  // Blocks while too many chunks are pending.
+  void Push(Chunk chunk) {
+    AutoLock auto_lock(lock_);
+    while (chunks_.size() >= kMaxPendingChunks)
+      not_full_.Wait();
+    chunks_.push_back(std::move(chunk));
+    not_empty_.Signal();
+  }
+
+  // Blocks until a chunk is available, or the queue is closed and empty, in
+  // which case this returns false.
+  bool Pop(Chunk* chunk) {
+    AutoLock auto_lock(lock_);
+    while (chunks_.empty() && !closed_)
+      not_empty_.Wait();
+    if (chunks_.empty())
+      return false;
+    *chunk = std::move(chunks_.front());
+    chunks_.pop_front();
+    not_full_.Signal();
+    return true;
+  }
+
+  void Close() {
+    AutoLock auto_lock(lock_);
+    closed_ = true;
+    not_empty_.Signal();
+  }
+
+ private:
+  Lock lock_;
+  ConditionVariable not_empty_{&lock_};
+  ConditionVariable not_full_{&lock_};
+  base::circular_deque<Chunk> chunks_ GUARDED_BY(lock_);
+  bool closed_ GUARDED_BY(lock_) = false;
+};
+
+float Producer(Allocator* allocator, ProducerConsumerQueue* queue) {
+  size_t size_index = 0;
+
+  LapTimer timer(0, kTimeLimit, 1);
+  do {
+    ProducerConsumerQueue::Chunk chunk(kProducerConsumerChunkSize);
+    for (void*& elem : chunk) {
+      elem = allocator->Alloc(kMixedSizes[size_index]);
+      CHECK_NE(elem, nullptr);
+      size_index = (size_index + 1) % base::size(kMixedSizes);
+    }
+    queue->Push(std::move(chunk));
+    timer.NextLap();
+  } while (!timer.HasTimeLimitExpired());
+  queue->Close();
+
+  return timer.LapsPerSecond() * kProducerConsumerChunkSize;
+}
+
+// All the objects freed here were allocated by another thread. Only the time
+// spent freeing is measured, not the time spent waiting for the producer.
+float Consumer(Allocator* allocator, ProducerConsumerQueue* queue) {
+  // Make sure that this thread has a thread cache, if the allocator uses one.
+  allocator->Free(allocator->Alloc(kAllocSize));
+
+  size_t free_count = 0;
+  TimeDelta free_time;
+  ProducerConsumerQueue::Chunk chunk;
+  while (queue->Pop(&chunk)) {
+    TimeTicks start = TimeTicks::Now();
+    for (void* elem : chunk)
+      allocator->Free(elem);
+    free_time += TimeTicks::Now() - start;
+    free_count += chunk.size();
+  }
+
+  return free_count / free_time.InSecondsF();
+}
+
 float DirectMapped(Allocator* allocator) {
   constexpr size_t kSize = 2 * 1000 * 1000;
 
@@ -305,7 +454,29 @@ std::unique_ptr<Allocator> CreateAllocator(AllocatorType type) {
     case AllocatorType::kPartitionAlloc:
       return std::make_unique<PartitionAllocator>();
     case AllocatorType::kPartitionAllocWithThreadCache:
-      return std::make_unique<PartitionAllocatorWithThreadCache>();
+      return std::make_unique<PartitionAllocatorWithThreadCache>(
+          /*adaptive_sizing=*/false, /*batched_free=*/false);
+    case AllocatorType::kPartitionAllocWithAdaptiveThreadCache:
+      return std::make_unique<PartitionAllocatorWithThreadCache>(
+          /*adaptive_sizing=*/true, /*batched_free=*/false);
+    case AllocatorType::kPartitionAllocWithBatchedFree:
+      return std::make_unique<PartitionAllocatorWithThreadCache>(
+          /*adaptive_sizing=*/false, /*batched_free=*/true);
+  }
+}
+
+const char* AllocatorTypeName(AllocatorType type) {
+  switch (type) {
+    case AllocatorType::kSystem:
+      return "System";
+    case AllocatorType::kPartitionAlloc:
+      return "PartitionAlloc";
+    case AllocatorType::kPartitionAllocWithThreadCache:
+      return "PartitionAllocWithThreadCache";
+    case AllocatorType::kPartitionAllocWithAdaptiveThreadCache:
+      return "PartitionAllocWithAdaptiveThreadCache";
+    case AllocatorType::kPartitionAllocWithBatchedFree:
+      return "PartitionAllocWithBatchedFree";
   }
 }
 
@@ -348,22 +519,9 @@ void RunTest(int thread_count,
   if (noisy_neighbor_thread)
     noisy_neighbor_thread->Run();
 
-  char const* alloc_type_str;
-  switch (alloc_type) {
-    case AllocatorType::kSystem:
-      alloc_type_str = "System";
-      break;
-    case AllocatorType::kPartitionAlloc:
-      alloc_type_str = "PartitionAlloc";
-      break;
-    case AllocatorType::kPartitionAllocWithThreadCache:
-      alloc_type_str = "PartitionAllocWithThreadCache";
-      break;
-  }
-
-  std::string name =
-      base::StringPrintf("%s%s_%s_%d", kMetricPrefixMemoryAllocation,
-                         story_base_name, alloc_type_str, thread_count);
+  std::string name = base::StringPrintf(
+      "%s%s_%s_%d", kMetricPrefixMemoryAllocation, story_base_name,
+      AllocatorTypeName(alloc_type), thread_count);
 
   DisplayResults(name + "_total", total_laps_per_second);
   DisplayResults(name + "_worst", min_laps_per_second);
@@ -371,6 +529,41 @@ void RunTest(int thread_count,
              min_laps_per_second);
 }
 
+// Each consumer thread frees the objects allocated by its producer thread.
+// Reports the free throughput of the consumers.
+void RunProducerConsumerTest(int pair_count, AllocatorType alloc_type) {
+  auto alloc = CreateAllocator(alloc_type);
+
+  std::vector<std::unique_ptr<ProducerConsumerQueue>> queues;
+  std::vector<std::unique_ptr<TestLoopThread>> producers;
+  std::vector<std::unique_ptr<TestLoopThread>> consumers;
+  for (int i = 0; i < pair_count; ++i) {
+    queues.push_back(std::make_unique<ProducerConsumerQueue>());
+    consumers.push_back(std::make_unique<TestLoopThread>(BindOnce(
+        Consumer, Unretained(alloc.get()), Unretained(queues.back().get()))));
+    producers.push_back(std::make_unique<TestLoopThread>(BindOnce(
+        Producer, Unretained(alloc.get()), Unretained(queues.back().get()))));
+  }
+
+  uint64_t total_frees_per_second = 0;
+  uint64_t min_frees_per_second = std::numeric_limits<uint64_t>::max();
+  for (int i = 0; i < pair_count; ++i) {
+    producers[i]->Run();
+    uint64_t frees_per_second = consumers[i]->Run();
+    min_frees_per_second = std::min(frees_per_second, min_frees_per_second);
+    total_frees_per_second += frees_per_second;
+  }
+
+  std::string name = base::StringPrintf(
+      "%sProducerConsumer_%s_%d", kMetricPrefixMemoryAllocation,
+      AllocatorTypeName(alloc_type), pair_count);
+
+  DisplayResults(name + "_total", total_frees_per_second);
+  DisplayResults(name + "_worst", min_frees_per_second);
+  LogResults(pair_count, alloc_type, total_frees_per_second,
+             min_frees_per_second);
+}
+
 class PartitionAllocMemoryAllocationPerfTest
     : public testing::TestWithParam<std::tuple<int, AllocatorType>> {};
 
@@ -434,6 +627,56 @@ TEST_P(PartitionAllocMemoryAllocationPerfTest,
 }
 #endif  // !defined(MEMORY_CONSTRAINED)
 
+// Compares the thread cache with and without adaptive sizing on a mixed size
+// workload, with a periodic purge running on another thread.
+class PartitionAllocMixedSizesPerfTest
+    : public testing::TestWithParam<std::tuple<int, AllocatorType>> {};
+
+INSTANTIATE_TEST_SUITE_P(
+    ,
+    PartitionAllocMixedSizesPerfTest,
+    ::testing::Combine(
+        ::testing::Values(1, 2, 4, 8),
+        ::testing::Values(AllocatorType::kSystem,
+                          AllocatorType::kPartitionAlloc
+#if !BUILDFLAG(USE_PARTITION_ALLOC_AS_MALLOC)
+                          ,
+                          AllocatorType::kPartitionAllocWithThreadCache,
+                          AllocatorType::kPartitionAllocWithAdaptiveThreadCache
+#endif
+                          )));
+
+TEST_P(PartitionAllocMixedSizesPerfTest, MixedSizesWithFree) {
+  auto params = GetParam();
+  RunTest(std::get<0>(params), std::get<1>(params), MixedSizesWithFree,
+          PeriodicPurge, "MixedSizesWithFree");
+}
+
+// Objects allocated on one thread and freed on another one. Frees of objects
+// which are not cached by the thread cache go to the central allocator, unless
+// they are batched.
+class PartitionAllocProducerConsumerPerfTest
+    : public testing::TestWithParam<std::tuple<int, AllocatorType>> {};
+
+INSTANTIATE_TEST_SUITE_P(
+    ,
+    PartitionAllocProducerConsumerPerfTest,
+    ::testing::Combine(
+        ::testing::Values(1, 2, 4),
+        ::testing::Values(AllocatorType::kSystem,
+                          AllocatorType::kPartitionAlloc
+#if !BUILDFLAG(USE_PARTITION_ALLOC_AS_MALLOC)
+                          ,
+                          AllocatorType::kPartitionAllocWithThreadCache,
+                          AllocatorType::kPartitionAllocWithBatchedFree
+#endif
+                          )));
+
+TEST_P(PartitionAllocProducerConsumerPerfTest, ProducerConsumer) {
+  auto params = GetParam();
+  RunProducerConsumerTest(std::get<0>(params), std::get<1>(params));
+}
+
 }  // namespace
 
 }  // namespace base
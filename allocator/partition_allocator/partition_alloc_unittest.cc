@@ -420,6 +420,11 @@ class MockPartitionStatsDumper : public PartitionStatsDumper {
     EXPECT_EQ(total_active_bytes, stats->total_active_bytes);
     EXPECT_EQ(total_decommittable_bytes, stats->total_decommittable_bytes);
     EXPECT_EQ(total_discardable_bytes, stats->total_discardable_bytes);
+    EXPECT_EQ(0u, stats->total_huge_page_advised_bytes % kSuperPageSize);
+    EXPECT_LE(stats->total_huge_page_backed_bytes,
+              stats->total_huge_page_advised_bytes);
+    huge_page_advised_bytes_ = stats->total_huge_page_advised_bytes;
+    committed_bytes_ = stats->total_committed_bytes;
   }
 
   void PartitionsDumpBucketStats(
@@ -447,12 +452,18 @@ class MockPartitionStatsDumper : public PartitionStatsDumper {
     return nullptr;
   }
 
+  size_t huge_page_advised_bytes() const { return huge_page_advised_bytes_; }
+  size_t committed_bytes() const { return committed_bytes_; }
+
  private:
   size_t total_resident_bytes = 0;
   size_t total_active_bytes = 0;
   size_t total_decommittable_bytes = 0;
   size_t total_discardable_bytes = 0;
 
+  size_t huge_page_advised_bytes_ = 0;
+  size_t committed_bytes_ = 0;
+
   std::vector<PartitionBucketMemoryStats> bucket_stats;
 };
 
@@ -2246,6 +2257,41 @@ TEST_F(PartitionAllocTest, Purge) {
   CHECK_PAGE_IN_CORE(big_ptr - kPointerOffset, false);
 }
 
+// Tests that empty slot spans are kept committed in buckets which recently
+// reused some, with PartitionPurgeKeepWarmSlotSpans.
+TEST_F(PartitionAllocTest, PurgeKeepWarmSlotSpans) {
+  constexpr int kFlags =
+      PartitionPurgeDecommitEmptySlotSpans | PartitionPurgeKeepWarmSlotSpans;
+  void* ptr = allocator.root()->Alloc(2048 - kExtraAllocSize, type_name);
+  SlotSpan* slot_span = SlotSpan::FromSlotStartPtr(
+      allocator.root()->AdjustPointerForExtrasSubtract(ptr));
+  allocator.root()->Free(ptr);
+  EXPECT_TRUE(slot_span->is_empty());
+
+  // No reuse yet, nothing to keep warm.
+  allocator.root()->PurgeMemory(kFlags);
+  EXPECT_TRUE(slot_span->is_decommitted());
+
+  // Reusing the decommitted slot span makes the bucket warm.
+  ptr = allocator.root()->Alloc(2048 - kExtraAllocSize, type_name);
+  EXPECT_EQ(slot_span,
+            SlotSpan::FromSlotStartPtr(
+                allocator.root()->AdjustPointerForExtrasSubtract(ptr)));
+  allocator.root()->Free(ptr);
+  allocator.root()->PurgeMemory(kFlags);
+  EXPECT_TRUE(slot_span->is_empty());
+
+  // Until it cools down.
+  allocator.root()->PurgeMemory(kFlags);
+  EXPECT_TRUE(slot_span->is_decommitted());
+
+  // Regular purging doesn't keep anything.
+  ptr = allocator.root()->Alloc(2048 - kExtraAllocSize, type_name);
+  allocator.root()->Free(ptr);
+  allocator.root()->PurgeMemory(PartitionPurgeDecommitEmptySlotSpans);
+  EXPECT_TRUE(slot_span->is_decommitted());
+}
+
 // Tests that we prefer to allocate into a non-empty partition page over an
 // empty one. This is an important aspect of minimizing memory usage for some
 // allocation sizes, particularly larger ones.
@@ -2580,6 +2626,82 @@ TEST_F(PartitionAllocTest, PurgeDiscardableDoubleTruncateFreeList) {
   allocator.root()->Free(ptr2);
 }
 
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+// Tests that a densely used super page gets backed by huge pages, keeps its
+// empty slot spans committed while it is, and goes back to regular pages once
+// sparsely used.
+TEST_F(PartitionAllocTest, HugePages) {
+  allocator.root()->EnableHugePagesIfSupported();
+
+  // Allocate more than a super page, so that the first one gets retired.
+  const size_t size = SystemPageSize() - kExtraAllocSize;
+  const size_t count = (kSuperPageSize + kSuperPageSize / 2) / SystemPageSize();
+  std::vector<void*> ptrs;
+  for (size_t i = 0; i < count; ++i)
+    ptrs.push_back(allocator.root()->Alloc(size, type_name));
+
+  auto slot_span_of = [this](void* ptr) {
+    return SlotSpan::FromSlotStartPtr(
+        allocator.root()->AdjustPointerForExtrasSubtract(ptr));
+  };
+  SlotSpan* slot_span = slot_span_of(ptrs[0]);
+  auto* extent = slot_span->ToSuperPageExtent();
+  if (!extent->uses_huge_pages) {
+    for (void* ptr : ptrs)
+      allocator.root()->Free(ptr);
+    GTEST_SKIP() << "Transparent huge pages are not supported.";
+  }
+  {
+    MockPartitionStatsDumper dumper;
+    allocator.root()->DumpStats("mock_allocator", false /* detailed dump */,
+                                &dumper);
+    EXPECT_EQ(kSuperPageSize, dumper.huge_page_advised_bytes());
+    // The metadata and the guard partition pages of the advised super page
+    // count as committed, since the huge page backs them too.
+    size_t extra_committed_bytes =
+        dumper.committed_bytes() -
+        allocator.root()->get_total_size_of_committed_pages();
+    EXPECT_GE(extra_committed_bytes, 2 * PartitionPageSize());
+    EXPECT_LE(extra_committed_bytes, kSuperPageSize);
+  }
+
+  // An empty slot span is not decommitted while the super page is backed by
+  // huge pages.
+  for (void*& ptr : ptrs) {
+    if (slot_span_of(ptr) == slot_span) {
+      allocator.root()->Free(ptr);
+      ptr = nullptr;
+    }
+  }
+  allocator.root()->PurgeMemory(PartitionPurgeDecommitEmptySlotSpans);
+  EXPECT_TRUE(extent->uses_huge_pages);
+  EXPECT_TRUE(slot_span->is_empty());
+
+  // Once all of it is free, the super page goes back to regular pages, and its
+  // empty slot spans are decommitted.
+  for (void*& ptr : ptrs) {
+    if (ptr && slot_span_of(ptr)->ToSuperPageExtent() == extent) {
+      allocator.root()->Free(ptr);
+      ptr = nullptr;
+    }
+  }
+  allocator.root()->PurgeMemory(PartitionPurgeDecommitEmptySlotSpans);
+  EXPECT_FALSE(extent->uses_huge_pages);
+  EXPECT_TRUE(slot_span->is_decommitted());
+  {
+    MockPartitionStatsDumper dumper;
+    allocator.root()->DumpStats("mock_allocator", true /* detailed dump */,
+                                &dumper);
+    EXPECT_EQ(0u, dumper.huge_page_advised_bytes());
+  }
+
+  for (void* ptr : ptrs) {
+    if (ptr)
+      allocator.root()->Free(ptr);
+  }
+}
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS)
+
 TEST_F(PartitionAllocTest, ReallocMovesCookie) {
   // Resize so as to be sure to hit a "resize in place" case, and ensure that
   // use of the entire result is compatible with the debug mode's cookie, even
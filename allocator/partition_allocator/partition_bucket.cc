@@ -477,6 +477,7 @@ void PartitionBucket<thread_safe>::Init(uint32_t new_slot_size) {
   decommitted_slot_spans_head = nullptr;
   num_full_slot_spans = 0;
   num_system_pages_per_slot_span = ComputeSystemPagesPerSlotSpan(slot_size);
+  num_empty_slot_span_reuses = 0;
 }
 
 template <bool thread_safe>
@@ -506,11 +507,20 @@ PartitionBucket<thread_safe>::AllocNewSlotSpan(PartitionRoot<thread_safe>* root,
       bits::AlignUp(root->next_partition_page, slot_span_alignment);
   if (UNLIKELY(adjusted_next_partition_page + slot_span_reservation_size >
                root->next_partition_page_end)) {
+    char* previous_super_page =
+        root->next_partition_page_end
+            ? bits::AlignDown(root->next_partition_page_end,
+                              kSuperPageAlignment)
+            : nullptr;
     // In this case, we can no longer hand out pages from the current super page
     // allocation. Get a new super page.
     if (!AllocNewSuperPage(root, flags)) {
       return nullptr;
     }
+    // The previous super page won't get new slot spans anymore, it may now be
+    // worth backing with a huge page.
+    if (root->use_huge_pages && previous_super_page)
+      root->UpdateHugePagesForSuperPage(previous_super_page);
     // AllocNewSuperPage() updates root->next_partition_page, re-query.
     adjusted_next_partition_page =
         bits::AlignUp(root->next_partition_page, slot_span_alignment);
@@ -532,6 +542,7 @@ PartitionBucket<thread_safe>::AllocNewSlotSpan(PartitionRoot<thread_safe>* root,
   void* slot_span_start = adjusted_next_partition_page;
   auto* slot_span = &gap_end_page->slot_span_metadata;
   InitializeSlotSpan(slot_span);
+  ++slot_span->ToSuperPageExtent()->number_of_slot_spans;
   // Now that slot span is initialized, it's safe to call FromSlotStartPtr.
   PA_DCHECK(slot_span ==
             SlotSpanMetadata<thread_safe>::FromSlotStartPtr(slot_span_start));
@@ -648,6 +659,8 @@ ALWAYS_INLINE void* PartitionBucket<thread_safe>::AllocNewSuperPage(
   latest_extent->number_of_consecutive_super_pages = 0;
   latest_extent->next = nullptr;
   latest_extent->number_of_nonempty_slot_spans = 0;
+  latest_extent->number_of_slot_spans = 0;
+  latest_extent->uses_huge_pages = false;
 
   PartitionSuperPageExtentEntry<thread_safe>* current_extent =
       root->current_extent;
@@ -904,6 +917,7 @@ void* PartitionBucket<thread_safe>::SlowPathAlloc(
                                           SystemPageSize());
         PA_DCHECK(root->empty_slot_spans_dirty_bytes >= dirty_size);
         root->empty_slot_spans_dirty_bytes -= dirty_size;
+        ++num_empty_slot_span_reuses;
 
         break;
       }
@@ -921,6 +935,7 @@ void* PartitionBucket<thread_safe>::SlowPathAlloc(
       PA_DCHECK(new_slot_span->bucket == this);
       PA_DCHECK(new_slot_span->is_decommitted());
       decommitted_slot_spans_head = new_slot_span->next_slot_span;
+      ++num_empty_slot_span_reuses;
 
       // If lazy commit is enabled, pages will be recommitted when provisioning
       // slots, in ProvisionMoreSlotsAndAllocOne(), not here.
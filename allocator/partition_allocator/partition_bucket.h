@@ -48,6 +48,12 @@ struct PartitionBucket {
       "GetSlotOffset may produce an incorrect result when kMaxBucketed is too "
       "large.");
 
+  // Number of times an empty or decommitted slot span was reused since the
+  // last decommit of empty slot spans, decayed at each of them. Tells how much
+  // this bucket would benefit from keeping empty slot spans committed, see
+  // PartitionPurgeKeepWarmSlotSpans.
+  uint32_t num_empty_slot_span_reuses;
+
   // Public API.
   void Init(uint32_t new_slot_size);
 
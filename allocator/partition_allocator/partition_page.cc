@@ -229,7 +229,10 @@ void SlotSpanMetadata<thread_safe>::DecommitIfPossible(
   PA_DCHECK(static_cast<unsigned>(empty_cache_index) < kMaxFreeableSpans);
   PA_DCHECK(this == root->global_empty_slot_span_ring[empty_cache_index]);
   empty_cache_index = -1;
-  if (is_empty())
+  // Decommitting part of a huge page splits it. The slot span is decommitted
+  // once the super page is no longer backed by a huge page, see
+  // PartitionRoot::UpdateHugePagesForSuperPage().
+  if (is_empty() && !ToSuperPageExtent()->uses_huge_pages)
     Decommit(root);
 }
 
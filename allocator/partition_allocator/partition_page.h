@@ -40,7 +40,14 @@ struct PartitionSuperPageExtentEntry {
   PartitionRoot<thread_safe>* root;
   PartitionSuperPageExtentEntry<thread_safe>* next;
   uint16_t number_of_consecutive_super_pages;
+  // The fields below describe the super page which holds this entry, not the
+  // whole extent.
   uint16_t number_of_nonempty_slot_spans;
+  // Number of slot spans carved out of the super page so far.
+  uint16_t number_of_slot_spans;
+  // Whether the super page is advised to be backed by a transparent huge page,
+  // see PartitionRoot::EnableHugePagesIfSupported().
+  bool uses_huge_pages;
 
   ALWAYS_INLINE void IncrementNumberOfNonemptySlotSpans();
   ALWAYS_INLINE void DecrementNumberOfNonemptySlotSpans();
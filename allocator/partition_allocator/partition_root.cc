@@ -4,6 +4,8 @@
 
 #include "base/allocator/partition_allocator/partition_root.h"
 
+#include <algorithm>
+
 #include "base/allocator/buildflags.h"
 #include "base/allocator/partition_allocator/address_pool_manager_bitmap.h"
 #include "base/allocator/partition_allocator/oom.h"
@@ -153,6 +155,29 @@ void PartitionAllocMallocHookOnAfterForkInChild() {
 
 namespace internal {
 
+// A super page is backed by a huge page once at least 1 / kHugePageHotRatio of
+// its slot spans are in use, and stops being so when less than
+// 1 / kHugePageColdRatio of them are, so as not to flip-flop.
+constexpr uint16_t kHugePageHotRatio = 2;
+constexpr uint16_t kHugePageColdRatio = 4;
+
+// Returns how much of |slot_span| is counted in total_size_of_committed_pages.
+template <bool thread_safe>
+size_t GetCommittedSize(SlotSpanMetadata<thread_safe>* slot_span,
+                        bool use_lazy_commit) {
+  if (slot_span->is_decommitted())
+    return 0;
+  // If lazy commit is enabled, only provisioned slots are committed.
+  if (use_lazy_commit)
+    return bits::AlignUp(slot_span->GetProvisionedSize(), SystemPageSize());
+  return slot_span->bucket->get_bytes_per_span();
+}
+
+// With PartitionPurgeKeepWarmSlotSpans, a bucket keeps one empty slot span
+// committed per recent reuse, up to this many. The empty slot span ring is
+// small, so this only matters for a handful of buckets at a time.
+constexpr uint32_t kMaxWarmSlotSpansPerBucket = 2;
+
 template <bool thread_safe>
 static size_t PartitionPurgeSlotSpan(
     internal::SlotSpanMetadata<thread_safe>* slot_span,
@@ -333,6 +358,9 @@ static void PartitionPurgeBucket(
       PA_DCHECK(
           slot_span !=
           internal::SlotSpanMetadata<thread_safe>::get_sentinel_slot_span());
+      // Discarding part of a huge page splits it.
+      if (slot_span->ToSuperPageExtent()->uses_huge_pages)
+        continue;
       PartitionPurgeSlotSpan(slot_span, true);
     }
   }
@@ -485,14 +513,45 @@ template <bool thread_safe>
 }
 
 template <bool thread_safe>
-void PartitionRoot<thread_safe>::DecommitEmptySlotSpans() {
+void PartitionRoot<thread_safe>::DecommitEmptySlotSpans(
+    bool keep_warm_slot_spans) {
+  uint8_t num_warm_slot_spans[kNumBuckets] = {};
   for (SlotSpan*& slot_span : global_empty_slot_span_ring) {
-    if (slot_span)
-      slot_span->DecommitIfPossible(this);
+    if (!slot_span)
+      continue;
+    if (keep_warm_slot_spans && slot_span->is_empty()) {
+      size_t index = slot_span->bucket - buckets;
+      PA_DCHECK(index < kNumBuckets);
+      if (num_warm_slot_spans[index] <
+          std::min(slot_span->bucket->num_empty_slot_span_reuses,
+                   internal::kMaxWarmSlotSpansPerBucket)) {
+        // Stays in the ring, and may be decommitted when it leaves it.
+        ++num_warm_slot_spans[index];
+        continue;
+      }
+    }
+    slot_span->DecommitIfPossible(this);
     slot_span = nullptr;
   }
-  // Just decommitted everything, and holding the lock, should be exactly 0.
-  PA_DCHECK(empty_slot_spans_dirty_bytes == 0);
+  // Reuses are only a good predictor of future ones for a few purge cycles.
+  for (Bucket& bucket : buckets)
+    bucket.num_empty_slot_span_reuses /= 2;
+  // Just decommitted everything, and holding the lock, should be exactly 0,
+  // unless empty slot spans are kept committed in huge pages, or kept warm.
+  PA_DCHECK(use_huge_pages || keep_warm_slot_spans ||
+            empty_slot_spans_dirty_bytes == 0);
+}
+
+template <bool thread_safe>
+void PartitionRoot<thread_safe>::UpdateHugePages() {
+  for (auto* super_page_extent = first_extent; super_page_extent;
+       super_page_extent = super_page_extent->next) {
+    for (char *super_page = SuperPagesBeginFromExtent(super_page_extent),
+              *super_page_end = SuperPagesEndFromExtent(super_page_extent);
+         super_page != super_page_end; super_page += kSuperPageSize) {
+      UpdateHugePagesForSuperPage(super_page);
+    }
+  }
 }
 
 template <bool thread_safe>
@@ -693,6 +752,123 @@ void PartitionRoot<thread_safe>::ConfigureLazyCommit() {
 #endif  // defined(OS_WIN)
 }
 
+template <bool thread_safe>
+void PartitionRoot<thread_safe>::EnableHugePagesIfSupported() {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  // Transparent huge pages are as large as a super page only with 4kiB system
+  // pages.
+  static_assert(kSuperPageSize == 2 * 1024 * 1024, "");
+  if (SystemPageSize() != 4096)
+    return;
+  ScopedGuard guard{lock_};
+  use_huge_pages = true;
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS)
+}
+
+template <bool thread_safe>
+void PartitionRoot<thread_safe>::UpdateHugePagesForSuperPage(char* super_page) {
+  auto* extent = internal::PartitionSuperPageToExtent<thread_safe>(super_page);
+  const size_t num_slot_spans = extent->number_of_slot_spans;
+  const size_t num_nonempty_slot_spans = extent->number_of_nonempty_slot_spans;
+
+  if (!extent->uses_huge_pages) {
+    // Slot spans can still be added to the current super page.
+    bool is_current =
+        internal::SuperPagePayloadEnd(super_page) == next_partition_page_end;
+    if (!use_huge_pages || is_current ||
+        num_nonempty_slot_spans * internal::kHugePageHotRatio < num_slot_spans)
+      return;
+
+    // A huge page can only be formed from pages with the same permissions.
+    // This gives up on the guard pages, and makes the whole super page
+    // accessible. When the system forms the huge page (e.g. khugepaged on
+    // Linux), it backs all of it, including what PartitionAlloc never
+    // committed, so DumpStats() counts advised super pages as fully
+    // committed.
+    internal::ScopedSyscallTimer<thread_safe> timer{this};
+    SetSystemPagesAccess(super_page, kSuperPageSize, PageReadWrite);
+    if (AdviseHugePages(super_page, kSuperPageSize)) {
+      extent->uses_huge_pages = true;
+      return;
+    }
+    // Not supported by the kernel, don't try again.
+    use_huge_pages = false;
+  } else {
+    if (num_nonempty_slot_spans * internal::kHugePageColdRatio >=
+        num_slot_spans)
+      return;
+    {
+      internal::ScopedSyscallTimer<thread_safe> timer{this};
+      AdviseNoHugePages(super_page, kSuperPageSize);
+    }
+    extent->uses_huge_pages = false;
+
+    // Now that the huge page can be split, decommit the empty slot spans which
+    // were kept around for it. The ones which are still in the empty slot
+    // span ring are decommitted when they leave it.
+    //
+    // The huge page may also have backed memory which PartitionAlloc doesn't
+    // count as committed. Release it: decommitted slot spans keep their
+    // permissions, as in SlotSpanMetadata::Decommit(), and what was never
+    // committed becomes inaccessible again.
+    auto release_uncommitted = [this](char* begin, char* end) {
+      if (begin >= end)
+        return;
+      internal::ScopedSyscallTimer<thread_safe> timer{this};
+      DecommitSystemPages(begin, end - begin, PageUpdatePermissions);
+    };
+    char* uncommitted_begin =
+        internal::SuperPagePayloadBegin(super_page, IsQuarantineAllowed());
+    internal::IterateSlotSpans<thread_safe>(
+        super_page, IsQuarantineAllowed(),
+        [this, &release_uncommitted,
+         &uncommitted_begin](SlotSpan* slot_span) -> bool {
+          lock_.AssertAcquired();
+          if (slot_span->is_empty() && slot_span->empty_cache_index == -1)
+            slot_span->Decommit(this);
+          char* slot_span_start =
+              reinterpret_cast<char*>(SlotSpan::ToSlotSpanStartPtr(slot_span));
+          release_uncommitted(uncommitted_begin, slot_span_start);
+          const size_t bytes_per_span = slot_span->bucket->get_bytes_per_span();
+          if (slot_span->is_decommitted()) {
+            internal::ScopedSyscallTimer<thread_safe> timer{this};
+            DecommitSystemPages(slot_span_start, bytes_per_span,
+                                PageKeepPermissionsIfPossible);
+            uncommitted_begin = slot_span_start + bytes_per_span;
+          } else {
+            uncommitted_begin =
+                slot_span_start +
+                internal::GetCommittedSize(slot_span, use_lazy_commit);
+          }
+          char* slot_span_end =
+              slot_span_start + slot_span->bucket->get_pages_per_slot_span() *
+                                    PartitionPageSize();
+          release_uncommitted(uncommitted_begin, slot_span_end);
+          uncommitted_begin = slot_span_end;
+          return false;
+        });
+    release_uncommitted(uncommitted_begin,
+                        internal::SuperPagePayloadEnd(super_page));
+  }
+
+  // Restore the guard pages around the metadata "island" and at the end of
+  // the super page, as set up by PartitionBucket::AllocNewSuperPage(). The
+  // rest stays accessible, as do decommitted slot spans.
+  size_t metadata_end = 2 * SystemPageSize();
+#if BUILDFLAG(PUT_REF_COUNT_IN_PREVIOUS_SLOT)
+  if (ChoosePool() == internal::GetBRPPool())
+    metadata_end += SystemPageSize();
+#endif
+  internal::ScopedSyscallTimer<thread_safe> timer{this};
+  SetSystemPagesAccess(super_page, SystemPageSize(), PageInaccessible);
+  if (metadata_end < PartitionPageSize()) {
+    SetSystemPagesAccess(super_page + metadata_end,
+                         PartitionPageSize() - metadata_end, PageInaccessible);
+  }
+  SetSystemPagesAccess(internal::SuperPagePayloadEnd(super_page),
+                       PartitionPageSize(), PageInaccessible);
+}
+
 template <bool thread_safe>
 bool PartitionRoot<thread_safe>::TryReallocInPlaceForDirectMap(
     internal::SlotSpanMetadata<thread_safe>* slot_span,
@@ -935,23 +1111,40 @@ void* PartitionRoot<thread_safe>::ReallocFlags(int flags,
 
 template <bool thread_safe>
 void PartitionRoot<thread_safe>::PurgeMemory(int flags) {
-  {
-    ScopedGuard guard{lock_};
-    // Avoid purging if there is PCScan task currently scheduled. Since pcscan
-    // takes snapshot of all allocated pages, decommitting pages here (even
-    // under the lock) is racy.
-    // TODO(bikineev): Consider rescheduling the purging after PCScan.
-    if (PCScan::IsInProgress())
-      return;
-    if (flags & PartitionPurgeDecommitEmptySlotSpans)
-      DecommitEmptySlotSpans();
-    if (flags & PartitionPurgeDiscardUnusedSystemPages) {
-      for (Bucket& bucket : buckets) {
-        if (bucket.slot_size >= SystemPageSize())
-          internal::PartitionPurgeBucket(&bucket);
+  PurgeMemory(flags, base::TimeTicks::Max());
+}
+
+template <bool thread_safe>
+bool PartitionRoot<thread_safe>::PurgeMemory(int flags,
+                                             base::TimeTicks deadline) {
+  ScopedGuard guard{lock_};
+  // Avoid purging if there is PCScan task currently scheduled. Since pcscan
+  // takes snapshot of all allocated pages, decommitting pages here (even
+  // under the lock) is racy.
+  // TODO(bikineev): Consider rescheduling the purging after PCScan.
+  if (PCScan::IsInProgress())
+    return true;
+  if (flags & PartitionPurgeDecommitEmptySlotSpans) {
+    if (use_huge_pages)
+      UpdateHugePages();
+    DecommitEmptySlotSpans(flags & PartitionPurgeKeepWarmSlotSpans);
+  }
+  if (flags & PartitionPurgeDiscardUnusedSystemPages) {
+    // Walking the buckets is where most of the time goes, so the deadline is
+    // checked between buckets. Always make progress.
+    for (size_t i = 0; i < kNumBuckets; i++) {
+      size_t index = (next_bucket_to_purge + i) % kNumBuckets;
+      Bucket& bucket = buckets[index];
+      if (bucket.slot_size >= SystemPageSize())
+        internal::PartitionPurgeBucket(&bucket);
+      if (!deadline.is_max() && base::TimeTicks::Now() >= deadline &&
+          i + 1 < kNumBuckets) {
+        next_bucket_to_purge = (index + 1) % kNumBuckets;
+        return false;
       }
     }
   }
+  return true;
 }
 
 template <bool thread_safe>
@@ -959,15 +1152,29 @@ void PartitionRoot<thread_safe>::DumpStats(const char* partition_name,
                                            bool is_light_dump,
                                            PartitionStatsDumper* dumper) {
   static const size_t kMaxReportableDirectMaps = 4096;
+  // 32GiB worth of super pages.
+  static const size_t kMaxReportableHugePageSuperPages = 16384;
   // Allocate on the heap rather than on the stack to avoid stack overflow
   // skirmishes (on Windows, in particular). Allocate before locking below,
   // otherwise when PartitionAlloc is malloc() we get reentrancy issues. This
-  // inflates reported values a bit for detailed dumps though, by 16kiB.
+  // inflates reported values a bit for detailed dumps though, by 16kiB, and
+  // 128kiB more with huge pages.
   std::unique_ptr<uint32_t[]> direct_map_lengths;
+  std::unique_ptr<uintptr_t[]> huge_page_super_pages;
   if (!is_light_dump) {
     direct_map_lengths =
         std::unique_ptr<uint32_t[]>(new uint32_t[kMaxReportableDirectMaps]);
+    bool with_huge_pages;
+    {
+      ScopedGuard guard{lock_};
+      with_huge_pages = use_huge_pages;
+    }
+    if (with_huge_pages) {
+      huge_page_super_pages = std::unique_ptr<uintptr_t[]>(
+          new uintptr_t[kMaxReportableHugePageSuperPages]);
+    }
   }
+  size_t num_huge_page_super_pages = 0;
   PartitionBucketMemoryStats bucket_stats[kNumBuckets];
   size_t num_direct_mapped_allocations = 0;
   PartitionMemoryStats stats = {0};
@@ -1031,6 +1238,34 @@ void PartitionRoot<thread_safe>::DumpStats(const char* partition_name,
     stats.total_resident_bytes += direct_mapped_allocations_total_size;
     stats.total_active_bytes += direct_mapped_allocations_total_size;
 
+    for (auto* super_page_extent = first_extent; super_page_extent;
+         super_page_extent = super_page_extent->next) {
+      for (char *super_page = SuperPagesBeginFromExtent(super_page_extent),
+                *super_page_end = SuperPagesEndFromExtent(super_page_extent);
+           super_page != super_page_end; super_page += kSuperPageSize) {
+        if (!internal::PartitionSuperPageToExtent<thread_safe>(super_page)
+                 ->uses_huge_pages)
+          continue;
+        stats.total_huge_page_advised_bytes += kSuperPageSize;
+        // The whole super page may be backed by the huge page, see
+        // UpdateHugePagesForSuperPage(). Count the rest of it as committed.
+        size_t committed_size = 0;
+        internal::IterateSlotSpans<thread_safe>(
+            super_page, IsQuarantineAllowed(),
+            [this, &committed_size](SlotSpan* slot_span) -> bool {
+              committed_size +=
+                  internal::GetCommittedSize(slot_span, use_lazy_commit);
+              return false;
+            });
+        stats.total_committed_bytes += kSuperPageSize - committed_size;
+        if (huge_page_super_pages &&
+            num_huge_page_super_pages < kMaxReportableHugePageSuperPages) {
+          huge_page_super_pages[num_huge_page_super_pages++] =
+              reinterpret_cast<uintptr_t>(super_page);
+        }
+      }
+    }
+
     stats.has_thread_cache = with_thread_cache;
     if (stats.has_thread_cache) {
       internal::ThreadCacheRegistry::Instance().DumpStats(
@@ -1060,6 +1295,17 @@ void PartitionRoot<thread_safe>::DumpStats(const char* partition_name,
       mapped_stats.resident_bytes = size;
       dumper->PartitionsDumpBucketStats(partition_name, &mapped_stats);
     }
+
+    // Reading /proc/self/smaps doesn't require the lock either, and advised
+    // super pages may only have changed state since then, which is fine for
+    // reporting purposes.
+    if (num_huge_page_super_pages) {
+      std::sort(huge_page_super_pages.get(),
+                huge_page_super_pages.get() + num_huge_page_super_pages);
+      stats.total_huge_page_backed_bytes =
+          GetHugePageBackedSize(huge_page_super_pages.get(),
+                                num_huge_page_super_pages, kSuperPageSize);
+    }
   }
   dumper->PartitionDumpTotals(partition_name, &stats);
 }
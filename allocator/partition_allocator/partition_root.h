@@ -95,6 +95,10 @@ enum PartitionPurgeFlags {
   // Aggressively reclaim memory. This is meant to be used in low-memory
   // situations, not for periodic memory reclaiming.
   PartitionPurgeAggressiveReclaim = 1 << 2,
+  // Along with PartitionPurgeDecommitEmptySlotSpans, keeps a few empty slot
+  // spans committed in the buckets which recently reused some, so that the next
+  // burst of allocations doesn't have to fault pages back in.
+  PartitionPurgeKeepWarmSlotSpans = 1 << 3,
 };
 
 // Options struct used to configure PartitionRoot and PartitionAllocator.
@@ -317,6 +321,11 @@ struct BASE_EXPORT PartitionRoot {
   // entries. But it might have been moved to swap. Note that all this memory
   // can be decommitted at any time.
   size_t empty_slot_spans_dirty_bytes GUARDED_BY(lock_) = 0;
+  // See EnableHugePagesIfSupported().
+  bool use_huge_pages GUARDED_BY(lock_) = false;
+  // Bucket at which a |PurgeMemory()| which ran past its deadline stopped
+  // discarding unused system pages, and the next one resumes.
+  size_t next_bucket_to_purge GUARDED_BY(lock_) = 0;
 
   char* next_super_page = nullptr;
   char* next_partition_page = nullptr;
@@ -350,6 +359,24 @@ struct BASE_EXPORT PartitionRoot {
 
   void EnableThreadCacheIfSupported();
   void ConfigureLazyCommit();
+  // Backs the super pages of this partition which are densely used with
+  // transparent huge pages, to reduce TLB misses. Decommitting part of a huge
+  // page would split it, so empty slot spans are kept committed in such super
+  // pages, and their unused system pages are not discarded, until they become
+  // sparsely used. The system may back all of such a super page, including
+  // the parts which were never committed, so DumpStats() counts all of it as
+  // committed.
+  //
+  // This is a security trade-off: huge pages require uniform permissions, so
+  // these super pages lose their guard pages, including the ones around the
+  // metadata. A linear overflow can then reach the metadata of the super page
+  // or run into the next one. Don't enable this without consulting the
+  // security team.
+  //
+  // Super pages are (re)considered when no more slot spans fit in them, and in
+  // PurgeMemory(). Only supported on Linux with 4kiB system pages, no-op
+  // otherwise.
+  void EnableHugePagesIfSupported();
 
   ALWAYS_INLINE static bool IsValidSlotSpan(SlotSpan* slot_span);
   ALWAYS_INLINE static PartitionRoot* FromSlotSpan(SlotSpan* slot_span);
@@ -363,6 +390,11 @@ struct BASE_EXPORT PartitionRoot {
   // direct-mapped allocation.
   ALWAYS_INLINE static PartitionRoot* FromPointerInFirstSuperpage(char* ptr);
 
+  // Starts or stops backing |super_page| with a transparent huge page,
+  // depending on how densely it is used.
+  void UpdateHugePagesForSuperPage(char* super_page)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   ALWAYS_INLINE void IncreaseCommittedPages(size_t len);
   ALWAYS_INLINE void DecreaseCommittedPages(size_t len);
   ALWAYS_INLINE void DecommitSystemPagesForData(
@@ -451,6 +483,10 @@ struct BASE_EXPORT PartitionRoot {
   // Frees memory from this partition, if possible, by decommitting pages or
   // even etnire slot spans. |flags| is an OR of base::PartitionPurgeFlags.
   void PurgeMemory(int flags);
+  // Same as above, but stops between buckets when |deadline| has passed while
+  // discarding unused system pages. Returns false if so, in which case the next
+  // call starts with the bucket that wasn't reached.
+  bool PurgeMemory(int flags, base::TimeTicks deadline);
 
   void DumpStats(const char* partition_name,
                  bool is_light_dump,
@@ -735,7 +771,9 @@ struct BASE_EXPORT PartitionRoot {
   bool TryReallocInPlaceForDirectMap(
       internal::SlotSpanMetadata<thread_safe>* slot_span,
       size_t requested_size) EXCLUSIVE_LOCKS_REQUIRED(lock_);
-  void DecommitEmptySlotSpans() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void DecommitEmptySlotSpans(bool keep_warm_slot_spans)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void UpdateHugePages() EXCLUSIVE_LOCKS_REQUIRED(lock_);
   ALWAYS_INLINE void RawFreeLocked(void* slot_start)
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
   void* MaybeInitThreadCacheAndAlloc(uint16_t bucket_index, size_t* slot_size);
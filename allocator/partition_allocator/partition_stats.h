@@ -31,9 +31,11 @@ struct ThreadCacheStats {
   uint64_t cache_fill_misses;  // Object too large.
 
   uint64_t batch_fill_count;  // Number of central allocator requests.
+  uint64_t batch_free_count;  // Number of batched central allocator frees.
 
   // Memory cost:
   uint32_t bucket_total_memory;
+  uint32_t free_batch_memory;  // Freed, not returned to the central allocator.
   uint32_t metadata_overhead;
 
 #if defined(PA_THREAD_CACHE_ALLOC_STATS)
@@ -53,6 +55,10 @@ struct PartitionMemoryStats {
   size_t total_active_bytes;     // Total active bytes in the partition.
   size_t total_decommittable_bytes;  // Total bytes that could be decommitted.
   size_t total_discardable_bytes;    // Total bytes that could be discarded.
+  size_t total_huge_page_advised_bytes;  // Total size of the super pages
+                                         // advised to use huge pages.
+  size_t total_huge_page_backed_bytes;   // Total bytes backed by huge pages.
+                                         // Not reported in light dumps.
 #if BUILDFLAG(USE_BACKUP_REF_PTR)
   size_t
       total_brp_quarantined_bytes;  // Total bytes that are quarantined by BRP.
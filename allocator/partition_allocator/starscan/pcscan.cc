@@ -99,6 +99,11 @@ void PCScan::FinishScanForTesting() {
   PCScanInternal::Instance().FinishScanForTesting();  // IN-TEST
 }
 
+void PCScan::SetIncrementalSafepointBudgetForTesting(TimeDelta budget) {
+  PCScanInternal::Instance().SetIncrementalSafepointBudgetForTesting(
+      budget);  // IN-TEST
+}
+
 PCScan PCScan::instance_ CONSTINIT;
 
 }  // namespace internal
@@ -65,6 +65,18 @@ class BASE_EXPORT PCScan final {
       kDisabled,
       kEnabled,
     } safepoint = SafepointMode::kDisabled;
+
+    // Flag that bounds the time mutators spend in safepoints. In the
+    // incremental mode, mutators leave the safepoint as soon as their budget
+    // is exhausted and the remaining work is picked up by other threads.
+    enum class SafepointPauseMode : uint8_t {
+      kUnbounded,
+      kIncremental,
+    } safepoint_pause = SafepointPauseMode::kUnbounded;
+
+    // Number of threads that help the scanner thread with clearing and
+    // scanning the heap in parallel.
+    size_t number_of_helper_threads = 0;
   };
 
   PCScan(const PCScan&) = delete;
@@ -165,6 +177,9 @@ class BASE_EXPORT PCScan final {
   // Reinitialize internal structures (e.g. card table).
   static void ReinitForTesting(InitConfig);
 
+  // Sets the maximum time a mutator spends in an incremental safepoint.
+  static void SetIncrementalSafepointBudgetForTesting(TimeDelta budget);
+
   size_t epoch() const { return scheduler_.epoch(); }
 
   // CONSTINIT for fast access (avoiding static thread-safe initialization).
@@ -430,6 +430,14 @@ SuperPageSnapshot::SuperPageSnapshot(uintptr_t super_page) {
   scan_areas_.set_size(current);
 }
 
+// Returns the predicate used to bail out from raceful visits once |deadline|
+// is reached. Visits with TimeTicks::Max() as the deadline are never stopped.
+auto DeadlineReached(TimeTicks deadline) {
+  return [deadline]() {
+    return !deadline.is_max() && TimeTicks::Now() >= deadline;
+  };
+}
+
 }  // namespace
 
 class PCScanScanLoop;
@@ -448,6 +456,9 @@ class PCScanTask final : public base::RefCountedThreadSafe<PCScanTask>,
   // Execute PCScan from mutator inside safepoint.
   void RunFromMutator();
 
+  // Execute clearing and scanning from a helper thread, alongside the scanner.
+  void RunFromHelper();
+
   // Execute PCScan from the scanner thread. Must be called only once from the
   // scanner thread.
   void RunFromScanner();
@@ -480,15 +491,23 @@ class PCScanTask final : public base::RefCountedThreadSafe<PCScanTask>,
       // First, notify the scanning thread that this thread is done.
       NotifyThreads();
       if (context == Context::kScanner) {
-        // The scanner thread must wait here until all safepoints leave.
-        // Otherwise, sweeping may free a page that can later be accessed by a
-        // descheduled mutator.
+        // The scanner thread must wait here until all safepoints and helper
+        // threads leave. Otherwise, sweeping may free a page that can later be
+        // accessed by a descheduled mutator.
         WaitForOtherThreads();
         task_.pcscan_.state_.store(PCScan::State::kSweepingAndFinishing,
                                    std::memory_order_relaxed);
       }
     }
 
+    // Called by mutators that leave the safepoint before all the work is done,
+    // so that other mutators can still join.
+    void KeepJoinable() {
+      static_assert(context == Context::kMutator,
+                    "Only mutators can leave before scanning is done");
+      keep_joinable_ = true;
+    }
+
    private:
     void NotifyThreads() {
       {
@@ -498,7 +517,7 @@ class PCScanTask final : public base::RefCountedThreadSafe<PCScanTask>,
         std::lock_guard<std::mutex> lock(task_.mutex_);
         task_.number_of_scanning_threads_.fetch_sub(1,
                                                     std::memory_order_relaxed);
-        {
+        if (!keep_joinable_) {
           // Notify that scan is done and there is no need to enter
           // the safepoint. This also helps a mutator to avoid repeating
           // entering. Since the scanner thread waits for all threads to finish,
@@ -515,9 +534,12 @@ class PCScanTask final : public base::RefCountedThreadSafe<PCScanTask>,
         return !task_.number_of_scanning_threads_.load(
             std::memory_order_relaxed);
       });
+      // Helper threads that wake up late must not join anymore.
+      task_.is_scanning_done_ = true;
     }
 
     PCScanTask& task_;
+    bool keep_joinable_ = false;
   };
 
   friend class base::RefCountedThreadSafe<PCScanTask>;
@@ -545,10 +567,14 @@ class PCScanTask final : public base::RefCountedThreadSafe<PCScanTask>,
                      size_t slot_size);
 
   // Scans all registered partitions and marks reachable quarantined objects.
-  void ScanPartitions();
+  // Bails out once |deadline| is reached. Returns whether all partitions have
+  // been scanned.
+  bool ScanPartitions(TimeTicks deadline);
 
-  // Clear quarantined objects and prepare card table for fast lookup
-  void ClearQuarantinedObjectsAndPrepareCardTable();
+  // Clear quarantined objects and prepare card table for fast lookup. Bails out
+  // once |deadline| is reached. Returns whether the card table is fully
+  // prepared.
+  bool ClearQuarantinedObjectsAndPrepareCardTable(TimeTicks deadline);
 
   // Unprotect all slot spans from all partitions.
   void UnprotectPartitions();
@@ -569,6 +595,13 @@ class PCScanTask final : public base::RefCountedThreadSafe<PCScanTask>,
   std::mutex mutex_;
   std::condition_variable condvar_;
   std::atomic<size_t> number_of_scanning_threads_{0u};
+  // Set once scanning is done, guarded by |mutex_|.
+  bool is_scanning_done_{false};
+  // Mutators that scanned their stack in the incremental mode, guarded by
+  // |mutex_|. They don't join again, so that every mutator spends at most one
+  // budget in the safepoint after its stack is scanned.
+  std::vector<PlatformThreadId, MetadataAllocator<PlatformThreadId>>
+      incremental_mutators_;
   // We can unprotect only once to reduce context-switches.
   std::once_flag unprotect_once_flag_;
   bool immediatelly_free_objects_{false};
@@ -672,33 +705,42 @@ PCScanTask::TryMarkObjectInNormalBuckets(uintptr_t maybe_ptr) const {
   return 0;
 }
 
-void PCScanTask::ClearQuarantinedObjectsAndPrepareCardTable() {
+bool PCScanTask::ClearQuarantinedObjectsAndPrepareCardTable(
+    TimeTicks deadline) {
   const PCScan::ClearType clear_type = pcscan_.clear_type_;
 
 #if !PA_STARSCAN_USE_CARD_TABLE
   if (clear_type == PCScan::ClearType::kEager)
-    return;
+    return true;
 #endif
 
+  size_t cleared_size = 0;
   StarScanSnapshot::ClearingView view(*snapshot_);
-  view.VisitConcurrently([clear_type](uintptr_t super_page_base) {
-    auto* bitmap =
-        StateBitmapFromPointer(reinterpret_cast<char*>(super_page_base));
-    auto* root = Root::FromSuperPage(reinterpret_cast<char*>(super_page_base));
-    bitmap->IterateQuarantined([root, clear_type](uintptr_t ptr) {
-      auto* object = reinterpret_cast<void*>(ptr);
-      auto* slot_span = SlotSpan::FromSlotInnerPtr(object);
-      // Use zero as a zapping value to speed up the fast bailout check in
-      // ScanPartitions.
-      const size_t size = slot_span->GetUsableSize(root);
-      if (clear_type == PCScan::ClearType::kLazy)
-        memset(object, 0, size);
+  const bool is_done = view.VisitConcurrentlyUntil(
+      [clear_type, &cleared_size](uintptr_t super_page_base) {
+        auto* bitmap =
+            StateBitmapFromPointer(reinterpret_cast<char*>(super_page_base));
+        auto* root =
+            Root::FromSuperPage(reinterpret_cast<char*>(super_page_base));
+        bitmap->IterateQuarantined(
+            [root, clear_type, &cleared_size](uintptr_t ptr) {
+              auto* object = reinterpret_cast<void*>(ptr);
+              auto* slot_span = SlotSpan::FromSlotInnerPtr(object);
+              // Use zero as a zapping value to speed up the fast bailout check
+              // in ScanPartitions.
+              const size_t size = slot_span->GetUsableSize(root);
+              if (clear_type == PCScan::ClearType::kLazy)
+                memset(object, 0, size);
 #if PA_STARSCAN_USE_CARD_TABLE
-      // Set card(s) for this quarantined object.
-      QuarantineCardTable::GetFrom(ptr).Quarantine(ptr, size);
+              // Set card(s) for this quarantined object.
+              QuarantineCardTable::GetFrom(ptr).Quarantine(ptr, size);
 #endif
-    });
-  });
+              cleared_size += size;
+            });
+      },
+      DeadlineReached(deadline));
+  stats_.IncreaseClearedSize(cleared_size);
+  return is_done;
 }
 
 void PCScanTask::UnprotectPartitions() {
@@ -843,7 +885,7 @@ void PCScanTask::ScanLargeArea(PCScanInternal& pcscan,
   }
 }
 
-void PCScanTask::ScanPartitions() {
+bool PCScanTask::ScanPartitions(TimeTicks deadline) {
   // Threshold for which bucket size it is worthwhile in checking whether the
   // object is allocated and needs to be scanned. PartitionPurgeSlotSpan()
   // purges only slots >= page-size, this helps us to avoid faulting in
@@ -856,9 +898,10 @@ void PCScanTask::ScanPartitions() {
   PCScanScanLoop scan_loop(*this);
   auto& pcscan = PCScanInternal::Instance();
 
+  size_t scanned_size = 0;
   StarScanSnapshot::ScanningView snapshot_view(*snapshot_);
-  snapshot_view.VisitConcurrently(
-      [this, &pcscan, &scan_loop](uintptr_t super_page) {
+  const bool is_done = snapshot_view.VisitConcurrentlyUntil(
+      [this, &pcscan, &scan_loop, &scanned_size](uintptr_t super_page) {
         SuperPageSnapshot super_page_snapshot(super_page);
 
         for (const auto& scan_area : super_page_snapshot.scan_areas()) {
@@ -866,6 +909,7 @@ void PCScanTask::ScanPartitions() {
               super_page |
               (scan_area.offset_within_page_in_words * sizeof(uintptr_t)));
           auto* const end = begin + scan_area.size_in_words;
+          scanned_size += scan_area.size_in_words * sizeof(uintptr_t);
 
           if (UNLIKELY(scan_area.slot_size_in_words >=
                        kLargeScanAreaThresholdInWords)) {
@@ -875,9 +919,12 @@ void PCScanTask::ScanPartitions() {
             ScanNormalArea(pcscan, scan_loop, begin, end);
           }
         }
-      });
+      },
+      DeadlineReached(deadline));
 
   stats_.IncreaseSurvivedQuarantineSize(scan_loop.quarantine_size());
+  stats_.IncreaseScannedSize(scanned_size);
+  return is_done;
 }
 
 namespace {
@@ -1008,8 +1055,95 @@ void PCScanTask::FinishScanner() {
            PCScan::State::kSweepingAndFinishing);
 }
 
+// Helper threads that join the scanner thread in clearing and scanning the
+// heap, similarly to mutators in safepoints. The work is distributed between
+// all scanning threads by the raceful worklists of the snapshot. PCScan is
+// driven by the allocator, hence it uses its own threads rather than depending
+// on a thread pool that may allocate.
+class PCScanHelperThreads final {
+ public:
+  using TaskHandle = PCScanInternal::TaskHandle;
+
+  static PCScanHelperThreads& Instance() {
+    // Lazily instantiate the helper threads.
+    static base::NoDestructor<PCScanHelperThreads> instance;
+    return *instance;
+  }
+
+  // Wakes up the helper threads to run |task|, starting new threads if there
+  // are less than |number_of_threads|.
+  void PostTask(TaskHandle task, size_t number_of_threads) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (; number_of_threads_ < number_of_threads; ++number_of_threads_)
+        StartThread();
+      posted_task_ = std::move(task);
+      ++posted_task_sequence_number_;
+    }
+    condvar_.notify_all();
+  }
+
+  // Releases the posted task once scanning is done. Threads that haven't woken
+  // up by then skip it.
+  void ResetTask() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    posted_task_.reset();
+  }
+
+ private:
+  friend class base::NoDestructor<PCScanHelperThreads>;
+
+  PCScanHelperThreads() = default;
+
+  void StartThread() {
+    std::thread{[this] {
+      static constexpr const char* kThreadName = "PCScanHelper";
+      base::PlatformThread::SetName(kThreadName);
+      TaskLoop();
+    }}.detach();
+  }
+
+  void TaskLoop() {
+    size_t last_sequence_number = 0;
+    while (true) {
+      TaskHandle current_task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condvar_.wait(lock, [this, last_sequence_number] {
+          return posted_task_sequence_number_ != last_sequence_number;
+        });
+        last_sequence_number = posted_task_sequence_number_;
+        current_task = posted_task_;
+      }
+      if (current_task.get())
+        current_task->RunFromHelper();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable condvar_;
+  TaskHandle posted_task_;
+  size_t posted_task_sequence_number_ = 0;
+  size_t number_of_threads_ = 0;
+};
+
 void PCScanTask::RunFromMutator() {
   ReentrantScannerGuard reentrancy_guard;
+  auto& pcscan = PCScanInternal::Instance();
+  const bool is_incremental = pcscan.IsIncrementalSafepointEnabled();
+  if (is_incremental) {
+    // Incremental mutators may leave the safepoint with the task still being
+    // joinable. Mutators that left before scanning their stack rejoin, the
+    // others are done.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (std::find(incremental_mutators_.begin(), incremental_mutators_.end(),
+                  PlatformThread::CurrentId()) != incremental_mutators_.end())
+      return;
+  }
+  const TimeTicks deadline =
+      is_incremental
+          ? TimeTicks::Now() + pcscan.incremental_safepoint_budget()
+          : TimeTicks::Max();
   StatsCollector::MutatorScope overall_scope(
       stats_, StatsCollector::MutatorId::kOverall);
   {
@@ -1022,7 +1156,13 @@ void PCScanTask::RunFromMutator() {
       // Clear all quarantined objects and prepare card table.
       StatsCollector::MutatorScope clear_scope(
           stats_, StatsCollector::MutatorId::kClear);
-      ClearQuarantinedObjectsAndPrepareCardTable();
+      if (!ClearQuarantinedObjectsAndPrepareCardTable(deadline)) {
+        // Scanning is only correct with a fully prepared card table, leave
+        // the rest of the work to other threads. The mutator rejoins later to
+        // scan its stack.
+        sync_scope.KeepJoinable();
+        return;
+      }
     }
     {
       // Scan the thread's stack to find dangling references.
@@ -1030,6 +1170,10 @@ void PCScanTask::RunFromMutator() {
           stats_, StatsCollector::MutatorId::kScanStack);
       ScanStack();
     }
+    if (is_incremental) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      incremental_mutators_.push_back(PlatformThread::CurrentId());
+    }
     {
       // Unprotect all scanned pages, if needed.
       UnprotectPartitions();
@@ -1038,35 +1182,80 @@ void PCScanTask::RunFromMutator() {
       // Scan heap for dangling references.
       StatsCollector::MutatorScope scan_scope(stats_,
                                               StatsCollector::MutatorId::kScan);
-      ScanPartitions();
+      if (!ScanPartitions(deadline))
+        sync_scope.KeepJoinable();
     }
   }
 }
 
+void PCScanTask::RunFromHelper() {
+  ReentrantScannerGuard reentrancy_guard;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The helper may only wake up after scanning is done.
+    if (is_scanning_done_)
+      return;
+    number_of_scanning_threads_.fetch_add(1, std::memory_order_relaxed);
+  }
+  {
+    // Clear all quarantined objects and prepare the card table.
+    StatsCollector::ScannerScope clear_scope(
+        stats_, StatsCollector::ScannerId::kClear);
+    ClearQuarantinedObjectsAndPrepareCardTable(TimeTicks::Max());
+  }
+  {
+    // Scan heap for dangling references.
+    StatsCollector::ScannerScope scan_scope(stats_,
+                                            StatsCollector::ScannerId::kScan);
+    ScanPartitions(TimeTicks::Max());
+  }
+  {
+    // Unprotect all scanned pages, if needed.
+    UnprotectPartitions();
+  }
+  {
+    // Same as in SyncScope, notify the scanner thread that this thread is done
+    // and that there is no need for mutators to enter the safepoint.
+    std::lock_guard<std::mutex> lock(mutex_);
+    number_of_scanning_threads_.fetch_sub(1, std::memory_order_relaxed);
+    pcscan_.SetJoinableIfSafepointEnabled(false);
+  }
+  condvar_.notify_all();
+}
+
 void PCScanTask::RunFromScanner() {
   ReentrantScannerGuard reentrancy_guard;
+  const size_t number_of_helper_threads =
+      PCScanInternal::Instance().number_of_helper_threads();
   {
     StatsCollector::ScannerScope overall_scope(
         stats_, StatsCollector::ScannerId::kOverall);
     {
       SyncScope<Context::kScanner> sync_scope(*this);
+      if (number_of_helper_threads) {
+        // Let the helper threads join clearing and scanning.
+        PCScanHelperThreads::Instance().PostTask(
+            PCScanInternal::TaskHandle(this), number_of_helper_threads);
+      }
       {
         // Clear all quarantined objects and prepare the card table.
         StatsCollector::ScannerScope clear_scope(
             stats_, StatsCollector::ScannerId::kClear);
-        ClearQuarantinedObjectsAndPrepareCardTable();
+        ClearQuarantinedObjectsAndPrepareCardTable(TimeTicks::Max());
       }
       {
         // Scan heap for dangling references.
         StatsCollector::ScannerScope scan_scope(
             stats_, StatsCollector::ScannerId::kScan);
-        ScanPartitions();
+        ScanPartitions(TimeTicks::Max());
       }
       {
         // Unprotect all scanned pages, if needed.
         UnprotectPartitions();
       }
     }
+    if (number_of_helper_threads)
+      PCScanHelperThreads::Instance().ResetTask();
     {
       // Sweep unreachable quarantined objects.
       StatsCollector::ScannerScope sweep_scope(
@@ -1204,6 +1393,10 @@ void PCScanInternal::Initialize(PCScan::InitConfig config) {
   if (config.safepoint == PCScan::InitConfig::SafepointMode::kEnabled) {
     PCScan::Instance().EnableSafepoints();
   }
+  incremental_safepoint_enabled_ =
+      config.safepoint_pause ==
+      PCScan::InitConfig::SafepointPauseMode::kIncremental;
+  number_of_helper_threads_ = config.number_of_helper_threads;
   scannable_roots_ = RootsMap();
   nonscannable_roots_ = RootsMap();
   is_initialized_ = true;
@@ -1490,5 +1683,10 @@ void PCScanInternal::FinishScanForTesting() {
   current_task->RunFromScanner();
 }
 
+void PCScanInternal::SetIncrementalSafepointBudgetForTesting(
+    TimeDelta budget) {
+  incremental_safepoint_budget_ = budget;
+}
+
 }  // namespace internal
 }  // namespace base
@@ -92,6 +92,14 @@ class PCScanInternal final {
   void EnableImmediateFreeing() { immediate_freeing_enabled_ = true; }
   bool IsImmediateFreeingEnabled() const { return immediate_freeing_enabled_; }
 
+  bool IsIncrementalSafepointEnabled() const {
+    return incremental_safepoint_enabled_;
+  }
+  TimeDelta incremental_safepoint_budget() const {
+    return incremental_safepoint_budget_;
+  }
+  size_t number_of_helper_threads() const { return number_of_helper_threads_; }
+
   void NotifyThreadCreated(void* stack_top);
   void NotifyThreadDestroyed();
 
@@ -104,6 +112,7 @@ class PCScanInternal final {
   void ClearRootsForTesting();                               // IN-TEST
   void ReinitForTesting(PCScan::InitConfig);                 // IN-TEST
   void FinishScanForTesting();                               // IN-TEST
+  void SetIncrementalSafepointBudgetForTesting(TimeDelta);   // IN-TEST
 
  private:
   friend base::NoDestructor<PCScanInternal>;
@@ -133,6 +142,13 @@ class PCScanInternal final {
 
   bool immediate_freeing_enabled_{false};
 
+  bool incremental_safepoint_enabled_{false};
+  // Maximum time a mutator spends in a safepoint in the incremental mode. The
+  // budget is checked between super pages, so the actual pause can exceed it
+  // by the time needed to process a single super page.
+  TimeDelta incremental_safepoint_budget_ = TimeDelta::FromMilliseconds(1);
+  size_t number_of_helper_threads_{0u};
+
   const char* process_name_ = nullptr;
   const SimdSupport simd_support_;
 
@@ -6,6 +6,8 @@
 
 #include "base/allocator/partition_allocator/starscan/pcscan.h"
 
+#include <vector>
+
 #include "base/allocator/partition_allocator/partition_alloc.h"
 #include "base/allocator/partition_allocator/partition_alloc_constants.h"
 #include "base/allocator/partition_allocator/partition_alloc_features.h"
@@ -40,13 +42,15 @@ struct DisableStackScanningScope final {
 
 class PartitionAllocPCScanTest : public testing::Test {
  public:
-  PartitionAllocPCScanTest() {
+  PartitionAllocPCScanTest()
+      : PartitionAllocPCScanTest(
+            {PCScan::InitConfig::WantedWriteProtectionMode::kDisabled,
+             PCScan::InitConfig::SafepointMode::kEnabled}) {}
+  explicit PartitionAllocPCScanTest(PCScan::InitConfig config) {
     PartitionAllocGlobalInit([](size_t) { LOG(FATAL) << "Out of memory"; });
     // Previous test runs within the same process decommit GigaCage, therefore
     // we need to make sure that the card table is recommitted for each run.
-    PCScan::ReinitForTesting(
-        {PCScan::InitConfig::WantedWriteProtectionMode::kDisabled,
-         PCScan::InitConfig::SafepointMode::kEnabled});
+    PCScan::ReinitForTesting(config);
     allocator_.init({PartitionOptions::AlignedAlloc::kAllowed,
                      PartitionOptions::ThreadCache::kDisabled,
                      PartitionOptions::Quarantine::kAllowed,
@@ -78,6 +82,12 @@ class PartitionAllocPCScanTest : public testing::Test {
 
   void FinishPCScanAsScanner() { PCScan::FinishScanForTesting(); }
 
+  bool IsPCScanJoinable() const { return PCScan::Instance().IsJoinable(); }
+
+  void SetIncrementalSafepointBudget(TimeDelta budget) {
+    PCScan::SetIncrementalSafepointBudgetForTesting(budget);
+  }
+
   bool IsInQuarantine(void* ptr) const {
     return StateBitmapFromPointer(ptr)->IsQuarantined(
         reinterpret_cast<uintptr_t>(ptr));
@@ -90,6 +100,28 @@ class PartitionAllocPCScanTest : public testing::Test {
   PartitionAllocator<ThreadSafe> allocator_;
 };
 
+class PartitionAllocPCScanWithHelperThreadsTest
+    : public PartitionAllocPCScanTest {
+ public:
+  static constexpr size_t kNumberOfHelperThreads = 3;
+
+  PartitionAllocPCScanWithHelperThreadsTest()
+      : PartitionAllocPCScanTest(
+            {PCScan::InitConfig::WantedWriteProtectionMode::kDisabled,
+             PCScan::InitConfig::SafepointMode::kEnabled,
+             PCScan::InitConfig::SafepointPauseMode::kUnbounded,
+             kNumberOfHelperThreads}) {}
+};
+
+class PartitionAllocPCScanIncrementalTest : public PartitionAllocPCScanTest {
+ public:
+  PartitionAllocPCScanIncrementalTest()
+      : PartitionAllocPCScanTest(
+            {PCScan::InitConfig::WantedWriteProtectionMode::kDisabled,
+             PCScan::InitConfig::SafepointMode::kEnabled,
+             PCScan::InitConfig::SafepointPauseMode::kIncremental}) {}
+};
+
 namespace {
 
 using SlotSpan = ThreadSafePartitionRoot::SlotSpan;
@@ -708,6 +740,108 @@ TEST_F(PartitionAllocPCScanTest, TwoDanglingPointersToSameObject) {
   EXPECT_EQ(slot_span_metadata->bucket->slot_size, quarantine.current_size);
 }
 
+TEST_F(PartitionAllocPCScanWithHelperThreadsTest, DanglingReferenceSameBucket) {
+  using SourceList = List<8>;
+  using ValueList = SourceList;
+
+  // Create two objects, where |source| references |value|.
+  auto* value = ValueList::Create(root(), nullptr);
+  auto* source = SourceList::Create(root(), value);
+
+  TestDanglingReference(*this, source, value);
+}
+
+// Spreads references over several super pages, so that they are scanned by
+// multiple threads.
+TEST_F(PartitionAllocPCScanWithHelperThreadsTest,
+       DanglingReferencesAcrossSuperPages) {
+  using SourceList = List<8>;
+  using ValueList = List<4096>;
+  static constexpr size_t kNumValues = 4 * kSuperPageSize / sizeof(ValueList);
+
+  std::vector<SourceList*> sources;
+  std::vector<ValueList*> values;
+  for (size_t i = 0; i < kNumValues; ++i) {
+    values.push_back(ValueList::Create(root(), nullptr));
+    sources.push_back(SourceList::Create(root(), values.back()));
+  }
+
+  // Free all values, keeping references to every other one.
+  for (size_t i = 0; i < kNumValues; ++i) {
+    ValueList::Destroy(root(), values[i]);
+    if (i % 2)
+      sources[i]->next = nullptr;
+  }
+  RunPCScan();
+
+  for (size_t i = 0; i < kNumValues; ++i) {
+    // Only referenced values must be kept in the quarantine.
+    EXPECT_EQ(!(i % 2), IsInQuarantine(values[i]));
+  }
+  for (auto* source : sources)
+    SourceList::Destroy(root(), source);
+}
+
+TEST_F(PartitionAllocPCScanIncrementalTest, Safepoint) {
+  using SourceList = List<64>;
+  using ValueList = SourceList;
+
+  DisableStackScanningScope no_stack_scanning;
+
+  auto* source = SourceList::Create(root());
+  auto* value = ValueList::Create(root());
+  source->next = value;
+
+  TestDanglingReferenceWithSafepoint(*this, source, value);
+}
+
+TEST_F(PartitionAllocPCScanIncrementalTest, RejoinToScanStack) {
+  using ValueList = List<8>;
+
+  PCScan::EnableStackScanning();
+
+  static void* dangling_reference = nullptr;
+  // Set to nullptr if the test is retried.
+  dangling_reference = nullptr;
+
+  // Create and set dangling reference in the global.
+  [this]() NOINLINE {
+    auto* value = ValueList::Create(root(), nullptr);
+    ValueList::Destroy(root(), value);
+    dangling_reference = value;
+  }();
+
+  [this]() NOINLINE {
+    // Register the top of the stack to be the current pointer.
+    PCScan::NotifyThreadCreated(GetStackPointer());
+    [this]() NOINLINE {
+      // This writes the pointer to the stack.
+      auto* volatile stack_ref = dangling_reference;
+      ALLOW_UNUSED_LOCAL(stack_ref);
+      [this]() NOINLINE {
+        // Schedule PCScan but don't scan.
+        SchedulePCScan();
+        // Without a budget, the mutator leaves the safepoint before clearing
+        // is done, i.e. without scanning its stack.
+        SetIncrementalSafepointBudget(TimeDelta());
+        JoinPCScanAsMutator();
+        EXPECT_TRUE(IsPCScanJoinable());
+        // Rejoin to finish clearing and scan the stack.
+        SetIncrementalSafepointBudget(TimeDelta::Max());
+        JoinPCScanAsMutator();
+        // Check that the object is still quarantined since it's referenced by
+        // |dangling_reference|.
+        EXPECT_TRUE(IsInQuarantine(dangling_reference));
+        // Run sweeper.
+        FinishPCScanAsScanner();
+        // Check that |dangling_reference| still exists.
+        EXPECT_FALSE(IsInFreeList(
+            root().AdjustPointerForExtrasSubtract(dangling_reference)));
+      }();
+    }();
+  }();
+}
+
 }  // namespace internal
 }  // namespace base
 
@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <utility>
 #include <vector>
 
 #include "base/allocator/partition_allocator/partition_alloc_check.h"
@@ -49,6 +50,12 @@ class RacefulWorklist {
     template <typename Function>
     void Visit(Function f);
 
+    // Same as Visit(), but checks |should_stop| before visiting each item and
+    // bails out as soon as it returns true, leaving the remaining items to
+    // other threads. Returns whether all items have been visited.
+    template <typename Function, typename StopPredicate>
+    bool VisitUntil(Function f, StopPredicate should_stop);
+
    private:
     RacefulWorklist& worklist_;
     size_t offset_;
@@ -85,6 +92,14 @@ void RacefulWorklist<T>::VisitNonConcurrently(Function f) const {
 template <typename T>
 template <typename Function>
 void RacefulWorklist<T>::RandomizedView::Visit(Function f) {
+  VisitUntil(std::move(f), []() { return false; });
+}
+
+template <typename T>
+template <typename Function, typename StopPredicate>
+bool RacefulWorklist<T>::RandomizedView::VisitUntil(
+    Function f,
+    StopPredicate should_stop) {
   auto& data = worklist_.data_;
   std::vector<typename Underlying::iterator,
               MetadataAllocator<typename Underlying::iterator>>
@@ -93,7 +108,7 @@ void RacefulWorklist<T>::RandomizedView::Visit(Function f) {
   // To avoid worklist iteration, quick check if the worklist was already
   // visited.
   if (worklist_.fully_visited_.load(std::memory_order_acquire))
-    return;
+    return true;
 
   const auto offset_it = std::next(data.begin(), offset_);
 
@@ -105,6 +120,8 @@ void RacefulWorklist<T>::RandomizedView::Visit(Function f) {
       to_revisit.push_back(it);
       continue;
     }
+    if (should_stop())
+      return false;
     it->is_being_visited.store(true, std::memory_order_relaxed);
     f(it->value);
     it->is_visited.store(true, std::memory_order_relaxed);
@@ -118,6 +135,8 @@ void RacefulWorklist<T>::RandomizedView::Visit(Function f) {
       to_revisit.push_back(it);
       continue;
     }
+    if (should_stop())
+      return false;
     it->is_being_visited.store(true, std::memory_order_relaxed);
     f(it->value);
     it->is_visited.store(true, std::memory_order_relaxed);
@@ -127,6 +146,8 @@ void RacefulWorklist<T>::RandomizedView::Visit(Function f) {
   for (auto it : to_revisit) {
     if (LIKELY(it->is_visited.load(std::memory_order_relaxed)))
       continue;
+    if (should_stop())
+      return false;
     // Don't bail out here if the item is being visited by another thread.
     // This is helpful to guarantee forward progress if the other thread
     // is making slow progress.
@@ -136,6 +157,7 @@ void RacefulWorklist<T>::RandomizedView::Visit(Function f) {
   }
 
   worklist_.fully_visited_.store(true, std::memory_order_release);
+  return true;
 }
 
 }  // namespace internal
@@ -26,6 +26,11 @@ class StarScanSnapshot final : public AllocatedOnPCScanMetadataPartition {
     template <typename Function>
     void VisitConcurrently(Function);
 
+    // Visits concurrently until |should_stop| returns true. Returns whether
+    // the worklist was fully visited.
+    template <typename Function, typename StopPredicate>
+    bool VisitConcurrentlyUntil(Function, StopPredicate should_stop);
+
     template <typename Function>
     void VisitNonConcurrently(Function);
 
@@ -75,6 +80,14 @@ void StarScanSnapshot::ViewBase::VisitConcurrently(Function f) {
   view.Visit(std::move(f));
 }
 
+template <typename Function, typename StopPredicate>
+bool StarScanSnapshot::ViewBase::VisitConcurrentlyUntil(
+    Function f,
+    StopPredicate should_stop) {
+  SuperPagesWorklist::RandomizedView view(worklist_);
+  return view.VisitUntil(std::move(f), std::move(should_stop));
+}
+
 template <typename Function>
 void StarScanSnapshot::ViewBase::VisitNonConcurrently(Function f) {
   worklist_.VisitNonConcurrently(std::move(f));
@@ -4,6 +4,8 @@
 
 #include "base/allocator/partition_allocator/starscan/stats_collector.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/time/time.h"
 #include "base/trace_event/base_tracing.h"
@@ -29,6 +31,7 @@ void StatsCollector::ReportTracesAndHists() const {
   ReportTracesAndHistsImpl<Context::kMutator>(mutator_trace_events_);
   ReportTracesAndHistsImpl<Context::kScanner>(scanner_trace_events_);
   ReportSurvivalRate();
+  ReportThroughput();
 }
 
 template <Context context>
@@ -39,7 +42,7 @@ base::TimeDelta StatsCollector::GetTimeImpl(
   for (const auto& tid_and_events : event_map.get_underlying_map_unsafe()) {
     const auto& events = tid_and_events.second;
     const auto& event = events[static_cast<size_t>(id)];
-    overall += (event.end_time - event.start_time);
+    overall += event.duration;
   }
   return overall;
 }
@@ -72,7 +75,7 @@ void StatsCollector::ReportTracesAndHistsImpl(
                         event.start_time);
       TRACE_EVENT_END(kTraceCategory, perfetto::ThreadTrack::ForThread(tid),
                       event.end_time);
-      accumulated_events[id] += (event.end_time - event.start_time);
+      accumulated_events[id] += event.duration;
     }
   }
   // Report UMA if process_name is set.
@@ -103,6 +106,47 @@ void StatsCollector::ReportSurvivalRate() const {
     VLOG(2) << "discarded quarantine size: " << discarded_quarantine_size_;
 }
 
+void StatsCollector::ReportThroughput() const {
+  ReportThroughputImpl(
+      "PCScan.ClearThroughputMBPerSecond", ".Clear.Throughput", cleared_size(),
+      GetTimeImpl<Context::kMutator>(mutator_trace_events_,
+                                     MutatorId::kClear) +
+          GetTimeImpl<Context::kScanner>(scanner_trace_events_,
+                                         ScannerId::kClear));
+  ReportThroughputImpl(
+      "PCScan.ScanThroughputMBPerSecond", ".Scan.Throughput", scanned_size(),
+      GetTimeImpl<Context::kMutator>(mutator_trace_events_, MutatorId::kScan) +
+          GetTimeImpl<Context::kScanner>(scanner_trace_events_,
+                                         ScannerId::kScan));
+  ReportThroughputImpl("PCScan.SweepThroughputMBPerSecond", ".Sweep.Throughput",
+                       swept_size(),
+                       GetTimeImpl<Context::kScanner>(scanner_trace_events_,
+                                                      ScannerId::kSweep));
+}
+
+void StatsCollector::ReportThroughputImpl(const char* trace_name,
+                                          const char* uma_suffix,
+                                          size_t size,
+                                          base::TimeDelta time) const {
+  // Phases that didn't run (e.g. clearing with eager clearing and no card
+  // table) are not reported.
+  if (time.is_zero())
+    return;
+  static constexpr size_t kMB = 1024 * 1024;
+  const size_t mb_per_second =
+      static_cast<size_t>(size / time.InSecondsF() / kMB);
+  TRACE_COUNTER1(kTraceCategory, trace_name, mb_per_second);
+  VLOG(2) << trace_name << ": " << mb_per_second << " (" << size
+          << " bytes in " << time << ")";
+  // Report UMA if process_name is set.
+  if (!process_name_)
+    return;
+  const MetadataString process_name = process_name_;
+  UmaHistogramCounts100000(
+      ("PA.PCScan." + process_name + uma_suffix).c_str(),
+      static_cast<int>(std::min<size_t>(mb_per_second, 100000)));
+}
+
 template base::TimeDelta StatsCollector::GetTimeImpl(
     const DeferredTraceEventMap<Context::kMutator>&,
     IdType<Context::kMutator>) const;
@@ -58,13 +58,20 @@ class StatsCollector final {
   // We don't immediately trace events, but instead defer it until scanning is
   // done. This is needed to avoid unpredictable work that can be done by traces
   // (e.g. recursive mutex lock).
+  // An event registered multiple times by the same thread (e.g. by a mutator
+  // that rejoins an incremental safepoint) is traced from its first begin to
+  // its last end, while |duration| only sums the time between each begin and
+  // end.
   struct DeferredTraceEvent {
     base::TimeTicks start_time;
     base::TimeTicks end_time;
+    base::TimeDelta duration;
+    // Begin of the event that is currently in progress, if any.
+    base::TimeTicks current_start_time;
   };
 
-  // Thread-safe hash-map that maps thread id to scanner events. Doesn't
-  // accumulate events, i.e. every event can only be registered once.
+  // Thread-safe hash-map that maps thread id to scanner events. Accumulates
+  // events that are registered multiple times, see DeferredTraceEvent.
   template <Context context>
   class DeferredTraceEventMap final {
    public:
@@ -123,6 +130,22 @@ class StatsCollector final {
     return survived_quarantine_size_.load(std::memory_order_relaxed);
   }
 
+  // Cleared and scanned sizes are increased concurrently by all scanning
+  // threads and are used to report the throughput of each phase.
+  void IncreaseClearedSize(size_t size) {
+    cleared_size_.fetch_add(size, std::memory_order_relaxed);
+  }
+  size_t cleared_size() const {
+    return cleared_size_.load(std::memory_order_relaxed);
+  }
+
+  void IncreaseScannedSize(size_t size) {
+    scanned_size_.fetch_add(size, std::memory_order_relaxed);
+  }
+  size_t scanned_size() const {
+    return scanned_size_.load(std::memory_order_relaxed);
+  }
+
   void IncreaseSweptSize(size_t size) { swept_size_ += size; }
   size_t swept_size() const { return swept_size_; }
 
@@ -167,10 +190,20 @@ class StatsCollector final {
 
   void ReportSurvivalRate() const;
 
+  // Reports the throughput of the clearing, scanning and sweeping phases in MB
+  // per second of the time spent in the phase, summed over all threads.
+  void ReportThroughput() const;
+  void ReportThroughputImpl(const char* trace_name,
+                            const char* uma_suffix,
+                            size_t size,
+                            base::TimeDelta time) const;
+
   DeferredTraceEventMap<Context::kMutator> mutator_trace_events_;
   DeferredTraceEventMap<Context::kScanner> scanner_trace_events_;
 
   std::atomic<size_t> survived_quarantine_size_{0u};
+  std::atomic<size_t> cleared_size_{0u};
+  std::atomic<size_t> scanned_size_{0u};
   size_t swept_size_ = 0u;
   size_t discarded_quarantine_size_ = 0u;
   const char* process_name_ = nullptr;
@@ -185,9 +218,10 @@ inline void StatsCollector::DeferredTraceEventMap<
   const auto now = base::TimeTicks::Now();
   auto& event_array = events_[tid];
   auto& event = event_array[static_cast<size_t>(id)];
-  PA_DCHECK(event.start_time.is_null());
-  PA_DCHECK(event.end_time.is_null());
-  event.start_time = now;
+  PA_DCHECK(event.current_start_time.is_null());
+  if (event.start_time.is_null())
+    event.start_time = now;
+  event.current_start_time = now;
 }
 
 template <Context context>
@@ -198,9 +232,10 @@ inline void StatsCollector::DeferredTraceEventMap<
   const auto now = base::TimeTicks::Now();
   auto& event_array = events_[tid];
   auto& event = event_array[static_cast<size_t>(id)];
-  PA_DCHECK(!event.start_time.is_null());
-  PA_DCHECK(event.end_time.is_null());
+  PA_DCHECK(!event.current_start_time.is_null());
   event.end_time = now;
+  event.duration += now - event.current_start_time;
+  event.current_start_time = base::TimeTicks();
 }
 
 inline constexpr const char* StatsCollector::ToTracingString(ScannerId id) {
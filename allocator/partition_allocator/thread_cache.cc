@@ -66,10 +66,17 @@ constexpr base::TimeDelta ThreadCacheRegistry::kMinPurgeInterval;
 constexpr base::TimeDelta ThreadCacheRegistry::kMaxPurgeInterval;
 constexpr base::TimeDelta ThreadCacheRegistry::kDefaultPurgeInterval;
 constexpr size_t ThreadCacheRegistry::kMinCachedMemoryForPurging;
+constexpr uint8_t ThreadCache::kAdaptiveLimitRatio;
+constexpr int ThreadCache::kHotBucketEventsPerSecond;
+constexpr size_t ThreadCache::kMinLimit;
+constexpr size_t ThreadCache::kMaxLimit;
+constexpr uint8_t ThreadCache::kFreeBatchSize;
+constexpr size_t ThreadCache::kMaxFreeBatchMemory;
 uint8_t ThreadCache::global_limits_[ThreadCache::kBucketCount];
+std::atomic<bool> ThreadCache::free_batching_enabled_{false};
 
 // Start with the normal size, not the maximum one.
-uint16_t ThreadCache::largest_active_bucket_index_ =
+uint16_t ThreadCache::global_largest_active_bucket_index_ =
     BucketIndexLookup::GetIndex(ThreadCache::kDefaultSizeThreshold);
 
 // static
@@ -201,6 +208,35 @@ void ThreadCacheRegistry::StartPeriodicPurge() {
 void ThreadCacheRegistry::SetLargestActiveBucketIndex(
     uint8_t largest_active_bucket_index) {
   largest_active_bucket_index_ = largest_active_bucket_index;
+
+  // New thread caches start from the global value, update the existing ones.
+  PartitionAutoLock scoped_locker(GetLock());
+  ThreadCache* tcache = list_head_;
+  while (tcache) {
+    PA_DCHECK(ThreadCache::IsValid(tcache));
+    tcache->largest_active_bucket_index_.store(largest_active_bucket_index,
+                                               std::memory_order_relaxed);
+    tcache = tcache->next_;
+  }
+}
+
+void ThreadCacheRegistry::SetAdaptiveSizingEnabled(bool enabled) {
+  adaptive_sizing_enabled_ = enabled;
+}
+
+void ThreadCacheRegistry::AdaptThreadCacheSizes(TimeDelta elapsed) {
+  if (!adaptive_sizing_enabled_)
+    return;
+
+  // Racy, as other threads are still allocating. This is fine, since usage
+  // is only a heuristic, and limits are only read with relaxed ordering.
+  PartitionAutoLock scoped_locker(GetLock());
+  ThreadCache* tcache = list_head_;
+  while (tcache) {
+    PA_DCHECK(ThreadCache::IsValid(tcache));
+    tcache->AdaptToUsage(elapsed);
+    tcache = tcache->next_;
+  }
 }
 
 void ThreadCacheRegistry::SetThreadCacheMultiplier(float multiplier) {
@@ -248,6 +284,9 @@ void ThreadCacheRegistry::PeriodicPurge() {
   if (!periodic_purge_running_)
     return;
 
+  // Time since the previous purge, before |purge_interval_| is updated below.
+  const TimeDelta elapsed = purge_interval_;
+
   // Summing across all threads can be slow, but is necessary. Otherwise we rely
   // on the assumption that the current thread is a good proxy for overall
   // allocation activity. This is not the case for all process types.
@@ -289,6 +328,8 @@ void ThreadCacheRegistry::PeriodicPurge() {
     purge_interval_ = std::min(kMaxPurgeInterval, purge_interval_ * 2);
   }
 
+  // Before purging, as the purge empties the caches which are being adapted.
+  AdaptThreadCacheSizes(elapsed);
   PurgeAll();
 
   PostDelayedPurgeTask();
@@ -297,6 +338,7 @@ void ThreadCacheRegistry::PeriodicPurge() {
 void ThreadCacheRegistry::ResetForTesting() {
   purge_interval_ = kDefaultPurgeInterval;
   periodic_purge_running_ = false;
+  adaptive_sizing_enabled_ = false;
 }
 
 // static
@@ -347,7 +389,7 @@ void ThreadCache::Init(PartitionRoot<ThreadSafe>* root) {
 #endif
   PA_CHECK(root->buckets[kBucketCount - 1].slot_size ==
            ThreadCache::kLargeSizeThreshold);
-  PA_CHECK(root->buckets[largest_active_bucket_index_].slot_size ==
+  PA_CHECK(root->buckets[global_largest_active_bucket_index_].slot_size ==
            ThreadCache::kDefaultSizeThreshold);
 
   EnsureThreadSpecificDataInitialized();
@@ -396,11 +438,6 @@ void ThreadCache::SetGlobalLimits(PartitionRoot<ThreadSafe>* root,
       value = initial_value / 8;
     }
 
-    // Bare minimum so that malloc() / free() in a loop will not hit the central
-    // allocator each time.
-    constexpr size_t kMinLimit = 1;
-    // |PutInBucket()| is called on a full bucket, which should not overflow.
-    constexpr size_t kMaxLimit = std::numeric_limits<uint8_t>::max() - 1;
     global_limits_[index] =
         static_cast<uint8_t>(base::clamp(value, kMinLimit, kMaxLimit));
     PA_DCHECK(global_limits_[index] >= kMinLimit);
@@ -412,11 +449,16 @@ void ThreadCache::SetGlobalLimits(PartitionRoot<ThreadSafe>* root,
 void ThreadCache::SetLargestCachedSize(size_t size) {
   if (size > ThreadCache::kLargeSizeThreshold)
     size = ThreadCache::kLargeSizeThreshold;
-  largest_active_bucket_index_ =
+  global_largest_active_bucket_index_ =
       PartitionRoot<internal::ThreadSafe>::SizeToBucketIndex(size);
-  PA_CHECK(largest_active_bucket_index_ < kBucketCount);
+  PA_CHECK(global_largest_active_bucket_index_ < kBucketCount);
   ThreadCacheRegistry::Instance().SetLargestActiveBucketIndex(
-      largest_active_bucket_index_);
+      global_largest_active_bucket_index_);
+}
+
+// static
+void ThreadCache::SetFreeBatchingEnabled(bool enabled) {
+  free_batching_enabled_.store(enabled, std::memory_order_relaxed);
 }
 
 // static
@@ -464,6 +506,7 @@ ThreadCache* ThreadCache::Create(PartitionRoot<internal::ThreadSafe>* root) {
 
 ThreadCache::ThreadCache(PartitionRoot<ThreadSafe>* root)
     : should_purge_(false),
+      largest_active_bucket_index_(global_largest_active_bucket_index_),
       root_(root),
       thread_id_(PlatformThread::CurrentId()),
       next_(nullptr),
@@ -551,6 +594,7 @@ void ThreadCache::FillBucket(size_t bucket_index) {
   // tries to keep memory usage low. So clearing half of the bucket, and filling
   // a quarter of it are sensible defaults.
   INCREMENT_COUNTER(stats_.batch_fill_count);
+  IncrementUsageCounter(bucket_usage_[bucket_index].misses);
 
   Bucket& bucket = buckets_[bucket_index];
   // Some buckets may have a limit lower than |kBatchFillRatio|, but we still
@@ -602,6 +646,71 @@ void ThreadCache::FillBucket(size_t bucket_index) {
   cached_memory_ += allocated_slots * bucket.slot_size;
 }
 
+void ThreadCache::AdaptToUsage(TimeDelta elapsed) {
+  // Bucket usage is measured in events, misses and overflows, which both
+  // require a trip to the central allocator. A bucket with many events needs a
+  // higher limit to serve bursts of allocations or deallocations from the
+  // cache, and a bucket with almost none caches more than it needs.
+  //
+  // Since the periodic purge empties the cache, a bucket which was used at all
+  // since the last purge missed at least once. Buckets above the default size
+  // threshold which were not used are not cached anymore, and larger buckets
+  // which miss often start being cached. The size threshold never goes below
+  // the default one, unless it was configured lower.
+  const double hot_bucket_event_count =
+      kHotBucketEventsPerSecond * elapsed.InSecondsF();
+  const uint16_t largest_active_bucket_index =
+      largest_active_bucket_index_.load(std::memory_order_relaxed);
+  uint16_t new_largest_active_bucket_index = std::min(
+      static_cast<uint16_t>(BucketIndexLookup::GetIndex(kDefaultSizeThreshold)),
+      global_largest_active_bucket_index_);
+
+  for (uint16_t index = 0; index < kBucketCount; index++) {
+    BucketUsage& usage = bucket_usage_[index];
+    const uint32_t misses = usage.misses.load(std::memory_order_relaxed);
+    const uint32_t overflows = usage.overflows.load(std::memory_order_relaxed);
+    // Unsigned arithmetic, so wrapping around is fine.
+    const uint32_t events =
+        (misses - usage.last_misses) + (overflows - usage.last_overflows);
+    usage.last_misses = misses;
+    usage.last_overflows = overflows;
+
+    Bucket& bucket = buckets_[index];
+    const size_t limit = bucket.limit.load(std::memory_order_relaxed);
+    const size_t global_limit = global_limits_[index];
+    // Invalid bucket.
+    if (!limit || !global_limit)
+      continue;
+
+    const bool is_hot = events >= hot_bucket_event_count;
+    if (index > largest_active_bucket_index) {
+      if (is_hot)
+        new_largest_active_bucket_index = index;
+      continue;
+    }
+    if (events) {
+      new_largest_active_bucket_index =
+          std::max(new_largest_active_bucket_index, index);
+    }
+
+    size_t new_limit = limit;
+    if (is_hot)
+      new_limit = limit * 2;
+    else if (events <= 1)
+      new_limit = limit / 2;
+    new_limit = base::clamp(
+        new_limit, std::max(kMinLimit, global_limit / kAdaptiveLimitRatio),
+        std::min(kMaxLimit, global_limit * kAdaptiveLimitRatio));
+    // As for |SetThreadCacheMultiplier()|, a lower limit is enforced at the
+    // next deallocation.
+    bucket.limit.store(static_cast<uint8_t>(new_limit),
+                       std::memory_order_relaxed);
+  }
+
+  largest_active_bucket_index_.store(new_largest_active_bucket_index,
+                                     std::memory_order_relaxed);
+}
+
 void ThreadCache::ClearBucket(ThreadCache::Bucket& bucket, size_t limit) {
   // Avoids acquiring the lock needlessly.
   if (!bucket.count || bucket.count <= limit)
@@ -657,6 +766,40 @@ void ThreadCache::FreeAfter(PartitionFreelistEntry* head, size_t slot_size) {
   }
 }
 
+void ThreadCache::AddToFreeBatch(void* slot_start, size_t bucket_index) {
+  PA_DCHECK(free_batch_count_ < kFreeBatchSize);
+  free_batch_[free_batch_count_++] = slot_start;
+  free_batch_memory_ += buckets_[bucket_index].slot_size;
+  if (free_batch_count_ == kFreeBatchSize ||
+      free_batch_memory_ >= kMaxFreeBatchMemory) {
+    FlushFreeBatch();
+  }
+
+  if (UNLIKELY(should_purge_.load(std::memory_order_relaxed)))
+    PurgeInternal();
+}
+
+void ThreadCache::FlushFreeBatch() {
+  if (!free_batch_count_)
+    return;
+
+  INCREMENT_COUNTER(stats_.batch_free_count);
+  // As in |PartitionRoot::RawFree()|, fault the slots in before locking, so as
+  // not to be descheduled while holding the lock. Unlike the cached slots, they
+  // haven't been touched by the thread cache.
+  for (size_t i = 0; i < free_batch_count_; i++)
+    *reinterpret_cast<volatile uintptr_t*>(free_batch_[i]) = 0;
+  __asm__ __volatile__("" : : : "memory");
+
+  {
+    internal::ScopedGuard<internal::ThreadSafe> guard(root_->lock_);
+    for (size_t i = 0; i < free_batch_count_; i++)
+      root_->RawFreeLocked(free_batch_[i]);
+  }
+  free_batch_count_ = 0;
+  free_batch_memory_ = 0;
+}
+
 void ThreadCache::ResetForTesting() {
   stats_.alloc_count = 0;
   stats_.alloc_hits = 0;
@@ -670,8 +813,10 @@ void ThreadCache::ResetForTesting() {
   stats_.cache_fill_misses = 0;
 
   stats_.batch_fill_count = 0;
+  stats_.batch_free_count = 0;
 
   stats_.bucket_total_memory = 0;
+  stats_.free_batch_memory = 0;
   stats_.metadata_overhead = 0;
 
   Purge();
@@ -700,6 +845,7 @@ void ThreadCache::AccumulateStats(ThreadCacheStats* stats) const {
   stats->cache_fill_misses += stats_.cache_fill_misses;
 
   stats->batch_fill_count += stats_.batch_fill_count;
+  stats->batch_free_count += stats_.batch_free_count;
 
 #if defined(PA_THREAD_CACHE_ALLOC_STATS)
   for (size_t i = 0; i < kNumBuckets + 1; i++)
@@ -710,6 +856,7 @@ void ThreadCache::AccumulateStats(ThreadCacheStats* stats) const {
   // this function can be called racily from another thread, to collect
   // statistics. Hence no DCHECK_EQ(CachedMemory(), cached_memory_).
   stats->bucket_total_memory += cached_memory_;
+  stats->free_batch_memory += free_batch_memory_;
 
   stats->metadata_overhead += sizeof(*this);
 }
@@ -732,6 +879,7 @@ void ThreadCache::PurgeCurrentThread() {
 
 void ThreadCache::PurgeInternal() {
   should_purge_.store(false, std::memory_order_relaxed);
+  FlushFreeBatch();
   // TODO(lizeb): Investigate whether lock acquisition should be less frequent.
   //
   // Note: iterate over all buckets, even the inactive ones. Since
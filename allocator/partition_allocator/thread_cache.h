@@ -146,6 +146,16 @@ class BASE_EXPORT ThreadCacheRegistry {
   void SetThreadCacheMultiplier(float multiplier);
   void SetLargestActiveBucketIndex(uint8_t largest_active_bucket_index);
 
+  // When adaptive sizing is enabled, each periodic purge adjusts the limit of
+  // each bucket of each thread cache, and the largest size it caches, to the
+  // rate at which it missed since the previous purge. See
+  // |ThreadCache::AdaptToUsage()|.
+  void SetAdaptiveSizingEnabled(bool enabled);
+  // Adapts all thread caches to their usage during the last |elapsed|, if
+  // adaptive sizing is enabled. Called by the periodic purge, public for
+  // benchmarks which don't run it.
+  void AdaptThreadCacheSizes(TimeDelta elapsed);
+
   static PartitionLock& GetLock() { return Instance().lock_; }
   // Purges all thread caches *now*. This is completely thread-unsafe, and
   // should only be called in a post-fork() handler.
@@ -171,6 +181,7 @@ class BASE_EXPORT ThreadCacheRegistry {
   ThreadCache* list_head_ GUARDED_BY(GetLock()) = nullptr;
   base::TimeDelta purge_interval_ = kDefaultPurgeInterval;
   bool periodic_purge_running_ = false;
+  bool adaptive_sizing_enabled_ = false;
 
 #if defined(OS_NACL)
   // The thread cache is never used with NaCl, but its compiler doesn't
@@ -322,6 +333,19 @@ class BASE_EXPORT ThreadCache {
   // |kLargeSizeThreshold|.
   static void SetLargestCachedSize(size_t size);
 
+  // When enabled, slots which are freed on this thread but are too large to be
+  // cached (though not larger than |kLargeSizeThreshold|) are not returned to
+  // the central allocator one at a time, but in batches, acquiring the lock
+  // once per batch. This matters when a thread frees many objects allocated
+  // by other threads, as in producer/consumer pipelines, since these objects
+  // are not reused by the freeing thread. This applies to all threads.
+  static void SetFreeBatchingEnabled(bool enabled);
+
+  // A free batch is returned to the central allocator once it has this many
+  // slots, or this much memory.
+  static constexpr uint8_t kFreeBatchSize = 32;
+  static constexpr size_t kMaxFreeBatchMemory = 256 * 1024;
+
   // Fill 1 / kBatchFillRatio * bucket.limit slots at a time.
   static constexpr uint16_t kBatchFillRatio = 8;
 
@@ -335,6 +359,13 @@ class BASE_EXPORT ThreadCache {
   static constexpr size_t kLargeSizeThreshold =
       ThreadCacheLimits::kLargeSizeThreshold;
 
+  // With adaptive sizing, the limit of a bucket stays within
+  // [global limit / kAdaptiveLimitRatio, global limit * kAdaptiveLimitRatio].
+  static constexpr uint8_t kAdaptiveLimitRatio = 4;
+  // With adaptive sizing, a bucket which misses or overflows at least this
+  // often gets a higher limit, or gets cached if it wasn't.
+  static constexpr int kHotBucketEventsPerSecond = 10;
+
  private:
   friend class tools::ThreadCacheInspector;
 
@@ -348,6 +379,20 @@ class BASE_EXPORT ThreadCache {
     Bucket();
   };
   static_assert(sizeof(Bucket) <= 2 * sizeof(void*), "Keep Bucket small.");
+
+  // Usage of a bucket, which drives adaptive sizing. Only counts events which
+  // are on slow paths anyway, to keep the fast paths unchanged.
+  struct BucketUsage {
+    // Allocations which were not served from the bucket, either because it
+    // was empty or because it is not cached. Incremented by the thread owning
+    // the cache, read by the registry.
+    std::atomic<uint32_t> misses{0};
+    // Deallocations which overflowed the bucket.
+    std::atomic<uint32_t> overflows{0};
+    // Values of the counters at the last |AdaptToUsage()| call.
+    uint32_t last_misses = 0;
+    uint32_t last_overflows = 0;
+  };
   enum class Mode { kNormal, kPurge, kNotifyRegistry };
 
   explicit ThreadCache(PartitionRoot<ThreadSafe>* root);
@@ -361,8 +406,28 @@ class BASE_EXPORT ThreadCache {
   void ResetForTesting();
   // Releases the entire freelist starting at |head| to the root.
   void FreeAfter(PartitionFreelistEntry* head, size_t slot_size);
+  // Adds a slot of an uncached bucket to the free batch, flushing it if full.
+  void AddToFreeBatch(void* slot_start, size_t bucket_index);
+  // Returns all the slots in the free batch to the root.
+  void FlushFreeBatch();
   static void SetGlobalLimits(PartitionRoot<ThreadSafe>* root,
                               float multiplier);
+  // Adjusts the limit of each bucket and the largest cached bucket to the
+  // misses and overflows of each bucket since the previous call, |elapsed|
+  // ago. Can be called from any thread, with the registry lock held.
+  void AdaptToUsage(TimeDelta elapsed);
+  // Only called from the thread owning the cache, hence no atomic increment.
+  ALWAYS_INLINE static void IncrementUsageCounter(
+      std::atomic<uint32_t>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+  }
+
+  // Bare minimum so that malloc() / free() in a loop will not hit the central
+  // allocator each time.
+  static constexpr size_t kMinLimit = 1;
+  // |PutInBucket()| is called on a full bucket, which should not overflow.
+  static constexpr size_t kMaxLimit = std::numeric_limits<uint8_t>::max() - 1;
 
 #if defined(OS_NACL)
   // The thread cache is never used with NaCl, but its compiler doesn't
@@ -393,20 +458,30 @@ class BASE_EXPORT ThreadCache {
   static uint8_t global_limits_[kBucketCount];
   // Index of the largest active bucket. Not all processes/platforms will use
   // all buckets, as using larger buckets increases the memory footprint.
-  //
-  // TODO(lizeb): Investigate making this per-thread rather than static, to
-  // improve locality, and open the door to per-thread settings.
-  static uint16_t largest_active_bucket_index_;
+  static uint16_t global_largest_active_bucket_index_;
+  // Read on every free() which misses the cache, and can be set concurrently.
+  static std::atomic<bool> free_batching_enabled_;
 
   // These are at the beginning as they're accessed for each allocation.
   uint32_t cached_memory_ = 0;
   std::atomic<bool> should_purge_;
+  // Per-thread copy of |global_largest_active_bucket_index_|, for locality,
+  // and so that adaptive sizing can change it. Can be changed from another
+  // thread.
+  std::atomic<uint16_t> largest_active_bucket_index_;
   ThreadCacheStats stats_;
 
   // Buckets are quite big, though each is only 2 pointers.
   Bucket buckets_[kBucketCount];
 
   // Cold data below.
+  BucketUsage bucket_usage_[kBucketCount];
+  // Slots waiting to be returned to the central allocator, see
+  // |SetFreeBatchingEnabled()|. Not counted in |cached_memory_|, as they
+  // cannot be allocated from the thread cache.
+  void* free_batch_[kFreeBatchSize];
+  uint8_t free_batch_count_ = 0;
+  uint32_t free_batch_memory_ = 0;
   PartitionRoot<ThreadSafe>* const root_;
   const PlatformThreadId thread_id_;
 #if DCHECK_IS_ON()
@@ -441,6 +516,16 @@ class BASE_EXPORT ThreadCache {
   FRIEND_TEST_ALL_PREFIXES(PartitionAllocThreadCacheTest,
                            DynamicSizeThresholdPurge);
   FRIEND_TEST_ALL_PREFIXES(PartitionAllocThreadCacheTest, ClearFromTail);
+  FRIEND_TEST_ALL_PREFIXES(PartitionAllocThreadCacheTest,
+                           AdaptiveSizingGrowsHotBuckets);
+  FRIEND_TEST_ALL_PREFIXES(PartitionAllocThreadCacheTest,
+                           AdaptiveSizingShrinksColdBuckets);
+  FRIEND_TEST_ALL_PREFIXES(PartitionAllocThreadCacheTest,
+                           AdaptiveSizeThreshold);
+  FRIEND_TEST_ALL_PREFIXES(PartitionAllocThreadCacheTest, FreeBatching);
+  FRIEND_TEST_ALL_PREFIXES(PartitionAllocThreadCacheTest, FreeBatchingPurge);
+  FRIEND_TEST_ALL_PREFIXES(PartitionAllocThreadCacheTest,
+                           FreeBatchingOtherThread);
 };
 
 ALWAYS_INLINE bool ThreadCache::MaybePutInCache(void* slot_start,
@@ -448,8 +533,16 @@ ALWAYS_INLINE bool ThreadCache::MaybePutInCache(void* slot_start,
   PA_REENTRANCY_GUARD(is_in_thread_cache_);
   INCREMENT_COUNTER(stats_.cache_fill_count);
 
-  if (UNLIKELY(bucket_index > largest_active_bucket_index_)) {
+  if (UNLIKELY(bucket_index >
+               largest_active_bucket_index_.load(std::memory_order_relaxed))) {
     INCREMENT_COUNTER(stats_.cache_fill_misses);
+    // The slot cannot be cached, but returning it to the central allocator can
+    // still be amortized.
+    if (free_batching_enabled_.load(std::memory_order_relaxed) &&
+        bucket_index < kBucketCount) {
+      AddToFreeBatch(slot_start, bucket_index);
+      return true;
+    }
     return false;
   }
 
@@ -468,6 +561,7 @@ ALWAYS_INLINE bool ThreadCache::MaybePutInCache(void* slot_start,
   uint8_t limit = bucket.limit.load(std::memory_order_relaxed);
   // Batched deallocation, amortizing lock acquisitions.
   if (UNLIKELY(bucket.count > limit)) {
+    IncrementUsageCounter(bucket_usage_[bucket_index].overflows);
     ClearBucket(bucket, limit / 2);
   }
 
@@ -486,9 +580,13 @@ ALWAYS_INLINE void* ThreadCache::GetFromCache(size_t bucket_index,
   PA_REENTRANCY_GUARD(is_in_thread_cache_);
   INCREMENT_COUNTER(stats_.alloc_count);
   // Only handle "small" allocations.
-  if (UNLIKELY(bucket_index > largest_active_bucket_index_)) {
+  if (UNLIKELY(bucket_index >
+               largest_active_bucket_index_.load(std::memory_order_relaxed))) {
     INCREMENT_COUNTER(stats_.alloc_miss_too_large);
     INCREMENT_COUNTER(stats_.alloc_misses);
+    // Tells adaptive sizing that the bucket could be worth caching.
+    if (bucket_index < kBucketCount)
+      IncrementUsageCounter(bucket_usage_[bucket_index].misses);
     return nullptr;
   }
 
@@ -46,6 +46,9 @@ constexpr size_t kFillCountForMediumBucket =
 
 static_assert(kMediumSize <= ThreadCache::kDefaultSizeThreshold, "");
 
+// Interval between two adaptations of the thread cache sizes.
+constexpr TimeDelta kAdaptInterval = TimeDelta::FromSeconds(1);
+
 class LambdaThreadDelegate : public PlatformThread::Delegate {
  public:
   explicit LambdaThreadDelegate(RepeatingClosure f) : f_(std::move(f)) {}
@@ -100,6 +103,7 @@ class PartitionAllocThreadCacheTest : public ::testing::Test {
 
   ~PartitionAllocThreadCacheTest() override {
     ThreadCache::SetLargestCachedSize(ThreadCache::kDefaultSizeThreshold);
+    ThreadCache::SetFreeBatchingEnabled(false);
     SwapInProcessThreadCacheForTesting(root_);
 
     ThreadSafePartitionRoot::DeleteForTesting(root_);
@@ -168,6 +172,24 @@ class PartitionAllocThreadCacheTest : public ::testing::Test {
     ASSERT_GE(ThreadCache::Get()->CachedMemory(), target_cached_memory);
   }
 
+  static size_t BucketLimit(ThreadCache* tcache, size_t index) {
+    return tcache->buckets_[index].limit.load(std::memory_order_relaxed);
+  }
+
+  static size_t LargestActiveBucketIndex(ThreadCache* tcache) {
+    return tcache->largest_active_bucket_index_.load(std::memory_order_relaxed);
+  }
+
+  // Enables adaptive sizing, starting from the default limits and size
+  // threshold, and from no recorded usage.
+  void EnableAdaptiveSizing() {
+    auto& registry = ThreadCacheRegistry::Instance();
+    registry.SetAdaptiveSizingEnabled(true);
+    registry.AdaptThreadCacheSizes(kAdaptInterval);
+    registry.SetThreadCacheMultiplier(ThreadCache::kDefaultMultiplier);
+    ThreadCache::SetLargestCachedSize(ThreadCache::kDefaultSizeThreshold);
+  }
+
   ThreadSafePartitionRoot* root_;
   base::test::TaskEnvironment task_env_;
 };
@@ -831,6 +853,197 @@ TEST_F(PartitionAllocThreadCacheTest, ClearFromTail) {
   EXPECT_EQ(nullptr, static_cast<void*>(tcache->buckets_[index].freelist_head));
 }
 
+TEST_F(PartitionAllocThreadCacheTest, AdaptiveSizingGrowsHotBuckets) {
+  auto* tcache = root_->thread_cache_for_testing();
+  auto& registry = ThreadCacheRegistry::Instance();
+  EnableAdaptiveSizing();
+
+  // Not enabled, nothing changes.
+  registry.SetAdaptiveSizingEnabled(false);
+  size_t bucket_index = FillThreadCacheAndReturnIndex(kMediumSize, 1000);
+  registry.AdaptThreadCacheSizes(kAdaptInterval);
+  EXPECT_EQ(kDefaultCountForMediumBucket, BucketLimit(tcache, bucket_index));
+
+  // Many misses: the limit doubles.
+  EnableAdaptiveSizing();
+  FillThreadCacheAndReturnIndex(kMediumSize, 1000);
+  registry.AdaptThreadCacheSizes(kAdaptInterval);
+  EXPECT_EQ(2 * kDefaultCountForMediumBucket,
+            BucketLimit(tcache, bucket_index));
+
+  // Up to a maximum.
+  for (int i = 0; i < 10; i++) {
+    FillThreadCacheAndReturnIndex(kMediumSize, 1000);
+    registry.AdaptThreadCacheSizes(kAdaptInterval);
+  }
+  size_t max_limit = std::min(
+      ThreadCache::kMaxLimit,
+      ThreadCache::kAdaptiveLimitRatio * kDefaultCountForMediumBucket);
+  EXPECT_EQ(max_limit, BucketLimit(tcache, bucket_index));
+
+  // The same misses over a much longer interval are not frequent enough to
+  // grow the limit, nor rare enough to shrink it.
+  registry.SetThreadCacheMultiplier(ThreadCache::kDefaultMultiplier);
+  FillThreadCacheAndReturnIndex(kMediumSize, 1000);
+  registry.AdaptThreadCacheSizes(1000 * kAdaptInterval);
+  EXPECT_EQ(kDefaultCountForMediumBucket, BucketLimit(tcache, bucket_index));
+}
+
+TEST_F(PartitionAllocThreadCacheTest, AdaptiveSizingShrinksColdBuckets) {
+  auto* tcache = root_->thread_cache_for_testing();
+  auto& registry = ThreadCacheRegistry::Instance();
+  EnableAdaptiveSizing();
+
+  // A single miss: the limit halves.
+  size_t bucket_index = FillThreadCacheAndReturnIndex(kMediumSize);
+  registry.AdaptThreadCacheSizes(kAdaptInterval);
+  EXPECT_EQ(kDefaultCountForMediumBucket / 2,
+            BucketLimit(tcache, bucket_index));
+
+  // Down to a minimum.
+  for (int i = 0; i < 10; i++)
+    registry.AdaptThreadCacheSizes(kAdaptInterval);
+  EXPECT_EQ(kDefaultCountForMediumBucket / ThreadCache::kAdaptiveLimitRatio,
+            BucketLimit(tcache, bucket_index));
+
+  // The bucket is still cached.
+  FillThreadCacheAndReturnIndex(kMediumSize);
+  EXPECT_GT(tcache->buckets_[bucket_index].count, 0u);
+}
+
+TEST_F(PartitionAllocThreadCacheTest, AdaptiveSizeThreshold) {
+  constexpr size_t kLargeSize = 2048;
+  static_assert(kLargeSize > ThreadCache::kDefaultSizeThreshold, "");
+  static_assert(kLargeSize <= ThreadCache::kLargeSizeThreshold, "");
+
+  auto* tcache = root_->thread_cache_for_testing();
+  auto& registry = ThreadCacheRegistry::Instance();
+  EnableAdaptiveSizing();
+  const size_t default_index = PartitionRoot<ThreadSafe>::SizeToBucketIndex(
+      ThreadCache::kDefaultSizeThreshold);
+  EXPECT_EQ(default_index, LargestActiveBucketIndex(tcache));
+
+  // Not cached.
+  size_t bucket_index = FillThreadCacheAndReturnIndex(kLargeSize, 100);
+  EXPECT_EQ(0u, tcache->buckets_[bucket_index].count);
+
+  // Misses often enough to be cached.
+  registry.AdaptThreadCacheSizes(kAdaptInterval);
+  EXPECT_EQ(bucket_index, LargestActiveBucketIndex(tcache));
+  FillThreadCacheAndReturnIndex(kLargeSize);
+  EXPECT_GT(tcache->buckets_[bucket_index].count, 0u);
+
+  // Used since the last adaptation, still cached.
+  tcache->Purge();
+  registry.AdaptThreadCacheSizes(kAdaptInterval);
+  EXPECT_EQ(bucket_index, LargestActiveBucketIndex(tcache));
+
+  // Unused, not cached anymore.
+  registry.AdaptThreadCacheSizes(kAdaptInterval);
+  EXPECT_EQ(default_index, LargestActiveBucketIndex(tcache));
+
+  // Setting the size threshold explicitly overrides adaptive sizing.
+  ThreadCache::SetLargestCachedSize(ThreadCache::kLargeSizeThreshold);
+  EXPECT_EQ(PartitionRoot<ThreadSafe>::SizeToBucketIndex(
+                ThreadCache::kLargeSizeThreshold),
+            LargestActiveBucketIndex(tcache));
+}
+
+TEST_F(PartitionAllocThreadCacheTest, FreeBatching) {
+  constexpr size_t kLargeSize = 2048;
+  static_assert(kLargeSize > ThreadCache::kDefaultSizeThreshold, "");
+
+  ThreadCache::SetLargestCachedSize(ThreadCache::kDefaultSizeThreshold);
+  ThreadCache::SetFreeBatchingEnabled(true);
+  auto* tcache = root_->thread_cache_for_testing();
+  DeltaCounter batch_free_counter{tcache->stats_.batch_free_count};
+
+  void* ptrs[ThreadCache::kFreeBatchSize];
+  for (void*& ptr : ptrs)
+    ptr = root_->Alloc(kLargeSize, "");
+  size_t bucket_index = root_->SizeToBucketIndex(kLargeSize);
+  size_t slot_size = root_->buckets[bucket_index].slot_size;
+  size_t allocated_bytes = root_->get_total_size_of_allocated_bytes();
+
+  // Not cached, batched instead. Batched slots are still accounted for as
+  // allocated, like cached ones.
+  for (size_t i = 0; i < ThreadCache::kFreeBatchSize - 1; i++)
+    root_->Free(ptrs[i]);
+  EXPECT_EQ(0u, tcache->buckets_[bucket_index].count);
+  EXPECT_EQ(0u, batch_free_counter.Delta());
+  EXPECT_EQ((ThreadCache::kFreeBatchSize - 1) * slot_size,
+            tcache->free_batch_memory_);
+  EXPECT_EQ(allocated_bytes, root_->get_total_size_of_allocated_bytes());
+
+  // The batch is full, returned to the central allocator.
+  root_->Free(ptrs[ThreadCache::kFreeBatchSize - 1]);
+  EXPECT_EQ(1u, batch_free_counter.Delta());
+  EXPECT_EQ(0u, tcache->free_batch_count_);
+  EXPECT_EQ(0u, tcache->free_batch_memory_);
+  EXPECT_EQ(allocated_bytes - ThreadCache::kFreeBatchSize * slot_size,
+            root_->get_total_size_of_allocated_bytes());
+}
+
+TEST_F(PartitionAllocThreadCacheTest, FreeBatchingPurge) {
+  constexpr size_t kLargeSize = 2048;
+  ThreadCache::SetLargestCachedSize(ThreadCache::kDefaultSizeThreshold);
+  ThreadCache::SetFreeBatchingEnabled(true);
+  auto* tcache = root_->thread_cache_for_testing();
+  DeltaCounter batch_free_counter{tcache->stats_.batch_free_count};
+
+  void* ptrs[3];
+  for (void*& ptr : ptrs)
+    ptr = root_->Alloc(kLargeSize, "");
+  size_t allocated_bytes = root_->get_total_size_of_allocated_bytes();
+  for (void* ptr : ptrs)
+    root_->Free(ptr);
+  EXPECT_EQ(3u, tcache->free_batch_count_);
+
+  tcache->Purge();
+  EXPECT_EQ(1u, batch_free_counter.Delta());
+  EXPECT_EQ(0u, tcache->free_batch_count_);
+  EXPECT_EQ(0u, tcache->free_batch_memory_);
+  EXPECT_LT(root_->get_total_size_of_allocated_bytes(), allocated_bytes);
+
+  // Nothing to return, not counted.
+  tcache->Purge();
+  EXPECT_EQ(1u, batch_free_counter.Delta());
+}
+
+// Objects allocated by one thread and freed by another one are returned in
+// batches by the freeing thread, and flushed when it exits.
+TEST_F(PartitionAllocThreadCacheTest, FreeBatchingOtherThread) {
+  constexpr size_t kLargeSize = 2048;
+  constexpr size_t kCount = ThreadCache::kFreeBatchSize * 3 + 1;
+  ThreadCache::SetLargestCachedSize(ThreadCache::kDefaultSizeThreshold);
+  ThreadCache::SetFreeBatchingEnabled(true);
+
+  size_t allocated_bytes = root_->get_total_size_of_allocated_bytes();
+  std::vector<void*> ptrs(kCount);
+  for (void*& ptr : ptrs)
+    ptr = root_->Alloc(kLargeSize, "");
+
+  LambdaThreadDelegate delegate{BindLambdaForTesting([&]() {
+    // Creates the thread cache.
+    root_->Free(root_->Alloc(kSmallSize, ""));
+    auto* tcache = root_->thread_cache_for_testing();
+    ASSERT_TRUE(tcache);
+    DeltaCounter batch_free_counter{tcache->stats_.batch_free_count};
+
+    for (void* ptr : ptrs)
+      root_->Free(ptr);
+    EXPECT_EQ(3u, batch_free_counter.Delta());
+    EXPECT_EQ(1u, tcache->free_batch_count_);
+  })};
+
+  PlatformThreadHandle thread_handle;
+  PlatformThread::Create(0, &delegate, &thread_handle);
+  PlatformThread::Join(thread_handle);
+
+  // The last batch was returned when the thread exited.
+  EXPECT_EQ(allocated_bytes, root_->get_total_size_of_allocated_bytes());
+}
+
 TEST_F(PartitionAllocThreadCacheTest, Bookkeeping) {
   void* arr[kFillCountForMediumBucket] = {};
   auto* tcache = root_->thread_cache_for_testing();
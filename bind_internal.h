@@ -9,6 +9,7 @@
 
 #include <functional>
 #include <memory>
+#include <new>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -871,6 +872,21 @@ struct BindState final : BindStateBase {
                          std::forward<ForwardBoundArgs>(bound_args)...);
   }
 
+  // Like Create(), but constructs the BindState in |storage|, the inline
+  // storage of a callback. See CanStoreBindStateInline.
+  template <typename ForwardFunctor, typename... ForwardBoundArgs>
+  static BindState* CreateInline(void* storage,
+                                 BindStateBase::InvokeFuncStorage invoke_func,
+                                 ForwardFunctor&& functor,
+                                 ForwardBoundArgs&&... bound_args) {
+    BanUnconstructedRefCountedReceiver<ForwardFunctor>(bound_args...);
+    BindState* bind_state = new (storage) BindState(
+        IsCancellable{}, invoke_func, std::forward<ForwardFunctor>(functor),
+        std::forward<ForwardBoundArgs>(bound_args)...);
+    bind_state->SetInline();
+    return bind_state;
+  }
+
   Functor functor_;
   std::tuple<BoundArgs...> bound_args_;
 
@@ -915,13 +931,52 @@ struct BindState final : BindStateBase {
     }
   }
 
+  // Moves the inline BindState |other| to a new inline BindState.
+  BindState(InlineBindStateTag, BindState* other)
+      : BindStateBase(other->polymorphic_invoke_,
+                      nullptr,
+                      other->query_cancellation_traits_),
+        functor_(std::move(other->functor_)),
+        bound_args_(std::move(other->bound_args_)) {
+    SetInline();
+  }
+
   ~BindState() = default;
 
+  // Marks the BindState as inline. It is never destroyed.
+  void SetInline() {
+    is_inline_ = true;
+    relocate_ = &Relocate;
+  }
+
   static void Destroy(const BindStateBase* self) {
     delete static_cast<const BindState*>(self);
   }
+
+  static BindStateBase* Relocate(BindStateBase* self, void* storage) {
+    return new (storage)
+        BindState(InlineBindStateTag(), static_cast<BindState*>(self));
+  }
 };
 
+// Whether a BindState can be stored inline in a callback, instead of being
+// allocated on the heap: it must fit InlineBindStateStorage, and be cheap to
+// relocate and safe to leave undestroyed, which holds if its functor and bound
+// arguments are trivially copyable. In particular, WeakPtr and scoped_refptr
+// arguments are stored on the heap.
+template <typename BindStateType>
+struct CanStoreBindStateInline;
+
+template <typename Functor, typename... BoundArgs>
+struct CanStoreBindStateInline<BindState<Functor, BoundArgs...>>
+    : bool_constant<
+          sizeof(BindState<Functor, BoundArgs...>) <=
+              sizeof(InlineBindStateStorage) &&
+          alignof(BindState<Functor, BoundArgs...>) <=
+              alignof(InlineBindStateStorage) &&
+          conjunction<std::is_trivially_copyable<Functor>,
+                      std::is_trivially_copyable<BoundArgs>...>::value> {};
+
 // Used to implement MakeBindStateType.
 template <bool is_method, typename Functor, typename... BoundArgs>
 struct MakeBindStateTypeImpl;
@@ -1192,6 +1247,22 @@ constexpr auto GetInvokeFunc(std::false_type) {
   return Invoker::Run;
 }
 
+// Used below in BindImpl to create the callback, with its BindState stored
+// inline if |store_inline| is true.
+template <typename CallbackType, typename BindState, typename... Args>
+CallbackType CreateCallback(std::false_type store_inline, Args&&... args) {
+  return CallbackType(BindState::Create(std::forward<Args>(args)...));
+}
+
+template <typename CallbackType, typename BindState, typename... Args>
+CallbackType CreateCallback(std::true_type store_inline, Args&&... args) {
+  return CallbackType(InlineBindStateTag(),
+                      [&](void* storage) -> BindStateBase* {
+                        return BindState::CreateInline(
+                            storage, std::forward<Args>(args)...);
+                      });
+}
+
 template <template <typename> class CallbackT,
           typename Functor,
           typename... Args>
@@ -1224,10 +1295,15 @@ decltype(auto) BindImpl(Functor&& functor, Args&&... args) {
   PolymorphicInvoke invoke_func =
       GetInvokeFunc<Invoker>(bool_constant<kIsOnce>());
 
+  // Only OnceCallbacks store their BindState inline, since copies of a
+  // RepeatingCallback share it.
+  using StoreInline =
+      bool_constant<kIsOnce && CanStoreBindStateInline<BindState>::value>;
+
   using InvokeFuncStorage = BindStateBase::InvokeFuncStorage;
-  return CallbackType(BindState::Create(
-      reinterpret_cast<InvokeFuncStorage>(invoke_func),
-      std::forward<Functor>(functor), std::forward<Args>(args)...));
+  return CreateCallback<CallbackType, BindState>(
+      StoreInline(), reinterpret_cast<InvokeFuncStorage>(invoke_func),
+      std::forward<Functor>(functor), std::forward<Args>(args)...);
 }
 
 // Special cases for binding to a base::{Once, Repeating}Callback without extra
@@ -15,6 +15,7 @@
 #include "base/bind.h"
 #include "base/callback_forward.h"
 #include "base/callback_internal.h"
+#include "base/gtest_prod_util.h"
 #include "base/notreached.h"
 
 // -----------------------------------------------------------------------------
@@ -67,11 +68,25 @@ class OnceCallback<R(Args...)> : public internal::CallbackBase {
   explicit OnceCallback(internal::BindStateBase* bind_state)
       : internal::CallbackBase(bind_state) {}
 
+  // Creates the BindState in |inline_storage_| with |create_bind_state|,
+  // which takes a pointer to the storage and returns the BindStateBase it
+  // constructed there.
+  template <typename CreateBindState>
+  OnceCallback(internal::InlineBindStateTag,
+               CreateBindState create_bind_state) {
+    SetInlineBindState(create_bind_state(inline_storage_.bytes));
+  }
+
   OnceCallback(const OnceCallback&) = delete;
   OnceCallback& operator=(const OnceCallback&) = delete;
 
-  OnceCallback(OnceCallback&&) noexcept = default;
-  OnceCallback& operator=(OnceCallback&&) noexcept = default;
+  OnceCallback(OnceCallback&& other) noexcept {
+    TakeBindState(&other, &inline_storage_);
+  }
+  OnceCallback& operator=(OnceCallback&& other) noexcept {
+    MoveAssign(&other, &inline_storage_);
+    return *this;
+  }
 
   OnceCallback(RepeatingCallback<RunType> other)
       : internal::CallbackBase(std::move(other)) {}
@@ -96,7 +111,7 @@ class OnceCallback<R(Args...)> : public internal::CallbackBase {
     OnceCallback cb = std::move(*this);
     PolymorphicInvoke f =
         reinterpret_cast<PolymorphicInvoke>(cb.polymorphic_invoke());
-    return f(cb.bind_state_.get(), std::forward<Args>(args)...);
+    return f(cb.bind_state(), std::forward<Args>(args)...);
   }
 
   // Then() returns a new OnceCallback that receives the same arguments as
@@ -131,6 +146,14 @@ class OnceCallback<R(Args...)> : public internal::CallbackBase {
             RepeatingCallback<ThenR(ThenArgs...)>>::CreateTrampoline(),
         std::move(*this), std::move(then));
   }
+
+ private:
+  FRIEND_TEST_ALL_PREFIXES(CallbackTest, InlineBindState);
+  FRIEND_TEST_ALL_PREFIXES(CallbackTest, HeapBindState);
+
+  // Holds the BindState if it's small and trivially copyable. See
+  // internal::CallbackBase.
+  internal::InlineBindStateStorage inline_storage_;
 };
 
 template <typename R, typename... Args>
@@ -164,7 +187,7 @@ class RepeatingCallback<R(Args...)> : public internal::CallbackBaseCopyable {
   R Run(Args... args) const & {
     PolymorphicInvoke f =
         reinterpret_cast<PolymorphicInvoke>(this->polymorphic_invoke());
-    return f(this->bind_state_.get(), std::forward<Args>(args)...);
+    return f(this->bind_state(), std::forward<Args>(args)...);
   }
 
   R Run(Args... args) && {
@@ -175,7 +198,7 @@ class RepeatingCallback<R(Args...)> : public internal::CallbackBaseCopyable {
     RepeatingCallback cb = std::move(*this);
     PolymorphicInvoke f =
         reinterpret_cast<PolymorphicInvoke>(cb.polymorphic_invoke());
-    return f(std::move(cb).bind_state_.get(), std::forward<Args>(args)...);
+    return f(cb.bind_state(), std::forward<Args>(args)...);
   }
 
   // Then() returns a new RepeatingCallback that receives the same arguments as
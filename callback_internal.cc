@@ -45,27 +45,35 @@ BindStateBase::BindStateBase(
       destructor_(destructor),
       query_cancellation_traits_(query_cancellation_traits) {}
 
-CallbackBase& CallbackBase::operator=(CallbackBase&& c) noexcept = default;
+CallbackBase& CallbackBase::operator=(CallbackBase&& c) noexcept {
+  MoveAssign(&c, nullptr);
+  return *this;
+}
+
 CallbackBase::CallbackBase(const CallbackBaseCopyable& c)
-    : bind_state_(c.bind_state_) {}
+    : bind_state_(c.bind_state_) {
+  // Only OnceCallbacks have inline BindStates.
+  DCHECK(!c.HasInlineBindState());
+  if (bind_state_)
+    bind_state_->AddRef();
+}
 
 CallbackBase& CallbackBase::operator=(const CallbackBaseCopyable& c) {
-  bind_state_ = c.bind_state_;
-  return *this;
+  return *this = CallbackBase(c);
 }
 
-CallbackBase::CallbackBase(CallbackBaseCopyable&& c) noexcept
-    : bind_state_(std::move(c.bind_state_)) {}
+CallbackBase::CallbackBase(CallbackBaseCopyable&& c) noexcept {
+  TakeBindState(&c, nullptr);
+}
 
 CallbackBase& CallbackBase::operator=(CallbackBaseCopyable&& c) noexcept {
-  bind_state_ = std::move(c.bind_state_);
-  return *this;
+  return *this = static_cast<CallbackBase&&>(c);
 }
 
 void CallbackBase::Reset() {
   // NULL the bind_state_ last, since it may be holding the last ref to whatever
   // object owns us, and we may be deleted after that.
-  bind_state_ = nullptr;
+  ReleaseBindState();
 }
 
 bool CallbackBase::IsCancelled() const {
@@ -82,15 +90,36 @@ bool CallbackBase::EqualsInternal(const CallbackBase& other) const {
   return bind_state_ == other.bind_state_;
 }
 
-CallbackBase::~CallbackBase() = default;
+CallbackBase::~CallbackBase() {
+  ReleaseBindState();
+}
 
-CallbackBaseCopyable::CallbackBaseCopyable(const CallbackBaseCopyable& c) {
-  bind_state_ = c.bind_state_;
+void CallbackBase::MoveAssign(CallbackBase* c,
+                              InlineBindStateStorage* inline_storage) {
+  if (this == c)
+    return;
+  BindStateBase* old_bind_state = HasInlineBindState() ? nullptr : bind_state_;
+  bind_state_ = nullptr;
+  TakeBindState(c, inline_storage);
+  // Released last, see ReleaseBindState().
+  if (old_bind_state)
+    old_bind_state->Release();
 }
 
+void CallbackBase::ReleaseBindState() {
+  BindStateBase* bind_state = bind_state_;
+  const bool has_inline_bind_state = HasInlineBindState();
+  bind_state_ = nullptr;
+  if (bind_state && !has_inline_bind_state)
+    bind_state->Release();
+}
+
+CallbackBaseCopyable::CallbackBaseCopyable(const CallbackBaseCopyable& c)
+    : CallbackBase(c) {}
+
 CallbackBaseCopyable& CallbackBaseCopyable::operator=(
     const CallbackBaseCopyable& c) {
-  bind_state_ = c.bind_state_;
+  CallbackBase::operator=(c);
   return *this;
 }
 
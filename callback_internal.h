@@ -8,10 +8,14 @@
 #ifndef BASE_CALLBACK_INTERNAL_H_
 #define BASE_CALLBACK_INTERNAL_H_
 
+#include <stddef.h>
+
+#include <type_traits>
 #include <utility>
 
 #include "base/base_export.h"
 #include "base/callback_forward.h"
+#include "base/check.h"
 #include "base/memory/ref_counted.h"
 
 namespace base {
@@ -40,6 +44,10 @@ struct BindStateBaseRefCountTraits {
 template <typename T>
 using PassingType = std::conditional_t<std::is_scalar<T>::value, T, T&&>;
 
+// Tag for the constructors of callbacks whose BindState is created in their
+// inline storage. See CallbackBase.
+struct InlineBindStateTag {};
+
 // BindStateBase is used to provide an opaque handle that the Callback
 // class can use to represent a function object with bound arguments.  It
 // behaves as an existential type that is used by a corresponding
@@ -94,22 +102,57 @@ class BASE_EXPORT BindStateBase
     return query_cancellation_traits_(this, MAYBE_VALID);
   }
 
+  // Whether the BindState is stored inline in a OnceCallback. Fits in the
+  // padding after the ref count.
+  bool is_inline_ = false;
+
   // In C++, it is safe to cast function pointers to function pointers of
   // another type. It is not okay to use void*. We create a InvokeFuncStorage
   // that that can store our function pointer, and then cast it back to
   // the original type on usage.
   InvokeFuncStorage polymorphic_invoke_;
 
-  // Pointer to a function that will properly destroy |this|.
-  void (*destructor_)(const BindStateBase*);
+  union {
+    // Pointer to a function that will properly destroy |this|, if it is
+    // allocated on the heap.
+    void (*destructor_)(const BindStateBase*);
+    // Pointer to a function that move-constructs the inline BindState |self|
+    // in |storage|, and returns the new BindState. |self| isn't destroyed.
+    BindStateBase* (*relocate_)(BindStateBase* self, void* storage);
+  };
   bool (*query_cancellation_traits_)(const BindStateBase*,
                                      CancellationQueryMode mode);
 };
 
+// Inline storage for the BindState of a OnceCallback. It fits BindStateBase
+// and 3 more pointers, e.g. a method pointer and an unretained receiver, or a
+// function pointer and two pointer or scalar arguments. See CallbackBase.
+union InlineBindStateStorage {
+  // Leaves |bytes| uninitialized, but keeps the default constructor of
+  // OnceCallback constexpr.
+  constexpr InlineBindStateStorage() : unused() {}
+
+  char unused;
+  alignas(void*) unsigned char
+      bytes[sizeof(BindStateBase) + 3 * sizeof(void*)];
+};
+
 // Holds the Callback methods that don't require specialization to reduce
 // template bloat.
 // CallbackBase<MoveOnly> is a direct base class of MoveOnly callbacks, and
 // CallbackBase<Copyable> uses CallbackBase<MoveOnly> for its implementation.
+//
+// The BindState of a callback is either allocated on the heap and ref-counted,
+// or, for a OnceCallback whose functor and bound arguments are trivially
+// copyable and small enough, stored in the InlineBindStateStorage of the
+// OnceCallback. RepeatingCallbacks have no such storage and stay the size of
+// a pointer. An inline BindState is move-constructed into the storage of the
+// new OnceCallback by its |relocate_| function when the OnceCallback is moved,
+// and isn't destroyed, since BindStateBase doesn't need its destructor to run
+// without references, and its functor and bound arguments are trivially
+// destructible. This
+// saves an allocation for most posted tasks, which bind a function or a method
+// with a few raw pointers or scalars.
 class BASE_EXPORT CallbackBase {
  public:
   inline CallbackBase(CallbackBase&& c) noexcept;
@@ -154,26 +197,71 @@ class BASE_EXPORT CallbackBase {
 
   constexpr inline CallbackBase();
 
-  // Allow initializing of |bind_state_| via the constructor to avoid default
-  // initialization of the scoped_refptr.
+  // Takes the only reference to |bind_state|, which was allocated on the heap.
   explicit inline CallbackBase(BindStateBase* bind_state);
 
+  // Sets the BindState of this null callback to |bind_state|, which was
+  // constructed in the InlineBindStateStorage of the OnceCallback.
+  void SetInlineBindState(BindStateBase* bind_state) {
+    DCHECK(!bind_state_);
+    bind_state_ = bind_state;
+    DCHECK(HasInlineBindState());
+  }
+
+  // Returns true if the BindState is stored inline rather than on the heap.
+  bool HasInlineBindState() const {
+    return bind_state_ && bind_state_->is_inline_;
+  }
+
+  // Moves the BindState of |c| to this callback, which must be null, and
+  // leaves |c| null. An inline BindState is relocated to |inline_storage|,
+  // which may only be null if |c| isn't a OnceCallback.
+  inline void TakeBindState(CallbackBase* c,
+                            InlineBindStateStorage* inline_storage);
+
+  // Like TakeBindState(), but releases the BindState of this callback, if any.
+  void MoveAssign(CallbackBase* c, InlineBindStateStorage* inline_storage);
+
   InvokeFuncStorage polymorphic_invoke() const {
     return bind_state_->polymorphic_invoke_;
   }
 
+  BindStateBase* bind_state() const { return bind_state_; }
+
   // Force the destructor to be instantiated inside this translation unit so
   // that our subclasses will not get inlined versions.  Avoids more template
   // bloat.
   ~CallbackBase();
 
-  scoped_refptr<BindStateBase> bind_state_;
+ private:
+  // Releases the reference to a heap BindState. Must be called last, since
+  // the BindState may hold the last reference to whatever object owns us.
+  void ReleaseBindState();
+
+  // Either points to the InlineBindStateStorage of a OnceCallback or to a
+  // ref-counted BindState, or is null.
+  BindStateBase* bind_state_ = nullptr;
 };
 
 constexpr CallbackBase::CallbackBase() = default;
-CallbackBase::CallbackBase(CallbackBase&&) noexcept = default;
+CallbackBase::CallbackBase(CallbackBase&& c) noexcept {
+  TakeBindState(&c, nullptr);
+}
 CallbackBase::CallbackBase(BindStateBase* bind_state)
-    : bind_state_(AdoptRef(bind_state)) {}
+    : bind_state_(AdoptRef(bind_state).release()) {}
+
+void CallbackBase::TakeBindState(CallbackBase* c,
+                                 InlineBindStateStorage* inline_storage) {
+  DCHECK(!bind_state_);
+  if (c->HasInlineBindState()) {
+    DCHECK(inline_storage);
+    bind_state_ =
+        c->bind_state_->relocate_(c->bind_state_, inline_storage->bytes);
+  } else {
+    bind_state_ = c->bind_state_;
+  }
+  c->bind_state_ = nullptr;
+}
 
 // CallbackBase<Copyable> is a direct base class of Copyable Callbacks.
 class BASE_EXPORT CallbackBaseCopyable : public CallbackBase {
@@ -0,0 +1,122 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/callback.h"
+
+#include <stddef.h>
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/containers/circular_deque.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace base {
+
+namespace {
+
+// The perftest compares OnceCallbacks whose BindState is stored inline with
+// OnceCallbacks of the same functor and bound arguments whose BindState is
+// allocated on the heap, for:
+// - One-off callbacks: A callback is bound, moved once and run, like a task
+//   posted to an idle task runner.
+// - Queued callbacks: kQueueSize callbacks are bound and queued before they
+//   are all run, like a burst of posted tasks. Inline BindStates make each
+//   OnceCallback larger, so this also measures the cost of moving them.
+
+constexpr char kMetricPrefixCallback[] = "OnceCallback.";
+constexpr char kMetricTimePerCallback[] = "time_per_callback";
+constexpr char kStoryOneOffHeap[] = "one_off_heap";
+constexpr char kStoryOneOffInline[] = "one_off_inline";
+constexpr char kStoryQueuedHeap[] = "queued_heap";
+constexpr char kStoryQueuedInline[] = "queued_inline";
+
+constexpr size_t kNumCallbacks = 1000000;
+constexpr size_t kQueueSize = 64;
+
+class Counter {
+ public:
+  void Increment() { ++count_; }
+  size_t count() const { return count_; }
+
+ private:
+  size_t count_ = 0;
+};
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixCallback, story_name);
+  reporter.RegisterImportantMetric(kMetricTimePerCallback, "ns");
+  return reporter;
+}
+
+OnceClosure BindInline(Counter* counter) {
+  return BindOnce(&Counter::Increment, Unretained(counter));
+}
+
+// A OnceCallback converted from a RepeatingCallback keeps its heap BindState.
+OnceClosure BindHeap(Counter* counter) {
+  return BindRepeating(&Counter::Increment, Unretained(counter));
+}
+
+void Report(const std::string& story_name,
+            const Counter& counter,
+            TimeDelta duration) {
+  EXPECT_EQ(kNumCallbacks, counter.count());
+  auto reporter = SetUpReporter(story_name);
+  reporter.AddResult(
+      kMetricTimePerCallback,
+      duration.InNanoseconds() / static_cast<double>(kNumCallbacks));
+}
+
+void RunOneOff(const std::string& story_name,
+               OnceClosure (*bind)(Counter* counter)) {
+  Counter counter;
+  const TimeTicks start = TimeTicks::Now();
+  for (size_t i = 0; i < kNumCallbacks; ++i) {
+    OnceClosure callback = bind(&counter);
+    OnceClosure moved_callback = std::move(callback);
+    std::move(moved_callback).Run();
+  }
+  Report(story_name, counter, TimeTicks::Now() - start);
+}
+
+void RunQueued(const std::string& story_name,
+               OnceClosure (*bind)(Counter* counter)) {
+  Counter counter;
+  circular_deque<OnceClosure> queue;
+  queue.reserve(kQueueSize);
+  const TimeTicks start = TimeTicks::Now();
+  for (size_t i = 0; i < kNumCallbacks; i += kQueueSize) {
+    for (size_t j = 0; j < kQueueSize; ++j)
+      queue.push_back(bind(&counter));
+    while (!queue.empty()) {
+      OnceClosure callback = std::move(queue.front());
+      queue.pop_front();
+      std::move(callback).Run();
+    }
+  }
+  Report(story_name, counter, TimeTicks::Now() - start);
+}
+
+}  // namespace
+
+TEST(OnceCallbackPerfTest, OneOffHeap) {
+  RunOneOff(kStoryOneOffHeap, &BindHeap);
+}
+
+TEST(OnceCallbackPerfTest, OneOffInline) {
+  RunOneOff(kStoryOneOffInline, &BindInline);
+}
+
+TEST(OnceCallbackPerfTest, QueuedHeap) {
+  RunQueued(kStoryQueuedHeap, &BindHeap);
+}
+
+TEST(OnceCallbackPerfTest, QueuedInline) {
+  RunQueued(kStoryQueuedInline, &BindInline);
+}
+
+}  // namespace base
@@ -676,6 +676,7 @@ TEST_F(CallbackTest, ThenRepeating) {
 class ClassWithAMethod {
  public:
   void TheMethod() {}
+  void TheMethodWithArg(int) {}
 };
 
 TEST_F(CallbackTest, MaybeValidInvalidateWeakPtrsOnSameSequence) {
@@ -725,6 +726,75 @@ TEST_F(CallbackTest, MaybeValidInvalidateWeakPtrsOnOtherSequence) {
   // run.
 }
 
+void Increment(int* value, int delta) {
+  *value += delta;
+}
+
+}  // namespace
+
+// Out of the anonymous namespace to be friends of OnceCallback.
+TEST_F(CallbackTest, InlineBindState) {
+  int value = 0;
+  OnceClosure cb = BindOnce(&Increment, &value, 1);
+  EXPECT_TRUE(cb.HasInlineBindState());
+  EXPECT_FALSE(cb.IsCancelled());
+  EXPECT_TRUE(cb.MaybeValid());
+
+  // Moving relocates the BindState to the new callback.
+  OnceClosure moved_cb = std::move(cb);
+  EXPECT_TRUE(cb.is_null());
+  EXPECT_TRUE(moved_cb.HasInlineBindState());
+
+  // Move-assign over an inline and over a heap BindState.
+  OnceClosure assigned_cb = BindOnce(&Increment, &value, 10);
+  assigned_cb = std::move(moved_cb);
+  EXPECT_TRUE(moved_cb.is_null());
+  OnceClosure heap_cb = BindRepeating(&Increment, &value, 100);
+  ASSERT_FALSE(heap_cb.HasInlineBindState());
+  heap_cb = std::move(assigned_cb);
+  EXPECT_TRUE(heap_cb.HasInlineBindState());
+
+  std::move(heap_cb).Run();
+  EXPECT_EQ(1, value);
+  EXPECT_TRUE(heap_cb.is_null());
+
+  // The storage fits a method bound to an unretained receiver, but not one
+  // more argument.
+  ClassWithAMethod obj;
+  OnceClosure method_cb =
+      BindOnce(&ClassWithAMethod::TheMethod, Unretained(&obj));
+  EXPECT_TRUE(method_cb.HasInlineBindState());
+  OnceClosure bound_arg_cb =
+      BindOnce(&ClassWithAMethod::TheMethodWithArg, Unretained(&obj), 1);
+  EXPECT_FALSE(bound_arg_cb.HasInlineBindState());
+}
+
+TEST_F(CallbackTest, HeapBindState) {
+  int value = 0;
+  // Copies of a RepeatingCallback share its BindState, so it has no inline
+  // storage.
+  static_assert(sizeof(RepeatingClosure) == sizeof(void*), "");
+  RepeatingClosure repeating_cb = BindRepeating(&Increment, &value, 1);
+  OnceClosure once_cb = repeating_cb;
+  EXPECT_FALSE(once_cb.HasInlineBindState());
+  std::move(once_cb).Run();
+  repeating_cb.Run();
+  EXPECT_EQ(2, value);
+
+  // WeakPtrs aren't trivially copyable, and keep cancelling the callback.
+  ClassWithAMethod obj;
+  WeakPtrFactory<ClassWithAMethod> factory(&obj);
+  OnceClosure weak_cb =
+      BindOnce(&ClassWithAMethod::TheMethod, factory.GetWeakPtr());
+  EXPECT_FALSE(weak_cb.HasInlineBindState());
+  OnceClosure moved_weak_cb = std::move(weak_cb);
+  EXPECT_FALSE(moved_weak_cb.IsCancelled());
+  factory.InvalidateWeakPtrs();
+  EXPECT_TRUE(moved_weak_cb.IsCancelled());
+}
+
+namespace {
+
 class CallbackOwner : public base::RefCounted<CallbackOwner> {
  public:
   explicit CallbackOwner(bool* deleted) {
@@ -133,4 +133,34 @@ TEST(CpuAffinityTest, MAYBE_SetThreadCpuAffinityMode) {
   ASSERT_FALSE(thread.IsRunning());
 }
 
+TEST(CpuAffinityTest, SetThreadCpuAffinity) {
+  cpu_set_t allowed;
+  ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+  int allowed_cpu = 0;
+  while (!CPU_ISSET(allowed_cpu, &allowed))
+    ++allowed_cpu;
+
+  TestThread thread;
+  PlatformThreadHandle handle;
+  ASSERT_TRUE(PlatformThread::Create(0, &thread, &handle));
+  thread.WaitForTerminationReady();
+  ASSERT_TRUE(thread.IsRunning());
+
+  PlatformThreadId thread_id = thread.thread_id();
+  cpu_set_t set;
+
+  EXPECT_TRUE(SetThreadCpuAffinity(thread_id, {allowed_cpu}));
+  EXPECT_EQ(sched_getaffinity(thread_id, sizeof(set), &set), 0);
+  EXPECT_EQ(CPU_COUNT(&set), 1);
+  EXPECT_TRUE(CPU_ISSET(allowed_cpu, &set));
+
+  // An empty or out of range set of CPUs is rejected.
+  EXPECT_FALSE(SetThreadCpuAffinity(thread_id, {}));
+  EXPECT_FALSE(SetThreadCpuAffinity(thread_id, {-1, CPU_SETSIZE}));
+
+  thread.MarkForTermination();
+  PlatformThread::Join(handle);
+  ASSERT_FALSE(thread.IsRunning());
+}
+
 }  // namespace base
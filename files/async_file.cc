@@ -0,0 +1,185 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/files/async_file.h"
+
+#include <string.h>
+
+#include <atomic>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/check_op.h"
+#include "base/location.h"
+#include "base/task_runner.h"
+#include "base/task_runner_util.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+#include "base/files/io_uring_linux.h"
+#endif
+
+namespace base {
+
+namespace {
+
+std::atomic<bool> g_io_uring_disabled_for_testing{false};
+
+}  // namespace
+
+// Closing a file may block, so the File is closed on |task_runner_| once the
+// AsyncFile and all operations in flight release it, like FileProxy does.
+struct AsyncFile::SharedFileTraits {
+  static void Destruct(const SharedFile* shared_file);
+};
+
+class AsyncFile::SharedFile
+    : public RefCountedThreadSafe<SharedFile, SharedFileTraits> {
+ public:
+  SharedFile(File file, scoped_refptr<TaskRunner> task_runner)
+      : file_(std::move(file)), task_runner_(std::move(task_runner)) {}
+  SharedFile(const SharedFile&) = delete;
+  SharedFile& operator=(const SharedFile&) = delete;
+
+  File& file() { return file_; }
+
+ private:
+  friend struct SharedFileTraits;
+  ~SharedFile() = default;
+
+  File file_;
+  scoped_refptr<TaskRunner> task_runner_;
+};
+
+// static
+void AsyncFile::SharedFileTraits::Destruct(const SharedFile* shared_file) {
+  SharedFile* const mutable_shared_file = const_cast<SharedFile*>(shared_file);
+  File file = std::move(mutable_shared_file->file_);
+  scoped_refptr<TaskRunner> task_runner =
+      std::move(mutable_shared_file->task_runner_);
+  delete shared_file;
+  if (file.IsValid()) {
+    task_runner->PostTask(FROM_HERE,
+                          BindOnce([](File file) {}, std::move(file)));
+  }
+}
+
+AsyncFile::AsyncFile(File file, scoped_refptr<TaskRunner> task_runner)
+    : file_(MakeRefCounted<SharedFile>(std::move(file), task_runner)),
+      task_runner_(std::move(task_runner)) {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (file_->file().IsValid() &&
+      !g_io_uring_disabled_for_testing.load(std::memory_order_relaxed)) {
+    io_uring_ = internal::IoUring::GetForCurrentSequence();
+  }
+#endif
+}
+
+AsyncFile::~AsyncFile() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+}
+
+bool AsyncFile::IsValid() const {
+  return file_->file().IsValid();
+}
+
+bool AsyncFile::UsesIoUring() const {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  return !!io_uring_;
+#else
+  return false;
+#endif
+}
+
+bool AsyncFile::Read(int64_t offset, int bytes_to_read, ReadCallback callback) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  DCHECK(IsValid());
+  DCHECK(!callback.is_null());
+  if (bytes_to_read < 0)
+    return false;
+
+  std::unique_ptr<char[]> buffer(new char[bytes_to_read]);
+  char* const data = buffer.get();
+  auto reply = BindOnce(&AsyncFile::OnReadDone, weak_ptr_factory_.GetWeakPtr(),
+                        file_, std::move(buffer), std::move(callback));
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (io_uring_) {
+    io_uring_->Read(file_->file().GetPlatformFile(), offset, data,
+                    bytes_to_read, std::move(reply));
+    return true;
+  }
+#endif
+  // |reply| owns |file_| and |data|, and is destroyed after the task.
+  return task_runner_->PostTaskAndReplyWithResult(
+      FROM_HERE,
+      BindOnce(
+          [](SharedFile* file, int64_t offset, char* data, int size) {
+            return file->file().Read(offset, data, size);
+          },
+          Unretained(file_.get()), offset, data, bytes_to_read),
+      std::move(reply));
+}
+
+bool AsyncFile::Write(int64_t offset,
+                      const char* buffer,
+                      int bytes_to_write,
+                      WriteCallback callback) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  DCHECK(IsValid());
+  if (bytes_to_write <= 0 || buffer == nullptr)
+    return false;
+
+  std::unique_ptr<char[]> buffer_copy(new char[bytes_to_write]);
+  memcpy(buffer_copy.get(), buffer, bytes_to_write);
+  const char* const data = buffer_copy.get();
+  auto reply = BindOnce(&AsyncFile::OnWriteDone,
+                        weak_ptr_factory_.GetWeakPtr(), file_,
+                        std::move(buffer_copy), std::move(callback));
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (io_uring_) {
+    io_uring_->Write(file_->file().GetPlatformFile(), offset, data,
+                     bytes_to_write, std::move(reply));
+    return true;
+  }
+#endif
+  // |reply| owns |file_| and |data|, and is destroyed after the task.
+  return task_runner_->PostTaskAndReplyWithResult(
+      FROM_HERE,
+      BindOnce(
+          [](SharedFile* file, int64_t offset, const char* data, int size) {
+            return file->file().Write(offset, data, size);
+          },
+          Unretained(file_.get()), offset, data, bytes_to_write),
+      std::move(reply));
+}
+
+// static
+void AsyncFile::SetIoUringDisabledForTesting(bool disabled) {
+  g_io_uring_disabled_for_testing.store(disabled, std::memory_order_relaxed);
+}
+
+void AsyncFile::OnReadDone(scoped_refptr<SharedFile> file,
+                           std::unique_ptr<char[]> buffer,
+                           ReadCallback callback,
+                           int bytes_read) {
+  if (bytes_read < 0) {
+    std::move(callback).Run(File::FILE_ERROR_FAILED, buffer.get(), -1);
+    return;
+  }
+  std::move(callback).Run(File::FILE_OK, buffer.get(), bytes_read);
+}
+
+void AsyncFile::OnWriteDone(scoped_refptr<SharedFile> file,
+                            std::unique_ptr<char[]> buffer,
+                            WriteCallback callback,
+                            int bytes_written) {
+  if (callback.is_null())
+    return;
+  if (bytes_written < 0) {
+    std::move(callback).Run(File::FILE_ERROR_FAILED, -1);
+    return;
+  }
+  std::move(callback).Run(File::FILE_OK, bytes_written);
+}
+
+}  // namespace base
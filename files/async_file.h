@@ -0,0 +1,109 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_FILES_ASYNC_FILE_H_
+#define BASE_FILES_ASYNC_FILE_H_
+
+#include <stdint.h>
+
+#include <memory>
+
+#include "base/base_export.h"
+#include "base/files/file.h"
+#include "base/files/file_proxy.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/sequence_checker.h"
+#include "build/build_config.h"
+
+namespace base {
+
+class TaskRunner;
+
+namespace internal {
+class IoUring;
+}
+
+// This class provides asynchronous reads and writes on a File. Results are
+// delivered on the sequence which issued the operations. Unlike FileProxy, any
+// number of operations may be in flight at once.
+//
+// On Linux, operations are submitted to an io_uring shared by all AsyncFiles
+// of the sequence, in batches: the operations issued during a task are
+// submitted together once it returns, with a single system call, and don't
+// need a thread hop. Where io_uring isn't available (older kernels, seccomp
+// sandboxes, other platforms), each operation runs as a blocking read or write
+// on |task_runner|, like FileProxy does.
+//
+// This class must be used on a sequence which supports FileDescriptorWatcher
+// on POSIX, e.g. a ThreadPool sequence or a thread with MessagePumpType::IO.
+// The file is closed once the AsyncFile is destroyed and the operations in
+// flight are done. Destroying the last AsyncFile of a sequence which uses
+// io_uring waits for the operations in flight.
+class BASE_EXPORT AsyncFile {
+ public:
+  using ReadCallback = FileProxy::ReadCallback;
+  using WriteCallback = FileProxy::WriteCallback;
+
+  // |task_runner| runs operations when io_uring isn't available, and must allow
+  // blocking.
+  AsyncFile(File file, scoped_refptr<TaskRunner> task_runner);
+  AsyncFile(const AsyncFile&) = delete;
+  AsyncFile& operator=(const AsyncFile&) = delete;
+  // Callbacks of operations in flight are not run.
+  ~AsyncFile();
+
+  // Returns true if the underlying file is valid.
+  bool IsValid() const;
+
+  // Returns true if operations are submitted to an io_uring.
+  bool UsesIoUring() const;
+
+  // Reads |bytes_to_read| bytes at |offset|, like File::Read. The callback
+  // can't be null. Returns false if |bytes_to_read| is less than zero, or if
+  // task posting to |task_runner| has failed.
+  bool Read(int64_t offset, int bytes_to_read, ReadCallback callback);
+
+  // Writes |bytes_to_write| bytes from |buffer| at |offset|, like File::Write.
+  // |buffer| is copied. The callback can be null. Returns false if
+  // |bytes_to_write| is less than or equal to zero, if |buffer| is NULL, or if
+  // task posting to |task_runner| has failed.
+  bool Write(int64_t offset,
+             const char* buffer,
+             int bytes_to_write,
+             WriteCallback callback);
+
+  // Prevents AsyncFiles created afterwards from using io_uring if |disabled| is
+  // true, so that tests can exercise the |task_runner| path.
+  static void SetIoUringDisabledForTesting(bool disabled);
+
+ private:
+  // The File, shared with operations in flight.
+  class SharedFile;
+  struct SharedFileTraits;
+
+  // Both callbacks take |file| to keep it open until the operation is done.
+  void OnReadDone(scoped_refptr<SharedFile> file,
+                  std::unique_ptr<char[]> buffer,
+                  ReadCallback callback,
+                  int bytes_read);
+  void OnWriteDone(scoped_refptr<SharedFile> file,
+                   std::unique_ptr<char[]> buffer,
+                   WriteCallback callback,
+                   int bytes_written);
+
+  scoped_refptr<SharedFile> file_;
+  const scoped_refptr<TaskRunner> task_runner_;
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  scoped_refptr<internal::IoUring> io_uring_;
+#endif
+
+  SEQUENCE_CHECKER(sequence_checker_);
+
+  WeakPtrFactory<AsyncFile> weak_ptr_factory_{this};
+};
+
+}  // namespace base
+
+#endif  // BASE_FILES_ASYNC_FILE_H_
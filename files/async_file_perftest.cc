@@ -0,0 +1,135 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/files/async_file.h"
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/files/file.h"
+#include "base/files/file_proxy.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/rand_util.h"
+#include "base/run_loop.h"
+#include "base/task/thread_pool.h"
+#include "base/test/bind.h"
+#include "base/test/task_environment.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace base {
+
+namespace {
+
+constexpr char kMetricPrefixAsyncFile[] = "AsyncFile.";
+constexpr char kMetricTimePerRead[] = "time_per_read";
+constexpr char kStoryFileProxy[] = "file_proxy";
+constexpr char kStoryAsyncFileThreadPool[] = "async_file_thread_pool";
+constexpr char kStoryAsyncFile[] = "async_file";
+
+constexpr int kReadSize = 4096;
+constexpr int kNumBlocks = 4096;
+constexpr int kNumReads = 10000;
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixAsyncFile, story_name);
+  reporter.RegisterImportantMetric(kMetricTimePerRead, "ns");
+  return reporter;
+}
+
+int64_t RandomOffset() {
+  return static_cast<int64_t>(RandInt(0, kNumBlocks - 1)) * kReadSize;
+}
+
+class AsyncFilePerfTest : public testing::Test {
+ public:
+  AsyncFilePerfTest()
+      : task_environment_(test::TaskEnvironment::MainThreadType::IO) {}
+
+  void SetUp() override {
+    ASSERT_TRUE(dir_.CreateUniqueTempDir());
+    path_ = dir_.GetPath().AppendASCII("async_file_perftest");
+    ASSERT_TRUE(
+        WriteFile(path_, std::string(size_t{kNumBlocks} * kReadSize, 'a')));
+  }
+
+  void TearDown() override { AsyncFile::SetIoUringDisabledForTesting(false); }
+
+ protected:
+  File OpenFile() { return File(path_, File::FLAG_OPEN | File::FLAG_READ); }
+
+  void Report(const std::string& story_name, TimeDelta duration) {
+    auto reporter = SetUpReporter(story_name);
+    reporter.AddResult(kMetricTimePerRead, duration.InNanoseconds() /
+                                               static_cast<double>(kNumReads));
+  }
+
+  // Issues all reads at once.
+  void BenchmarkAsyncFile(const std::string& story_name) {
+    AsyncFile file(OpenFile(), ThreadPool::CreateTaskRunner({MayBlock()}));
+    ASSERT_TRUE(file.IsValid());
+
+    int num_done = 0;
+    RunLoop run_loop;
+    auto on_read = BindLambdaForTesting(
+        [&](File::Error error, const char* data, int bytes_read) {
+          EXPECT_EQ(kReadSize, bytes_read);
+          if (++num_done == kNumReads)
+            run_loop.Quit();
+        });
+    const TimeTicks start = TimeTicks::Now();
+    for (int i = 0; i < kNumReads; ++i)
+      ASSERT_TRUE(file.Read(RandomOffset(), kReadSize, on_read));
+    run_loop.Run();
+    Report(story_name, TimeTicks::Now() - start);
+  }
+
+  test::TaskEnvironment task_environment_;
+  ScopedTempDir dir_;
+  FilePath path_;
+};
+
+}  // namespace
+
+// FileProxy allows a single operation in flight, so each read is issued from
+// the reply of the previous one.
+TEST_F(AsyncFilePerfTest, FileProxy) {
+  FileProxy proxy(ThreadPool::CreateTaskRunner({MayBlock()}).get());
+  proxy.SetFile(OpenFile());
+  ASSERT_TRUE(proxy.IsValid());
+
+  int num_done = 0;
+  RunLoop run_loop;
+  RepeatingClosure read_next;
+  auto on_read = BindLambdaForTesting(
+      [&](File::Error error, const char* data, int bytes_read) {
+        EXPECT_EQ(kReadSize, bytes_read);
+        if (++num_done == kNumReads)
+          run_loop.Quit();
+        else
+          read_next.Run();
+      });
+  read_next = BindLambdaForTesting([&]() {
+    ASSERT_TRUE(proxy.Read(RandomOffset(), kReadSize, on_read));
+  });
+  const TimeTicks start = TimeTicks::Now();
+  read_next.Run();
+  run_loop.Run();
+  Report(kStoryFileProxy, TimeTicks::Now() - start);
+}
+
+TEST_F(AsyncFilePerfTest, AsyncFileThreadPool) {
+  AsyncFile::SetIoUringDisabledForTesting(true);
+  BenchmarkAsyncFile(kStoryAsyncFileThreadPool);
+}
+
+TEST_F(AsyncFilePerfTest, AsyncFile) {
+  BenchmarkAsyncFile(kStoryAsyncFile);
+}
+
+}  // namespace base
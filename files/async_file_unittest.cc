@@ -0,0 +1,181 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/files/async_file.h"
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/file.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/run_loop.h"
+#include "base/task/thread_pool.h"
+#include "base/test/bind.h"
+#include "base/test/task_environment.h"
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+#include "base/files/io_uring_linux.h"
+#endif
+
+namespace base {
+
+// The test parameter is whether io_uring is disabled.
+class AsyncFileTest : public testing::TestWithParam<bool> {
+ public:
+  AsyncFileTest()
+      : task_environment_(test::TaskEnvironment::MainThreadType::IO) {}
+
+  void SetUp() override {
+    AsyncFile::SetIoUringDisabledForTesting(GetParam());
+    ASSERT_TRUE(dir_.CreateUniqueTempDir());
+    path_ = dir_.GetPath().AppendASCII("async_file");
+  }
+
+  void TearDown() override { AsyncFile::SetIoUringDisabledForTesting(false); }
+
+  std::unique_ptr<AsyncFile> CreateAsyncFile(const std::string& content) {
+    EXPECT_TRUE(WriteFile(path_, content));
+    File file(path_, File::FLAG_OPEN_ALWAYS | File::FLAG_READ |
+                         File::FLAG_WRITE);
+    return std::make_unique<AsyncFile>(
+        std::move(file), ThreadPool::CreateTaskRunner({MayBlock()}));
+  }
+
+  // Reads |size| bytes at |offset| and returns them.
+  std::string Read(AsyncFile* file, int64_t offset, int size) {
+    std::string result;
+    RunLoop run_loop;
+    EXPECT_TRUE(file->Read(
+        offset, size,
+        BindLambdaForTesting(
+            [&](File::Error error, const char* data, int bytes_read) {
+              EXPECT_EQ(File::FILE_OK, error);
+              result.assign(data, bytes_read);
+              run_loop.Quit();
+            })));
+    run_loop.Run();
+    return result;
+  }
+
+ protected:
+  test::TaskEnvironment task_environment_;
+  ScopedTempDir dir_;
+  FilePath path_;
+};
+
+TEST_P(AsyncFileTest, UsesIoUring) {
+  std::unique_ptr<AsyncFile> file = CreateAsyncFile(std::string());
+  ASSERT_TRUE(file->IsValid());
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  EXPECT_EQ(!GetParam() && internal::IoUring::IsSupported(),
+            file->UsesIoUring());
+#else
+  EXPECT_FALSE(file->UsesIoUring());
+#endif
+}
+
+TEST_P(AsyncFileTest, Read) {
+  std::unique_ptr<AsyncFile> file = CreateAsyncFile("0123456789");
+  EXPECT_EQ("0123456789", Read(file.get(), 0, 10));
+  EXPECT_EQ("345", Read(file.get(), 3, 3));
+  EXPECT_EQ("89", Read(file.get(), 8, 10));
+  EXPECT_EQ("", Read(file.get(), 20, 10));
+}
+
+TEST_P(AsyncFileTest, WriteThenRead) {
+  std::unique_ptr<AsyncFile> file = CreateAsyncFile(std::string());
+  const std::string data = "hello async file";
+  const int size = static_cast<int>(data.size());
+
+  RunLoop run_loop;
+  EXPECT_TRUE(file->Write(
+      4, data.data(), size,
+      BindLambdaForTesting([&](File::Error error, int bytes_written) {
+        EXPECT_EQ(File::FILE_OK, error);
+        EXPECT_EQ(size, bytes_written);
+        run_loop.Quit();
+      })));
+  run_loop.Run();
+
+  EXPECT_EQ(data, Read(file.get(), 4, size));
+  std::string content;
+  ASSERT_TRUE(ReadFileToString(path_, &content));
+  EXPECT_EQ(std::string(4, '\0') + data, content);
+}
+
+TEST_P(AsyncFileTest, WriteWithoutCallback) {
+  std::unique_ptr<AsyncFile> file = CreateAsyncFile("aaaa");
+  EXPECT_TRUE(file->Write(1, "bb", 2, AsyncFile::WriteCallback()));
+  // Submits the write, or runs it on the ThreadPool. Destroying the AsyncFile
+  // then waits for a submitted write.
+  task_environment_.RunUntilIdle();
+  file.reset();
+  task_environment_.RunUntilIdle();
+
+  std::string content;
+  ASSERT_TRUE(ReadFileToString(path_, &content));
+  EXPECT_EQ("abba", content);
+}
+
+// Issues more concurrent reads than the io_uring queue depth.
+TEST_P(AsyncFileTest, ManyConcurrentReads) {
+  constexpr int kNumReads = 500;
+  std::string content;
+  for (int i = 0; i < kNumReads; ++i)
+    content.push_back('a' + i % 26);
+  std::unique_ptr<AsyncFile> file = CreateAsyncFile(content);
+
+  std::vector<char> results(kNumReads);
+  int num_done = 0;
+  RunLoop run_loop;
+  for (int i = 0; i < kNumReads; ++i) {
+    EXPECT_TRUE(file->Read(
+        i, 1,
+        BindLambdaForTesting(
+            [&, i](File::Error error, const char* data, int bytes_read) {
+              EXPECT_EQ(File::FILE_OK, error);
+              ASSERT_EQ(1, bytes_read);
+              results[i] = data[0];
+              if (++num_done == kNumReads)
+                run_loop.Quit();
+            })));
+  }
+  run_loop.Run();
+  EXPECT_EQ(content, std::string(results.begin(), results.end()));
+}
+
+TEST_P(AsyncFileTest, CallbackNotRunAfterDestruction) {
+  std::unique_ptr<AsyncFile> file = CreateAsyncFile("0123456789");
+  bool callback_run = false;
+  EXPECT_TRUE(file->Read(
+      0, 10, BindLambdaForTesting([&](File::Error, const char*, int) {
+        callback_run = true;
+      })));
+  file.reset();
+  task_environment_.RunUntilIdle();
+  EXPECT_FALSE(callback_run);
+}
+
+TEST_P(AsyncFileTest, InvalidArguments) {
+  std::unique_ptr<AsyncFile> file = CreateAsyncFile(std::string());
+  EXPECT_FALSE(file->Read(0, -1, BindOnce([](File::Error, const char*, int) {
+                            ADD_FAILURE();
+                          })));
+  EXPECT_FALSE(file->Write(0, "a", 0, AsyncFile::WriteCallback()));
+  EXPECT_FALSE(file->Write(0, nullptr, 1, AsyncFile::WriteCallback()));
+}
+
+TEST_P(AsyncFileTest, InvalidFile) {
+  AsyncFile file(File(), ThreadPool::CreateTaskRunner({MayBlock()}));
+  EXPECT_FALSE(file.IsValid());
+  EXPECT_FALSE(file.UsesIoUring());
+}
+
+INSTANTIATE_TEST_SUITE_P(All, AsyncFileTest, testing::Bool());
+
+}  // namespace base
@@ -0,0 +1,348 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/files/io_uring_linux.h"
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/check_op.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/threading/sequence_local_storage_slot.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+int IoUringSetup(uint32_t entries, io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int ring_fd,
+                 uint32_t to_submit,
+                 uint32_t min_complete,
+                 uint32_t flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit,
+                                  min_complete, flags, nullptr, 0));
+}
+
+int IoUringRegister(int ring_fd,
+                    uint32_t opcode,
+                    const void* arg,
+                    uint32_t nr_args) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+// Returns a pointer to the field at |offset| of the mapping at |base|.
+template <typename T>
+T* GetRingField(void* base, uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+}  // namespace
+
+// An operation queued by Read() or Write(). It is owned by |backlog_| until it
+// is in the submission queue, and then by the submission queue entry's
+// |user_data|, until its completion is reaped.
+struct IoUring::Operation {
+  // IORING_OP_READV and IORING_OP_WRITEV are supported by all kernels with
+  // io_uring, unlike IORING_OP_READ and IORING_OP_WRITE.
+  uint8_t opcode;
+  int fd;
+  int64_t offset;
+  iovec iov;
+  CompletionCallback callback;
+};
+
+// static
+bool IoUring::IsSupported() {
+  static const bool is_supported = []() {
+    io_uring_params params = {};
+    const int ring_fd = IoUringSetup(1, &params);
+    if (ring_fd < 0)
+      return false;
+    close(ring_fd);
+    return true;
+  }();
+  return is_supported;
+}
+
+// static
+scoped_refptr<IoUring> IoUring::GetForCurrentSequence() {
+  if (!IsSupported())
+    return nullptr;
+
+  // The slot doesn't own the IoUring, which would otherwise be destroyed along
+  // with the sequence, possibly on another thread.
+  static SequenceLocalStorageSlot<WeakPtr<IoUring>> io_uring_slot;
+  WeakPtr<IoUring>& io_uring = io_uring_slot.GetOrCreateValue();
+  if (io_uring)
+    return WrapRefCounted(io_uring.get());
+
+  auto new_io_uring = WrapRefCounted(new IoUring);
+  if (!new_io_uring->Initialize())
+    return nullptr;
+  io_uring = new_io_uring->weak_ptr_factory_.GetWeakPtr();
+  return new_io_uring;
+}
+
+IoUring::IoUring() = default;
+
+IoUring::~IoUring() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  event_fd_watcher_.reset();
+  backlog_.clear();
+
+  // Operations which weren't submitted are discarded along with the ring.
+  if (ring_fd_.is_valid()) {
+    while (num_in_flight_ > num_unsubmitted_) {
+      if (IoUringEnter(ring_fd_.get(), 0, 1, IORING_ENTER_GETEVENTS) < 0)
+        PCHECK(errno == EINTR) << "io_uring_enter";
+      ReapCompletions(/*run_callbacks=*/false);
+    }
+    for (uint32_t i = 0; i < num_unsubmitted_; ++i) {
+      const uint32_t index =
+          (sq_tail_->load(std::memory_order_relaxed) - i - 1) & sq_mask_;
+      delete reinterpret_cast<Operation*>(sqes_[index].user_data);
+    }
+  }
+
+  if (sqes_)
+    munmap(sqes_, sqes_size_);
+  if (cq_ring_ && cq_ring_ != sq_ring_)
+    munmap(cq_ring_, cq_ring_size_);
+  if (sq_ring_)
+    munmap(sq_ring_, sq_ring_size_);
+}
+
+bool IoUring::Initialize() {
+  io_uring_params params = {};
+  ring_fd_.reset(IoUringSetup(kQueueDepth, &params));
+  if (!ring_fd_.is_valid()) {
+    DPLOG(ERROR) << "io_uring_setup";
+    return false;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  // Since Linux 5.4, both queues share a single mapping.
+  const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap)
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+  void* mapping = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd_.get(),
+                       IORING_OFF_SQ_RING);
+  if (mapping == MAP_FAILED) {
+    DPLOG(ERROR) << "mmap";
+    return false;
+  }
+  sq_ring_ = mapping;
+
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    mapping = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring_fd_.get(),
+                   IORING_OFF_CQ_RING);
+    if (mapping == MAP_FAILED) {
+      DPLOG(ERROR) << "mmap";
+      return false;
+    }
+    cq_ring_ = mapping;
+  }
+
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  mapping = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, ring_fd_.get(), IORING_OFF_SQES);
+  if (mapping == MAP_FAILED) {
+    DPLOG(ERROR) << "mmap";
+    return false;
+  }
+  sqes_ = static_cast<io_uring_sqe*>(mapping);
+
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+                "Ring indices are accessed as atomics.");
+  sq_head_ = GetRingField<std::atomic<uint32_t>>(sq_ring_, params.sq_off.head);
+  sq_tail_ = GetRingField<std::atomic<uint32_t>>(sq_ring_, params.sq_off.tail);
+  sq_mask_ = *GetRingField<uint32_t>(sq_ring_, params.sq_off.ring_mask);
+  sq_entries_ = params.sq_entries;
+  sq_array_ = GetRingField<uint32_t>(sq_ring_, params.sq_off.array);
+  cq_head_ = GetRingField<std::atomic<uint32_t>>(cq_ring_, params.cq_off.head);
+  cq_tail_ = GetRingField<std::atomic<uint32_t>>(cq_ring_, params.cq_off.tail);
+  cq_mask_ = *GetRingField<uint32_t>(cq_ring_, params.cq_off.ring_mask);
+  cq_entries_ = params.cq_entries;
+  cqes_ = GetRingField<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+
+  event_fd_.reset(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+  if (!event_fd_.is_valid()) {
+    DPLOG(ERROR) << "eventfd";
+    return false;
+  }
+  const int event_fd = event_fd_.get();
+  if (IoUringRegister(ring_fd_.get(), IORING_REGISTER_EVENTFD, &event_fd, 1) <
+      0) {
+    DPLOG(ERROR) << "io_uring_register";
+    return false;
+  }
+  // Unretained() is safe because |event_fd_watcher_| is owned by |this|.
+  event_fd_watcher_ = FileDescriptorWatcher::WatchReadable(
+      event_fd, BindRepeating(&IoUring::OnEventFdReadable, Unretained(this)));
+  return true;
+}
+
+void IoUring::Read(int fd,
+                   int64_t offset,
+                   char* buffer,
+                   int size,
+                   CompletionCallback callback) {
+  DCHECK_GE(size, 0);
+  QueueOperation(WrapUnique(new Operation{
+      IORING_OP_READV, fd, offset, {buffer, static_cast<size_t>(size)},
+      std::move(callback)}));
+}
+
+void IoUring::Write(int fd,
+                    int64_t offset,
+                    const char* buffer,
+                    int size,
+                    CompletionCallback callback) {
+  DCHECK_GE(size, 0);
+  // The kernel doesn't write to |buffer|.
+  QueueOperation(WrapUnique(new Operation{
+      IORING_OP_WRITEV,
+      fd,
+      offset,
+      {const_cast<char*>(buffer), static_cast<size_t>(size)},
+      std::move(callback)}));
+}
+
+void IoUring::QueueOperation(std::unique_ptr<Operation> operation) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  backlog_.push_back(std::move(operation));
+  FillSubmissionQueue();
+}
+
+void IoUring::FillSubmissionQueue() {
+  while (!backlog_.empty() && num_in_flight_ < cq_entries_) {
+    const uint32_t tail = sq_tail_->load(std::memory_order_relaxed);
+    if (tail - sq_head_->load(std::memory_order_acquire) == sq_entries_) {
+      // The submission queue is full: submit it now to make room.
+      Submit();
+      if (num_unsubmitted_ == sq_entries_)
+        break;
+      continue;
+    }
+
+    std::unique_ptr<Operation> operation = std::move(backlog_.front());
+    backlog_.pop_front();
+
+    const uint32_t index = tail & sq_mask_;
+    io_uring_sqe& sqe = sqes_[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = operation->opcode;
+    sqe.fd = operation->fd;
+    sqe.off = static_cast<uint64_t>(operation->offset);
+    sqe.addr = reinterpret_cast<uint64_t>(&operation->iov);
+    sqe.len = 1;
+    sqe.user_data = reinterpret_cast<uint64_t>(operation.release());
+    sq_array_[index] = index;
+    // Publishes the entry to the kernel.
+    sq_tail_->store(tail + 1, std::memory_order_release);
+
+    ++num_unsubmitted_;
+    ++num_in_flight_;
+  }
+
+  if (num_unsubmitted_ > 0)
+    ScheduleSubmit();
+}
+
+void IoUring::ScheduleSubmit() {
+  if (submit_pending_)
+    return;
+  submit_pending_ = true;
+  SequencedTaskRunnerHandle::Get()->PostTask(
+      FROM_HERE, BindOnce(&IoUring::Submit, weak_ptr_factory_.GetWeakPtr()));
+}
+
+void IoUring::Submit() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  submit_pending_ = false;
+  while (num_unsubmitted_ > 0) {
+    const int result = IoUringEnter(ring_fd_.get(), num_unsubmitted_, 0, 0);
+    if (result < 0) {
+      if (errno == EINTR)
+        continue;
+      // The kernel is temporarily out of resources. Retry from another task.
+      PCHECK(errno == EAGAIN || errno == EBUSY) << "io_uring_enter";
+      ScheduleSubmit();
+      return;
+    }
+    DCHECK_LE(static_cast<uint32_t>(result), num_unsubmitted_);
+    num_unsubmitted_ -= static_cast<uint32_t>(result);
+  }
+}
+
+void IoUring::ReapCompletions(bool run_callbacks) {
+  uint32_t head = cq_head_->load(std::memory_order_relaxed);
+  const uint32_t tail = cq_tail_->load(std::memory_order_acquire);
+  if (head == tail)
+    return;
+
+  std::vector<std::pair<std::unique_ptr<Operation>, int>> completed;
+  completed.reserve(tail - head);
+  for (; head != tail; ++head) {
+    const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+    completed.emplace_back(reinterpret_cast<Operation*>(cqe.user_data),
+                           cqe.res);
+  }
+  // Releases the completion queue entries to the kernel.
+  cq_head_->store(head, std::memory_order_release);
+  num_in_flight_ -= completed.size();
+
+  if (!run_callbacks)
+    return;
+
+  // Completions made room for operations of the backlog. Queue them before
+  // running callbacks, which may queue more operations.
+  FillSubmissionQueue();
+  for (auto& operation_and_result : completed) {
+    std::move(operation_and_result.first->callback)
+        .Run(operation_and_result.second);
+  }
+}
+
+void IoUring::OnEventFdReadable() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  uint64_t value;
+  const ssize_t nread =
+      HANDLE_EINTR(read(event_fd_.get(), &value, sizeof(value)));
+  DPCHECK(nread == static_cast<ssize_t>(sizeof(value)) || errno == EAGAIN)
+      << "nread:" << nread;
+  // A callback may release the last reference to |this|.
+  scoped_refptr<IoUring> self(this);
+  ReapCompletions(/*run_callbacks=*/true);
+}
+
+}  // namespace internal
+}  // namespace base
@@ -0,0 +1,156 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_FILES_IO_URING_LINUX_H_
+#define BASE_FILES_IO_URING_LINUX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+
+#include "base/base_export.h"
+#include "base/callback.h"
+#include "base/containers/circular_deque.h"
+#include "base/files/file_descriptor_watcher_posix.h"
+#include "base/files/scoped_file.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/sequence_checker.h"
+
+struct io_uring_cqe;
+struct io_uring_sqe;
+
+namespace base {
+namespace internal {
+
+// A minimal wrapper around an io_uring(7) instance, used by AsyncFile to read
+// and write files without a thread hop per operation.
+//
+// Operations queued during a task are submitted together by a task posted on
+// the current sequence, with a single io_uring_enter() call. Their completions
+// are reaped, and their callbacks run on the current sequence, when the
+// eventfd registered with the io_uring is readable.
+//
+// There is at most one IoUring per sequence, shared by the AsyncFiles of the
+// sequence. This class is sequence-affine.
+class BASE_EXPORT IoUring : public RefCounted<IoUring> {
+ public:
+  // Receives the result of an operation: the number of bytes transferred, or a
+  // negated errno value.
+  using CompletionCallback = OnceCallback<void(int result)>;
+
+  // Number of submission queue entries. The completion queue is twice as
+  // large.
+  static constexpr uint32_t kQueueDepth = 64;
+
+  // Returns true if io_uring can be used in this process. It isn't supported by
+  // kernels older than 5.1 and may be blocked by seccomp sandboxes.
+  static bool IsSupported();
+
+  // Returns the IoUring of the current sequence, creating it if needed.
+  // Returns null if io_uring isn't supported. The current sequence must support
+  // FileDescriptorWatcher.
+  static scoped_refptr<IoUring> GetForCurrentSequence();
+
+  IoUring(const IoUring&) = delete;
+  IoUring& operator=(const IoUring&) = delete;
+
+  // Queues a read of |size| bytes from |fd| at |offset| into |buffer|. |fd| and
+  // |buffer| must remain valid until |callback| runs or is destroyed, which
+  // callers usually ensure by binding their owners to |callback|.
+  void Read(int fd,
+            int64_t offset,
+            char* buffer,
+            int size,
+            CompletionCallback callback);
+
+  // Queues a write of |size| bytes from |buffer| to |fd| at |offset|, with the
+  // same requirements as Read().
+  void Write(int fd,
+             int64_t offset,
+             const char* buffer,
+             int size,
+             CompletionCallback callback);
+
+ private:
+  friend class RefCounted<IoUring>;
+
+  struct Operation;
+
+  IoUring();
+  // Waits for operations in flight, since the kernel may still access their
+  // buffers. Their callbacks are destroyed without being run.
+  ~IoUring();
+
+  // Sets up the io_uring. Returns false on failure.
+  bool Initialize();
+
+  void QueueOperation(std::unique_ptr<Operation> operation);
+
+  // Moves operations from |backlog_| to the submission queue, as long as there
+  // is room for them and for their completions.
+  void FillSubmissionQueue();
+
+  // Posts a task to Submit(), unless one is pending.
+  void ScheduleSubmit();
+
+  // Submits the operations in the submission queue.
+  void Submit();
+
+  // Reaps completions and runs their callbacks if |run_callbacks| is true.
+  void ReapCompletions(bool run_callbacks);
+
+  void OnEventFdReadable();
+
+  ScopedFD ring_fd_;
+  ScopedFD event_fd_;
+
+  // Mappings of the submission and completion queues, and of the submission
+  // queue entries.
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  // Pointers into the queue mappings. The kernel updates the submission queue
+  // head and the completion queue tail.
+  std::atomic<uint32_t>* sq_head_ = nullptr;
+  std::atomic<uint32_t>* sq_tail_ = nullptr;
+  uint32_t sq_mask_ = 0;
+  uint32_t sq_entries_ = 0;
+  uint32_t* sq_array_ = nullptr;
+  std::atomic<uint32_t>* cq_head_ = nullptr;
+  std::atomic<uint32_t>* cq_tail_ = nullptr;
+  uint32_t cq_mask_ = 0;
+  uint32_t cq_entries_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+
+  // Operations in the submission queue which weren't submitted yet.
+  uint32_t num_unsubmitted_ = 0;
+
+  // Operations in the submission queue or submitted, whose completion wasn't
+  // reaped yet. Bounded by |cq_entries_|, so that completions never overflow.
+  uint32_t num_in_flight_ = 0;
+
+  // Operations waiting for room in the queues.
+  circular_deque<std::unique_ptr<Operation>> backlog_;
+
+  // Whether a Submit() task is posted.
+  bool submit_pending_ = false;
+
+  std::unique_ptr<FileDescriptorWatcher::Controller> event_fd_watcher_;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+
+  WeakPtrFactory<IoUring> weak_ptr_factory_{this};
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_FILES_IO_URING_LINUX_H_
@@ -0,0 +1,460 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/message_loop/message_pump_epoll.h"
+
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include "base/auto_reset.h"
+#include "base/check_op.h"
+#include "base/containers/span.h"
+#include "base/containers/stack_container.h"
+#include "base/logging.h"
+#include "base/notreached.h"
+#include "base/numerics/safe_conversions.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/ranges/algorithm.h"
+#include "base/trace_event/base_tracing.h"
+
+namespace base {
+
+namespace {
+
+// Maximum number of events returned by a single epoll_wait() call. More events
+// are returned by the next call.
+constexpr int kMaxEventsPerWait = 64;
+
+}  // namespace
+
+MessagePumpEpoll::FdWatchController::FdWatchController(
+    const Location& from_here)
+    : FdWatchControllerInterface(from_here) {}
+
+MessagePumpEpoll::FdWatchController::~FdWatchController() {
+  if (interest_) {
+    CHECK(StopWatchingFileDescriptor());
+  }
+  if (was_destroyed_) {
+    DCHECK(!*was_destroyed_);
+    *was_destroyed_ = true;
+  }
+}
+
+bool MessagePumpEpoll::FdWatchController::StopWatchingFileDescriptor() {
+  watcher_ = nullptr;
+  scoped_refptr<Interest> interest = std::move(interest_);
+  if (!interest)
+    return true;
+
+  bool success = true;
+  if (pump_)
+    success = pump_->UnregisterInterest(interest);
+  else
+    interest->Cancel();
+  pump_ = nullptr;
+  return success;
+}
+
+void MessagePumpEpoll::FdWatchController::OnFileCanReadWithoutBlocking(
+    int fd,
+    MessagePumpEpoll* pump) {
+  // Since OnFileCanWriteWithoutBlocking() gets called first, it can stop
+  // watching the file descriptor.
+  if (!watcher_)
+    return;
+  watcher_->OnFileCanReadWithoutBlocking(fd);
+}
+
+void MessagePumpEpoll::FdWatchController::OnFileCanWriteWithoutBlocking(
+    int fd,
+    MessagePumpEpoll* pump) {
+  DCHECK(watcher_);
+  watcher_->OnFileCanWriteWithoutBlocking(fd);
+}
+
+MessagePumpEpoll::Interest::Interest(FdWatchController* controller,
+                                     const InterestParams& params)
+    : controller_(controller), params_(params) {}
+
+MessagePumpEpoll::Interest::~Interest() = default;
+
+MessagePumpEpoll::EpollEventEntry::EpollEventEntry(int fd) : fd(fd) {}
+
+MessagePumpEpoll::EpollEventEntry::~EpollEventEntry() = default;
+
+uint32_t MessagePumpEpoll::EpollEventEntry::ComputeActiveEvents() const {
+  if (interests.empty())
+    return 0;
+
+  uint32_t events = 0;
+  bool edge_triggered = true;
+  for (const scoped_refptr<Interest>& interest : interests) {
+    if (interest->params().mode & WATCH_READ)
+      events |= EPOLLIN;
+    if (interest->params().mode & WATCH_WRITE)
+      events |= EPOLLOUT;
+    edge_triggered &= interest->params().edge_triggered;
+  }
+  // A level-triggered interest could miss readiness which an edge-triggered
+  // interest didn't consume, so the fd is edge-triggered only if all of its
+  // interests are.
+  if (edge_triggered)
+    events |= EPOLLET;
+  return events;
+}
+
+MessagePumpEpoll::MessagePumpEpoll() {
+  epoll_.reset(epoll_create1(EPOLL_CLOEXEC));
+  PCHECK(epoll_.is_valid()) << "epoll_create1";
+
+  wake_event_.reset(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+  PCHECK(wake_event_.is_valid()) << "eventfd";
+
+  epoll_event wake_event = {};
+  wake_event.events = EPOLLIN;
+  wake_event.data.ptr = &wake_event_;
+  PCHECK(epoll_ctl(epoll_.get(), EPOLL_CTL_ADD, wake_event_.get(),
+                   &wake_event) == 0)
+      << "epoll_ctl";
+}
+
+MessagePumpEpoll::~MessagePumpEpoll() = default;
+
+bool MessagePumpEpoll::WatchFileDescriptor(int fd,
+                                           bool persistent,
+                                           int mode,
+                                           FdWatchController* controller,
+                                           FdWatcher* delegate) {
+  return WatchFileDescriptorImpl({fd, mode, persistent,
+                                  /*edge_triggered=*/false},
+                                 controller, delegate);
+}
+
+bool MessagePumpEpoll::WatchFileDescriptorEdgeTriggered(
+    int fd,
+    int mode,
+    FdWatchController* controller,
+    FdWatcher* delegate) {
+  return WatchFileDescriptorImpl({fd, mode, /*persistent=*/true,
+                                  /*edge_triggered=*/true},
+                                 controller, delegate);
+}
+
+bool MessagePumpEpoll::WatchFileDescriptorImpl(InterestParams params,
+                                               FdWatchController* controller,
+                                               FdWatcher* delegate) {
+  const int fd = params.fd;
+  DCHECK_GE(fd, 0);
+  DCHECK(controller);
+  DCHECK(delegate);
+  DCHECK(params.mode == WATCH_READ || params.mode == WATCH_WRITE ||
+         params.mode == WATCH_READ_WRITE);
+  // WatchFileDescriptor should be called on the pump thread. It is not
+  // threadsafe, and your watcher may never be registered.
+  DCHECK(watch_file_descriptor_caller_checker_.CalledOnValidThread());
+
+  TRACE_EVENT_WITH_FLOW1("toplevel.flow",
+                         "MessagePumpEpoll::WatchFileDescriptor",
+                         reinterpret_cast<uintptr_t>(controller) ^ fd,
+                         TRACE_EVENT_FLAG_FLOW_OUT, "fd", fd);
+
+  if (controller->interest_ && controller->interest_->params().fd != fd) {
+    // It's illegal to use this function to listen on 2 separate fds with the
+    // same |controller|.
+    NOTREACHED() << "FDs don't match" << controller->interest_->params().fd
+                 << "!=" << fd;
+    return false;
+  }
+
+  auto it = entries_.try_emplace(fd, fd).first;
+  EpollEventEntry& entry = it->second;
+
+  if (controller->interest_) {
+    const InterestParams& old_params = controller->interest_->params();
+
+    // Combine the old and new registrations, like MessagePumpLibevent does.
+    params.mode |= old_params.mode;
+    params.persistent |= old_params.persistent;
+    params.edge_triggered &= old_params.edge_triggered;
+
+    // The epoll registration of |fd| is updated below, once for both
+    // registrations.
+    scoped_refptr<Interest> old_interest = std::move(controller->interest_);
+    entry.interests.erase(ranges::find(entry.interests, old_interest));
+    old_interest->Cancel();
+  }
+
+  auto interest = MakeRefCounted<Interest>(controller, params);
+  entry.interests.push_back(interest);
+  if (!UpdateEpollEvents(&entry)) {
+    entry.interests.pop_back();
+    interest->Cancel();
+    controller->pump_ = nullptr;
+    controller->watcher_ = nullptr;
+    // Restore the registration of the other interests in |fd|, if any.
+    UpdateEpollEvents(&entry);
+    if (entry.interests.empty())
+      entries_.erase(it);
+    return false;
+  }
+
+  controller->interest_ = std::move(interest);
+  controller->pump_ = weak_ptr_factory_.GetWeakPtr();
+  controller->watcher_ = delegate;
+  return true;
+}
+
+// Reentrant!
+void MessagePumpEpoll::Run(Delegate* delegate) {
+  RunState run_state(delegate);
+  AutoReset<RunState*> auto_reset_run_state(&run_state_, &run_state);
+
+  for (;;) {
+    // Do some work and see if the next task is ready right away.
+    Delegate::NextWorkInfo next_work_info = delegate->DoWork();
+    bool immediate_work_available = next_work_info.is_immediate();
+
+    if (run_state.should_quit)
+      break;
+
+    // Process native events if any are ready. Do not block waiting for more.
+    {
+      auto scoped_do_work_item = delegate->BeginWorkItem();
+      WaitForEpollEvents(TimeDelta());
+    }
+
+    bool attempt_more_work = immediate_work_available || processed_io_events_;
+    processed_io_events_ = false;
+
+    if (run_state.should_quit)
+      break;
+
+    if (attempt_more_work)
+      continue;
+
+    attempt_more_work = delegate->DoIdleWork();
+
+    if (run_state.should_quit)
+      break;
+
+    if (attempt_more_work)
+      continue;
+
+    // Block waiting for events and process all available upon waking up. This
+    // is conditionally interrupted to look for more work if we are aware of a
+    // delayed task that will need servicing.
+    DCHECK(!next_work_info.delayed_run_time.is_null());
+    delegate->BeforeWait();
+    WaitForEpollEvents(next_work_info.delayed_run_time.is_max()
+                           ? TimeDelta::Max()
+                           : next_work_info.remaining_delay());
+
+    if (run_state.should_quit)
+      break;
+  }
+}
+
+void MessagePumpEpoll::Quit() {
+  DCHECK(run_state_) << "Quit was called outside of Run!";
+  // Tell both epoll_wait() and Run that they should break out of their loops.
+  run_state_->should_quit = true;
+  ScheduleWork();
+}
+
+void MessagePumpEpoll::ScheduleWork() {
+  // Wake up epoll_wait() in a threadsafe way. Writes are coalesced by the
+  // eventfd counter, which is reset by OnWakeUp().
+  const uint64_t value = 1;
+  const ssize_t nwrite =
+      HANDLE_EINTR(write(wake_event_.get(), &value, sizeof(value)));
+  DPCHECK(nwrite == static_cast<ssize_t>(sizeof(value)) || errno == EAGAIN)
+      << "nwrite:" << nwrite;
+}
+
+void MessagePumpEpoll::ScheduleDelayedWork(
+    const TimeTicks& delayed_work_time) {
+  // We know that we can't be blocked in epoll_wait() right now since this
+  // method can only be called on the same thread as Run(). Hence we have
+  // nothing to do here, this thread will sleep in Run() with the correct
+  // timeout when it's out of immediate tasks.
+}
+
+bool MessagePumpEpoll::UnregisterInterest(
+    const scoped_refptr<Interest>& interest) {
+  interest->Cancel();
+
+  auto it = entries_.find(interest->params().fd);
+  DCHECK(it != entries_.end());
+  EpollEventEntry& entry = it->second;
+  auto interest_it = ranges::find(entry.interests, interest);
+  DCHECK(interest_it != entry.interests.end());
+  entry.interests.erase(interest_it);
+
+  const bool success = UpdateEpollEvents(&entry);
+  if (entry.interests.empty()) {
+    for (span<epoll_event> events : dispatched_events_) {
+      for (epoll_event& event : events) {
+        if (event.data.ptr == &entry)
+          event.data.ptr = nullptr;
+      }
+    }
+    entries_.erase(it);
+  }
+  return success;
+}
+
+bool MessagePumpEpoll::UpdateEpollEvents(EpollEventEntry* entry) {
+  const uint32_t events = entry->ComputeActiveEvents();
+  if (events == entry->registered_events)
+    return true;
+
+  int op = EPOLL_CTL_MOD;
+  if (entry->registered_events == 0)
+    op = EPOLL_CTL_ADD;
+  else if (events == 0)
+    op = EPOLL_CTL_DEL;
+
+  epoll_event event = {};
+  event.events = events;
+  event.data.ptr = entry;
+  if (epoll_ctl(epoll_.get(), op, entry->fd, &event) != 0) {
+    // A closed fd was already removed from the epoll set.
+    if (op == EPOLL_CTL_DEL && (errno == EBADF || errno == ENOENT)) {
+      entry->registered_events = 0;
+      return true;
+    }
+    DPLOG(ERROR) << "epoll_ctl(fd=" << entry->fd << ")";
+    return false;
+  }
+  entry->registered_events = events;
+  return true;
+}
+
+bool MessagePumpEpoll::WaitForEpollEvents(TimeDelta timeout) {
+  // Round the timeout up so that the pump doesn't spin until delayed work is
+  // due.
+  const int epoll_timeout =
+      timeout.is_max() ? -1
+                       : saturated_cast<int>(timeout.InMillisecondsRoundedUp());
+  epoll_event events[kMaxEventsPerWait];
+  const int epoll_result =
+      epoll_wait(epoll_.get(), events, kMaxEventsPerWait, epoll_timeout);
+  if (epoll_result < 0) {
+    DPCHECK(errno == EINTR);
+    return false;
+  }
+  if (epoll_result == 0)
+    return false;
+
+  const span<epoll_event> ready_events(events,
+                                       static_cast<size_t>(epoll_result));
+
+  // A callback may stop watching, or destroy the controllers of, another fd
+  // whose event is in |ready_events|, possibly from a nested Run(). Let
+  // UnregisterInterest() find and clear that event.
+  dispatched_events_.push_back(ready_events);
+  for (epoll_event& event : ready_events) {
+    if (event.data.ptr == &wake_event_) {
+      OnWakeUp();
+      continue;
+    }
+    auto* entry = static_cast<EpollEventEntry*>(event.data.ptr);
+    // The entry was removed while dispatching a previous event.
+    if (!entry)
+      continue;
+    OnEpollEvent(entry, event.events);
+  }
+  DCHECK(dispatched_events_.back().data() == events);
+  dispatched_events_.pop_back();
+  return true;
+}
+
+void MessagePumpEpoll::OnEpollEvent(EpollEventEntry* entry, uint32_t events) {
+  const int fd = entry->fd;
+  // Errors and hang-ups are reported to readers and writers, which find out
+  // about them from their next read or write.
+  const bool readable = events & (EPOLLIN | EPOLLERR | EPOLLHUP);
+  const bool writable = events & (EPOLLOUT | EPOLLERR | EPOLLHUP);
+
+  // Callbacks may stop watching |fd| or destroy any of its controllers, and
+  // remove |entry| along with them. Dispatch from a copy of its interests,
+  // each of which is cancelled once its controller stops watching.
+  StackVector<scoped_refptr<Interest>, 2> interests;
+  interests->assign(entry->interests.begin(), entry->interests.end());
+
+  for (const scoped_refptr<Interest>& interest : interests.container()) {
+    FdWatchController* controller = interest->controller();
+    if (!controller)
+      continue;
+    const int mode = interest->params().mode;
+    const bool can_read = readable && (mode & WATCH_READ);
+    const bool can_write = writable && (mode & WATCH_WRITE);
+    if (!can_read && !can_write)
+      continue;
+
+    // A non-persistent registration fires once. Unregister it before running
+    // callbacks, which may register |controller| again.
+    if (!interest->params().persistent) {
+      UnregisterInterest(interest);
+      controller->interest_ = nullptr;
+      controller->pump_ = nullptr;
+    }
+
+    HandleEvent(fd, can_read, can_write, controller);
+  }
+}
+
+void MessagePumpEpoll::HandleEvent(int fd,
+                                   bool can_read,
+                                   bool can_write,
+                                   FdWatchController* controller) {
+  TRACE_EVENT0("toplevel", "EpollEvent");
+  TRACE_EVENT_WITH_FLOW1(
+      "toplevel.flow", "MessagePumpEpoll::HandleEvent",
+      reinterpret_cast<uintptr_t>(controller) ^ fd,
+      TRACE_EVENT_FLAG_FLOW_IN | TRACE_EVENT_FLAG_FLOW_OUT, "fd", fd);
+
+  TRACE_HEAP_PROFILER_API_SCOPED_TASK_EXECUTION heap_profiler_scope(
+      controller->created_from_location().file_name());
+
+  processed_io_events_ = true;
+
+  // Make the MessagePumpDelegate aware of this other form of "DoWork". Skip if
+  // HandleEvent is called outside of Run() (e.g. in unit tests).
+  Delegate::ScopedDoWorkItem scoped_do_work_item;
+  if (run_state_)
+    scoped_do_work_item = run_state_->delegate->BeginWorkItem();
+
+  if (can_read && can_write) {
+    // Both callbacks will be called. It is necessary to check that |controller|
+    // is not destroyed.
+    bool controller_was_destroyed = false;
+    controller->was_destroyed_ = &controller_was_destroyed;
+    controller->OnFileCanWriteWithoutBlocking(fd, this);
+    if (!controller_was_destroyed)
+      controller->OnFileCanReadWithoutBlocking(fd, this);
+    if (!controller_was_destroyed)
+      controller->was_destroyed_ = nullptr;
+  } else if (can_write) {
+    controller->OnFileCanWriteWithoutBlocking(fd, this);
+  } else if (can_read) {
+    controller->OnFileCanReadWithoutBlocking(fd, this);
+  }
+}
+
+void MessagePumpEpoll::OnWakeUp() {
+  // Reset the eventfd counter.
+  uint64_t value;
+  const ssize_t nread =
+      HANDLE_EINTR(read(wake_event_.get(), &value, sizeof(value)));
+  DPCHECK(nread == static_cast<ssize_t>(sizeof(value)) || errno == EAGAIN)
+      << "nread:" << nread;
+  processed_io_events_ = true;
+}
+
+}  // namespace base
@@ -0,0 +1,215 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_MESSAGE_LOOP_MESSAGE_PUMP_EPOLL_H_
+#define BASE_MESSAGE_LOOP_MESSAGE_PUMP_EPOLL_H_
+
+#include <stdint.h>
+#include <sys/epoll.h>
+
+#include <map>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/containers/span.h"
+#include "base/files/scoped_file.h"
+#include "base/location.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/message_loop/message_pump.h"
+#include "base/message_loop/watchable_io_message_pump_posix.h"
+#include "base/threading/thread_checker.h"
+#include "base/time/time.h"
+
+namespace base {
+
+// Class to monitor file descriptors and issue callbacks when they are ready for
+// I/O, built directly on epoll(7) rather than on libevent. There is a single
+// epoll registration per file descriptor, which combines the interests of all
+// the FdWatchControllers watching it. ScheduleWork() wakes up the pump through
+// an eventfd.
+class BASE_EXPORT MessagePumpEpoll : public MessagePump,
+                                     public WatchableIOMessagePumpPosix {
+ private:
+  class Interest;
+
+ public:
+  class FdWatchController : public FdWatchControllerInterface {
+   public:
+    explicit FdWatchController(const Location& from_here);
+
+    FdWatchController(const FdWatchController&) = delete;
+    FdWatchController& operator=(const FdWatchController&) = delete;
+
+    // Implicitly calls StopWatchingFileDescriptor.
+    ~FdWatchController() override;
+
+    // FdWatchControllerInterface:
+    bool StopWatchingFileDescriptor() override;
+
+   private:
+    friend class MessagePumpEpoll;
+    friend class MessagePumpEpollTest;
+
+    void OnFileCanReadWithoutBlocking(int fd, MessagePumpEpoll* pump);
+    void OnFileCanWriteWithoutBlocking(int fd, MessagePumpEpoll* pump);
+
+    // The registration made by the last WatchFileDescriptor() call, until it
+    // is stopped or, if it isn't persistent, until it fires.
+    scoped_refptr<Interest> interest_;
+    WeakPtr<MessagePumpEpoll> pump_;
+    FdWatcher* watcher_ = nullptr;
+    // If this pointer is non-NULL, the pointee is set to true in the
+    // destructor.
+    bool* was_destroyed_ = nullptr;
+  };
+
+  MessagePumpEpoll();
+
+  MessagePumpEpoll(const MessagePumpEpoll&) = delete;
+  MessagePumpEpoll& operator=(const MessagePumpEpoll&) = delete;
+
+  ~MessagePumpEpoll() override;
+
+  bool WatchFileDescriptor(int fd,
+                           bool persistent,
+                           int mode,
+                           FdWatchController* controller,
+                           FdWatcher* delegate);
+
+  // Same as WatchFileDescriptor() with |persistent| set, but |fd| is watched in
+  // edge-triggered mode: |delegate| isn't notified again until |fd| becomes
+  // ready after a read or write on it failed with EAGAIN. This saves epoll
+  // wake-ups for busy file descriptors, but |delegate| must always drain |fd|.
+  // |fd| stays level-triggered while another controller watches it with
+  // WatchFileDescriptor().
+  bool WatchFileDescriptorEdgeTriggered(int fd,
+                                        int mode,
+                                        FdWatchController* controller,
+                                        FdWatcher* delegate);
+
+  // MessagePump methods:
+  void Run(Delegate* delegate) override;
+  void Quit() override;
+  void ScheduleWork() override;
+  void ScheduleDelayedWork(const TimeTicks& delayed_work_time) override;
+
+ private:
+  friend class MessagePumpEpollTest;
+
+  struct InterestParams {
+    int fd;
+    int mode;
+    bool persistent;
+    bool edge_triggered;
+  };
+
+  // A registration made by WatchFileDescriptor(). It is shared by its
+  // FdWatchController and by the EpollEventEntry of its fd, so that the pump
+  // can tell when a registration is stopped while its event is dispatched.
+  class Interest : public RefCounted<Interest> {
+   public:
+    Interest(FdWatchController* controller, const InterestParams& params);
+
+    Interest(const Interest&) = delete;
+    Interest& operator=(const Interest&) = delete;
+
+    // Returns the controller of this registration, or null once it is stopped.
+    FdWatchController* controller() const { return controller_; }
+    const InterestParams& params() const { return params_; }
+
+    void Cancel() { controller_ = nullptr; }
+
+   private:
+    friend class RefCounted<Interest>;
+    ~Interest();
+
+    FdWatchController* controller_;
+    const InterestParams params_;
+  };
+
+  // The epoll registration of a file descriptor watched by at least one
+  // FdWatchController.
+  struct EpollEventEntry {
+    explicit EpollEventEntry(int fd);
+    EpollEventEntry(const EpollEventEntry&) = delete;
+    EpollEventEntry& operator=(const EpollEventEntry&) = delete;
+    ~EpollEventEntry();
+
+    // Returns the epoll events needed by |interests|.
+    uint32_t ComputeActiveEvents() const;
+
+    const int fd;
+
+    // Events currently registered with epoll for |fd|.
+    uint32_t registered_events = 0;
+
+    std::vector<scoped_refptr<Interest>> interests;
+  };
+
+  bool WatchFileDescriptorImpl(InterestParams params,
+                               FdWatchController* controller,
+                               FdWatcher* delegate);
+
+  // Removes |interest| from the entry of its fd, updates its epoll
+  // registration and cancels |interest|. Returns false if epoll_ctl() failed.
+  bool UnregisterInterest(const scoped_refptr<Interest>& interest);
+
+  // Registers the events needed by |entry| with epoll. Returns false if
+  // epoll_ctl() failed.
+  bool UpdateEpollEvents(EpollEventEntry* entry);
+
+  // Waits up to |timeout| for epoll events and dispatches them. Returns true if
+  // any event was dispatched.
+  bool WaitForEpollEvents(TimeDelta timeout);
+
+  // Dispatches |events| for |entry| to the controllers watching its fd.
+  void OnEpollEvent(EpollEventEntry* entry, uint32_t events);
+
+  void HandleEvent(int fd,
+                   bool can_read,
+                   bool can_write,
+                   FdWatchController* controller);
+
+  // Resets |wake_event_|.
+  void OnWakeUp();
+
+  struct RunState {
+    explicit RunState(Delegate* delegate_in) : delegate(delegate_in) {}
+
+    Delegate* const delegate;
+
+    // Used to flag that the current Run() invocation should return ASAP.
+    bool should_quit = false;
+  };
+
+  // State for the current invocation of Run(). null if not running.
+  RunState* run_state_ = nullptr;
+
+  // This flag is set if epoll events were dispatched.
+  bool processed_io_events_ = false;
+
+  // The events returned by the epoll_wait() calls being dispatched, one batch
+  // per nested Run(). UnregisterInterest() clears the events of the entries it
+  // removes from all of them, so that an outer batch doesn't dispatch to an
+  // entry removed by a nested one.
+  std::vector<span<epoll_event>> dispatched_events_;
+
+  // Entries of all watched file descriptors, by fd. std::map doesn't move its
+  // values, which epoll events point to.
+  std::map<int, EpollEventEntry> entries_;
+
+  ScopedFD epoll_;
+
+  // eventfd which ScheduleWork() signals to wake up epoll_wait().
+  ScopedFD wake_event_;
+
+  ThreadChecker watch_file_descriptor_caller_checker_;
+
+  WeakPtrFactory<MessagePumpEpoll> weak_ptr_factory_{this};
+};
+
+}  // namespace base
+
+#endif  // BASE_MESSAGE_LOOP_MESSAGE_PUMP_EPOLL_H_
@@ -0,0 +1,449 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/message_loop/message_pump_epoll.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/callback.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_file.h"
+#include "base/memory/ptr_util.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/run_loop.h"
+#include "base/task/single_thread_task_executor.h"
+#include "base/test/bind.h"
+#include "base/test/gtest_util.h"
+#include "base/test/task_environment.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+class MessagePumpEpollTest : public testing::Test {
+ protected:
+  MessagePumpEpollTest()
+      : task_environment_(std::make_unique<test::SingleThreadTaskEnvironment>(
+            test::SingleThreadTaskEnvironment::MainThreadType::UI)) {}
+  ~MessagePumpEpollTest() override = default;
+
+  void SetUp() override {
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    ASSERT_TRUE(SetNonBlocking(fds[0]));
+    ASSERT_TRUE(SetNonBlocking(fds[1]));
+    socket_.reset(fds[0]);
+    peer_socket_.reset(fds[1]);
+  }
+
+  // Spoofs an event signaling that |controller|'s fd is readable and writable.
+  void HandleEvent(MessagePumpEpoll* pump,
+                   MessagePumpEpoll::FdWatchController* controller) {
+    pump->HandleEvent(0, /*can_read=*/true, /*can_write=*/true, controller);
+  }
+
+  // Dispatches the epoll events which are ready, without blocking.
+  bool DispatchReadyEvents(MessagePumpEpoll* pump) {
+    return pump->WaitForEpollEvents(TimeDelta());
+  }
+
+  size_t GetNumWatchedFds(MessagePumpEpoll* pump) {
+    return pump->entries_.size();
+  }
+
+  void WriteToPeer() {
+    const char buf = 0;
+    ASSERT_EQ(1, HANDLE_EINTR(write(peer_socket_.get(), &buf, 1)));
+  }
+
+  void ReadFromSocket() {
+    char buf;
+    ASSERT_EQ(1, HANDLE_EINTR(read(socket_.get(), &buf, 1)));
+  }
+
+  ScopedFD socket_;
+  ScopedFD peer_socket_;
+  std::unique_ptr<test::SingleThreadTaskEnvironment> task_environment_;
+};
+
+namespace {
+
+class BaseWatcher : public MessagePumpEpoll::FdWatcher {
+ public:
+  explicit BaseWatcher(MessagePumpEpoll::FdWatchController* controller)
+      : controller_(controller) {
+    DCHECK(controller_);
+  }
+  ~BaseWatcher() override = default;
+
+  // base:MessagePumpEpoll::FdWatcher interface
+  void OnFileCanReadWithoutBlocking(int /* fd */) override { NOTREACHED(); }
+
+  void OnFileCanWriteWithoutBlocking(int /* fd */) override { NOTREACHED(); }
+
+ protected:
+  MessagePumpEpoll::FdWatchController* controller_;
+};
+
+// Counts notifications, and runs |on_read| on each read notification.
+class CountingWatcher : public MessagePumpEpoll::FdWatcher {
+ public:
+  CountingWatcher() = default;
+  ~CountingWatcher() override = default;
+
+  void OnFileCanReadWithoutBlocking(int /* fd */) override {
+    ++num_reads;
+    if (on_read)
+      on_read.Run();
+  }
+
+  void OnFileCanWriteWithoutBlocking(int /* fd */) override { ++num_writes; }
+
+  int num_reads = 0;
+  int num_writes = 0;
+  RepeatingClosure on_read;
+};
+
+}  // namespace
+
+TEST_F(MessagePumpEpollTest, QuitOutsideOfRun) {
+  auto pump = std::make_unique<MessagePumpEpoll>();
+  ASSERT_DCHECK_DEATH(pump->Quit());
+}
+
+namespace {
+
+class DeleteWatcher : public BaseWatcher {
+ public:
+  explicit DeleteWatcher(MessagePumpEpoll::FdWatchController* controller)
+      : BaseWatcher(controller) {}
+
+  ~DeleteWatcher() override { DCHECK(!controller_); }
+
+  void OnFileCanWriteWithoutBlocking(int /* fd */) override {
+    DCHECK(controller_);
+    delete controller_;
+    controller_ = nullptr;
+  }
+};
+
+}  // namespace
+
+TEST_F(MessagePumpEpollTest, DeleteWatcher) {
+  auto pump = std::make_unique<MessagePumpEpoll>();
+  MessagePumpEpoll::FdWatchController* watcher =
+      new MessagePumpEpoll::FdWatchController(FROM_HERE);
+  DeleteWatcher delegate(watcher);
+  pump->WatchFileDescriptor(socket_.get(), false,
+                            MessagePumpEpoll::WATCH_READ_WRITE, watcher,
+                            &delegate);
+
+  HandleEvent(pump.get(), watcher);
+  EXPECT_EQ(0U, GetNumWatchedFds(pump.get()));
+}
+
+namespace {
+
+class StopWatcher : public BaseWatcher {
+ public:
+  explicit StopWatcher(MessagePumpEpoll::FdWatchController* controller)
+      : BaseWatcher(controller) {}
+
+  ~StopWatcher() override = default;
+
+  void OnFileCanWriteWithoutBlocking(int /* fd */) override {
+    controller_->StopWatchingFileDescriptor();
+  }
+};
+
+}  // namespace
+
+TEST_F(MessagePumpEpollTest, StopWatcher) {
+  auto pump = std::make_unique<MessagePumpEpoll>();
+  MessagePumpEpoll::FdWatchController watcher(FROM_HERE);
+  StopWatcher delegate(&watcher);
+  pump->WatchFileDescriptor(socket_.get(), false,
+                            MessagePumpEpoll::WATCH_READ_WRITE, &watcher,
+                            &delegate);
+
+  HandleEvent(pump.get(), &watcher);
+  EXPECT_EQ(0U, GetNumWatchedFds(pump.get()));
+}
+
+namespace {
+
+void QuitMessageLoopAndStart(OnceClosure quit_closure) {
+  std::move(quit_closure).Run();
+
+  RunLoop runloop(RunLoop::Type::kNestableTasksAllowed);
+  ThreadTaskRunnerHandle::Get()->PostTask(FROM_HERE, runloop.QuitClosure());
+  runloop.Run();
+}
+
+class NestedPumpWatcher : public MessagePumpEpoll::FdWatcher {
+ public:
+  NestedPumpWatcher() = default;
+  ~NestedPumpWatcher() override = default;
+
+  void OnFileCanReadWithoutBlocking(int /* fd */) override {
+    RunLoop runloop;
+    ThreadTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE, BindOnce(&QuitMessageLoopAndStart, runloop.QuitClosure()));
+    runloop.Run();
+  }
+
+  void OnFileCanWriteWithoutBlocking(int /* fd */) override {}
+};
+
+}  // namespace
+
+TEST_F(MessagePumpEpollTest, NestedPumpWatcher) {
+  auto pump = std::make_unique<MessagePumpEpoll>();
+  MessagePumpEpoll::FdWatchController watcher(FROM_HERE);
+  NestedPumpWatcher delegate;
+  pump->WatchFileDescriptor(socket_.get(), false, MessagePumpEpoll::WATCH_READ,
+                            &watcher, &delegate);
+
+  HandleEvent(pump.get(), &watcher);
+}
+
+namespace {
+
+void FatalClosure() {
+  FAIL() << "Reached fatal closure.";
+}
+
+class QuitWatcher : public BaseWatcher {
+ public:
+  QuitWatcher(MessagePumpEpoll::FdWatchController* controller,
+              base::OnceClosure quit_closure)
+      : BaseWatcher(controller), quit_closure_(std::move(quit_closure)) {}
+
+  void OnFileCanReadWithoutBlocking(int /* fd */) override {
+    // Post a fatal closure to the MessageLoop before we quit it.
+    ThreadTaskRunnerHandle::Get()->PostTask(FROM_HERE, BindOnce(&FatalClosure));
+
+    if (quit_closure_)
+      std::move(quit_closure_).Run();
+  }
+
+ private:
+  base::OnceClosure quit_closure_;
+};
+
+}  // namespace
+
+// Tests that MessagePumpEpoll quits immediately when it is quit from an event
+// callback.
+TEST_F(MessagePumpEpollTest, QuitWatcher) {
+  // Delete the old TaskEnvironment so that we can manage our own one here.
+  task_environment_.reset();
+
+  MessagePumpEpoll* pump = new MessagePumpEpoll;  // owned by |executor|.
+  SingleThreadTaskExecutor executor(WrapUnique(pump));
+  RunLoop run_loop;
+  MessagePumpEpoll::FdWatchController controller(FROM_HERE);
+  QuitWatcher delegate(&controller, run_loop.QuitClosure());
+  pump->WatchFileDescriptor(socket_.get(), false, MessagePumpEpoll::WATCH_READ,
+                            &controller, &delegate);
+
+  // Make |socket_| readable once the loop runs.
+  ThreadTaskRunnerHandle::Get()->PostTask(
+      FROM_HERE, BindLambdaForTesting([&]() { WriteToPeer(); }));
+
+  run_loop.Run();
+}
+
+// A non-persistent registration fires once, and is then removed.
+TEST_F(MessagePumpEpollTest, NonPersistent) {
+  auto pump = std::make_unique<MessagePumpEpoll>();
+  MessagePumpEpoll::FdWatchController controller(FROM_HERE);
+  CountingWatcher delegate;
+  ASSERT_TRUE(pump->WatchFileDescriptor(socket_.get(), false,
+                                        MessagePumpEpoll::WATCH_READ,
+                                        &controller, &delegate));
+  WriteToPeer();
+
+  EXPECT_TRUE(DispatchReadyEvents(pump.get()));
+  EXPECT_EQ(1, delegate.num_reads);
+  EXPECT_EQ(0U, GetNumWatchedFds(pump.get()));
+
+  EXPECT_FALSE(DispatchReadyEvents(pump.get()));
+  EXPECT_EQ(1, delegate.num_reads);
+  EXPECT_TRUE(controller.StopWatchingFileDescriptor());
+}
+
+// Several controllers can watch the same fd, each for its own mode.
+TEST_F(MessagePumpEpollTest, MultipleControllersOnSameFd) {
+  auto pump = std::make_unique<MessagePumpEpoll>();
+  MessagePumpEpoll::FdWatchController read_controller(FROM_HERE);
+  MessagePumpEpoll::FdWatchController write_controller(FROM_HERE);
+  CountingWatcher read_delegate;
+  CountingWatcher write_delegate;
+  ASSERT_TRUE(pump->WatchFileDescriptor(socket_.get(), true,
+                                        MessagePumpEpoll::WATCH_READ,
+                                        &read_controller, &read_delegate));
+  ASSERT_TRUE(pump->WatchFileDescriptor(socket_.get(), true,
+                                        MessagePumpEpoll::WATCH_WRITE,
+                                        &write_controller, &write_delegate));
+  EXPECT_EQ(1U, GetNumWatchedFds(pump.get()));
+
+  // |socket_| is writable but not readable.
+  EXPECT_TRUE(DispatchReadyEvents(pump.get()));
+  EXPECT_EQ(0, read_delegate.num_reads);
+  EXPECT_EQ(1, write_delegate.num_writes);
+
+  WriteToPeer();
+  EXPECT_TRUE(DispatchReadyEvents(pump.get()));
+  EXPECT_EQ(1, read_delegate.num_reads);
+  EXPECT_EQ(0, read_delegate.num_writes);
+  EXPECT_EQ(2, write_delegate.num_writes);
+  EXPECT_EQ(0, write_delegate.num_reads);
+
+  EXPECT_TRUE(write_controller.StopWatchingFileDescriptor());
+  ReadFromSocket();
+  EXPECT_FALSE(DispatchReadyEvents(pump.get()));
+  EXPECT_EQ(1U, GetNumWatchedFds(pump.get()));
+
+  EXPECT_TRUE(read_controller.StopWatchingFileDescriptor());
+  EXPECT_EQ(0U, GetNumWatchedFds(pump.get()));
+}
+
+// A controller destroyed by the callback of another controller of the same fd
+// isn't notified.
+TEST_F(MessagePumpEpollTest, DeleteOtherControllerOnSameFd) {
+  auto pump = std::make_unique<MessagePumpEpoll>();
+  MessagePumpEpoll::FdWatchController first_controller(FROM_HERE);
+  auto second_controller =
+      std::make_unique<MessagePumpEpoll::FdWatchController>(FROM_HERE);
+  CountingWatcher first_delegate;
+  BaseWatcher second_delegate(second_controller.get());
+  first_delegate.on_read = BindLambdaForTesting([&]() {
+    second_controller.reset();
+  });
+  ASSERT_TRUE(pump->WatchFileDescriptor(socket_.get(), true,
+                                        MessagePumpEpoll::WATCH_READ,
+                                        &first_controller, &first_delegate));
+  ASSERT_TRUE(pump->WatchFileDescriptor(
+      socket_.get(), true, MessagePumpEpoll::WATCH_READ,
+      second_controller.get(), &second_delegate));
+
+  WriteToPeer();
+  EXPECT_TRUE(DispatchReadyEvents(pump.get()));
+  EXPECT_EQ(1, first_delegate.num_reads);
+  EXPECT_FALSE(second_controller);
+}
+
+// An fd whose event is pending in the batch of an outer loop can stop being
+// watched from a nested loop, after which the outer loop doesn't dispatch its
+// event.
+TEST_F(MessagePumpEpollTest, StopWatchingFromNestedLoop) {
+  // Delete the old TaskEnvironment so that we can manage our own one here.
+  task_environment_.reset();
+
+  MessagePumpEpoll* pump = new MessagePumpEpoll;  // owned by |executor|.
+  SingleThreadTaskExecutor executor(WrapUnique(pump));
+
+  int fds[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  ASSERT_TRUE(SetNonBlocking(fds[0]));
+  ScopedFD other_socket(fds[0]);
+  ScopedFD other_peer_socket(fds[1]);
+  const int sockets[] = {socket_.get(), other_socket.get()};
+
+  std::unique_ptr<MessagePumpEpoll::FdWatchController> controllers[2];
+  CountingWatcher delegates[2];
+  RunLoop run_loop;
+  OnceClosure quit_nested_loop;
+  for (int i = 0; i < 2; ++i) {
+    controllers[i] =
+        std::make_unique<MessagePumpEpoll::FdWatchController>(FROM_HERE);
+    delegates[i].on_read = BindLambdaForTesting([&, i]() {
+      char buf;
+      ASSERT_EQ(1, HANDLE_EINTR(read(sockets[i], &buf, 1)));
+      if (!RunLoop::IsNestedOnCurrentThread()) {
+        // The event of the other fd is still pending in this batch. The nested
+        // loop dispatches it again.
+        RunLoop nested_loop(RunLoop::Type::kNestableTasksAllowed);
+        quit_nested_loop = nested_loop.QuitClosure();
+        nested_loop.Run();
+        run_loop.Quit();
+        return;
+      }
+      // Removes the entry of this fd.
+      controllers[i].reset();
+      std::move(quit_nested_loop).Run();
+    });
+    ASSERT_TRUE(pump->WatchFileDescriptor(sockets[i], true,
+                                          MessagePumpEpoll::WATCH_READ,
+                                          controllers[i].get(), &delegates[i]));
+  }
+
+  // Both fds are ready in the first batch.
+  WriteToPeer();
+  const char buf = 0;
+  ASSERT_EQ(1, HANDLE_EINTR(write(other_peer_socket.get(), &buf, 1)));
+
+  run_loop.Run();
+  EXPECT_EQ(1, delegates[0].num_reads);
+  EXPECT_EQ(1, delegates[1].num_reads);
+  EXPECT_EQ(1U, GetNumWatchedFds(pump));
+}
+
+// An edge-triggered controller is only notified again once its fd becomes
+// ready again.
+TEST_F(MessagePumpEpollTest, EdgeTriggered) {
+  auto pump = std::make_unique<MessagePumpEpoll>();
+  MessagePumpEpoll::FdWatchController controller(FROM_HERE);
+  CountingWatcher delegate;
+  ASSERT_TRUE(pump->WatchFileDescriptorEdgeTriggered(
+      socket_.get(), MessagePumpEpoll::WATCH_READ, &controller, &delegate));
+
+  WriteToPeer();
+  EXPECT_TRUE(DispatchReadyEvents(pump.get()));
+  EXPECT_EQ(1, delegate.num_reads);
+
+  // |socket_| is still readable, but wasn't drained.
+  EXPECT_FALSE(DispatchReadyEvents(pump.get()));
+  EXPECT_EQ(1, delegate.num_reads);
+
+  WriteToPeer();
+  EXPECT_TRUE(DispatchReadyEvents(pump.get()));
+  EXPECT_EQ(2, delegate.num_reads);
+}
+
+// An fd watched by both an edge-triggered and a level-triggered controller is
+// level-triggered.
+TEST_F(MessagePumpEpollTest, EdgeTriggeredWithLevelTriggered) {
+  auto pump = std::make_unique<MessagePumpEpoll>();
+  MessagePumpEpoll::FdWatchController edge_controller(FROM_HERE);
+  MessagePumpEpoll::FdWatchController level_controller(FROM_HERE);
+  CountingWatcher edge_delegate;
+  CountingWatcher level_delegate;
+  ASSERT_TRUE(pump->WatchFileDescriptorEdgeTriggered(
+      socket_.get(), MessagePumpEpoll::WATCH_READ, &edge_controller,
+      &edge_delegate));
+  ASSERT_TRUE(pump->WatchFileDescriptor(socket_.get(), true,
+                                        MessagePumpEpoll::WATCH_READ,
+                                        &level_controller, &level_delegate));
+
+  WriteToPeer();
+  EXPECT_TRUE(DispatchReadyEvents(pump.get()));
+  EXPECT_TRUE(DispatchReadyEvents(pump.get()));
+  EXPECT_EQ(2, edge_delegate.num_reads);
+  EXPECT_EQ(2, level_delegate.num_reads);
+
+  // Once the level-triggered controller stops, the fd is edge-triggered again.
+  EXPECT_TRUE(level_controller.StopWatchingFileDescriptor());
+  EXPECT_TRUE(DispatchReadyEvents(pump.get()));
+  EXPECT_FALSE(DispatchReadyEvents(pump.get()));
+  EXPECT_EQ(3, edge_delegate.num_reads);
+}
+
+}  // namespace base
@@ -8,6 +8,7 @@
 // This header is a forwarding header to coalesce the various platform specific
 // types representing MessagePumpForIO.
 
+#include "base/message_loop/message_pump_buildflags.h"
 #include "build/build_config.h"
 
 #if defined(OS_WIN)
@@ -20,6 +21,8 @@
 #include "base/message_loop/message_pump_default.h"
 #elif defined(OS_FUCHSIA)
 #include "base/message_loop/message_pump_fuchsia.h"
+#elif BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
+#include "base/message_loop/message_pump_epoll.h"
 #elif defined(OS_POSIX)
 #include "base/message_loop/message_pump_libevent.h"
 #endif
@@ -37,6 +40,8 @@ using MessagePumpForIO = MessagePumpKqueue;
 using MessagePumpForIO = MessagePumpDefault;
 #elif defined(OS_FUCHSIA)
 using MessagePumpForIO = MessagePumpFuchsia;
+#elif BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
+using MessagePumpForIO = MessagePumpEpoll;
 #elif defined(OS_POSIX)
 using MessagePumpForIO = MessagePumpLibevent;
 #else
@@ -8,6 +8,7 @@
 // This header is a forwarding header to coalesce the various platform specific
 // implementations of MessagePumpForUI.
 
+#include "base/message_loop/message_pump_buildflags.h"
 #include "build/build_config.h"
 
 #if defined(OS_WIN)
@@ -20,6 +21,8 @@
 // No MessagePumpForUI, see below.
 #elif defined(USE_GLIB)
 #include "base/message_loop/message_pump_glib.h"
+#elif BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
+#include "base/message_loop/message_pump_epoll.h"
 #elif defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_BSD)
 #include "base/message_loop/message_pump_libevent.h"
 #elif defined(OS_FUCHSIA)
@@ -44,6 +47,8 @@ using MessagePumpForUI = MessagePump;
 // TODO(abarth): Figure out if we need this.
 #elif defined(USE_GLIB)
 using MessagePumpForUI = MessagePumpGlib;
+#elif BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
+using MessagePumpForUI = MessagePumpEpoll;
 #elif defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_BSD)
 using MessagePumpForUI = MessagePumpLibevent;
 #elif defined(OS_FUCHSIA)
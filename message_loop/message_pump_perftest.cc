@@ -11,7 +11,10 @@
 #include "base/callback_helpers.h"
 #include "base/format_macros.h"
 #include "base/memory/ptr_util.h"
+#include "base/message_loop/message_pump_buildflags.h"
+#include "base/message_loop/message_pump_for_io.h"
 #include "base/message_loop/message_pump_type.h"
+#include "base/run_loop.h"
 #include "base/single_thread_task_runner.h"
 #include "base/strings/stringprintf.h"
 #include "base/synchronization/condition_variable.h"
@@ -19,6 +22,7 @@
 #include "base/synchronization/waitable_event.h"
 #include "base/task/current_thread.h"
 #include "base/task/sequence_manager/sequence_manager_impl.h"
+#include "base/task/single_thread_task_executor.h"
 #include "base/threading/thread.h"
 #include "base/time/time.h"
 #include "build/build_config.h"
@@ -29,6 +33,19 @@
 #include "base/android/java_handler_thread.h"
 #endif
 
+#if defined(OS_POSIX) && !defined(OS_NACL)
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_file.h"
+#include "base/posix/eintr_wrapper.h"
+#endif
+
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
+#include "base/message_loop/message_pump_libevent.h"
+#endif
+
 namespace base {
 namespace {
 
@@ -265,4 +282,173 @@ TEST_F(ScheduleWorkTest, ThreadTimeToJavaFromFourThreads) {
 }
 #endif
 
+#if defined(OS_POSIX) && !defined(OS_NACL)
+namespace {
+
+constexpr char kMetricPrefixFdWatch[] = "FdWatch.";
+constexpr char kMetricTimePerWatch[] = "time_per_watch_and_stop";
+constexpr char kMetricTimePerEvent[] = "time_per_event";
+
+// Number of socket pairs watched by the FdWatchPerfTest benchmarks.
+constexpr int kNumSocketPairs = 256;
+// Number of times each socket is watched and stopped by FdChurn.
+constexpr int kNumChurnIterations = 200;
+// Number of read events dispatched by EventDispatch.
+constexpr int kNumEvents = 500000;
+
+perf_test::PerfResultReporter SetUpFdWatchReporter(
+    const std::string& story_name) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixFdWatch, story_name);
+  reporter.RegisterImportantMetric(kMetricTimePerWatch, "ns");
+  reporter.RegisterImportantMetric(kMetricTimePerEvent, "ns");
+  return reporter;
+}
+
+struct IOPump {
+  using Pump = MessagePumpForIO;
+  static constexpr char kStoryName[] = "io_pump";
+};
+
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
+// Compares MessagePumpForIO with the pump it replaces.
+struct LibeventPump {
+  using Pump = MessagePumpLibevent;
+  static constexpr char kStoryName[] = "libevent";
+};
+#endif
+
+template <typename Pump>
+class NoopWatcher : public Pump::FdWatcher {
+ public:
+  void OnFileCanReadWithoutBlocking(int fd) override {}
+  void OnFileCanWriteWithoutBlocking(int fd) override {}
+};
+
+// Reads the byte written to its socket and writes it again from the peer
+// socket, so that its socket is readable the next time the pump polls, until
+// |num_events_left| reaches 0.
+template <typename Pump>
+class EchoWatcher : public Pump::FdWatcher {
+ public:
+  EchoWatcher(int peer_fd, int* num_events_left, OnceClosure* quit_closure)
+      : peer_fd_(peer_fd),
+        num_events_left_(num_events_left),
+        quit_closure_(quit_closure) {}
+
+  void OnFileCanReadWithoutBlocking(int fd) override {
+    char buf;
+    CHECK_EQ(1, HANDLE_EINTR(read(fd, &buf, 1)));
+    if (*num_events_left_ <= 0)
+      return;
+    if (--*num_events_left_ == 0) {
+      std::move(*quit_closure_).Run();
+      return;
+    }
+    CHECK_EQ(1, HANDLE_EINTR(write(peer_fd_, &buf, 1)));
+  }
+
+  void OnFileCanWriteWithoutBlocking(int fd) override {}
+
+ private:
+  const int peer_fd_;
+  int* const num_events_left_;
+  OnceClosure* const quit_closure_;
+};
+
+}  // namespace
+
+template <typename PumpType>
+class FdWatchPerfTest : public testing::Test {
+ public:
+  using Pump = typename PumpType::Pump;
+
+  void SetUp() override {
+    for (int i = 0; i < kNumSocketPairs; ++i) {
+      int fds[2];
+      ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+      sockets_.emplace_back(fds[0]);
+      peer_sockets_.emplace_back(fds[1]);
+      ASSERT_TRUE(SetNonBlocking(fds[0]));
+      ASSERT_TRUE(SetNonBlocking(fds[1]));
+    }
+  }
+
+  // Watches and stops watching each socket in turn, as done when connections
+  // are opened and closed.
+  void FdChurn() {
+    Pump pump;
+    NoopWatcher<Pump> watcher;
+    const TimeTicks start = TimeTicks::Now();
+    for (int i = 0; i < kNumChurnIterations; ++i) {
+      for (const ScopedFD& socket : sockets_) {
+        typename Pump::FdWatchController controller(FROM_HERE);
+        CHECK(pump.WatchFileDescriptor(socket.get(), true, Pump::WATCH_READ,
+                                       &controller, &watcher));
+        CHECK(controller.StopWatchingFileDescriptor());
+      }
+    }
+    const TimeDelta duration = TimeTicks::Now() - start;
+
+    auto reporter = SetUpFdWatchReporter(PumpType::kStoryName);
+    reporter.AddResult(kMetricTimePerWatch,
+                       duration.InNanoseconds() /
+                           static_cast<double>(kNumChurnIterations *
+                                               kNumSocketPairs));
+  }
+
+  // Keeps all sockets readable, and measures how long it takes to dispatch
+  // their read events.
+  void EventDispatch() {
+    auto owned_pump = std::make_unique<Pump>();
+    Pump* pump = owned_pump.get();
+    SingleThreadTaskExecutor executor(std::move(owned_pump));
+    RunLoop run_loop;
+    OnceClosure quit_closure = run_loop.QuitClosure();
+    int num_events_left = kNumEvents;
+
+    std::vector<std::unique_ptr<typename Pump::FdWatchController>> controllers;
+    std::vector<std::unique_ptr<EchoWatcher<Pump>>> watchers;
+    for (int i = 0; i < kNumSocketPairs; ++i) {
+      controllers.push_back(
+          std::make_unique<typename Pump::FdWatchController>(FROM_HERE));
+      watchers.push_back(std::make_unique<EchoWatcher<Pump>>(
+          peer_sockets_[i].get(), &num_events_left, &quit_closure));
+      CHECK(pump->WatchFileDescriptor(sockets_[i].get(), true,
+                                      Pump::WATCH_READ, controllers[i].get(),
+                                      watchers[i].get()));
+      const char buf = 0;
+      CHECK_EQ(1, HANDLE_EINTR(write(peer_sockets_[i].get(), &buf, 1)));
+    }
+
+    const TimeTicks start = TimeTicks::Now();
+    run_loop.Run();
+    const TimeDelta duration = TimeTicks::Now() - start;
+
+    auto reporter = SetUpFdWatchReporter(PumpType::kStoryName);
+    reporter.AddResult(kMetricTimePerEvent,
+                       duration.InNanoseconds() /
+                           static_cast<double>(kNumEvents));
+  }
+
+ private:
+  std::vector<ScopedFD> sockets_;
+  std::vector<ScopedFD> peer_sockets_;
+};
+
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
+using FdWatchPumpTypes = testing::Types<IOPump, LibeventPump>;
+#else
+using FdWatchPumpTypes = testing::Types<IOPump>;
+#endif
+TYPED_TEST_SUITE(FdWatchPerfTest, FdWatchPumpTypes);
+
+TYPED_TEST(FdWatchPerfTest, FdChurn) {
+  this->FdChurn();
+}
+
+TYPED_TEST(FdWatchPerfTest, EventDispatch) {
+  this->EventDispatch();
+}
+#endif  // defined(OS_POSIX) && !defined(OS_NACL)
+
 }  // namespace base
@@ -7,6 +7,7 @@
 #include <type_traits>
 
 #include "base/bind.h"
+#include "base/message_loop/message_pump_buildflags.h"
 #include "base/message_loop/message_pump_for_io.h"
 #include "base/message_loop/message_pump_for_ui.h"
 #include "base/message_loop/message_pump_type.h"
@@ -27,6 +28,10 @@
 #include "base/message_loop/message_pump_libevent.h"
 #endif
 
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
+#include "base/message_loop/message_pump_epoll.h"
+#endif
+
 using ::testing::_;
 using ::testing::AnyNumber;
 using ::testing::AtMost;
@@ -89,6 +94,17 @@ class MessagePumpTest : public ::testing::TestWithParam<MessagePumpType> {
       EXPECT_CALL(delegate, OnEndWorkItem);
     }
 #endif  // defined(OS_POSIX) && !defined(OS_NACL_SFI)
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
+    if ((GetParam() == MessagePumpType::UI &&
+         std::is_same<MessagePumpForUI, MessagePumpEpoll>::value) ||
+        (GetParam() == MessagePumpType::IO &&
+         std::is_same<MessagePumpForIO, MessagePumpEpoll>::value)) {
+      // MessagePumpEpoll also checks for native notifications once after
+      // processing a DoWork().
+      EXPECT_CALL(delegate, OnBeginWorkItem);
+      EXPECT_CALL(delegate, OnEndWorkItem);
+    }
+#endif  // BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
   }
 
   std::unique_ptr<MessagePump> message_pump_;
@@ -0,0 +1,27 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/common/delayed_task_leeway.h"
+
+#include <stdint.h>
+
+#include "base/bits.h"
+
+namespace base {
+namespace internal {
+
+TimeTicks AlignDelayedRunTime(TimeTicks delayed_run_time, TimeDelta leeway) {
+  const int64_t leeway_us = leeway.InMicroseconds();
+  if (leeway_us <= 0 || delayed_run_time.is_null() || delayed_run_time.is_max())
+    return delayed_run_time;
+  const uint64_t alignment_us =
+      uint64_t{1} << (63 - bits::CountLeadingZeroBits(
+                               static_cast<uint64_t>(leeway_us)));
+  return delayed_run_time.SnappedToNextTick(
+      TimeTicks(),
+      TimeDelta::FromMicroseconds(static_cast<int64_t>(alignment_us)));
+}
+
+}  // namespace internal
+}  // namespace base
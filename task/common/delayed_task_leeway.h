@@ -0,0 +1,32 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TASK_COMMON_DELAYED_TASK_LEEWAY_H_
+#define BASE_TASK_COMMON_DELAYED_TASK_LEEWAY_H_
+
+#include "base/base_export.h"
+#include "base/time/time.h"
+
+namespace base {
+namespace internal {
+
+// Returns the time at which to run a delayed task which is due at
+// |delayed_run_time| but may run up to |leeway| later (see
+// TaskRunner::PostDelayedTaskWithLeeway()). This is |delayed_run_time|
+// rounded up to a multiple of the largest power of two number of microseconds
+// which doesn't exceed |leeway|.
+//
+// Because the run times of tasks with a leeway are snapped to a shared grid,
+// and because the grids of smaller leeways are subdivisions of the grids of
+// larger ones, tasks which are due around the same time have the same run time
+// and are run by a single wake up. Since a task's run time doesn't depend on
+// other tasks, the ThreadPool and SequenceManager align their wake ups without
+// coordinating, and their delayed task queues remain sorted by run time.
+BASE_EXPORT TimeTicks AlignDelayedRunTime(TimeTicks delayed_run_time,
+                                          TimeDelta leeway);
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_TASK_COMMON_DELAYED_TASK_LEEWAY_H_
@@ -0,0 +1,138 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/common/delayed_task_leeway.h"
+
+#include <stddef.h>
+
+#include <set>
+#include <string>
+
+#include "base/bind.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/rand_util.h"
+#include "base/synchronization/lock.h"
+#include "base/task/thread_pool.h"
+#include "base/task_runner.h"
+#include "base/test/task_environment.h"
+#include "base/thread_annotations.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// The perftest posts 100k timers with delays spread over 100 seconds, with and
+// without leeway, to the main thread (SequenceManager) and to the ThreadPool,
+// and reports the number of distinct wake ups needed to run them. Time is
+// mocked, so the results are deterministic given the random delays.
+
+constexpr char kMetricPrefixDelayedTaskLeeway[] = "DelayedTaskLeeway.";
+constexpr char kMetricWakeUpsPerSecond[] = "wake_ups_per_second";
+constexpr char kMetricMeanLateness[] = "mean_lateness";
+
+constexpr size_t kNumTimers = 100000;
+constexpr int kMaxDelayMs = 100000;
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixDelayedTaskLeeway,
+                                         story_name);
+  reporter.RegisterImportantMetric(kMetricWakeUpsPerSecond, "count/s");
+  reporter.RegisterImportantMetric(kMetricMeanLateness, "us");
+  return reporter;
+}
+
+class DelayedTaskLeewayPerfTest : public testing::Test {
+ public:
+  DelayedTaskLeewayPerfTest() = default;
+  DelayedTaskLeewayPerfTest(const DelayedTaskLeewayPerfTest&) = delete;
+  DelayedTaskLeewayPerfTest& operator=(const DelayedTaskLeewayPerfTest&) =
+      delete;
+
+  // Posts kNumTimers timers with |leeway| to |task_runner|, runs them all and
+  // reports the wake ups needed to do so under |story_name|.
+  void Run(const std::string& story_name,
+           scoped_refptr<TaskRunner> task_runner,
+           TimeDelta leeway) {
+    const TimeTicks start = TimeTicks::Now();
+    for (size_t i = 0; i < kNumTimers; ++i) {
+      const TimeDelta delay =
+          TimeDelta::FromMicroseconds(RandInt(1000, kMaxDelayMs * 1000));
+      task_runner->PostDelayedTaskWithLeeway(
+          FROM_HERE,
+          BindOnce(&DelayedTaskLeewayPerfTest::OnTimerFired, Unretained(this),
+                   start + delay),
+          delay, leeway);
+    }
+    task_environment_.FastForwardBy(TimeDelta::FromMilliseconds(kMaxDelayMs) +
+                                    leeway);
+    task_environment_.RunUntilIdle();
+
+    AutoLock auto_lock(lock_);
+    EXPECT_EQ(kNumTimers, num_fired_);
+    auto reporter = SetUpReporter(story_name);
+    reporter.AddResult(kMetricWakeUpsPerSecond,
+                       wake_up_times_.size() /
+                           (TimeTicks::Now() - start).InSecondsF());
+    reporter.AddResult(kMetricMeanLateness,
+                       total_lateness_.InMicrosecondsF() / num_fired_);
+  }
+
+ private:
+  void OnTimerFired(TimeTicks desired_run_time) {
+    const TimeTicks now = TimeTicks::Now();
+    EXPECT_GE(now, desired_run_time);
+    AutoLock auto_lock(lock_);
+    wake_up_times_.insert(now);
+    total_lateness_ += now - desired_run_time;
+    ++num_fired_;
+  }
+
+  test::TaskEnvironment task_environment_{
+      test::TaskEnvironment::TimeSource::MOCK_TIME};
+
+  Lock lock_;
+  std::set<TimeTicks> wake_up_times_ GUARDED_BY(lock_);
+  TimeDelta total_lateness_ GUARDED_BY(lock_);
+  size_t num_fired_ GUARDED_BY(lock_) = 0;
+};
+
+}  // namespace
+
+TEST_F(DelayedTaskLeewayPerfTest, SequenceManagerNoLeeway) {
+  Run("sequence_manager_no_leeway", ThreadTaskRunnerHandle::Get(),
+      TimeDelta());
+}
+
+TEST_F(DelayedTaskLeewayPerfTest, SequenceManagerLeeway10ms) {
+  Run("sequence_manager_leeway_10ms", ThreadTaskRunnerHandle::Get(),
+      TimeDelta::FromMilliseconds(10));
+}
+
+TEST_F(DelayedTaskLeewayPerfTest, SequenceManagerLeeway100ms) {
+  Run("sequence_manager_leeway_100ms", ThreadTaskRunnerHandle::Get(),
+      TimeDelta::FromMilliseconds(100));
+}
+
+TEST_F(DelayedTaskLeewayPerfTest, ThreadPoolNoLeeway) {
+  Run("thread_pool_no_leeway", ThreadPool::CreateSequencedTaskRunner({}),
+      TimeDelta());
+}
+
+TEST_F(DelayedTaskLeewayPerfTest, ThreadPoolLeeway10ms) {
+  Run("thread_pool_leeway_10ms", ThreadPool::CreateSequencedTaskRunner({}),
+      TimeDelta::FromMilliseconds(10));
+}
+
+TEST_F(DelayedTaskLeewayPerfTest, ThreadPoolLeeway100ms) {
+  Run("thread_pool_leeway_100ms", ThreadPool::CreateSequencedTaskRunner({}),
+      TimeDelta::FromMilliseconds(100));
+}
+
+}  // namespace internal
+}  // namespace base
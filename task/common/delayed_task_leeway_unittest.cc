@@ -0,0 +1,88 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/common/delayed_task_leeway.h"
+
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+TimeTicks At(TimeDelta delta) {
+  return TimeTicks() + TimeDelta::FromDays(1) + delta;
+}
+
+}  // namespace
+
+TEST(DelayedTaskLeewayTest, NoLeeway) {
+  const TimeTicks run_time = At(TimeDelta::FromMicroseconds(1234567));
+  EXPECT_EQ(run_time, AlignDelayedRunTime(run_time, TimeDelta()));
+  EXPECT_EQ(run_time,
+            AlignDelayedRunTime(run_time, TimeDelta::FromMicroseconds(-10)));
+}
+
+TEST(DelayedTaskLeewayTest, NullAndMaxRunTime) {
+  const TimeDelta leeway = TimeDelta::FromMilliseconds(10);
+  EXPECT_EQ(TimeTicks(), AlignDelayedRunTime(TimeTicks(), leeway));
+  EXPECT_EQ(TimeTicks::Max(), AlignDelayedRunTime(TimeTicks::Max(), leeway));
+}
+
+// The aligned run time is never earlier than the requested one, and never
+// later than the requested one plus the leeway.
+TEST(DelayedTaskLeewayTest, WithinLeeway) {
+  for (int leeway_us : {1, 2, 3, 1000, 4096, 10000, 65535, 1000000}) {
+    const TimeDelta leeway = TimeDelta::FromMicroseconds(leeway_us);
+    for (int offset_us = 0; offset_us < 3 * leeway_us;
+         offset_us += 1 + leeway_us / 7) {
+      const TimeTicks run_time = At(TimeDelta::FromMicroseconds(offset_us));
+      const TimeTicks aligned_run_time = AlignDelayedRunTime(run_time, leeway);
+      EXPECT_GE(aligned_run_time, run_time);
+      EXPECT_LE(aligned_run_time, run_time + leeway);
+    }
+  }
+}
+
+// Run times which are already aligned are unchanged.
+TEST(DelayedTaskLeewayTest, AlreadyAligned) {
+  const TimeTicks run_time = At(TimeDelta::FromMicroseconds(8192 * 1000));
+  EXPECT_EQ(run_time,
+            AlignDelayedRunTime(run_time, TimeDelta::FromMilliseconds(10)));
+}
+
+// Run times which are close to each other share a wake up.
+TEST(DelayedTaskLeewayTest, Coalesce) {
+  const TimeDelta leeway = TimeDelta::FromMilliseconds(10);
+  const TimeTicks aligned_run_time =
+      AlignDelayedRunTime(At(TimeDelta::FromMicroseconds(8192 * 1000 + 1)),
+                          leeway);
+  for (int offset_us = 1; offset_us <= 8192; ++offset_us) {
+    EXPECT_EQ(aligned_run_time,
+              AlignDelayedRunTime(
+                  At(TimeDelta::FromMicroseconds(8192 * 1000 + offset_us)),
+                  leeway));
+  }
+}
+
+// A task with a smaller leeway is aligned on a finer grid, which is a
+// subdivision of the grid of larger leeways. Hence, a task with a large leeway
+// can share the wake up of a task with a smaller leeway which is due at the
+// aligned time, but not the other way around.
+TEST(DelayedTaskLeewayTest, NestedGrids) {
+  const TimeTicks run_time = At(TimeDelta::FromMicroseconds(123456789));
+  const TimeTicks coarse =
+      AlignDelayedRunTime(run_time, TimeDelta::FromMilliseconds(100));
+  const TimeTicks fine =
+      AlignDelayedRunTime(run_time, TimeDelta::FromMilliseconds(1));
+  EXPECT_LE(fine, coarse);
+  EXPECT_EQ(coarse,
+            AlignDelayedRunTime(coarse, TimeDelta::FromMilliseconds(1)));
+  EXPECT_EQ(coarse,
+            AlignDelayedRunTime(fine, TimeDelta::FromMilliseconds(100)));
+}
+
+}  // namespace internal
+}  // namespace base
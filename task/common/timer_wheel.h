@@ -0,0 +1,442 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TASK_COMMON_TIMER_WHEEL_H_
+#define BASE_TASK_COMMON_TIMER_WHEEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "base/bits.h"
+#include "base/check.h"
+#include "base/check_op.h"
+#include "base/containers/linked_list.h"
+#include "base/time/time.h"
+
+namespace base {
+namespace internal {
+
+// A hierarchical timer wheel that can replace an IntrusiveHeap or a
+// std::priority_queue of delayed tasks. Insertion is O(1), and so is Min()
+// once the wheel has cascaded (see below), whereas a heap pays O(log n) for
+// insertion. There is no erasure of individual elements, as delayed tasks can't
+// be canceled through their queue: canceled tasks are swept with TakeIf().
+//
+// Elements are bucketed by "tick", their run time divided by |resolution|.
+// There are kNumLevels levels of kNumSlots slots; a slot of level L spans
+// kNumSlots^L ticks. An element is stored at the lowest level where its tick
+// shares all the higher slot indices with the wheel's current tick, so that
+// level 0 holds the elements that are due within the current kNumSlots ticks.
+// Whenever level 0 becomes empty, the earliest non-empty slot of the lowest
+// non-empty level is cascaded into the lower levels and the current tick
+// advances to the start of that slot. This keeps the earliest element of the
+// wheel in level 0.
+//
+// Since the current tick can advance past the time at which the wheel is used,
+// an element can be earlier than the current tick. Such elements are rare:
+// when the wheel holds few elements, it is rebased on the new element's tick,
+// and otherwise the element is kept in a small binary heap on the side.
+//
+// Level 0 slots are kept sorted with |Compare|, so unlike a coarse timer wheel,
+// Min() returns the exact earliest element, not just an element due within the
+// same tick. Ties are broken by |Compare| too (e.g. by sequence number), so
+// popping elements yields the same order as a heap would. Sorted insertion
+// scans from the back of the slot, which is O(1) for elements inserted in
+// order, as is typical for tasks posted with the same delay.
+//
+// |GetRunTime| returns the run time of an element, and |Compare| is a strict
+// weak ordering that returns true if its first argument runs before its second
+// one. It must order elements with different run times by run time.
+//
+// This class is not thread-safe.
+template <typename T, typename Compare, typename GetRunTime>
+class TimerWheel {
+ private:
+  struct Node;
+
+ public:
+  static constexpr size_t kSlotBits = 6;
+  static constexpr size_t kNumSlots = size_t{1} << kSlotBits;
+  // Enough levels for any non-negative int64_t tick.
+  static constexpr size_t kNumLevels = (63 + kSlotBits - 1) / kSlotBits;
+  static constexpr uint64_t kMaxTick = ~uint64_t{0} >> 1;
+
+  explicit TimerWheel(TimeDelta resolution = TimeDelta::FromMilliseconds(1))
+      : resolution_(resolution) {
+    DCHECK_GT(resolution_, TimeDelta());
+  }
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+  ~TimerWheel() { Clear(); }
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+  // Returns the element with the earliest run time.
+  const T& Min() const { return MinNode()->value; }
+
+  // Removes the element with the earliest run time.
+  void Pop() { TakeMin(); }
+
+  // Removes and returns the element with the earliest run time.
+  T TakeMin() { return TakeNode(MinNode()); }
+
+  void insert(T&& element) {
+    const uint64_t tick = ToTick(GetRunTime()(element));
+    Node* node = new Node(std::move(element), tick);
+    const size_t num_nodes_in_levels = size_ - early_nodes_.size();
+    if (num_nodes_in_levels == 0) {
+      // Nothing constrains the current tick when the levels are empty, so move
+      // it to the new element to store it in level 0 without cascading later.
+      current_tick_ = tick;
+      AddToSlot(node);
+    } else if (tick >= current_tick_) {
+      AddToSlot(node);
+    } else if (num_nodes_in_levels <= kMaxNodesToRebase) {
+      Rebase(tick);
+      AddToSlot(node);
+    } else {
+      AddToEarlyHeap(node);
+    }
+    ++size_;
+  }
+
+  // Moves the elements that satisfy |predicate| to |taken|, in no particular
+  // order. This is O(n), but is meant to be called rarely, e.g. to sweep
+  // canceled tasks.
+  template <typename Predicate>
+  void TakeIf(Predicate predicate, std::vector<T>* taken) {
+    DCHECK(taken);
+    auto take_node = [&](Node* node) {
+      taken->push_back(std::move(node->value));
+      delete node;
+      --size_;
+    };
+
+    for (auto& level : levels_) {
+      if (!level)
+        continue;
+      for (size_t slot = 0; slot < kNumSlots; ++slot) {
+        LinkedList<Node>& list = level->slots[slot];
+        for (auto* link = list.head(); link != list.end();) {
+          Node* node = link->value();
+          link = link->next();
+          if (!predicate(static_cast<const T&>(node->value)))
+            continue;
+          node->RemoveFromList();
+          take_node(node);
+        }
+        if (list.empty())
+          level->occupied_slots &= ~(uint64_t{1} << slot);
+      }
+    }
+
+    std::vector<Node*> kept_early_nodes;
+    for (Node* node : early_nodes_) {
+      if (predicate(static_cast<const T&>(node->value)))
+        take_node(node);
+      else
+        kept_early_nodes.push_back(node);
+    }
+    early_nodes_ = std::move(kept_early_nodes);
+    for (size_t i = 0; i < early_nodes_.size(); ++i)
+      early_nodes_[i]->heap_index = i;
+    for (size_t i = early_nodes_.size() / 2; i > 0; --i)
+      SiftDown(i - 1);
+
+    Cascade();
+  }
+
+  // Invokes |function| on each element, in no particular order.
+  template <typename Function>
+  void ForEach(Function function) const {
+    for (const auto& level : levels_) {
+      if (!level)
+        continue;
+      for (const LinkedList<Node>& list : level->slots) {
+        for (auto* link = list.head(); link != list.end(); link = link->next())
+          function(static_cast<const T&>(link->value()->value));
+      }
+    }
+    for (const Node* node : early_nodes_)
+      function(static_cast<const T&>(node->value));
+  }
+
+  // Deletes all the elements. The wheel is left empty before the elements are
+  // deleted, in case their destructors access it.
+  void Clear() {
+    std::vector<Node*> nodes;
+    nodes.reserve(size_);
+    TakeNodesFromLevels(&nodes);
+    nodes.insert(nodes.end(), early_nodes_.begin(), early_nodes_.end());
+    early_nodes_.clear();
+    size_ = 0;
+    for (Node* node : nodes)
+      delete node;
+  }
+
+  void swap(TimerWheel& other) {
+    std::swap(resolution_, other.resolution_);
+    std::swap(current_tick_, other.current_tick_);
+    std::swap(size_, other.size_);
+    levels_.swap(other.levels_);
+    early_nodes_.swap(other.early_nodes_);
+  }
+
+ private:
+  // Level of the nodes in |early_nodes_|.
+  static constexpr size_t kEarlyLevel = kNumLevels;
+
+  // Inserting an element earlier than the current tick rebases the wheel if it
+  // has at most this many elements in its levels.
+  static constexpr size_t kMaxNodesToRebase = kNumSlots;
+
+  struct Node : public base::LinkNode<Node> {
+    Node(T value, uint64_t tick) : value(std::move(value)), tick(tick) {}
+
+    T value;
+    const uint64_t tick;
+    size_t level = 0;
+    // Index in |Level::slots|, unless |level| is kEarlyLevel.
+    size_t slot = 0;
+    // Index in |early_nodes_| if |level| is kEarlyLevel.
+    size_t heap_index = 0;
+  };
+
+  struct Level {
+    // Bit i is set iff |slots[i]| is non-empty.
+    uint64_t occupied_slots = 0;
+    std::array<LinkedList<Node>, kNumSlots> slots;
+  };
+  static_assert(kNumSlots <= 64, "Level::occupied_slots is a 64-bit mask.");
+
+  uint64_t ToTick(TimeTicks run_time) const {
+    if (run_time <= TimeTicks())
+      return 0;
+    if (run_time.is_max())
+      return kMaxTick;
+    return std::min(
+        static_cast<uint64_t>((run_time - TimeTicks()).IntDiv(resolution_)),
+        kMaxTick);
+  }
+
+  // Returns the level at which an element with |tick| is stored.
+  size_t LevelForTick(uint64_t tick) const {
+    const uint64_t diff = tick ^ current_tick_;
+    if (!diff)
+      return 0;
+    return (63 - bits::CountLeadingZeroBits(diff)) / kSlotBits;
+  }
+
+  static size_t SlotForTick(uint64_t tick, size_t level) {
+    return (tick >> (level * kSlotBits)) & (kNumSlots - 1);
+  }
+
+  static size_t FirstOccupiedSlot(const Level& level) {
+    DCHECK(level.occupied_slots);
+    return bits::CountTrailingZeroBits(level.occupied_slots);
+  }
+
+  bool IsLevelEmpty(size_t level) const {
+    return !levels_[level] || !levels_[level]->occupied_slots;
+  }
+
+  Node* MinNode() const {
+    DCHECK(!empty());
+    Node* min_node = nullptr;
+    if (!IsLevelEmpty(0)) {
+      const Level& level = *levels_[0];
+      min_node = level.slots[FirstOccupiedSlot(level)].head()->value();
+    }
+    if (!early_nodes_.empty() &&
+        (!min_node || Compare()(early_nodes_[0]->value, min_node->value))) {
+      min_node = early_nodes_[0];
+    }
+    DCHECK(min_node);
+    return min_node;
+  }
+
+  void AddToSlot(Node* node) {
+    DCHECK_GE(node->tick, current_tick_);
+    node->level = LevelForTick(node->tick);
+    node->slot = SlotForTick(node->tick, node->level);
+    DCHECK_LT(node->level, kNumLevels);
+
+    std::unique_ptr<Level>& level = levels_[node->level];
+    if (!level)
+      level = std::make_unique<Level>();
+    LinkedList<Node>& list = level->slots[node->slot];
+    level->occupied_slots |= uint64_t{1} << node->slot;
+
+    if (node->level != 0) {
+      list.Append(node);
+      return;
+    }
+    base::LinkNode<Node>* previous = list.tail();
+    while (previous != list.end() &&
+           Compare()(node->value, previous->value()->value)) {
+      previous = previous->previous();
+    }
+    if (previous == list.end())
+      node->InsertBefore(list.head());
+    else
+      node->InsertAfter(previous);
+  }
+
+  void TakeNodesFromLevels(std::vector<Node*>* nodes) {
+    for (auto& level : levels_) {
+      if (!level)
+        continue;
+      for (LinkedList<Node>& list : level->slots) {
+        while (!list.empty()) {
+          Node* node = list.head()->value();
+          node->RemoveFromList();
+          nodes->push_back(node);
+        }
+      }
+      level->occupied_slots = 0;
+    }
+  }
+
+  // Moves the current tick back to |tick| and re-adds the elements of the
+  // levels relative to it.
+  void Rebase(uint64_t tick) {
+    DCHECK_LT(tick, current_tick_);
+    std::vector<Node*> nodes;
+    TakeNodesFromLevels(&nodes);
+    current_tick_ = tick;
+    for (Node* node : nodes)
+      AddToSlot(node);
+  }
+
+  T TakeNode(Node* node) {
+    if (node->level == kEarlyLevel) {
+      RemoveFromEarlyHeap(node);
+    } else {
+      Level& level = *levels_[node->level];
+      node->RemoveFromList();
+      if (level.slots[node->slot].empty())
+        level.occupied_slots &= ~(uint64_t{1} << node->slot);
+    }
+    T value = std::move(node->value);
+    delete node;
+    --size_;
+    Cascade();
+    return value;
+  }
+
+  // Moves elements down to level 0 until it holds the earliest element of the
+  // levels.
+  void Cascade() {
+    while (size_ > early_nodes_.size() && IsLevelEmpty(0)) {
+      size_t level_index = 1;
+      while (IsLevelEmpty(level_index))
+        ++level_index;
+      Level& level = *levels_[level_index];
+      const size_t slot = FirstOccupiedSlot(level);
+
+      // Advance to the first tick of |slot|. All the elements of the levels
+      // are at or after it since the lower levels are empty.
+      const size_t shift = level_index * kSlotBits;
+      const size_t higher_shift = shift + kSlotBits;
+      const uint64_t higher_bits_mask =
+          higher_shift >= 64 ? 0 : ~((uint64_t{1} << higher_shift) - 1);
+      current_tick_ =
+          (current_tick_ & higher_bits_mask) | (uint64_t{slot} << shift);
+
+      LinkedList<Node>& list = level.slots[slot];
+      level.occupied_slots &= ~(uint64_t{1} << slot);
+      while (!list.empty()) {
+        Node* node = list.head()->value();
+        node->RemoveFromList();
+        AddToSlot(node);
+        DCHECK_LT(node->level, level_index);
+      }
+    }
+  }
+
+  // |early_nodes_| is a binary min-heap.
+  bool EarlyNodeRunsBefore(size_t a, size_t b) const {
+    return Compare()(early_nodes_[a]->value, early_nodes_[b]->value);
+  }
+
+  void SwapEarlyNodes(size_t a, size_t b) {
+    std::swap(early_nodes_[a], early_nodes_[b]);
+    early_nodes_[a]->heap_index = a;
+    early_nodes_[b]->heap_index = b;
+  }
+
+  size_t SiftUp(size_t index) {
+    while (index > 0) {
+      const size_t parent = (index - 1) / 2;
+      if (!EarlyNodeRunsBefore(index, parent))
+        break;
+      SwapEarlyNodes(index, parent);
+      index = parent;
+    }
+    return index;
+  }
+
+  void SiftDown(size_t index) {
+    while (true) {
+      size_t child = 2 * index + 1;
+      if (child >= early_nodes_.size())
+        return;
+      if (child + 1 < early_nodes_.size() &&
+          EarlyNodeRunsBefore(child + 1, child)) {
+        ++child;
+      }
+      if (!EarlyNodeRunsBefore(child, index))
+        return;
+      SwapEarlyNodes(index, child);
+      index = child;
+    }
+  }
+
+  void AddToEarlyHeap(Node* node) {
+    node->level = kEarlyLevel;
+    node->heap_index = early_nodes_.size();
+    early_nodes_.push_back(node);
+    SiftUp(node->heap_index);
+  }
+
+  void RemoveFromEarlyHeap(Node* node) {
+    const size_t index = node->heap_index;
+    DCHECK_EQ(early_nodes_[index], node);
+    Node* last_node = early_nodes_.back();
+    early_nodes_.pop_back();
+    if (last_node == node)
+      return;
+    early_nodes_[index] = last_node;
+    last_node->heap_index = index;
+    SiftDown(SiftUp(index));
+  }
+
+  TimeDelta resolution_;
+
+  // Elements in the levels are stored relative to this tick. Only moves
+  // forward while the levels are non-empty, except when rebasing.
+  uint64_t current_tick_ = 0;
+
+  // Number of elements, including |early_nodes_|.
+  size_t size_ = 0;
+
+  // Allocated on first use, since a wheel typically only uses a few levels.
+  std::array<std::unique_ptr<Level>, kNumLevels> levels_;
+
+  // Elements that were inserted with a tick earlier than |current_tick_| while
+  // the levels held too many elements to rebase.
+  std::vector<Node*> early_nodes_;
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_TASK_COMMON_TIMER_WHEEL_H_
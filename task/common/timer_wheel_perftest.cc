@@ -0,0 +1,152 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/common/timer_wheel.h"
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "base/rand_util.h"
+#include "base/task/common/intrusive_heap.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+constexpr char kMetricPrefixTimerQueue[] = "TimerQueue.";
+constexpr char kMetricTimePerTimer[] = "time_per_timer";
+
+// Number of timers added over the course of a churn.
+constexpr size_t kNumTimers = 1000000;
+// Every kCancelPeriod timers, the timer added kCancelDistance timers earlier is
+// canceled if it hasn't fired yet. Like canceled delayed tasks, canceled timers
+// stay queued, and are dropped once they are due.
+constexpr size_t kCancelPeriod = 4;
+constexpr size_t kCancelDistance = 1000;
+// Virtual time elapsed between two timers being added. With delays of up to
+// 10 seconds, about 100k timers are pending at any time.
+constexpr TimeDelta kTimeBetweenTimers = TimeDelta::FromMicroseconds(100);
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixTimerQueue, story_name);
+  reporter.RegisterImportantMetric(kMetricTimePerTimer, "ns");
+  return reporter;
+}
+
+// Delays spread between 1 ms and 10 s, generated before the churn so that
+// random number generation isn't measured.
+std::vector<TimeDelta> GenerateDelays() {
+  std::vector<TimeDelta> delays;
+  delays.reserve(kNumTimers);
+  for (size_t i = 0; i < kNumTimers; ++i)
+    delays.push_back(TimeDelta::FromMilliseconds(RandInt(1, 10000)));
+  return delays;
+}
+
+struct HeapTimer {
+  TimeTicks run_time;
+  size_t id;
+
+  bool operator<=(const HeapTimer& other) const {
+    if (run_time == other.run_time)
+      return id <= other.id;
+    return run_time < other.run_time;
+  }
+
+  // Not used, as timers are never erased from the heap.
+  void SetHeapHandle(HeapHandle handle) {}
+  void ClearHeapHandle() {}
+  HeapHandle GetHeapHandle() const { return HeapHandle::Invalid(); }
+};
+
+struct WheelTimer {
+  TimeTicks run_time;
+  size_t id;
+};
+
+struct WheelTimerRunsBefore {
+  bool operator()(const WheelTimer& a, const WheelTimer& b) const {
+    if (a.run_time == b.run_time)
+      return a.id < b.id;
+    return a.run_time < b.run_time;
+  }
+};
+
+struct WheelTimerRunTime {
+  TimeTicks operator()(const WheelTimer& timer) const {
+    return timer.run_time;
+  }
+};
+
+using WheelTimerQueue =
+    TimerWheel<WheelTimer, WheelTimerRunsBefore, WheelTimerRunTime>;
+
+void MaybeCancel(size_t i, std::vector<bool>* canceled) {
+  if (i % kCancelPeriod == 0 && i >= kCancelDistance)
+    (*canceled)[i - kCancelDistance] = true;
+}
+
+void ReportChurn(const std::string& story_name,
+                 TimeDelta duration,
+                 size_t num_fired) {
+  EXPECT_GT(num_fired, 0u);
+  auto reporter = SetUpReporter(story_name);
+  reporter.AddResult(kMetricTimePerTimer, duration.InNanoseconds() /
+                                             static_cast<double>(kNumTimers));
+}
+
+}  // namespace
+
+// Adds 1M timers to an IntrusiveHeap, as used by the DelayedTaskManager,
+// while canceling some of them and popping the ones that are due.
+TEST(TimerWheelPerfTest, ChurnIntrusiveHeap) {
+  const std::vector<TimeDelta> delays = GenerateDelays();
+  std::vector<bool> canceled(kNumTimers);
+  IntrusiveHeap<HeapTimer> heap;
+  TimeTicks now = TimeTicks::Now();
+  size_t num_fired = 0;
+
+  const TimeTicks start = TimeTicks::Now();
+  for (size_t i = 0; i < kNumTimers; ++i) {
+    heap.insert({now + delays[i], i});
+    MaybeCancel(i, &canceled);
+    now += kTimeBetweenTimers;
+    while (!heap.empty() && heap.Min().run_time <= now) {
+      if (!canceled[heap.Min().id])
+        ++num_fired;
+      heap.Pop();
+    }
+  }
+  ReportChurn("IntrusiveHeap", TimeTicks::Now() - start, num_fired);
+}
+
+// Same as above, with a TimerWheel.
+TEST(TimerWheelPerfTest, ChurnTimerWheel) {
+  const std::vector<TimeDelta> delays = GenerateDelays();
+  std::vector<bool> canceled(kNumTimers);
+  WheelTimerQueue wheel;
+  TimeTicks now = TimeTicks::Now();
+  size_t num_fired = 0;
+
+  const TimeTicks start = TimeTicks::Now();
+  for (size_t i = 0; i < kNumTimers; ++i) {
+    wheel.insert({now + delays[i], i});
+    MaybeCancel(i, &canceled);
+    now += kTimeBetweenTimers;
+    while (!wheel.empty() && wheel.Min().run_time <= now) {
+      if (!canceled[wheel.TakeMin().id])
+        ++num_fired;
+    }
+  }
+  ReportChurn("TimerWheel", TimeTicks::Now() - start, num_fired);
+}
+
+}  // namespace internal
+}  // namespace base
@@ -0,0 +1,252 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/common/timer_wheel.h"
+
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "base/rand_util.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+struct TestElement {
+  TimeTicks run_time;
+  int sequence_num;
+};
+
+struct RunsBefore {
+  bool operator()(const TestElement& a, const TestElement& b) const {
+    if (a.run_time != b.run_time)
+      return a.run_time < b.run_time;
+    return a.sequence_num < b.sequence_num;
+  }
+};
+
+struct GetRunTime {
+  TimeTicks operator()(const TestElement& element) const {
+    return element.run_time;
+  }
+};
+
+using TestTimerWheel = TimerWheel<TestElement, RunsBefore, GetRunTime>;
+
+TimeTicks At(TimeDelta delta) {
+  return TimeTicks() + TimeDelta::FromDays(1) + delta;
+}
+
+std::vector<int> PopAll(TestTimerWheel* wheel) {
+  std::vector<int> sequence_nums;
+  while (!wheel->empty())
+    sequence_nums.push_back(wheel->TakeMin().sequence_num);
+  return sequence_nums;
+}
+
+}  // namespace
+
+TEST(TimerWheelTest, Empty) {
+  TestTimerWheel wheel;
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(0u, wheel.size());
+}
+
+TEST(TimerWheelTest, PopsInRunTimeOrder) {
+  TestTimerWheel wheel;
+  wheel.insert({At(TimeDelta::FromSeconds(10)), 0});
+  wheel.insert({At(TimeDelta::FromMilliseconds(3)), 1});
+  wheel.insert({At(TimeDelta::FromHours(5)), 2});
+  wheel.insert({At(TimeDelta()), 3});
+  wheel.insert({At(TimeDelta::FromMicroseconds(2500)), 4});
+  EXPECT_EQ(5u, wheel.size());
+
+  EXPECT_EQ(At(TimeDelta()), wheel.Min().run_time);
+  EXPECT_EQ(std::vector<int>({3, 4, 1, 0, 2}), PopAll(&wheel));
+}
+
+// Elements within the same tick are ordered exactly, as they would be by a
+// heap.
+TEST(TimerWheelTest, ExactOrderWithinTick) {
+  TestTimerWheel wheel(TimeDelta::FromMilliseconds(10));
+  wheel.insert({At(TimeDelta::FromMilliseconds(9)), 0});
+  wheel.insert({At(TimeDelta::FromMilliseconds(1)), 1});
+  wheel.insert({At(TimeDelta::FromMilliseconds(1)), 2});
+  wheel.insert({At(TimeDelta::FromMilliseconds(5)), 3});
+
+  EXPECT_EQ(At(TimeDelta::FromMilliseconds(1)), wheel.Min().run_time);
+  EXPECT_EQ(std::vector<int>({1, 2, 3, 0}), PopAll(&wheel));
+}
+
+// An element earlier than the current tick of the wheel, which advanced while
+// cascading, is still returned first.
+TEST(TimerWheelTest, InsertBeforeCurrentTick) {
+  TestTimerWheel wheel;
+  wheel.insert({At(TimeDelta()), 0});
+  wheel.insert({At(TimeDelta::FromMinutes(1)), 1});
+  wheel.Pop();
+  EXPECT_EQ(At(TimeDelta::FromMinutes(1)), wheel.Min().run_time);
+
+  wheel.insert({At(TimeDelta::FromSeconds(1)), 2});
+  wheel.insert({At(TimeDelta()), 3});
+  EXPECT_EQ(std::vector<int>({3, 2, 1}), PopAll(&wheel));
+}
+
+// Same as above, with too many elements in the wheel to rebase it.
+TEST(TimerWheelTest, InsertBeforeCurrentTickManyElements) {
+  constexpr int kNumElements = 2 * TestTimerWheel::kNumSlots;
+  TestTimerWheel wheel;
+  wheel.insert({At(TimeDelta()), 0});
+  for (int i = 1; i <= kNumElements; ++i) {
+    wheel.insert(
+        {At(TimeDelta::FromMinutes(1) + TimeDelta::FromSeconds(i)), i});
+  }
+  wheel.Pop();
+
+  wheel.insert({At(TimeDelta::FromSeconds(2)), kNumElements + 1});
+  wheel.insert({At(TimeDelta::FromSeconds(1)), kNumElements + 2});
+  wheel.insert({At(TimeDelta::FromSeconds(3)), kNumElements + 3});
+  std::vector<TestElement> taken;
+  wheel.TakeIf(
+      [](const TestElement& element) {
+        return element.sequence_num == kNumElements + 1;
+      },
+      &taken);
+  ASSERT_EQ(1u, taken.size());
+
+  std::vector<int> expected = {kNumElements + 2, kNumElements + 3};
+  for (int i = 1; i <= kNumElements; ++i)
+    expected.push_back(i);
+  EXPECT_EQ(expected, PopAll(&wheel));
+}
+
+TEST(TimerWheelTest, NullAndMaxRunTimes) {
+  TestTimerWheel wheel;
+  wheel.insert({TimeTicks::Max(), 0});
+  wheel.insert({TimeTicks(), 1});
+  wheel.insert({At(TimeDelta::FromDays(365)), 2});
+  EXPECT_EQ(std::vector<int>({1, 2, 0}), PopAll(&wheel));
+}
+
+// Taking the last element of level 0 cascades the next element down.
+TEST(TimerWheelTest, TakeIfMinCascades) {
+  TestTimerWheel wheel;
+  wheel.insert({At(TimeDelta::FromMilliseconds(1)), 0});
+  wheel.insert({At(TimeDelta::FromSeconds(30)), 1});
+  std::vector<TestElement> taken;
+  wheel.TakeIf(
+      [](const TestElement& element) { return element.sequence_num == 0; },
+      &taken);
+  EXPECT_EQ(1, wheel.Min().sequence_num);
+}
+
+TEST(TimerWheelTest, TakeIf) {
+  TestTimerWheel wheel;
+  for (int i = 0; i < 10; ++i)
+    wheel.insert({At(TimeDelta::FromSeconds(i)), i});
+
+  std::vector<TestElement> taken;
+  wheel.TakeIf(
+      [](const TestElement& element) { return element.sequence_num % 2 == 0; },
+      &taken);
+  EXPECT_EQ(5u, taken.size());
+  EXPECT_EQ(5u, wheel.size());
+  EXPECT_EQ(std::vector<int>({1, 3, 5, 7, 9}), PopAll(&wheel));
+}
+
+TEST(TimerWheelTest, ForEachAndClear) {
+  TestTimerWheel wheel;
+  for (int i = 0; i < 10; ++i)
+    wheel.insert({At(TimeDelta::FromMinutes(i)), i});
+
+  int sum = 0;
+  wheel.ForEach([&sum](const TestElement& element) {
+    sum += element.sequence_num;
+  });
+  EXPECT_EQ(45, sum);
+
+  wheel.Clear();
+  EXPECT_TRUE(wheel.empty());
+  wheel.insert({At(TimeDelta()), 0});
+  EXPECT_EQ(0, wheel.Min().sequence_num);
+}
+
+TEST(TimerWheelTest, Swap) {
+  TestTimerWheel wheel;
+  TestTimerWheel other;
+  wheel.insert({At(TimeDelta::FromSeconds(1)), 0});
+  wheel.swap(other);
+  EXPECT_TRUE(wheel.empty());
+  ASSERT_EQ(1u, other.size());
+  EXPECT_EQ(0, other.Min().sequence_num);
+}
+
+// The wheel pops random elements in the same order as sorting them.
+TEST(TimerWheelTest, MatchesSortedOrder) {
+  constexpr int kNumElements = 10000;
+  TestTimerWheel wheel;
+  std::vector<TestElement> elements;
+  for (int i = 0; i < kNumElements; ++i) {
+    // Spread run times from microseconds to days to use many levels.
+    const TimeDelta delay =
+        TimeDelta::FromMicroseconds(RandInt(0, 1000)) *
+        (int64_t{1} << RandInt(0, 27));
+    elements.push_back({At(delay), i});
+    wheel.insert({At(delay), i});
+  }
+  std::sort(elements.begin(), elements.end(), RunsBefore());
+
+  for (const TestElement& element : elements) {
+    ASSERT_FALSE(wheel.empty());
+    EXPECT_EQ(element.sequence_num, wheel.Min().sequence_num);
+    wheel.Pop();
+  }
+  EXPECT_TRUE(wheel.empty());
+}
+
+// Interleaving inserts and pops exercises insertion both after and before the
+// current tick of the wheel.
+TEST(TimerWheelTest, InterleavedInsertAndPop) {
+  TestTimerWheel wheel;
+  std::set<TestElement, RunsBefore> expected;
+  TimeDelta now = TimeDelta::FromHours(1);
+  for (int i = 0; i < 10000; ++i) {
+    // Some delays are negative to insert elements before the current tick.
+    const TimeDelta delay =
+        TimeDelta::FromMicroseconds(RandInt(-100, 1000)) *
+        (int64_t{1} << RandInt(0, 20));
+    expected.insert({At(now + delay), i});
+    wheel.insert({At(now + delay), i});
+
+    if (RandInt(0, 2) == 0) {
+      ASSERT_EQ(expected.begin()->sequence_num, wheel.Min().sequence_num);
+      now = expected.begin()->run_time - At(TimeDelta());
+      expected.erase(expected.begin());
+      wheel.Pop();
+    }
+    if (RandInt(0, 100) == 0) {
+      std::vector<TestElement> taken;
+      wheel.TakeIf(
+          [](const TestElement& element) {
+            return element.sequence_num % 3 != 0;
+          },
+          &taken);
+      for (const TestElement& element : taken)
+        expected.erase(element);
+    }
+  }
+  for (const TestElement& element : expected) {
+    EXPECT_EQ(element.sequence_num, wheel.Min().sequence_num);
+    wheel.Pop();
+  }
+  EXPECT_TRUE(wheel.empty());
+}
+
+}  // namespace internal
+}  // namespace base
@@ -0,0 +1,88 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/coroutine.h"
+
+#include "base/immediate_crash.h"
+#include "base/synchronization/waitable_event.h"
+
+namespace base {
+
+void Coroutine::promise_type::unhandled_exception() {
+  IMMEDIATE_CRASH();
+}
+
+namespace internal {
+
+void ResumeCoroutine(std::coroutine_handle<> handle) {
+  handle.resume();
+}
+
+WaitableEventAwaiter::WaitableEventAwaiter(WaitableEvent* event)
+    : event_(event) {
+  DCHECK(event_);
+}
+
+WaitableEventAwaiter::~WaitableEventAwaiter() = default;
+
+bool WaitableEventAwaiter::await_ready() const {
+  return event_->IsSignaled();
+}
+
+void WaitableEventAwaiter::await_suspend(std::coroutine_handle<> handle) {
+  DCHECK(SequencedTaskRunnerHandle::IsSet());
+  handle_ = handle;
+  watcher_.StartWatching(
+      event_,
+      BindOnce(&WaitableEventAwaiter::OnSignaled, Unretained(this)),
+      SequencedTaskRunnerHandle::Get());
+}
+
+void WaitableEventAwaiter::OnSignaled(WaitableEvent* event) {
+  // The watcher supports being deleted by its callback, which happens when the
+  // coroutine returns.
+  handle_.resume();
+}
+
+#if defined(OS_POSIX)
+FileDescriptorAwaiter::FileDescriptorAwaiter(int fd, Mode mode)
+    : fd_(fd), mode_(mode) {}
+
+FileDescriptorAwaiter::~FileDescriptorAwaiter() = default;
+
+void FileDescriptorAwaiter::await_suspend(std::coroutine_handle<> handle) {
+  handle_ = handle;
+  const RepeatingClosure callback =
+      BindRepeating(&FileDescriptorAwaiter::OnReady, Unretained(this));
+  controller_ = mode_ == Mode::kReadable
+                    ? FileDescriptorWatcher::WatchReadable(fd_, callback)
+                    : FileDescriptorWatcher::WatchWritable(fd_, callback);
+}
+
+void FileDescriptorAwaiter::OnReady() {
+  // Stop watching before resuming, since the coroutine may destroy |this|.
+  controller_.reset();
+  handle_.resume();
+}
+#endif  // defined(OS_POSIX)
+
+}  // namespace internal
+
+internal::WaitableEventAwaiter AwaitWaitableEvent(WaitableEvent* event) {
+  return internal::WaitableEventAwaiter(event);
+}
+
+#if defined(OS_POSIX)
+internal::FileDescriptorAwaiter AwaitReadable(int fd) {
+  return internal::FileDescriptorAwaiter(
+      fd, internal::FileDescriptorAwaiter::Mode::kReadable);
+}
+
+internal::FileDescriptorAwaiter AwaitWritable(int fd) {
+  return internal::FileDescriptorAwaiter(
+      fd, internal::FileDescriptorAwaiter::Mode::kWritable);
+}
+#endif  // defined(OS_POSIX)
+
+}  // namespace base
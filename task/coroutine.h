@@ -0,0 +1,226 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TASK_COROUTINE_H_
+#define BASE_TASK_COROUTINE_H_
+
+// Coroutines require C++20, while Chromium builds as C++17. This file is only
+// built with the enable_base_coroutines GN arg, which requires a C++20
+// toolchain.
+#if !defined(__cpp_impl_coroutine) || __cpp_impl_coroutine < 201902L
+#error "base/task/coroutine.h requires C++20 coroutines"
+#endif
+
+#include <coroutine>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "base/base_export.h"
+#include "base/bind.h"
+#include "base/callback.h"
+#include "base/check.h"
+#include "base/location.h"
+#include "base/memory/ref_counted.h"
+#include "base/sequenced_task_runner.h"
+#include "base/synchronization/waitable_event_watcher.h"
+#include "base/task_runner.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+#include "build/build_config.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+#if defined(OS_POSIX)
+#include "base/files/file_descriptor_watcher_posix.h"
+#endif
+
+// Coroutines running on a sequence.
+//
+// A function returning base::Coroutine is a coroutine which starts running
+// synchronously when called, on the calling sequence, and which is destroyed
+// when it returns. It can co_await the awaitables below, each of which
+// suspends the coroutine and resumes it on the sequence it was suspended on:
+//
+//   base::Coroutine LoadAndDisplay(scoped_refptr<TaskRunner> blocking_runner,
+//                                  base::WaitableEvent* ready) {
+//     co_await base::AwaitWaitableEvent(ready);
+//     std::string contents = co_await base::AwaitPostTask(
+//         blocking_runner, FROM_HERE, base::BindOnce(&ReadFile, path));
+//     Display(contents);
+//   }
+//
+// This is equivalent to a chain of PostTaskAndReplyWithResult() calls, but the
+// state carried between steps, including the result of AwaitPostTask(), lives
+// in the coroutine frame rather than in the bound arguments of each reply.
+// Each step still posts two tasks, one that runs the awaited task and one that
+// resumes the coroutine. Their BindStates only bind a pointer or the coroutine
+// handle, so they are small enough to be stored inline in the OnceCallback.
+//
+// Like the reply of PostTaskAndReply(), a coroutine which can't be resumed on
+// its sequence because that sequence stopped accepting tasks is leaked rather
+// than being destroyed on the wrong sequence.
+//
+// Coroutines must not throw exceptions.
+
+namespace base {
+
+class BASE_EXPORT Coroutine {
+ public:
+  struct BASE_EXPORT promise_type {
+    Coroutine get_return_object() { return Coroutine(); }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception();
+  };
+};
+
+namespace internal {
+
+// Resumes |handle|. Posted to resume a coroutine on its sequence.
+BASE_EXPORT void ResumeCoroutine(std::coroutine_handle<> handle);
+
+// Holds the result of the task run by a PostTaskAwaiter.
+template <typename R>
+class PostTaskResult {
+ public:
+  void Run(OnceCallback<R()> task) { result_.emplace(std::move(task).Run()); }
+  R Take() { return std::move(*result_); }
+
+ private:
+  absl::optional<R> result_;
+};
+
+template <>
+class PostTaskResult<void> {
+ public:
+  void Run(OnceCallback<void()> task) { std::move(task).Run(); }
+  void Take() {}
+};
+
+template <typename R>
+class PostTaskAwaiter {
+ public:
+  PostTaskAwaiter(scoped_refptr<TaskRunner> task_runner,
+                  const Location& from_here,
+                  OnceCallback<R()> task)
+      : task_runner_(std::move(task_runner)),
+        from_here_(from_here),
+        task_(std::move(task)) {
+    DCHECK(task_);
+  }
+  PostTaskAwaiter(const PostTaskAwaiter&) = delete;
+  PostTaskAwaiter& operator=(const PostTaskAwaiter&) = delete;
+
+  bool await_ready() const { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    DCHECK(SequencedTaskRunnerHandle::IsSet());
+    handle_ = handle;
+    reply_task_runner_ = SequencedTaskRunnerHandle::Get();
+    // |this| is owned by the coroutine frame, which is only resumed once
+    // RunTask() has posted the reply, so it can be bound unretained.
+    if (!task_runner_->PostTask(from_here_,
+                                BindOnce(&PostTaskAwaiter::RunTask,
+                                         Unretained(this)))) {
+      // The task was destroyed without running. The coroutine can't be resumed
+      // without its result, so it is destroyed on the current sequence.
+      handle.destroy();
+    }
+  }
+
+  R await_resume() { return result_.Take(); }
+
+ private:
+  void RunTask() {
+    result_.Run(std::move(task_));
+    // The coroutine may resume and destroy |this| as soon as the reply is
+    // posted, so don't access members after that.
+    scoped_refptr<SequencedTaskRunner> reply_task_runner =
+        std::move(reply_task_runner_);
+    const Location from_here = from_here_;
+    reply_task_runner->PostTask(from_here,
+                                BindOnce(&ResumeCoroutine, handle_));
+  }
+
+  const scoped_refptr<TaskRunner> task_runner_;
+  const Location from_here_;
+  OnceCallback<R()> task_;
+  PostTaskResult<R> result_;
+  scoped_refptr<SequencedTaskRunner> reply_task_runner_;
+  std::coroutine_handle<> handle_;
+};
+
+class BASE_EXPORT WaitableEventAwaiter {
+ public:
+  explicit WaitableEventAwaiter(WaitableEvent* event);
+  WaitableEventAwaiter(const WaitableEventAwaiter&) = delete;
+  WaitableEventAwaiter& operator=(const WaitableEventAwaiter&) = delete;
+  ~WaitableEventAwaiter();
+
+  bool await_ready() const;
+  void await_suspend(std::coroutine_handle<> handle);
+  void await_resume() {}
+
+ private:
+  void OnSignaled(WaitableEvent* event);
+
+  WaitableEvent* const event_;
+  WaitableEventWatcher watcher_;
+  std::coroutine_handle<> handle_;
+};
+
+#if defined(OS_POSIX)
+class BASE_EXPORT FileDescriptorAwaiter {
+ public:
+  enum class Mode { kReadable, kWritable };
+
+  FileDescriptorAwaiter(int fd, Mode mode);
+  FileDescriptorAwaiter(const FileDescriptorAwaiter&) = delete;
+  FileDescriptorAwaiter& operator=(const FileDescriptorAwaiter&) = delete;
+  ~FileDescriptorAwaiter();
+
+  bool await_ready() const { return false; }
+  void await_suspend(std::coroutine_handle<> handle);
+  void await_resume() {}
+
+ private:
+  void OnReady();
+
+  const int fd_;
+  const Mode mode_;
+  std::unique_ptr<FileDescriptorWatcher::Controller> controller_;
+  std::coroutine_handle<> handle_;
+};
+#endif  // defined(OS_POSIX)
+
+}  // namespace internal
+
+// Runs |task| on |task_runner| and resumes the awaiting coroutine on its
+// sequence with the value returned by |task|. If |task_runner| doesn't accept
+// |task|, the coroutine is destroyed without being resumed.
+template <typename R>
+internal::PostTaskAwaiter<R> AwaitPostTask(
+    scoped_refptr<TaskRunner> task_runner,
+    const Location& from_here,
+    OnceCallback<R()> task) {
+  return internal::PostTaskAwaiter<R>(std::move(task_runner), from_here,
+                                      std::move(task));
+}
+
+// Resumes the awaiting coroutine on its sequence once |event| is signaled. An
+// automatic-reset |event| is reset, as by WaitableEvent::Wait().
+BASE_EXPORT internal::WaitableEventAwaiter AwaitWaitableEvent(
+    WaitableEvent* event);
+
+#if defined(OS_POSIX)
+// Resumes the awaiting coroutine on its sequence once |fd| is readable or
+// writable without blocking. Must be awaited on a sequence which supports
+// FileDescriptorWatcher.
+BASE_EXPORT internal::FileDescriptorAwaiter AwaitReadable(int fd);
+BASE_EXPORT internal::FileDescriptorAwaiter AwaitWritable(int fd);
+#endif  // defined(OS_POSIX)
+
+}  // namespace base
+
+#endif  // BASE_TASK_COROUTINE_H_
@@ -0,0 +1,108 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/coroutine.h"
+
+#include <stddef.h>
+#include <string>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/run_loop.h"
+#include "base/sequenced_task_runner.h"
+#include "base/task/thread_pool.h"
+#include "base/test/task_environment.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace base {
+
+namespace {
+
+constexpr char kMetricPrefixCoroutine[] = "Coroutine.";
+constexpr char kMetricTimePerRoundTrip[] = "time_per_round_trip";
+constexpr char kStoryPostTaskAndReplyChain[] = "post_task_and_reply_chain";
+constexpr char kStoryCoroutineChain[] = "coroutine_chain";
+
+// Number of round trips between the main thread and a ThreadPool sequence.
+constexpr int kNumRoundTrips = 100000;
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixCoroutine, story_name);
+  reporter.RegisterImportantMetric(kMetricTimePerRoundTrip, "ns");
+  return reporter;
+}
+
+int Increment(int value) {
+  return value + 1;
+}
+
+// Each step posts Increment() with PostTaskAndReplyWithResult() and continues
+// from the reply.
+void PostTaskAndReplyStep(scoped_refptr<SequencedTaskRunner> task_runner,
+                          OnceClosure done,
+                          int value) {
+  if (value == kNumRoundTrips) {
+    std::move(done).Run();
+    return;
+  }
+  task_runner->PostTaskAndReplyWithResult(
+      FROM_HERE, BindOnce(&Increment, value),
+      BindOnce(&PostTaskAndReplyStep, task_runner, std::move(done)));
+}
+
+Coroutine CoroutineChain(scoped_refptr<SequencedTaskRunner> task_runner,
+                         OnceClosure done) {
+  int value = 0;
+  while (value != kNumRoundTrips) {
+    value = co_await AwaitPostTask(task_runner, FROM_HERE,
+                                   BindOnce(&Increment, value));
+  }
+  std::move(done).Run();
+}
+
+class CoroutinePerfTest : public testing::Test {
+ protected:
+  void Benchmark(const std::string& story_name,
+                 OnceCallback<void(OnceClosure)> start_chain) {
+    RunLoop run_loop;
+    const TimeTicks start = TimeTicks::Now();
+    std::move(start_chain).Run(run_loop.QuitClosure());
+    run_loop.Run();
+    const TimeDelta duration = TimeTicks::Now() - start;
+
+    auto reporter = SetUpReporter(story_name);
+    reporter.AddResult(kMetricTimePerRoundTrip,
+                       duration.InNanoseconds() /
+                           static_cast<double>(kNumRoundTrips));
+  }
+
+  test::TaskEnvironment task_environment_;
+};
+
+}  // namespace
+
+TEST_F(CoroutinePerfTest, PostTaskAndReplyChain) {
+  Benchmark(kStoryPostTaskAndReplyChain,
+            BindOnce(
+                [](scoped_refptr<SequencedTaskRunner> task_runner,
+                   OnceClosure done) {
+                  PostTaskAndReplyStep(task_runner, std::move(done), 0);
+                },
+                ThreadPool::CreateSequencedTaskRunner({})));
+}
+
+TEST_F(CoroutinePerfTest, CoroutineChain) {
+  Benchmark(kStoryCoroutineChain,
+            BindOnce(
+                [](scoped_refptr<SequencedTaskRunner> task_runner,
+                   OnceClosure done) {
+                  CoroutineChain(task_runner, std::move(done));
+                },
+                ThreadPool::CreateSequencedTaskRunner({})));
+}
+
+}  // namespace base
@@ -0,0 +1,178 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/coroutine.h"
+
+#include <string>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/callback_helpers.h"
+#include "base/location.h"
+#include "base/run_loop.h"
+#include "base/sequenced_task_runner.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/task/thread_pool.h"
+#include "base/task_runner.h"
+#include "base/test/task_environment.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+#if defined(OS_POSIX)
+#include <unistd.h>
+
+#include "base/files/scoped_file.h"
+#include "base/posix/eintr_wrapper.h"
+#endif
+
+namespace base {
+
+namespace {
+
+// A TaskRunner which rejects all tasks.
+class RejectingTaskRunner : public TaskRunner {
+ public:
+  RejectingTaskRunner() = default;
+
+  bool PostDelayedTask(const Location& from_here,
+                       OnceClosure task,
+                       TimeDelta delay) override {
+    return false;
+  }
+
+ private:
+  ~RejectingTaskRunner() override = default;
+};
+
+std::string ReturnFirst(scoped_refptr<SequencedTaskRunner> expected_runner) {
+  EXPECT_TRUE(expected_runner->RunsTasksInCurrentSequence());
+  return "first";
+}
+
+void AppendPlus(std::string* value) {
+  *value += "+";
+}
+
+Coroutine PostTwoTasks(scoped_refptr<SequencedTaskRunner> other_runner,
+                       std::string* result,
+                       OnceClosure done) {
+  scoped_refptr<SequencedTaskRunner> origin_runner =
+      SequencedTaskRunnerHandle::Get();
+
+  std::string value = co_await AwaitPostTask(
+      other_runner, FROM_HERE, BindOnce(&ReturnFirst, other_runner));
+  EXPECT_TRUE(origin_runner->RunsTasksInCurrentSequence());
+
+  // State in the coroutine frame can be accessed by the awaited task.
+  co_await AwaitPostTask(other_runner, FROM_HERE,
+                         BindOnce(&AppendPlus, Unretained(&value)));
+  EXPECT_TRUE(origin_runner->RunsTasksInCurrentSequence());
+
+  *result = value + "second";
+  std::move(done).Run();
+}
+
+Coroutine PostToRejectingTaskRunner(OnceClosure on_destroyed, bool* resumed) {
+  ScopedClosureRunner run_on_destroyed(std::move(on_destroyed));
+  co_await AwaitPostTask(MakeRefCounted<RejectingTaskRunner>(), FROM_HERE,
+                         BindOnce([]() { return 1; }));
+  *resumed = true;
+}
+
+Coroutine WaitForEvent(WaitableEvent* event, bool* resumed, OnceClosure done) {
+  scoped_refptr<SequencedTaskRunner> origin_runner =
+      SequencedTaskRunnerHandle::Get();
+  co_await AwaitWaitableEvent(event);
+  EXPECT_TRUE(origin_runner->RunsTasksInCurrentSequence());
+  *resumed = true;
+  std::move(done).Run();
+}
+
+#if defined(OS_POSIX)
+Coroutine ReadWhenReadable(int fd, char* result, OnceClosure done) {
+  co_await AwaitReadable(fd);
+  EXPECT_EQ(1, HANDLE_EINTR(read(fd, result, 1)));
+  std::move(done).Run();
+}
+#endif  // defined(OS_POSIX)
+
+class CoroutineTest : public testing::Test {
+ protected:
+  test::TaskEnvironment task_environment_{
+      test::TaskEnvironment::MainThreadType::IO};
+};
+
+}  // namespace
+
+// A coroutine resumes on its sequence with the result of each task it awaits.
+TEST_F(CoroutineTest, AwaitPostTask) {
+  std::string result;
+  RunLoop run_loop;
+  PostTwoTasks(ThreadPool::CreateSequencedTaskRunner({}), &result,
+               run_loop.QuitClosure());
+  EXPECT_TRUE(result.empty());
+  run_loop.Run();
+  EXPECT_EQ("first+second", result);
+}
+
+// A coroutine whose task is rejected is destroyed without being resumed.
+TEST_F(CoroutineTest, AwaitPostTaskRejected) {
+  bool destroyed = false;
+  bool resumed = false;
+  PostToRejectingTaskRunner(
+      BindOnce([](bool* destroyed) { *destroyed = true; },
+               Unretained(&destroyed)),
+      &resumed);
+  EXPECT_TRUE(destroyed);
+  EXPECT_FALSE(resumed);
+}
+
+TEST_F(CoroutineTest, AwaitWaitableEvent) {
+  WaitableEvent event(WaitableEvent::ResetPolicy::AUTOMATIC,
+                      WaitableEvent::InitialState::NOT_SIGNALED);
+  bool resumed = false;
+  RunLoop run_loop;
+  WaitForEvent(&event, &resumed, run_loop.QuitClosure());
+  RunLoop().RunUntilIdle();
+  EXPECT_FALSE(resumed);
+
+  ThreadPool::PostTask(FROM_HERE, BindOnce(&WaitableEvent::Signal,
+                                           Unretained(&event)));
+  run_loop.Run();
+  EXPECT_TRUE(resumed);
+  // The automatic-reset event was reset by the coroutine.
+  EXPECT_FALSE(event.IsSignaled());
+}
+
+// The coroutine doesn't suspend if the event is already signaled.
+TEST_F(CoroutineTest, AwaitSignaledWaitableEvent) {
+  WaitableEvent event;
+  event.Signal();
+  bool resumed = false;
+  WaitForEvent(&event, &resumed, DoNothing());
+  EXPECT_TRUE(resumed);
+}
+
+#if defined(OS_POSIX)
+TEST_F(CoroutineTest, AwaitReadable) {
+  int pipe_fds[2];
+  ASSERT_EQ(0, pipe(pipe_fds));
+  ScopedFD read_fd(pipe_fds[0]);
+  ScopedFD write_fd(pipe_fds[1]);
+
+  char result = 0;
+  RunLoop run_loop;
+  ReadWhenReadable(read_fd.get(), &result, run_loop.QuitClosure());
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(0, result);
+
+  const char kByte = 'x';
+  ASSERT_EQ(1, HANDLE_EINTR(write(write_fd.get(), &kByte, 1)));
+  run_loop.Run();
+  EXPECT_EQ(kByte, result);
+}
+#endif  // defined(OS_POSIX)
+
+}  // namespace base
@@ -212,7 +212,8 @@ class BASE_EXPORT CurrentUIThread : public CurrentThread {
   static_assert(
       std::is_base_of<WatchableIOMessagePumpPosix, MessagePumpForUI>::value,
       "CurrentThreadForUI::WatchFileDescriptor is supported only"
-      "by MessagePumpLibevent and MessagePumpGlib implementations.");
+      "by MessagePumpLibevent, MessagePumpEpoll and MessagePumpGlib "
+      "implementations.");
   bool WatchFileDescriptor(int fd,
                            bool persistent,
                            MessagePumpForUI::Mode mode,
@@ -0,0 +1,193 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+#include "base/check_op.h"
+#include "base/task/post_job.h"
+#include "base/task/task_traits.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// Chunks of [begin, end) which a ParallelFor() has left to run. Chunks are
+// identified by their index, and each thread which runs the job owns a Slot,
+// which holds a range of chunk indices. The owner takes chunks from the front
+// of its range, and other threads steal the back half of the range when their
+// own is empty.
+class ParallelForState {
+ public:
+  ParallelForState(size_t begin,
+                   size_t end,
+                   size_t grain_size,
+                   RepeatingCallback<void(size_t, size_t, uint8_t)> fn)
+      : begin_(begin),
+        end_(end),
+        grain_size_(grain_size),
+        fn_(std::move(fn)),
+        num_unclaimed_chunks_((end - begin + grain_size - 1) / grain_size) {
+    const size_t num_chunks = num_unclaimed_chunks_.load();
+    CHECK_LE(num_chunks, std::numeric_limits<uint32_t>::max());
+    // The first thread to run takes chunks from the front, and threads which
+    // join later split the range adaptively.
+    slots_[0].range.store(PackRange(0, static_cast<uint32_t>(num_chunks)),
+                          std::memory_order_relaxed);
+  }
+  ParallelForState(const ParallelForState&) = delete;
+  ParallelForState& operator=(const ParallelForState&) = delete;
+  ~ParallelForState() = default;
+
+  void Run(JobDelegate* delegate) {
+    const uint8_t task_id = delegate->GetTaskId();
+    CHECK_LT(task_id, kMaxParallelForWorkers);
+    Slot& slot = slots_[task_id];
+    while (!delegate->ShouldYield()) {
+      uint32_t chunk;
+      if (!TakeFront(&slot, &chunk) &&
+          !(Steal(&slot) && TakeFront(&slot, &chunk))) {
+        return;
+      }
+      const size_t chunk_begin = begin_ + chunk * grain_size_;
+      fn_.Run(chunk_begin, std::min(chunk_begin + grain_size_, end_), task_id);
+    }
+  }
+
+  size_t GetMaxConcurrency(size_t /*worker_count*/) const {
+    return std::min(num_unclaimed_chunks_.load(std::memory_order_relaxed),
+                    kMaxParallelForWorkers);
+  }
+
+ private:
+  struct alignas(64) Slot {
+    // The [begin, end) range of chunk indices, packed by PackRange().
+    std::atomic<uint64_t> range{0};
+  };
+
+  static uint64_t PackRange(uint32_t begin, uint32_t end) {
+    return (uint64_t{begin} << 32) | end;
+  }
+  static uint32_t RangeBegin(uint64_t range) {
+    return static_cast<uint32_t>(range >> 32);
+  }
+  static uint32_t RangeEnd(uint64_t range) {
+    return static_cast<uint32_t>(range);
+  }
+
+  // Takes the first chunk of |slot|, owned by the current thread. Returns
+  // false if it's empty.
+  bool TakeFront(Slot* slot, uint32_t* chunk) {
+    uint64_t range = slot->range.load(std::memory_order_relaxed);
+    do {
+      if (RangeBegin(range) == RangeEnd(range))
+        return false;
+      *chunk = RangeBegin(range);
+    } while (!slot->range.compare_exchange_weak(
+        range, PackRange(*chunk + 1, RangeEnd(range)),
+        std::memory_order_relaxed));
+    num_unclaimed_chunks_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Moves the back half of the largest range of other slots to the empty
+  // |slot|, owned by the current thread. Returns false if all ranges are
+  // empty.
+  //
+  // A range of a slot is never set twice to the same non-empty value, since
+  // each chunk is run once, so comparing ranges isn't subject to ABA.
+  bool Steal(Slot* slot) {
+    while (true) {
+      Slot* victim = nullptr;
+      uint64_t victim_range = 0;
+      uint32_t victim_size = 0;
+      for (Slot& other : slots_) {
+        const uint64_t range = other.range.load(std::memory_order_relaxed);
+        const uint32_t size = RangeEnd(range) - RangeBegin(range);
+        if (size > victim_size) {
+          victim = &other;
+          victim_range = range;
+          victim_size = size;
+        }
+      }
+      if (!victim)
+        return false;
+      DCHECK_NE(victim, slot);
+
+      // Leaves the first half to the owner, rounded down, which is all of the
+      // range if there is a single chunk.
+      const uint32_t mid = RangeBegin(victim_range) + victim_size / 2;
+      if (victim->range.compare_exchange_strong(
+              victim_range, PackRange(RangeBegin(victim_range), mid),
+              std::memory_order_relaxed)) {
+        slot->range.store(PackRange(mid, RangeEnd(victim_range)),
+                          std::memory_order_relaxed);
+        return true;
+      }
+    }
+  }
+
+  const size_t begin_;
+  const size_t end_;
+  const size_t grain_size_;
+  const RepeatingCallback<void(size_t, size_t, uint8_t)> fn_;
+
+  // Chunks which no thread took yet, including those in |slots_|.
+  std::atomic<size_t> num_unclaimed_chunks_;
+
+  Slot slots_[kMaxParallelForWorkers];
+};
+
+}  // namespace
+
+void ParallelForWithTaskId(
+    const Location& from_here,
+    size_t begin,
+    size_t end,
+    size_t grain_size,
+    const TaskTraits& traits,
+    RepeatingCallback<void(size_t begin, size_t end, uint8_t task_id)> fn) {
+  DCHECK_GT(grain_size, 0u);
+  if (begin >= end)
+    return;
+
+  // Join() returns once all workers are done, and the job's callbacks aren't
+  // called afterwards, which makes Unretained() safe.
+  ParallelForState state(begin, end, grain_size, fn);
+  JobHandle handle =
+      PostJob(from_here, traits,
+              BindRepeating(&ParallelForState::Run, Unretained(&state)),
+              BindRepeating(&ParallelForState::GetMaxConcurrency,
+                            Unretained(&state)));
+  if (handle) {
+    handle.Join();
+    return;
+  }
+
+  // The job couldn't be posted, e.g. because of shutdown. Run it here.
+  for (size_t chunk_begin = begin; chunk_begin < end; chunk_begin += grain_size)
+    fn.Run(chunk_begin, std::min(chunk_begin + grain_size, end), 0);
+}
+
+}  // namespace internal
+
+void ParallelFor(const Location& from_here,
+                 size_t begin,
+                 size_t end,
+                 size_t grain_size,
+                 const TaskTraits& traits,
+                 RepeatingCallback<void(size_t begin, size_t end)> fn) {
+  internal::ParallelForWithTaskId(
+      from_here, begin, end, grain_size, traits,
+      BindRepeating(
+          [](const RepeatingCallback<void(size_t, size_t)>& fn, size_t begin,
+             size_t end, uint8_t task_id) { fn.Run(begin, end); },
+          std::move(fn)));
+}
+
+}  // namespace base
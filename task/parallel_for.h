@@ -0,0 +1,130 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TASK_PARALLEL_FOR_H_
+#define BASE_TASK_PARALLEL_FOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/bind.h"
+#include "base/callback.h"
+#include "base/location.h"
+
+namespace base {
+
+class TaskTraits;
+
+namespace internal {
+
+// Maximum number of threads that run a ParallelFor() concurrently, including
+// the calling thread. Task ids returned by JobDelegate::GetTaskId() for a
+// ParallelFor() are smaller than this.
+constexpr size_t kMaxParallelForWorkers = 32;
+
+// Runs |fn| on all chunks of |grain_size| indices of [begin, end), and passes
+// it the JobDelegate task id of the thread running each chunk.
+BASE_EXPORT void ParallelForWithTaskId(
+    const Location& from_here,
+    size_t begin,
+    size_t end,
+    size_t grain_size,
+    const TaskTraits& traits,
+    RepeatingCallback<void(size_t begin, size_t end, uint8_t task_id)> fn);
+
+}  // namespace internal
+
+// Calls |fn| on consecutive subranges of [begin, end), in parallel on the
+// calling thread and on ThreadPool workers running a Job with |traits|, and
+// returns once the whole range was processed. Subranges have |grain_size|
+// indices, except possibly the last one.
+//
+// The range is split adaptively: it is initially assigned to a single thread,
+// and each thread that joins the Job, or runs out of indices, steals the upper
+// half of the largest range left to another thread. Threads check
+// JobDelegate::ShouldYield() between subranges, and the indices left to a
+// thread that yields are taken over by other threads. |grain_size| should be
+// large enough for |fn| to amortize this bookkeeping, e.g. a few microseconds
+// of work.
+//
+// |fn| is called concurrently on any thread, and must not call ParallelFor().
+// Like JobHandle::Join(), ParallelFor() must not be called with a priority
+// higher than the priority of the current thread, and while holding a lock
+// which |fn| could acquire.
+//
+// Example:
+//   base::ParallelFor(
+//       FROM_HERE, 0, pixels.size(), 4096, {base::TaskPriority::USER_VISIBLE},
+//       base::BindRepeating(
+//           [](std::vector<Pixel>* pixels, size_t begin, size_t end) {
+//             for (size_t i = begin; i < end; ++i)
+//               Blur(&(*pixels)[i]);
+//           },
+//           &pixels));
+BASE_EXPORT void ParallelFor(
+    const Location& from_here,
+    size_t begin,
+    size_t end,
+    size_t grain_size,
+    const TaskTraits& traits,
+    RepeatingCallback<void(size_t begin, size_t end)> fn);
+
+// Returns |reduce| applied to |identity| and to the values returned by |map|
+// for all the subranges of [begin, end) of ParallelFor(). |reduce| must be
+// associative and commutative, since subranges are mapped and reduced in no
+// particular order: each thread reduces the values of the subranges it runs,
+// and the results of the threads are then reduced on the calling thread. Both
+// |map| and |reduce| are called concurrently on any thread.
+//
+// Example:
+//   int64_t sum = base::ParallelReduce<int64_t>(
+//       FROM_HERE, 0, values.size(), 4096, {}, 0,
+//       base::BindRepeating(
+//           [](const std::vector<int>* values, size_t begin, size_t end) {
+//             return std::accumulate(values->begin() + begin,
+//                                    values->begin() + end, int64_t{0});
+//           },
+//           &values),
+//       base::BindRepeating([](int64_t a, int64_t b) { return a + b; }));
+template <typename T>
+T ParallelReduce(const Location& from_here,
+                 size_t begin,
+                 size_t end,
+                 size_t grain_size,
+                 const TaskTraits& traits,
+                 T identity,
+                 RepeatingCallback<T(size_t begin, size_t end)> map,
+                 RepeatingCallback<T(T, T)> reduce) {
+  // Each thread reduces into the value of its task id, which no other thread
+  // uses at the same time. Values are padded to avoid false sharing.
+  struct alignas(64) PartialResult {
+    T value;
+  };
+  std::vector<PartialResult> partial_results(internal::kMaxParallelForWorkers,
+                                             PartialResult{identity});
+  internal::ParallelForWithTaskId(
+      from_here, begin, end, grain_size, traits,
+      BindRepeating(
+          [](std::vector<PartialResult>* partial_results,
+             const RepeatingCallback<T(size_t, size_t)>& map,
+             const RepeatingCallback<T(T, T)>& reduce, size_t begin,
+             size_t end, uint8_t task_id) {
+            T& value = (*partial_results)[task_id].value;
+            value = reduce.Run(std::move(value), map.Run(begin, end));
+          },
+          Unretained(&partial_results), map, reduce));
+
+  T result = std::move(identity);
+  for (PartialResult& partial_result : partial_results)
+    result = reduce.Run(std::move(result), std::move(partial_result.value));
+  return result;
+}
+
+}  // namespace base
+
+#endif  // BASE_TASK_PARALLEL_FOR_H_
@@ -0,0 +1,207 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/parallel_for.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/task/post_job.h"
+#include "base/task/task_traits.h"
+#include "base/test/bind.h"
+#include "base/test/task_environment.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace base {
+
+namespace {
+
+// The perftest compares the following ways of processing a range of elements:
+// - Serial: A loop on the calling thread.
+// - Atomic: A Job whose workers claim one chunk at a time by incrementing an
+//   atomic index.
+// - ParallelFor: ParallelReduce(), which splits the range adaptively.
+// for the following workloads:
+// - Memory bound: Summing a 64 MiB vector.
+// - Compute bound: Hashing each element many times.
+
+constexpr char kMetricPrefixParallelFor[] = "ParallelFor.";
+constexpr char kMetricTimePerElement[] = "time_per_element";
+constexpr char kStoryMemoryBoundSerial[] = "memory_bound_serial";
+constexpr char kStoryMemoryBoundAtomic[] = "memory_bound_atomic";
+constexpr char kStoryMemoryBoundParallelFor[] = "memory_bound_parallel_for";
+constexpr char kStoryComputeBoundSerial[] = "compute_bound_serial";
+constexpr char kStoryComputeBoundAtomic[] = "compute_bound_atomic";
+constexpr char kStoryComputeBoundParallelFor[] = "compute_bound_parallel_for";
+
+constexpr size_t kNumMemoryBoundElements = 16 * 1024 * 1024;
+constexpr size_t kMemoryBoundGrainSize = 16 * 1024;
+constexpr size_t kNumComputeBoundElements = 256 * 1024;
+constexpr size_t kComputeBoundGrainSize = 256;
+constexpr int kNumHashRounds = 200;
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixParallelFor, story_name);
+  reporter.RegisterImportantMetric(kMetricTimePerElement, "ns");
+  return reporter;
+}
+
+uint64_t SumRange(const std::vector<uint32_t>* values,
+                  size_t begin,
+                  size_t end) {
+  uint64_t sum = 0;
+  for (size_t i = begin; i < end; ++i)
+    sum += (*values)[i];
+  return sum;
+}
+
+uint64_t HashRange(size_t begin, size_t end) {
+  uint64_t sum = 0;
+  for (size_t i = begin; i < end; ++i) {
+    uint64_t hash = i;
+    for (int round = 0; round < kNumHashRounds; ++round) {
+      hash ^= hash >> 33;
+      hash *= 0xff51afd7ed558ccdULL;
+    }
+    sum += hash;
+  }
+  return sum;
+}
+
+class ParallelForPerfTest : public testing::Test {
+ public:
+  ParallelForPerfTest() = default;
+  ParallelForPerfTest(const ParallelForPerfTest&) = delete;
+  ParallelForPerfTest& operator=(const ParallelForPerfTest&) = delete;
+
+ protected:
+  using RangeCallback = RepeatingCallback<uint64_t(size_t, size_t)>;
+
+  void RunSerial(const std::string& story_name,
+                 size_t num_elements,
+                 size_t grain_size,
+                 RangeCallback process_range) {
+    const TimeTicks start = TimeTicks::Now();
+    uint64_t result = 0;
+    for (size_t begin = 0; begin < num_elements; begin += grain_size) {
+      result += process_range.Run(begin,
+                                  std::min(begin + grain_size, num_elements));
+    }
+    Report(story_name, num_elements, TimeTicks::Now() - start);
+    EXPECT_NE(0u, result);
+  }
+
+  // Posts a Job whose workers claim chunks by incrementing a shared index, and
+  // waits for it on the calling thread.
+  void RunAtomic(const std::string& story_name,
+                 size_t num_elements,
+                 size_t grain_size,
+                 RangeCallback process_range) {
+    const size_t num_chunks = (num_elements + grain_size - 1) / grain_size;
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<uint64_t> result{0};
+    const TimeTicks start = TimeTicks::Now();
+    PostJob(FROM_HERE, {TaskPriority::USER_VISIBLE},
+            BindLambdaForTesting([&](JobDelegate* delegate) {
+              uint64_t partial_result = 0;
+              while (!delegate->ShouldYield()) {
+                const size_t chunk = next_chunk.fetch_add(1);
+                if (chunk >= num_chunks)
+                  break;
+                const size_t begin = chunk * grain_size;
+                partial_result += process_range.Run(
+                    begin, std::min(begin + grain_size, num_elements));
+              }
+              result.fetch_add(partial_result);
+            }),
+            BindLambdaForTesting([&](size_t /*worker_count*/) -> size_t {
+              const size_t chunk = next_chunk.load();
+              return chunk < num_chunks ? num_chunks - chunk : 0;
+            }))
+        .Join();
+    Report(story_name, num_elements, TimeTicks::Now() - start);
+    EXPECT_NE(0u, result.load());
+  }
+
+  void RunParallelFor(const std::string& story_name,
+                      size_t num_elements,
+                      size_t grain_size,
+                      RangeCallback process_range) {
+    const TimeTicks start = TimeTicks::Now();
+    const uint64_t result = ParallelReduce<uint64_t>(
+        FROM_HERE, 0, num_elements, grain_size, {TaskPriority::USER_VISIBLE},
+        0, std::move(process_range),
+        BindRepeating([](uint64_t a, uint64_t b) { return a + b; }));
+    Report(story_name, num_elements, TimeTicks::Now() - start);
+    EXPECT_NE(0u, result);
+  }
+
+ private:
+  void Report(const std::string& story_name,
+              size_t num_elements,
+              TimeDelta duration) {
+    auto reporter = SetUpReporter(story_name);
+    reporter.AddResult(kMetricTimePerElement,
+                       duration.InNanoseconds() /
+                           static_cast<double>(num_elements));
+  }
+
+  test::TaskEnvironment task_environment_;
+};
+
+class ParallelForMemoryBoundPerfTest : public ParallelForPerfTest {
+ protected:
+  ParallelForMemoryBoundPerfTest() : values_(kNumMemoryBoundElements) {
+    for (size_t i = 0; i < values_.size(); ++i)
+      values_[i] = static_cast<uint32_t>(i);
+  }
+
+  RangeCallback GetProcessRange() const {
+    return BindRepeating(&SumRange, Unretained(&values_));
+  }
+
+  std::vector<uint32_t> values_;
+};
+
+}  // namespace
+
+TEST_F(ParallelForMemoryBoundPerfTest, Serial) {
+  RunSerial(kStoryMemoryBoundSerial, kNumMemoryBoundElements,
+            kMemoryBoundGrainSize, GetProcessRange());
+}
+
+TEST_F(ParallelForMemoryBoundPerfTest, Atomic) {
+  RunAtomic(kStoryMemoryBoundAtomic, kNumMemoryBoundElements,
+            kMemoryBoundGrainSize, GetProcessRange());
+}
+
+TEST_F(ParallelForMemoryBoundPerfTest, ParallelFor) {
+  RunParallelFor(kStoryMemoryBoundParallelFor, kNumMemoryBoundElements,
+                 kMemoryBoundGrainSize, GetProcessRange());
+}
+
+TEST_F(ParallelForPerfTest, ComputeBoundSerial) {
+  RunSerial(kStoryComputeBoundSerial, kNumComputeBoundElements,
+            kComputeBoundGrainSize, BindRepeating(&HashRange));
+}
+
+TEST_F(ParallelForPerfTest, ComputeBoundAtomic) {
+  RunAtomic(kStoryComputeBoundAtomic, kNumComputeBoundElements,
+            kComputeBoundGrainSize, BindRepeating(&HashRange));
+}
+
+TEST_F(ParallelForPerfTest, ComputeBoundParallelFor) {
+  RunParallelFor(kStoryComputeBoundParallelFor, kNumComputeBoundElements,
+                 kComputeBoundGrainSize, BindRepeating(&HashRange));
+}
+
+}  // namespace base
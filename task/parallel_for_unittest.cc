@@ -0,0 +1,95 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/parallel_for.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "base/synchronization/lock.h"
+#include "base/task/task_traits.h"
+#include "base/test/bind.h"
+#include "base/test/task_environment.h"
+#include "base/threading/platform_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+TEST(ParallelForTest, EmptyRange) {
+  test::TaskEnvironment task_environment;
+  ParallelFor(FROM_HERE, 10, 10, 1, {},
+              BindRepeating([](size_t, size_t) { ADD_FAILURE(); }));
+}
+
+// Verifies that each index is visited exactly once, for various grain sizes.
+TEST(ParallelForTest, VisitsEachIndexOnce) {
+  test::TaskEnvironment task_environment;
+  constexpr size_t kBegin = 7;
+  constexpr size_t kEnd = 10007;
+  for (size_t grain_size : {1, 3, 64, 10000, 20000}) {
+    std::unique_ptr<std::atomic<int>[]> visits(new std::atomic<int>[kEnd]());
+    ParallelFor(FROM_HERE, kBegin, kEnd, grain_size, {},
+                BindLambdaForTesting([&](size_t begin, size_t end) {
+                  EXPECT_LT(begin, end);
+                  EXPECT_LE(end - begin, grain_size);
+                  for (size_t i = begin; i < end; ++i)
+                    visits[i].fetch_add(1, std::memory_order_relaxed);
+                }));
+    for (size_t i = 0; i < kEnd; ++i)
+      EXPECT_EQ(i < kBegin ? 0 : 1, visits[i].load()) << i;
+  }
+}
+
+// Verifies that several threads run subranges when they take a while.
+TEST(ParallelForTest, RunsInParallel) {
+  test::TaskEnvironment task_environment;
+  Lock lock;
+  std::set<PlatformThreadId> thread_ids;
+  ParallelFor(FROM_HERE, 0, 64, 1, {TaskPriority::USER_BLOCKING},
+              BindLambdaForTesting([&](size_t begin, size_t end) {
+                PlatformThread::Sleep(TimeDelta::FromMilliseconds(5));
+                AutoLock auto_lock(lock);
+                thread_ids.insert(PlatformThread::CurrentId());
+              }));
+  // The calling thread and at least one worker participated.
+  EXPECT_GT(thread_ids.size(), 1u);
+  EXPECT_EQ(1u, thread_ids.count(PlatformThread::CurrentId()));
+}
+
+TEST(ParallelForTest, ParallelReduce) {
+  test::TaskEnvironment task_environment;
+  std::vector<int> values(100000);
+  for (size_t i = 0; i < values.size(); ++i)
+    values[i] = static_cast<int>(i % 1000);
+  int64_t expected = 0;
+  for (int value : values)
+    expected += value;
+
+  const int64_t sum = ParallelReduce<int64_t>(
+      FROM_HERE, 0, values.size(), 1000, {}, 0,
+      BindLambdaForTesting([&](size_t begin, size_t end) {
+        int64_t partial_sum = 0;
+        for (size_t i = begin; i < end; ++i)
+          partial_sum += values[i];
+        return partial_sum;
+      }),
+      BindRepeating([](int64_t a, int64_t b) { return a + b; }));
+  EXPECT_EQ(expected, sum);
+}
+
+TEST(ParallelForTest, ParallelReduceEmptyRangeReturnsIdentity) {
+  test::TaskEnvironment task_environment;
+  const int result = ParallelReduce<int>(
+      FROM_HERE, 0, 0, 1, {}, -1,
+      BindRepeating([](size_t, size_t) { return 1; }),
+      BindRepeating([](int a, int b) { return std::max(a, b); }));
+  EXPECT_EQ(-1, result);
+}
+
+}  // namespace base
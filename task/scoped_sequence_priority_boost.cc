@@ -0,0 +1,32 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/scoped_sequence_priority_boost.h"
+
+#include <utility>
+
+#include "base/check.h"
+#include "base/task/scoped_set_task_priority_for_current_thread.h"
+
+namespace base {
+
+ScopedSequencePriorityBoost::ScopedSequencePriorityBoost(
+    scoped_refptr<UpdateableSequencedTaskRunner> task_runner)
+    : ScopedSequencePriorityBoost(std::move(task_runner),
+                                  internal::GetTaskPriorityForCurrentThread()) {
+}
+
+ScopedSequencePriorityBoost::ScopedSequencePriorityBoost(
+    scoped_refptr<UpdateableSequencedTaskRunner> task_runner,
+    TaskPriority priority)
+    : task_runner_(std::move(task_runner)), priority_(priority) {
+  DCHECK(task_runner_);
+  task_runner_->AddPriorityBoost(priority_);
+}
+
+ScopedSequencePriorityBoost::~ScopedSequencePriorityBoost() {
+  task_runner_->RemovePriorityBoost(priority_);
+}
+
+}  // namespace base
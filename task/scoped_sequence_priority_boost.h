@@ -0,0 +1,57 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TASK_SCOPED_SEQUENCE_PRIORITY_BOOST_H_
+#define BASE_TASK_SCOPED_SEQUENCE_PRIORITY_BOOST_H_
+
+#include "base/base_export.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/task/task_traits.h"
+#include "base/updateable_sequenced_task_runner.h"
+
+namespace base {
+
+// Within its scope, raises the priority of the tasks posted through an
+// UpdateableSequencedTaskRunner to at least the priority of the current task
+// (or an explicit priority). This avoids priority inversions when a task
+// synchronously waits for work queued on a lower priority sequence, which
+// would otherwise be scheduled behind other work of its priority and, for
+// BEST_EFFORT sequences, subject to the limit of concurrent BEST_EFFORT tasks.
+//
+// Tasks run with the boosted priority, so a boost propagates to sequences
+// that they wait for in turn.
+//
+// As with UpdatePriority(), boosting a BEST_EFFORT sequence requires a
+// ThreadPolicy in its TaskTraits.
+//
+// Example:
+//   // |object_| is a SequenceBound<Object> bound to |task_runner_|, which was
+//   // created with ThreadPool::CreateUpdateableSequencedTaskRunner().
+//   WaitableEvent done;
+//   object_.AsyncCall(&Object::DoWork).WithArgs(&done);
+//   {
+//     ScopedSequencePriorityBoost boost(task_runner_);
+//     ScopedAllowBaseSyncPrimitives allow_wait;
+//     done.Wait();
+//   }
+class BASE_EXPORT ScopedSequencePriorityBoost {
+ public:
+  explicit ScopedSequencePriorityBoost(
+      scoped_refptr<UpdateableSequencedTaskRunner> task_runner);
+  ScopedSequencePriorityBoost(
+      scoped_refptr<UpdateableSequencedTaskRunner> task_runner,
+      TaskPriority priority);
+  ScopedSequencePriorityBoost(const ScopedSequencePriorityBoost&) = delete;
+  ScopedSequencePriorityBoost& operator=(const ScopedSequencePriorityBoost&) =
+      delete;
+  ~ScopedSequencePriorityBoost();
+
+ private:
+  const scoped_refptr<UpdateableSequencedTaskRunner> task_runner_;
+  const TaskPriority priority_;
+};
+
+}  // namespace base
+
+#endif  // BASE_TASK_SCOPED_SEQUENCE_PRIORITY_BOOST_H_
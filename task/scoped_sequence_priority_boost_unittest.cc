@@ -0,0 +1,73 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/scoped_sequence_priority_boost.h"
+
+#include "base/bind.h"
+#include "base/task/scoped_set_task_priority_for_current_thread.h"
+#include "base/task/task_traits.h"
+#include "base/task/thread_pool.h"
+#include "base/task/thread_pool/thread_pool_instance.h"
+#include "base/test/bind.h"
+#include "base/test/task_environment.h"
+#include "base/test/test_waitable_event.h"
+#include "base/updateable_sequenced_task_runner.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Tests use a ScopedBestEffortExecutionFence to prevent BEST_EFFORT tasks from
+// running unless they are boosted, like the limit of concurrent BEST_EFFORT
+// tasks would when it is reached.
+class ScopedSequencePriorityBoostTest : public testing::Test {
+ protected:
+  ScopedSequencePriorityBoostTest()
+      : best_effort_task_runner_(
+            ThreadPool::CreateUpdateableSequencedTaskRunner(
+                {TaskPriority::BEST_EFFORT,
+                 ThreadPolicy::PREFER_BACKGROUND})) {}
+
+  test::TaskEnvironment task_environment_;
+  const scoped_refptr<UpdateableSequencedTaskRunner> best_effort_task_runner_;
+};
+
+}  // namespace
+
+TEST_F(ScopedSequencePriorityBoostTest, BoostedSequenceRuns) {
+  ThreadPoolInstance::ScopedBestEffortExecutionFence best_effort_fence;
+  TestWaitableEvent task_ran;
+  best_effort_task_runner_->PostTask(
+      FROM_HERE, BindOnce(&TestWaitableEvent::Signal, Unretained(&task_ran)));
+
+  ScopedSequencePriorityBoost boost(best_effort_task_runner_,
+                                    TaskPriority::USER_VISIBLE);
+  task_ran.Wait();
+}
+
+// Verify that a boost applies the priority of the current task by default, and
+// that boosted tasks run with the boosted priority.
+TEST_F(ScopedSequencePriorityBoostTest, InheritsPriorityOfCurrentTask) {
+  ThreadPoolInstance::ScopedBestEffortExecutionFence best_effort_fence;
+  TestWaitableEvent task_ran;
+  TaskPriority boosted_task_priority = TaskPriority::BEST_EFFORT;
+  best_effort_task_runner_->PostTask(
+      FROM_HERE, BindLambdaForTesting([&]() {
+        boosted_task_priority = internal::GetTaskPriorityForCurrentThread();
+        task_ran.Signal();
+      }));
+
+  ThreadPool::PostTask(FROM_HERE, {TaskPriority::USER_VISIBLE},
+                       BindLambdaForTesting([&]() {
+                         ScopedSequencePriorityBoost boost(
+                             best_effort_task_runner_);
+                         task_ran.Wait();
+                       }));
+  task_environment_.RunUntilIdle();
+  EXPECT_TRUE(task_ran.IsSignaled());
+  EXPECT_EQ(TaskPriority::USER_VISIBLE, boosted_task_priority);
+}
+
+}  // namespace base
@@ -0,0 +1,205 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/sequence_manager/atomic_task_list.h"
+
+#include "base/bits.h"
+#include "base/check.h"
+#include "base/check_op.h"
+
+namespace base {
+namespace sequence_manager {
+namespace internal {
+
+AtomicTaskList::Node::Node() = default;
+
+AtomicTaskList::Node::~Node() = default;
+
+AtomicTaskList::AtomicTaskList() = default;
+
+AtomicTaskList::~AtomicTaskList() {
+  // Deleting the nodes deletes the Tasks left in the list.
+  for (auto& chunk : chunks_)
+    delete[] chunk.load(std::memory_order_relaxed);
+}
+
+Task* AtomicTaskList::Push(Task task,
+                           EnqueueOrderGenerator* generator,
+                           bool* was_empty) {
+  DCHECK(!task.enqueue_order_set());
+  const NodeIndex index = AllocateNode();
+  Node& node = GetNode(index);
+  node.task.emplace(std::move(task));
+  // |node| may be taken by the consumer as soon as it is linked.
+  Task* const pushed_task = &*node.task;
+  size_.fetch_add(1, std::memory_order_relaxed);
+  TaggedIndex head = head_.load(std::memory_order_acquire);
+  do {
+    // The enqueue order must be generated after |head| was loaded for enqueue
+    // orders to increase along the list. If another producer links its Task
+    // first, the compare-and-swap fails and a new enqueue order is generated.
+    node.task->enqueue_order_ = generator->GenerateNext();
+    node.next.store(GetIndex(head), std::memory_order_relaxed);
+  } while (!head_.compare_exchange_weak(head, NextHead(head, index),
+                                        std::memory_order_release,
+                                        std::memory_order_acquire));
+  OnPushed(head, index);
+  *was_empty = GetIndex(head) == kNullIndex;
+  return pushed_task;
+}
+
+void AtomicTaskList::PushAll(std::vector<Task> tasks,
+                             EnqueueOrderGenerator* generator,
+                             bool* was_empty) {
+  DCHECK(!tasks.empty());
+  // Link the nodes newest first, like the list, but keep them in posting order
+  // to generate their enqueue orders.
+  std::vector<Node*> nodes;
+  nodes.reserve(tasks.size());
+  NodeIndex oldest = kNullIndex;
+  NodeIndex newest = kNullIndex;
+  for (Task& task : tasks) {
+    DCHECK(!task.enqueue_order_set());
+    const NodeIndex index = AllocateNode();
+    Node& node = GetNode(index);
+    node.task.emplace(std::move(task));
+    if (newest != kNullIndex)
+      node.next.store(newest, std::memory_order_relaxed);
+    else
+      oldest = index;
+    nodes.push_back(&node);
+    newest = index;
+  }
+  size_.fetch_add(nodes.size(), std::memory_order_relaxed);
+
+  TaggedIndex head = head_.load(std::memory_order_acquire);
+  do {
+    // See Push(). All the enqueue orders are regenerated if the
+    // compare-and-swap fails.
+    for (Node* node : nodes)
+      node->task->enqueue_order_ = generator->GenerateNext();
+    nodes.front()->next.store(GetIndex(head), std::memory_order_relaxed);
+  } while (!head_.compare_exchange_weak(head, NextHead(head, newest),
+                                        std::memory_order_release,
+                                        std::memory_order_acquire));
+  OnPushed(head, oldest);
+  *was_empty = GetIndex(head) == kNullIndex;
+}
+
+void AtomicTaskList::PushForTesting(Task task) {
+  DCHECK(task.enqueue_order_set());
+  const NodeIndex index = AllocateNode();
+  Node& node = GetNode(index);
+  node.task.emplace(std::move(task));
+  const TaggedIndex head = head_.load(std::memory_order_relaxed);
+  DCHECK(GetIndex(head) == kNullIndex ||
+         GetNode(GetIndex(head)).task->enqueue_order() <
+             node.task->enqueue_order());
+  node.next.store(GetIndex(head), std::memory_order_relaxed);
+  size_.fetch_add(1, std::memory_order_relaxed);
+  head_.store(NextHead(head, index), std::memory_order_release);
+  OnPushed(head, index);
+}
+
+void AtomicTaskList::OnPushed(TaggedIndex head, NodeIndex oldest) {
+  if (GetIndex(head) == kNullIndex)
+    front_.store(NextHead(head, oldest), std::memory_order_release);
+}
+
+const Task* AtomicTaskList::Front() const {
+  NodeIndex index = GetIndex(head_.load(std::memory_order_acquire));
+  if (index == kNullIndex)
+    return nullptr;
+  const TaggedIndex front = front_.load(std::memory_order_acquire);
+  if (GetTag(front) == empty_head_tag_ + 1)
+    return &*GetNode(GetIndex(front)).task;
+
+  // The producer which made the list non-empty didn't publish its node yet.
+  for (NodeIndex next = GetNode(index).next.load(std::memory_order_relaxed);
+       next != kNullIndex;
+       next = GetNode(index).next.load(std::memory_order_relaxed)) {
+    index = next;
+  }
+  return &*GetNode(index).task;
+}
+
+AtomicTaskList::Node& AtomicTaskList::GetNode(NodeIndex index) const {
+  DCHECK_NE(index, kNullIndex);
+  // Chunk |i| holds kFirstChunkSize << i nodes, starting at offset
+  // kFirstChunkSize * (2^i - 1).
+  const uint32_t offset = index - 1;
+  const int chunk = bits::Log2Floor(offset / kFirstChunkSize + 1);
+  Node* nodes = chunks_[chunk].load(std::memory_order_acquire);
+  DCHECK(nodes);
+  return nodes[offset - kFirstChunkSize * ((size_t{1} << chunk) - 1)];
+}
+
+AtomicTaskList::NodeIndex AtomicTaskList::AllocateNode() {
+  NodeIndex index = PopFreeNode();
+  if (index != kNullIndex)
+    return index;
+
+  AutoLock auto_lock(grow_lock_);
+  // Another thread may have grown the pool while this one was waiting.
+  index = PopFreeNode();
+  if (index != kNullIndex)
+    return index;
+
+  CHECK_LT(num_chunks_, kMaxChunks);
+  const size_t chunk_size = kFirstChunkSize << num_chunks_;
+  const NodeIndex first = static_cast<NodeIndex>(
+      kFirstChunkSize * ((size_t{1} << num_chunks_) - 1) + 1);
+  Node* nodes = new Node[chunk_size];
+  chunks_[num_chunks_].store(nodes, std::memory_order_release);
+  ++num_chunks_;
+
+  // Keep the first node and make the others available to all threads.
+  for (size_t i = 1; i + 1 < chunk_size; ++i)
+    nodes[i].next.store(first + i + 1, std::memory_order_relaxed);
+  FreeNodes(first + 1, first + chunk_size - 1);
+  return first;
+}
+
+AtomicTaskList::NodeIndex AtomicTaskList::PopFreeNode() {
+  TaggedIndex free_head = free_head_.load(std::memory_order_acquire);
+  while (GetIndex(free_head) != kNullIndex) {
+    // |next| may be stale if another thread popped the node in the meantime,
+    // in which case the tag makes the compare-and-swap fail.
+    const NodeIndex next =
+        GetNode(GetIndex(free_head)).next.load(std::memory_order_relaxed);
+    if (free_head_.compare_exchange_weak(free_head, NextHead(free_head, next),
+                                         std::memory_order_acquire,
+                                         std::memory_order_acquire)) {
+      return GetIndex(free_head);
+    }
+  }
+  return kNullIndex;
+}
+
+void AtomicTaskList::FreeNodes(NodeIndex first, NodeIndex last) {
+  Node& last_node = GetNode(last);
+  TaggedIndex free_head = free_head_.load(std::memory_order_relaxed);
+  do {
+    last_node.next.store(GetIndex(free_head), std::memory_order_relaxed);
+  } while (!free_head_.compare_exchange_weak(free_head,
+                                             NextHead(free_head, first),
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed));
+}
+
+AtomicTaskList::NodeIndex AtomicTaskList::ReverseList(NodeIndex head) {
+  NodeIndex reversed = kNullIndex;
+  while (head != kNullIndex) {
+    Node& node = GetNode(head);
+    const NodeIndex next = node.next.load(std::memory_order_relaxed);
+    node.next.store(reversed, std::memory_order_relaxed);
+    reversed = head;
+    head = next;
+  }
+  return reversed;
+}
+
+}  // namespace internal
+}  // namespace sequence_manager
+}  // namespace base
@@ -0,0 +1,211 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TASK_SEQUENCE_MANAGER_ATOMIC_TASK_LIST_H_
+#define BASE_TASK_SEQUENCE_MANAGER_ATOMIC_TASK_LIST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/synchronization/lock.h"
+#include "base/task/sequence_manager/enqueue_order_generator.h"
+#include "base/task/sequence_manager/tasks.h"
+#include "base/thread_annotations.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+namespace sequence_manager {
+namespace internal {
+
+// A lock-free list of immediate Tasks with multiple producers and a single
+// consumer. Producers push onto the head of a singly linked list with a
+// compare-and-swap; the consumer takes the whole list at once and reverses it
+// into posting order.
+//
+// The enqueue order of a Task is generated inside the compare-and-swap loop,
+// after the producer has observed the head it links to. Hence enqueue orders
+// strictly increase from the oldest to the newest Task in the list, and a Task
+// pushed after TakeAll() gets a higher enqueue order than all the Tasks that
+// TakeAll() returned. This is the same guarantee as generating the enqueue
+// order and pushing under a lock shared with the consumer.
+//
+// This relies on the compare-and-swap failing whenever the head was updated
+// since it was loaded, even if the same node is at the head again after being
+// taken and recycled (the ABA problem). To that end, nodes live in a pool owned
+// by the list and are referred to by index, and the heads of both the list and
+// the pool's free list pack that index with a generation tag which every update
+// increments. The pool also saves an allocation per push: it grows to the
+// largest number of Tasks ever in the list, and is only freed with the list.
+//
+// Push() and PushAll() can be called from any thread. All other methods read
+// nodes or recycle them and must be mutually exclusive, which callers typically
+// ensure with a lock that Push() doesn't need.
+//
+// Size() and Front() are O(1), since callers use them on every post, e.g. to
+// trace the queue size. The list counts its Tasks, and the producer whose push
+// makes the list non-empty publishes its oldest Task, which stays the oldest
+// until the next TakeAll().
+class BASE_EXPORT AtomicTaskList {
+ public:
+  AtomicTaskList();
+  AtomicTaskList(const AtomicTaskList&) = delete;
+  AtomicTaskList& operator=(const AtomicTaskList&) = delete;
+  // Deletes the Tasks left in the list.
+  ~AtomicTaskList();
+
+  // Pushes |task| and assigns it an enqueue order from |generator|. Returns a
+  // pointer to the pushed Task, which remains valid until the next TakeAll(),
+  // and sets |*was_empty| to whether the list was empty before the push.
+  Task* Push(Task task, EnqueueOrderGenerator* generator, bool* was_empty);
+
+  // Pushes all of |tasks|, which must not be empty, with a single
+  // compare-and-swap. Enqueue orders increase along |tasks| and no Task pushed
+  // concurrently is interleaved with them. Sets |*was_empty| to whether the
+  // list was empty before the push.
+  void PushAll(std::vector<Task> tasks,
+               EnqueueOrderGenerator* generator,
+               bool* was_empty);
+
+  // Pushes |task| with the enqueue order it already has, which must be higher
+  // than those of the Tasks in the list. Not thread-safe.
+  void PushForTesting(Task task);
+
+  // Removes all the Tasks from the list and appends them to |tasks| in enqueue
+  // order. Returns true if any Task was appended.
+  template <typename Container>
+  bool TakeAll(Container* tasks) {
+    TaggedIndex head = head_.load(std::memory_order_acquire);
+    do {
+      if (GetIndex(head) == kNullIndex)
+        return false;
+    } while (!head_.compare_exchange_weak(head, NextHead(head, kNullIndex),
+                                          std::memory_order_acquire,
+                                          std::memory_order_acquire));
+    empty_head_tag_ = GetTag(NextHead(head, kNullIndex));
+    const NodeIndex first = ReverseList(GetIndex(head));
+    NodeIndex last = first;
+    size_t num_tasks = 0;
+    for (NodeIndex index = first; index != kNullIndex;) {
+      Node& node = GetNode(index);
+      tasks->push_back(std::move(*node.task));
+      node.task.reset();
+      last = index;
+      index = node.next.load(std::memory_order_relaxed);
+      ++num_tasks;
+    }
+    size_.fetch_sub(num_tasks, std::memory_order_relaxed);
+    FreeNodes(first, last);
+    return true;
+  }
+
+  // Invokes |function| on each Task in enqueue order.
+  template <typename Function>
+  void ForEach(Function function) const {
+    std::vector<const Task*> tasks;
+    for (NodeIndex index = GetIndex(head_.load(std::memory_order_acquire));
+         index != kNullIndex;
+         index = GetNode(index).next.load(std::memory_order_relaxed)) {
+      tasks.push_back(&*GetNode(index).task);
+    }
+    for (auto it = tasks.rbegin(); it != tasks.rend(); ++it)
+      function(**it);
+  }
+
+  // Returns true if the list has no Task. Unlike other accessors, this can be
+  // called from any thread, but the result may be immediately obsolete.
+  bool IsEmpty() const {
+    return GetIndex(head_.load(std::memory_order_relaxed)) == kNullIndex;
+  }
+
+  // Returns the number of Tasks in the list, including those being pushed
+  // concurrently.
+  size_t Size() const { return size_.load(std::memory_order_relaxed); }
+
+  // Returns the oldest Task in the list, or nullptr if it is empty.
+  const Task* Front() const;
+
+ private:
+  // 1-based index of a node in the pool.
+  using NodeIndex = uint32_t;
+  // A NodeIndex in the low 32 bits and a generation tag in the high 32 bits.
+  using TaggedIndex = uint64_t;
+
+  static constexpr NodeIndex kNullIndex = 0;
+  // The pool grows by chunks, each one twice as large as the previous one.
+  static constexpr size_t kFirstChunkSize = 16;
+  static constexpr size_t kMaxChunks = 24;
+
+  struct Node {
+    Node();
+    ~Node();
+
+    absl::optional<Task> task;
+    // Atomic since threads racing to pop a node from the free list read it
+    // while the thread which won may already be writing it.
+    std::atomic<NodeIndex> next{kNullIndex};
+  };
+
+  static NodeIndex GetIndex(TaggedIndex tagged_index) {
+    return static_cast<NodeIndex>(tagged_index);
+  }
+  static uint32_t GetTag(TaggedIndex tagged_index) {
+    return static_cast<uint32_t>(tagged_index >> 32);
+  }
+  // Returns the value to replace |head| with to point to |index|.
+  static TaggedIndex NextHead(TaggedIndex head, NodeIndex index) {
+    const uint32_t tag = GetTag(head) + 1;
+    return (static_cast<TaggedIndex>(tag) << 32) | index;
+  }
+
+  Node& GetNode(NodeIndex index) const;
+
+  // Returns the index of a node from the free list, growing the pool if it is
+  // empty.
+  NodeIndex AllocateNode();
+  // Pops a node from the free list, or returns kNullIndex if it is empty.
+  NodeIndex PopFreeNode();
+  // Pushes the nodes linked from |first| to |last| onto the free list.
+  void FreeNodes(NodeIndex first, NodeIndex last);
+
+  // Reverses the list starting at |head| in place and returns its new head.
+  NodeIndex ReverseList(NodeIndex head);
+
+  // Called after a push of nodes from |oldest| replaced the |head| that the
+  // producer observed.
+  void OnPushed(TaggedIndex head, NodeIndex oldest);
+
+  // Newest Task first.
+  std::atomic<TaggedIndex> head_{kNullIndex};
+
+  // Incremented before a Task is linked, so that TakeAll() never takes a Task
+  // which isn't counted yet.
+  std::atomic<size_t> size_{0};
+
+  // The head that the push which made the list non-empty replaced it with,
+  // i.e. the oldest node tagged with the head's tag right after that push. It
+  // refers to the current oldest node if its tag is |empty_head_tag_| + 1, as
+  // the first update of an empty head is that push. Otherwise, it is stale and
+  // the producer which made the list non-empty is yet to publish its node.
+  std::atomic<TaggedIndex> front_{kNullIndex};
+  // Tag of the empty head written by the last TakeAll().
+  uint32_t empty_head_tag_ = 0;
+  std::atomic<TaggedIndex> free_head_{kNullIndex};
+
+  // Chunks are published before any of their nodes is reachable from the
+  // heads, and are only deleted with the list.
+  std::atomic<Node*> chunks_[kMaxChunks] = {};
+  Lock grow_lock_;
+  size_t num_chunks_ GUARDED_BY(grow_lock_) = 0;
+};
+
+}  // namespace internal
+}  // namespace sequence_manager
+}  // namespace base
+
+#endif  // BASE_TASK_SEQUENCE_MANAGER_ATOMIC_TASK_LIST_H_
@@ -0,0 +1,226 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/sequence_manager/atomic_task_list.h"
+
+#include <memory>
+#include <vector>
+
+#include "base/callback_helpers.h"
+#include "base/task/sequence_manager/enqueue_order_generator.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace sequence_manager {
+namespace internal {
+
+namespace {
+
+Task CreateTask() {
+  return Task(PostedTask(nullptr, DoNothing(), FROM_HERE), TimeTicks(),
+              EnqueueOrder());
+}
+
+class PushingThread : public SimpleThread {
+ public:
+  PushingThread(AtomicTaskList* list,
+                EnqueueOrderGenerator* generator,
+                size_t num_tasks)
+      : SimpleThread("PushingThread"),
+        list_(list),
+        generator_(generator),
+        num_tasks_(num_tasks) {}
+
+  void Run() override {
+    bool was_empty;
+    for (size_t i = 0; i < num_tasks_; ++i)
+      list_->Push(CreateTask(), generator_, &was_empty);
+  }
+
+ private:
+  AtomicTaskList* const list_;
+  EnqueueOrderGenerator* const generator_;
+  const size_t num_tasks_;
+};
+
+}  // namespace
+
+TEST(AtomicTaskListTest, PushAndTakeAll) {
+  AtomicTaskList list;
+  EnqueueOrderGenerator generator;
+  EXPECT_TRUE(list.IsEmpty());
+  EXPECT_EQ(nullptr, list.Front());
+
+  bool was_empty = false;
+  Task* first_task = list.Push(CreateTask(), &generator, &was_empty);
+  EXPECT_TRUE(was_empty);
+  list.Push(CreateTask(), &generator, &was_empty);
+  EXPECT_FALSE(was_empty);
+  Task* last_task = list.Push(CreateTask(), &generator, &was_empty);
+  EXPECT_FALSE(was_empty);
+
+  EXPECT_FALSE(list.IsEmpty());
+  EXPECT_EQ(3u, list.Size());
+  EXPECT_EQ(first_task, list.Front());
+  EXPECT_LT(first_task->enqueue_order(), last_task->enqueue_order());
+
+  std::vector<EnqueueOrder> enqueue_orders;
+  list.ForEach([&](const Task& task) {
+    enqueue_orders.push_back(task.enqueue_order());
+  });
+
+  std::vector<Task> tasks;
+  EXPECT_TRUE(list.TakeAll(&tasks));
+  EXPECT_TRUE(list.IsEmpty());
+  EXPECT_FALSE(list.TakeAll(&tasks));
+  ASSERT_EQ(3u, tasks.size());
+  ASSERT_EQ(3u, enqueue_orders.size());
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    EXPECT_EQ(enqueue_orders[i], tasks[i].enqueue_order());
+    if (i > 0)
+      EXPECT_LT(tasks[i - 1].enqueue_order(), tasks[i].enqueue_order());
+  }
+
+  list.Push(CreateTask(), &generator, &was_empty);
+  EXPECT_TRUE(was_empty);
+}
+
+TEST(AtomicTaskListTest, PushAll) {
+  AtomicTaskList list;
+  EnqueueOrderGenerator generator;
+  bool was_empty = false;
+  const Task* first_task = list.Push(CreateTask(), &generator, &was_empty);
+
+  std::vector<Task> batch;
+  for (size_t i = 0; i < 3; ++i)
+    batch.push_back(CreateTask());
+  list.PushAll(std::move(batch), &generator, &was_empty);
+  EXPECT_FALSE(was_empty);
+  EXPECT_EQ(4u, list.Size());
+  EXPECT_EQ(first_task, list.Front());
+
+  std::vector<Task> tasks;
+  list.TakeAll(&tasks);
+  ASSERT_EQ(4u, tasks.size());
+  for (size_t i = 1; i < tasks.size(); ++i)
+    EXPECT_LT(tasks[i - 1].enqueue_order(), tasks[i].enqueue_order());
+
+  batch.clear();
+  batch.push_back(CreateTask());
+  list.PushAll(std::move(batch), &generator, &was_empty);
+  EXPECT_TRUE(was_empty);
+}
+
+// Size() and Front() follow the list across TakeAll() calls.
+TEST(AtomicTaskListTest, SizeAndFrontAfterTakeAll) {
+  AtomicTaskList list;
+  EnqueueOrderGenerator generator;
+  bool was_empty;
+  list.Push(CreateTask(), &generator, &was_empty);
+  list.Push(CreateTask(), &generator, &was_empty);
+
+  std::vector<Task> tasks;
+  list.TakeAll(&tasks);
+  EXPECT_EQ(0u, list.Size());
+  EXPECT_EQ(nullptr, list.Front());
+
+  std::vector<Task> batch;
+  batch.push_back(CreateTask());
+  batch.push_back(CreateTask());
+  list.PushAll(std::move(batch), &generator, &was_empty);
+  EXPECT_TRUE(was_empty);
+  list.Push(CreateTask(), &generator, &was_empty);
+  EXPECT_EQ(3u, list.Size());
+  ASSERT_TRUE(list.Front());
+  EXPECT_LT(tasks.back().enqueue_order(), list.Front()->enqueue_order());
+
+  std::vector<EnqueueOrder> enqueue_orders;
+  list.ForEach([&](const Task& task) {
+    enqueue_orders.push_back(task.enqueue_order());
+  });
+  EXPECT_EQ(enqueue_orders.front(), list.Front()->enqueue_order());
+}
+
+TEST(AtomicTaskListTest, PushForTesting) {
+  AtomicTaskList list;
+  list.PushForTesting(Task(PostedTask(nullptr, DoNothing(), FROM_HERE),
+                           TimeTicks(), EnqueueOrder(),
+                           EnqueueOrder::FromIntForTesting(2)));
+  list.PushForTesting(Task(PostedTask(nullptr, DoNothing(), FROM_HERE),
+                           TimeTicks(), EnqueueOrder(),
+                           EnqueueOrder::FromIntForTesting(3)));
+  EXPECT_EQ(2u, list.Front()->enqueue_order());
+
+  std::vector<Task> tasks;
+  list.TakeAll(&tasks);
+  ASSERT_EQ(2u, tasks.size());
+  EXPECT_EQ(2u, tasks[0].enqueue_order());
+  EXPECT_EQ(3u, tasks[1].enqueue_order());
+}
+
+// Nodes are recycled after TakeAll() rather than allocated for each push.
+TEST(AtomicTaskListTest, ReusesNodes) {
+  AtomicTaskList list;
+  EnqueueOrderGenerator generator;
+  bool was_empty;
+  const Task* task = list.Push(CreateTask(), &generator, &was_empty);
+
+  std::vector<Task> tasks;
+  list.TakeAll(&tasks);
+  EXPECT_EQ(task, list.Push(CreateTask(), &generator, &was_empty));
+}
+
+// The node pool grows to hold more Tasks than fit in its first chunk.
+TEST(AtomicTaskListTest, GrowsPool) {
+  constexpr size_t kNumTasks = 1000;
+  AtomicTaskList list;
+  EnqueueOrderGenerator generator;
+  bool was_empty;
+  for (size_t i = 0; i < kNumTasks; ++i)
+    list.Push(CreateTask(), &generator, &was_empty);
+  EXPECT_EQ(kNumTasks, list.Size());
+
+  std::vector<Task> tasks;
+  list.TakeAll(&tasks);
+  ASSERT_EQ(kNumTasks, tasks.size());
+  for (size_t i = 1; i < tasks.size(); ++i)
+    EXPECT_LT(tasks[i - 1].enqueue_order(), tasks[i].enqueue_order());
+}
+
+// Enqueue orders must strictly increase across all the batches taken while
+// several threads are pushing.
+TEST(AtomicTaskListTest, ConcurrentPushes) {
+  constexpr size_t kNumThreads = 8;
+  constexpr size_t kNumTasksPerThread = 10000;
+  AtomicTaskList list;
+  EnqueueOrderGenerator generator;
+
+  std::vector<std::unique_ptr<PushingThread>> threads;
+  for (size_t i = 0; i < kNumThreads; ++i) {
+    threads.push_back(
+        std::make_unique<PushingThread>(&list, &generator, kNumTasksPerThread));
+    threads.back()->Start();
+  }
+
+  size_t num_tasks = 0;
+  EnqueueOrder last_enqueue_order;
+  while (num_tasks < kNumThreads * kNumTasksPerThread) {
+    std::vector<Task> tasks;
+    list.TakeAll(&tasks);
+    for (const Task& task : tasks) {
+      EXPECT_LT(last_enqueue_order, task.enqueue_order());
+      last_enqueue_order = task.enqueue_order();
+    }
+    num_tasks += tasks.size();
+  }
+
+  for (auto& thread : threads)
+    thread->Join();
+  EXPECT_TRUE(list.IsEmpty());
+}
+
+}  // namespace internal
+}  // namespace sequence_manager
+}  // namespace base
@@ -301,6 +301,11 @@ std::unique_ptr<SequenceManagerImpl> SequenceManagerImpl::CreateUnbound(
                                             std::move(settings)));
 }
 
+// static
+void SequenceManagerImpl::InitializeFeatures() {
+  TaskQueueImpl::InitializeFeatures();
+}
+
 void SequenceManagerImpl::BindToMessagePump(std::unique_ptr<MessagePump> pump) {
   controller_->BindToCurrentThread(std::move(pump));
   CompleteInitializationOnBoundThread();
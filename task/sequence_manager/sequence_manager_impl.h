@@ -98,6 +98,12 @@ class BASE_EXPORT SequenceManagerImpl
   static std::unique_ptr<SequenceManagerImpl> CreateUnbound(
       SequenceManager::Settings settings);
 
+  // Initializes the state of the features used by SequenceManager. Must be
+  // called once FeatureList is initialized, by the embedder. Queues created
+  // earlier, like those of the main thread, pick up the new state the next
+  // time they are empty.
+  static void InitializeFeatures();
+
   // SequenceManager implementation:
   void BindToCurrentThread() override;
   scoped_refptr<SequencedTaskRunner> GetTaskRunnerForCurrentTask() override;
@@ -41,9 +41,11 @@
 #include "base/task/sequence_manager/thread_controller_with_message_pump_impl.h"
 #include "base/task/sequence_manager/work_queue.h"
 #include "base/task/sequence_manager/work_queue_sets.h"
+#include "base/task/task_features.h"
 #include "base/test/bind.h"
 #include "base/test/mock_callback.h"
 #include "base/test/null_task_runner.h"
+#include "base/test/scoped_feature_list.h"
 #include "base/test/simple_test_tick_clock.h"
 #include "base/test/task_environment.h"
 #include "base/test/test_mock_time_task_runner.h"
@@ -568,6 +570,38 @@ TEST_P(SequenceManagerTest, MultiQueuePosting) {
   EXPECT_THAT(run_order, ElementsAre(1u, 2u, 3u, 4u, 5u, 6u));
 }
 
+TEST_P(SequenceManagerTest, SingleQueueBatchPosting) {
+  auto queue = CreateTaskQueue();
+
+  std::vector<EnqueueOrder> run_order;
+  queue->task_runner()->PostTask(FROM_HERE, BindOnce(&TestTask, 1, &run_order));
+  std::vector<OnceClosure> tasks;
+  tasks.push_back(BindOnce(&TestTask, 2, &run_order));
+  tasks.push_back(BindOnce(&TestTask, 3, &run_order));
+  tasks.push_back(BindOnce(&TestTask, 4, &run_order));
+  EXPECT_TRUE(queue->task_runner()->PostTasks(FROM_HERE, tasks));
+  queue->task_runner()->PostTask(FROM_HERE, BindOnce(&TestTask, 5, &run_order));
+
+  RunLoop().RunUntilIdle();
+  EXPECT_THAT(run_order, ElementsAre(1u, 2u, 3u, 4u, 5u));
+}
+
+// Same as above, on the path which pushes tasks under the queue's lock.
+TEST_P(SequenceManagerTest, SingleQueueBatchPostingWithQueueTime) {
+  sequence_manager()->SetAddQueueTimeToTasks(true);
+  auto queue = CreateTaskQueue();
+
+  std::vector<EnqueueOrder> run_order;
+  std::vector<OnceClosure> tasks;
+  tasks.push_back(BindOnce(&TestTask, 1, &run_order));
+  tasks.push_back(BindOnce(&TestTask, 2, &run_order));
+  EXPECT_TRUE(queue->task_runner()->PostTasks(FROM_HERE, tasks));
+  queue->task_runner()->PostTask(FROM_HERE, BindOnce(&TestTask, 3, &run_order));
+
+  RunLoop().RunUntilIdle();
+  EXPECT_THAT(run_order, ElementsAre(1u, 2u, 3u));
+}
+
 TEST_P(SequenceManagerTest, NonNestableTaskPosting) {
   auto queue = CreateTaskQueue();
 
@@ -2705,6 +2739,52 @@ TEST_P(SequenceManagerTest, CancelledTaskPostAnother) {
   EXPECT_TRUE(did_post);
 }
 
+TEST_P(SequenceManagerTest, DelayedTasksInTimerWheel) {
+  // Like the queues of the main thread, |queue| is created before the features
+  // are initialized. It switches to the wheel with its first delayed task, and
+  // keeps it once the feature is reset.
+  scoped_refptr<TestTaskQueue> queue = CreateTaskQueue();
+  std::vector<EnqueueOrder> run_order;
+  {
+    base::test::ScopedFeatureList feature_list(kUseTimerWheelForDelayedTasks);
+    SequenceManagerImpl::InitializeFeatures();
+    queue->task_runner()->PostDelayedTask(FROM_HERE,
+                                          BindOnce(&TestTask, 1, &run_order),
+                                          TimeDelta::FromMilliseconds(10));
+  }
+  SequenceManagerImpl::InitializeFeatures();
+
+  queue->task_runner()->PostDelayedTask(FROM_HERE,
+                                        BindOnce(&TestTask, 2, &run_order),
+                                        TimeDelta::FromMilliseconds(5));
+  queue->task_runner()->PostDelayedTask(FROM_HERE,
+                                        BindOnce(&TestTask, 3, &run_order),
+                                        TimeDelta::FromMilliseconds(5));
+  queue->task_runner()->PostDelayedTask(FROM_HERE,
+                                        BindOnce(&TestTask, 4, &run_order),
+                                        TimeDelta::FromHours(1));
+  CancelableTask task(mock_tick_clock());
+  queue->task_runner()->PostDelayedTask(
+      FROM_HERE,
+      BindOnce(&CancelableTask::FailTask<>, task.weak_factory_.GetWeakPtr()),
+      TimeDelta::FromMilliseconds(1));
+  EXPECT_EQ(5u, queue->GetNumberOfPendingTasks());
+  EXPECT_EQ(TimeDelta::FromMilliseconds(1), NextPendingTaskDelay());
+
+  // Sweeping the canceled task updates the next wake-up.
+  task.weak_factory_.InvalidateWeakPtrs();
+  sequence_manager()->ReclaimMemory();
+  EXPECT_EQ(4u, queue->GetNumberOfPendingTasks());
+  EXPECT_EQ(TimeDelta::FromMilliseconds(5), NextPendingTaskDelay());
+
+  FastForwardBy(TimeDelta::FromMilliseconds(5));
+  EXPECT_THAT(run_order, ElementsAre(2u, 3u));
+  EXPECT_EQ(TimeDelta::FromMilliseconds(5), NextPendingTaskDelay());
+
+  FastForwardBy(TimeDelta::FromHours(1));
+  EXPECT_THAT(run_order, ElementsAre(2u, 3u, 1u, 4u));
+}
+
 TEST_P(SequenceManagerTest, CancelledImmediateTaskShutsDownQueue) {
   // This check ensures that an immediate task whose destruction causes the
   // owning task queue to be shut down doesn't cause us to access freed memory.
@@ -14,6 +14,7 @@
 #include "base/run_loop.h"
 #include "base/sequence_checker.h"
 #include "base/single_thread_task_runner.h"
+#include "base/strings/stringprintf.h"
 #include "base/synchronization/condition_variable.h"
 #include "base/task/post_task.h"
 #include "base/task/sequence_manager/task_queue_impl.h"
@@ -543,6 +544,72 @@ class TwoThreadTestCase : public TestCase {
   int done_count_ = 0;
 };
 
+// Many threads post immediate tasks concurrently and the main thread runs them.
+class ManyThreadTestCase : public TestCase {
+ public:
+  ManyThreadTestCase(PerfTestDelegate* delegate,
+                     std::vector<scoped_refptr<TaskRunner>> task_runners,
+                     size_t num_posting_threads)
+      : TestCase(delegate), task_runners_(std::move(task_runners)) {
+    for (size_t i = 0; i < num_posting_threads; i++) {
+      posting_threads_.push_back(
+          std::make_unique<Thread>(StringPrintf("posting thread %zu", i)));
+      posting_threads_.back()->Start();
+    }
+  }
+
+  ~ManyThreadTestCase() override {
+    for (auto& thread : posting_threads_)
+      thread->Stop();
+  }
+
+ protected:
+  void Start() override {
+    done_count_ = 0;
+    task_sources_.clear();
+    const size_t num_tasks_per_thread = kNumTasks / posting_threads_.size();
+    for (auto& thread : posting_threads_) {
+      task_sources_.push_back(std::make_unique<CrossThreadImmediateTaskSource>(
+          this, task_runners_, num_tasks_per_thread));
+      thread->task_runner()->PostTask(
+          FROM_HERE, BindOnce(&CrossThreadImmediateTaskSource::Start,
+                              Unretained(task_sources_.back().get())));
+    }
+  }
+
+  class CrossThreadImmediateTaskSource : public CrossThreadTaskSource {
+   public:
+    CrossThreadImmediateTaskSource(
+        ManyThreadTestCase* many_thread_test_case,
+        std::vector<scoped_refptr<TaskRunner>> task_runners,
+        size_t num_tasks)
+        : CrossThreadTaskSource(std::move(task_runners), num_tasks),
+          many_thread_test_case_(many_thread_test_case) {}
+
+    ~CrossThreadImmediateTaskSource() override = default;
+
+    void PostTask(unsigned int queue) override {
+      task_runners_[queue]->PostTask(FROM_HERE, task_closure_);
+    }
+
+    // Will be called on the main thread.
+    void SignalDone() override { many_thread_test_case_->SignalDone(); }
+
+    ManyThreadTestCase* many_thread_test_case_;  // NOT OWNED.
+  };
+
+  void SignalDone() {
+    if (++done_count_ == posting_threads_.size())
+      delegate_->SignalDone();
+  }
+
+ private:
+  const std::vector<scoped_refptr<TaskRunner>> task_runners_;
+  std::vector<std::unique_ptr<Thread>> posting_threads_;
+  std::vector<std::unique_ptr<CrossThreadImmediateTaskSource>> task_sources_;
+  size_t done_count_ = 0;
+};
+
 class SequenceManagerPerfTest : public testing::TestWithParam<PerfTestType> {
  public:
   SequenceManagerPerfTest() = default;
@@ -703,6 +770,33 @@ TEST_P(SequenceManagerPerfTest, PostImmediateTasks_ThirtyTwoQueues) {
   Benchmark("post immediate tasks with thirty two queues", &task_source);
 }
 
+// The next two tests measure how the cost of selecting a queue scales with the
+// number of queues.
+TEST_P(SequenceManagerPerfTest,
+       PostImmediateTasks_OneHundredTwentyEightQueues) {
+  if (!ShouldMeasureQueueScaling()) {
+    LOG(INFO) << "Unsupported";
+    return;
+  }
+
+  SingleThreadImmediateTestCase task_source(delegate_.get(),
+                                            CreateTaskRunners(128));
+  Benchmark("post immediate tasks with one hundred twenty eight queues",
+            &task_source);
+}
+
+TEST_P(SequenceManagerPerfTest, PostImmediateTasks_FiveHundredTwelveQueues) {
+  if (!ShouldMeasureQueueScaling()) {
+    LOG(INFO) << "Unsupported";
+    return;
+  }
+
+  SingleThreadImmediateTestCase task_source(delegate_.get(),
+                                            CreateTaskRunners(512));
+  Benchmark("post immediate tasks with five hundred twelve queues",
+            &task_source);
+}
+
 TEST_P(SequenceManagerPerfTest, PostImmediateTasksFromTwoThreads_OneQueue) {
   TwoThreadTestCase task_source(delegate_.get(), CreateTaskRunners(1));
   Benchmark("post immediate tasks with one queue from two threads",
@@ -743,6 +837,31 @@ TEST_P(SequenceManagerPerfTest,
             &task_source);
 }
 
+TEST_P(SequenceManagerPerfTest, PostImmediateTasksFromEightThreads_OneQueue) {
+  ManyThreadTestCase task_source(delegate_.get(), CreateTaskRunners(1), 8);
+  Benchmark("post immediate tasks with one queue from eight threads",
+            &task_source);
+}
+
+TEST_P(SequenceManagerPerfTest,
+       PostImmediateTasksFromThirtyTwoThreads_OneQueue) {
+  ManyThreadTestCase task_source(delegate_.get(), CreateTaskRunners(1), 32);
+  Benchmark("post immediate tasks with one queue from thirty two threads",
+            &task_source);
+}
+
+TEST_P(SequenceManagerPerfTest,
+       PostImmediateTasksFromThirtyTwoThreads_FourQueues) {
+  if (!ShouldMeasureQueueScaling()) {
+    LOG(INFO) << "Unsupported";
+    return;
+  }
+
+  ManyThreadTestCase task_source(delegate_.get(), CreateTaskRunners(4), 32);
+  Benchmark("post immediate tasks with four queues from thirty two threads",
+            &task_source);
+}
+
 // TODO(alexclarke): Add additional tests with different mixes of non-delayed vs
 // delayed tasks.
 
@@ -8,15 +8,19 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "base/containers/stack_container.h"
+#include "base/feature_list.h"
 #include "base/logging.h"
 #include "base/ranges/algorithm.h"
 #include "base/strings/stringprintf.h"
+#include "base/task/common/delayed_task_leeway.h"
 #include "base/task/common/scoped_defer_task_posting.h"
 #include "base/task/sequence_manager/sequence_manager_impl.h"
 #include "base/task/sequence_manager/time_domain.h"
 #include "base/task/sequence_manager/work_queue.h"
+#include "base/task/task_features.h"
 #include "base/task/task_observer.h"
 #include "base/threading/thread_restrictions.h"
 #include "base/time/time.h"
@@ -52,6 +56,13 @@ const char* TaskQueue::PriorityToString(TaskQueue::QueuePriority priority) {
 
 namespace internal {
 
+namespace {
+
+// Whether DelayedIncomingQueues use a timer wheel. Set by InitializeFeatures().
+std::atomic_bool g_use_timer_wheel_for_delayed_tasks{false};
+
+}  // namespace
+
 TaskQueueImpl::GuardedTaskPoster::GuardedTaskPoster(TaskQueueImpl* outer)
     : outer_(outer) {}
 
@@ -70,6 +81,19 @@ bool TaskQueueImpl::GuardedTaskPoster::PostTask(PostedTask task) {
   return true;
 }
 
+bool TaskQueueImpl::GuardedTaskPoster::PostTasks(
+    std::vector<PostedTask> tasks) {
+  // See PostTask().
+  ScopedDeferTaskPosting disallow_task_posting;
+
+  auto token = operations_controller_.TryBeginOperation();
+  if (!token)
+    return false;
+
+  outer_->PostTasks(std::move(tasks));
+  return true;
+}
+
 TaskQueueImpl::TaskRunner::TaskRunner(
     scoped_refptr<GuardedTaskPoster> task_poster,
     scoped_refptr<AssociatedThreadId> associated_thread,
@@ -88,6 +112,16 @@ bool TaskQueueImpl::TaskRunner::PostDelayedTask(const Location& location,
                                            task_type_));
 }
 
+bool TaskQueueImpl::TaskRunner::PostDelayedTaskWithLeeway(
+    const Location& location,
+    OnceClosure callback,
+    TimeDelta delay,
+    TimeDelta leeway) {
+  return task_poster_->PostTask(PostedTask(this, std::move(callback), location,
+                                           delay, Nestable::kNestable,
+                                           task_type_, leeway));
+}
+
 bool TaskQueueImpl::TaskRunner::PostNonNestableDelayedTask(
     const Location& location,
     OnceClosure callback,
@@ -97,6 +131,17 @@ bool TaskQueueImpl::TaskRunner::PostNonNestableDelayedTask(
                                            task_type_));
 }
 
+bool TaskQueueImpl::TaskRunner::PostTasks(const Location& location,
+                                          span<OnceClosure> tasks) {
+  std::vector<PostedTask> posted_tasks;
+  posted_tasks.reserve(tasks.size());
+  for (OnceClosure& callback : tasks) {
+    posted_tasks.emplace_back(this, std::move(callback), location, TimeDelta(),
+                              Nestable::kNestable, task_type_);
+  }
+  return task_poster_->PostTasks(std::move(posted_tasks));
+}
+
 bool TaskQueueImpl::TaskRunner::RunsTasksInCurrentSequence() const {
   return associated_thread_->IsBoundToCurrentThread();
 }
@@ -158,6 +203,13 @@ TaskQueueImpl::MainThreadOnly::MainThreadOnly(TaskQueueImpl* task_queue,
 
 TaskQueueImpl::MainThreadOnly::~MainThreadOnly() = default;
 
+// static
+void TaskQueueImpl::InitializeFeatures() {
+  g_use_timer_wheel_for_delayed_tasks.store(
+      FeatureList::IsEnabled(kUseTimerWheelForDelayedTasks),
+      std::memory_order_relaxed);
+}
+
 scoped_refptr<SingleThreadTaskRunner> TaskQueueImpl::CreateTaskRunner(
     TaskType task_type) const {
   return MakeRefCounted<TaskRunner>(task_poster_, associated_thread_,
@@ -178,7 +230,7 @@ void TaskQueueImpl::UnregisterTaskQueue() {
     base::internal::CheckedAutoLock lock(any_thread_lock_);
     any_thread_.unregistered = true;
     any_thread_.time_domain = nullptr;
-    immediate_incoming_queue.swap(any_thread_.immediate_incoming_queue);
+    immediate_incoming_queue_.TakeAll(&immediate_incoming_queue);
   }
 
   if (main_thread_only().time_domain)
@@ -231,6 +283,35 @@ void TaskQueueImpl::PostTask(PostedTask task) {
   }
 }
 
+void TaskQueueImpl::PostTasks(std::vector<PostedTask> tasks) {
+  if (tasks.empty())
+    return;
+
+  CurrentThread current_thread =
+      associated_thread_->IsBoundToCurrentThread()
+          ? TaskQueueImpl::CurrentThread::kMainThread
+          : TaskQueueImpl::CurrentThread::kNotMainThread;
+
+#if DCHECK_IS_ON()
+  // Tasks which were given a delay for testing are posted individually.
+  std::vector<PostedTask> immediate_tasks;
+  immediate_tasks.reserve(tasks.size());
+  for (PostedTask& task : tasks) {
+    MaybeLogPostTask(&task);
+    MaybeAdjustTaskDelay(&task, current_thread);
+    if (task.delay.is_zero())
+      immediate_tasks.push_back(std::move(task));
+    else
+      PostDelayedTaskImpl(std::move(task), current_thread);
+  }
+  tasks = std::move(immediate_tasks);
+  if (tasks.empty())
+    return;
+#endif  // DCHECK_IS_ON()
+
+  PostImmediateTasksImpl(std::move(tasks), current_thread);
+}
+
 void TaskQueueImpl::MaybeLogPostTask(PostedTask* task) {
 #if DCHECK_IS_ON()
   if (!sequence_manager_->settings().log_post_task)
@@ -266,51 +347,38 @@ void TaskQueueImpl::PostImmediateTaskImpl(PostedTask task,
   CHECK(task.callback);
 
   bool should_schedule_work = false;
-  {
-    // TODO(alexclarke): Maybe add a main thread only immediate_incoming_queue
-    // See https://crbug.com/901800
-    base::internal::CheckedAutoLock lock(any_thread_lock_);
-    LazyNow lazy_now = any_thread_.time_domain->CreateLazyNow();
-    bool add_queue_time_to_tasks = sequence_manager_->GetAddQueueTimeToTasks();
-    if (add_queue_time_to_tasks || delayed_fence_allowed_)
-      task.queue_time = lazy_now.Now();
-
-    // The sequence number must be incremented atomically with pushing onto the
-    // incoming queue. Otherwise if there are several threads posting task we
-    // risk breaking the assumption that sequence numbers increase monotonically
-    // within a queue.
-    EnqueueOrder sequence_number = sequence_manager_->GetNextSequenceNumber();
-    bool was_immediate_incoming_queue_empty =
-        any_thread_.immediate_incoming_queue.empty();
-    // Delayed run time is null for an immediate task.
-    base::TimeTicks delayed_run_time;
-    any_thread_.immediate_incoming_queue.push_back(Task(
-        std::move(task), delayed_run_time, sequence_number, sequence_number));
-
+  if (CanPostImmediateTaskLockFree()) {
+    // Lock-free fast path. Delayed run time is null for an immediate task and
+    // the enqueue order is assigned by |immediate_incoming_queue_|.
+    Task pending_task(std::move(task), TimeTicks(),
+                      sequence_manager_->GetNextSequenceNumber());
 #if DCHECK_IS_ON()
-    any_thread_.immediate_incoming_queue.back().cross_thread_ =
+    pending_task.cross_thread_ =
         (current_thread == TaskQueueImpl::CurrentThread::kNotMainThread);
 #endif
+    sequence_manager_->WillQueueTask(&pending_task, name_);
+    MaybeReportIpcTaskQueuedFromAnyThreadUnlocked(&pending_task, name_);
 
-    sequence_manager_->WillQueueTask(
-        &any_thread_.immediate_incoming_queue.back(), name_);
-    MaybeReportIpcTaskQueuedFromAnyThreadLocked(
-        &any_thread_.immediate_incoming_queue.back(), name_);
-    if (!any_thread_.on_task_posted_handler.is_null()) {
-      any_thread_.on_task_posted_handler.Run(
-          any_thread_.immediate_incoming_queue.back());
-    }
+    bool was_immediate_incoming_queue_empty;
+    immediate_incoming_queue_.Push(std::move(pending_task),
+                                   &sequence_manager_->enqueue_order_generator_,
+                                   &was_immediate_incoming_queue_empty);
 
-    // If this queue was completely empty, then the SequenceManager needs to be
-    // informed so it can reload the work queue and add us to the
-    // TaskQueueSelector which can only be done from the main thread. In
-    // addition it may need to schedule a DoWork if this queue isn't blocked.
-    if (was_immediate_incoming_queue_empty &&
-        any_thread_.immediate_work_queue_empty) {
-      empty_queues_to_reload_handle_.SetActive(true);
-      should_schedule_work =
-          any_thread_.post_immediate_task_should_schedule_work;
+    // Only the post which made |immediate_incoming_queue_| non-empty needs to
+    // check whether the SequenceManager must be informed. If the main thread
+    // took the task in the meantime, |immediate_work_queue_empty| is false.
+    if (was_immediate_incoming_queue_empty) {
+      base::internal::CheckedAutoLock lock(any_thread_lock_);
+      should_schedule_work = OnImmediateIncomingQueueBecameNonEmptyLocked();
     }
+  } else {
+    // Reading the time domain and running |on_task_posted_handler| require
+    // |any_thread_lock_|. Holding it while pushing also keeps queue times and
+    // handler invocations in enqueue order.
+    base::internal::CheckedAutoLock lock(any_thread_lock_);
+    LazyNow lazy_now = any_thread_.time_domain->CreateLazyNow();
+    should_schedule_work = PushOntoImmediateIncomingQueueLocked(
+        std::move(task), current_thread, &lazy_now);
   }
 
   // On windows it's important to call this outside of a lock because calling a
@@ -330,6 +398,106 @@ void TaskQueueImpl::PostImmediateTaskImpl(PostedTask task,
   TraceQueueSize();
 }
 
+void TaskQueueImpl::PostImmediateTasksImpl(std::vector<PostedTask> tasks,
+                                           CurrentThread current_thread) {
+  DCHECK(!tasks.empty());
+
+  bool should_schedule_work = false;
+  if (CanPostImmediateTaskLockFree()) {
+    // Lock-free fast path. All the tasks are linked into
+    // |immediate_incoming_queue_| at once, so that tasks posted concurrently
+    // can't be interleaved with them.
+    std::vector<Task> pending_tasks;
+    pending_tasks.reserve(tasks.size());
+    for (PostedTask& task : tasks) {
+      // Use CHECK instead of DCHECK to crash earlier. See
+      // http://crbug.com/711167 for details.
+      CHECK(task.callback);
+      pending_tasks.emplace_back(std::move(task), TimeTicks(),
+                                 sequence_manager_->GetNextSequenceNumber());
+      Task& pending_task = pending_tasks.back();
+#if DCHECK_IS_ON()
+      pending_task.cross_thread_ =
+          (current_thread == TaskQueueImpl::CurrentThread::kNotMainThread);
+#endif
+      sequence_manager_->WillQueueTask(&pending_task, name_);
+      MaybeReportIpcTaskQueuedFromAnyThreadUnlocked(&pending_task, name_);
+    }
+
+    bool was_immediate_incoming_queue_empty;
+    immediate_incoming_queue_.PushAll(
+        std::move(pending_tasks), &sequence_manager_->enqueue_order_generator_,
+        &was_immediate_incoming_queue_empty);
+    if (was_immediate_incoming_queue_empty) {
+      base::internal::CheckedAutoLock lock(any_thread_lock_);
+      should_schedule_work = OnImmediateIncomingQueueBecameNonEmptyLocked();
+    }
+  } else {
+    base::internal::CheckedAutoLock lock(any_thread_lock_);
+    LazyNow lazy_now = any_thread_.time_domain->CreateLazyNow();
+    for (PostedTask& task : tasks) {
+      CHECK(task.callback);
+      should_schedule_work |= PushOntoImmediateIncomingQueueLocked(
+          std::move(task), current_thread, &lazy_now);
+    }
+  }
+
+  // See PostImmediateTaskImpl() for why this is called outside the lock.
+  if (should_schedule_work)
+    sequence_manager_->ScheduleWork();
+
+  TraceQueueSize();
+}
+
+bool TaskQueueImpl::CanPostImmediateTaskLockFree() const {
+  return !delayed_fence_allowed_ &&
+         !sequence_manager_->GetAddQueueTimeToTasks() &&
+         !has_on_task_posted_handler_.load(std::memory_order_relaxed);
+}
+
+bool TaskQueueImpl::PushOntoImmediateIncomingQueueLocked(
+    PostedTask task,
+    CurrentThread current_thread,
+    LazyNow* lazy_now) {
+  bool add_queue_time_to_tasks = sequence_manager_->GetAddQueueTimeToTasks();
+  if (add_queue_time_to_tasks || delayed_fence_allowed_)
+    task.queue_time = lazy_now->Now();
+
+  // Delayed run time is null for an immediate task.
+  Task pending_task(std::move(task), TimeTicks(),
+                    sequence_manager_->GetNextSequenceNumber());
+#if DCHECK_IS_ON()
+  pending_task.cross_thread_ =
+      (current_thread == TaskQueueImpl::CurrentThread::kNotMainThread);
+#endif
+  sequence_manager_->WillQueueTask(&pending_task, name_);
+  MaybeReportIpcTaskQueuedFromAnyThreadLocked(&pending_task, name_);
+
+  bool was_immediate_incoming_queue_empty;
+  // |queued_task| can't be taken from |immediate_incoming_queue_| while
+  // |any_thread_lock_| is held.
+  const Task* queued_task = immediate_incoming_queue_.Push(
+      std::move(pending_task), &sequence_manager_->enqueue_order_generator_,
+      &was_immediate_incoming_queue_empty);
+  if (!any_thread_.on_task_posted_handler.is_null())
+    any_thread_.on_task_posted_handler.Run(*queued_task);
+
+  if (!was_immediate_incoming_queue_empty)
+    return false;
+  return OnImmediateIncomingQueueBecameNonEmptyLocked();
+}
+
+bool TaskQueueImpl::OnImmediateIncomingQueueBecameNonEmptyLocked() {
+  // If this queue was completely empty, then the SequenceManager needs to be
+  // informed so it can reload the work queue and add us to the
+  // TaskQueueSelector which can only be done from the main thread. In
+  // addition it may need to schedule a DoWork if this queue isn't blocked.
+  if (!any_thread_.immediate_work_queue_empty)
+    return false;
+  empty_queues_to_reload_handle_.SetActive(true);
+  return any_thread_.post_immediate_task_should_schedule_work;
+}
+
 void TaskQueueImpl::PostDelayedTaskImpl(PostedTask posted_task,
                                         CurrentThread current_thread) {
   // Use CHECK instead of DCHECK to crash earlier. See http://crbug.com/711167
@@ -342,10 +510,14 @@ void TaskQueueImpl::PostDelayedTaskImpl(PostedTask posted_task,
   // We consider the task needs a high resolution timer if the delay is more
   // than 0 and less than 32ms. This caps the relative error to less than 50% :
   // a 33ms wait can wake at 48ms since the default resolution on Windows is
-  // between 10 and 15ms.
+  // between 10 and 15ms. Tasks which tolerate running late by more than the
+  // default resolution don't need a high resolution timer.
   if (posted_task.delay.InMilliseconds() <
-      (2 * Time::kMinLowResolutionThresholdMs))
+          (2 * Time::kMinLowResolutionThresholdMs) &&
+      posted_task.leeway.InMilliseconds() <
+          Time::kMinLowResolutionThresholdMs) {
     resolution = WakeUpResolution::kHigh;
+  }
 #endif  // defined(OS_WIN)
 
   if (current_thread == CurrentThread::kMainThread) {
@@ -354,7 +526,8 @@ void TaskQueueImpl::PostDelayedTaskImpl(PostedTask posted_task,
 
     TimeTicks time_domain_now = main_thread_only().time_domain->Now();
     TimeTicks time_domain_delayed_run_time =
-        time_domain_now + posted_task.delay;
+        base::internal::AlignDelayedRunTime(time_domain_now + posted_task.delay,
+                                            posted_task.leeway);
     if (sequence_manager_->GetAddQueueTimeToTasks())
       posted_task.queue_time = time_domain_now;
 
@@ -375,7 +548,8 @@ void TaskQueueImpl::PostDelayedTaskImpl(PostedTask posted_task,
       time_domain_now = any_thread_.time_domain->Now();
     }
     TimeTicks time_domain_delayed_run_time =
-        time_domain_now + posted_task.delay;
+        base::internal::AlignDelayedRunTime(time_domain_now + posted_task.delay,
+                                            posted_task.leeway);
     if (sequence_manager_->GetAddQueueTimeToTasks())
       posted_task.queue_time = time_domain_now;
 
@@ -456,11 +630,7 @@ void TaskQueueImpl::ReloadEmptyImmediateWorkQueue() {
 void TaskQueueImpl::TakeImmediateIncomingQueueTasks(TaskDeque* queue) {
   base::internal::CheckedAutoLock lock(any_thread_lock_);
   DCHECK(queue->empty());
-  queue->swap(any_thread_.immediate_incoming_queue);
-
-  // Since |immediate_incoming_queue| is empty, now is a good time to consider
-  // reducing it's capacity if we're wasting memory.
-  any_thread_.immediate_incoming_queue.MaybeShrinkQueue();
+  immediate_incoming_queue_.TakeAll(queue);
 
   // Activate delayed fence if necessary. This is ideologically similar to
   // ActivateDelayedFenceIfNeeded, but due to immediate tasks being posted
@@ -496,8 +666,7 @@ bool TaskQueueImpl::IsEmpty() const {
     return false;
   }
 
-  base::internal::CheckedAutoLock lock(any_thread_lock_);
-  return any_thread_.immediate_incoming_queue.empty();
+  return immediate_incoming_queue_.IsEmpty();
 }
 
 size_t TaskQueueImpl::GetNumberOfPendingTasks() const {
@@ -507,7 +676,7 @@ size_t TaskQueueImpl::GetNumberOfPendingTasks() const {
   task_count += main_thread_only().immediate_work_queue->Size();
 
   base::internal::CheckedAutoLock lock(any_thread_lock_);
-  task_count += any_thread_.immediate_incoming_queue.size();
+  task_count += immediate_incoming_queue_.Size();
   return task_count;
 }
 
@@ -527,8 +696,7 @@ bool TaskQueueImpl::HasTaskToRunImmediatelyOrReadyDelayedTask() const {
   }
 
   // Finally tasks on |immediate_incoming_queue| count as immediate work.
-  base::internal::CheckedAutoLock lock(any_thread_lock_);
-  return !any_thread_.immediate_incoming_queue.empty();
+  return !immediate_incoming_queue_.IsEmpty();
 }
 
 absl::optional<DelayedWakeUp> TaskQueueImpl::GetNextDesiredWakeUp() {
@@ -602,7 +770,7 @@ void TaskQueueImpl::TraceQueueSize() const {
   size_t total_task_count;
   {
     base::internal::CheckedAutoLock lock(any_thread_lock_);
-    total_task_count = any_thread_.immediate_incoming_queue.size() +
+    total_task_count = immediate_incoming_queue_.Size() +
                        main_thread_only().immediate_work_queue->Size() +
                        main_thread_only().delayed_work_queue->Size() +
                        main_thread_only().delayed_incoming_queue.size();
@@ -670,8 +838,8 @@ Value TaskQueueImpl::AsValue(TimeTicks now, bool force_verbose) const {
   state.SetBoolKey("enabled", IsQueueEnabled());
   state.SetStringKey("time_domain_name",
                      main_thread_only().time_domain->GetName());
-  state.SetIntKey("any_thread_.immediate_incoming_queuesize",
-                  any_thread_.immediate_incoming_queue.size());
+  state.SetIntKey("immediate_incoming_queue_size",
+                  immediate_incoming_queue_.Size());
   state.SetIntKey("delayed_incoming_queue_size",
                   main_thread_only().delayed_incoming_queue.size());
   state.SetIntKey("immediate_work_queue_size",
@@ -679,8 +847,6 @@ Value TaskQueueImpl::AsValue(TimeTicks now, bool force_verbose) const {
   state.SetIntKey("delayed_work_queue_size",
                   main_thread_only().delayed_work_queue->Size());
 
-  state.SetIntKey("any_thread_.immediate_incoming_queuecapacity",
-                  any_thread_.immediate_incoming_queue.capacity());
   state.SetIntKey("immediate_work_queue_capacity",
                   immediate_work_queue()->Capacity());
   state.SetIntKey("delayed_work_queue_capacity",
@@ -708,7 +874,7 @@ Value TaskQueueImpl::AsValue(TimeTicks now, bool force_verbose) const {
 
   if (verbose || force_verbose) {
     state.SetKey("immediate_incoming_queue",
-                 QueueAsValue(any_thread_.immediate_incoming_queue, now));
+                 QueueAsValue(immediate_incoming_queue_, now));
     state.SetKey("delayed_work_queue",
                  main_thread_only().delayed_work_queue->AsValue(now));
     state.SetKey("immediate_work_queue",
@@ -805,11 +971,9 @@ void TaskQueueImpl::InsertFence(TaskQueue::InsertFencePosition position) {
     base::internal::CheckedAutoLock lock(any_thread_lock_);
     if (!front_task_unblocked && previous_fence &&
         previous_fence < current_fence) {
-      if (!any_thread_.immediate_incoming_queue.empty() &&
-          any_thread_.immediate_incoming_queue.front().enqueue_order() >
-              previous_fence &&
-          any_thread_.immediate_incoming_queue.front().enqueue_order() <
-              current_fence) {
+      const Task* front_task = immediate_incoming_queue_.Front();
+      if (front_task && front_task->enqueue_order() > previous_fence &&
+          front_task->enqueue_order() < current_fence) {
         front_task_unblocked = true;
       }
     }
@@ -845,11 +1009,9 @@ void TaskQueueImpl::RemoveFence() {
   {
     base::internal::CheckedAutoLock lock(any_thread_lock_);
     if (!front_task_unblocked && previous_fence) {
-      if (!any_thread_.immediate_incoming_queue.empty() &&
-          any_thread_.immediate_incoming_queue.front().enqueue_order() >
-              previous_fence) {
+      const Task* front_task = immediate_incoming_queue_.Front();
+      if (front_task && front_task->enqueue_order() > previous_fence)
         front_task_unblocked = true;
-      }
     }
 
     UpdateCrossThreadQueueStateLocked();
@@ -871,11 +1033,11 @@ bool TaskQueueImpl::BlockedByFence() const {
   }
 
   base::internal::CheckedAutoLock lock(any_thread_lock_);
-  if (any_thread_.immediate_incoming_queue.empty())
+  const Task* front_task = immediate_incoming_queue_.Front();
+  if (!front_task)
     return true;
 
-  return any_thread_.immediate_incoming_queue.front().enqueue_order() >
-         main_thread_only().current_fence;
+  return front_task->enqueue_order() > main_thread_only().current_fence;
 }
 
 bool TaskQueueImpl::HasActiveFence() {
@@ -904,10 +1066,11 @@ bool TaskQueueImpl::WasBlockedOrLowPriority(EnqueueOrder enqueue_order) const {
 }
 
 // static
-Value TaskQueueImpl::QueueAsValue(const TaskDeque& queue, TimeTicks now) {
+Value TaskQueueImpl::QueueAsValue(const AtomicTaskList& queue,
+                                  TimeTicks now) {
   Value state(Value::Type::LIST);
-  for (const Task& task : queue)
-    state.Append(TaskAsValue(task, now));
+  queue.ForEach(
+      [&](const Task& task) { state.Append(TaskAsValue(task, now)); });
   return state;
 }
 
@@ -1050,18 +1213,13 @@ void TaskQueueImpl::ReclaimMemory(TimeTicks now) {
   main_thread_only().delayed_work_queue->MaybeShrinkQueue();
   main_thread_only().immediate_work_queue->MaybeShrinkQueue();
 
-  {
-    base::internal::CheckedAutoLock lock(any_thread_lock_);
-    any_thread_.immediate_incoming_queue.MaybeShrinkQueue();
-  }
-
   LazyNow lazy_now(now);
   UpdateDelayedWakeUp(&lazy_now);
 }
 
 void TaskQueueImpl::PushImmediateIncomingTaskForTest(Task&& task) {
   base::internal::CheckedAutoLock lock(any_thread_lock_);
-  any_thread_.immediate_incoming_queue.push_back(std::move(task));
+  immediate_incoming_queue_.PushForTesting(std::move(task));
 }
 
 void TaskQueueImpl::RequeueDeferredNonNestableTask(
@@ -1141,14 +1299,13 @@ bool TaskQueueImpl::HasTaskToRunImmediately() const {
   }
 
   // Finally tasks on |immediate_incoming_queue| count as immediate work.
-  base::internal::CheckedAutoLock lock(any_thread_lock_);
-  return !any_thread_.immediate_incoming_queue.empty();
+  return !immediate_incoming_queue_.IsEmpty();
 }
 
 bool TaskQueueImpl::HasTaskToRunImmediatelyLocked() const {
   return !main_thread_only().delayed_work_queue->Empty() ||
          !main_thread_only().immediate_work_queue->Empty() ||
-         !any_thread_.immediate_incoming_queue.empty();
+         !immediate_incoming_queue_.IsEmpty();
 }
 
 void TaskQueueImpl::SetOnTaskStartedHandler(
@@ -1186,6 +1343,8 @@ bool TaskQueueImpl::RequiresTaskTiming() const {
 void TaskQueueImpl::SetOnTaskPostedHandler(OnTaskPostedHandler handler) {
   DCHECK(should_notify_observers_ || handler.is_null());
   base::internal::CheckedAutoLock lock(any_thread_lock_);
+  has_on_task_posted_handler_.store(!handler.is_null(),
+                                    std::memory_order_relaxed);
   any_thread_.on_task_posted_handler = std::move(handler);
 }
 
@@ -1333,12 +1492,20 @@ void TaskQueueImpl::OnQueueUnblocked() {
 }
 
 TaskQueueImpl::DelayedIncomingQueue::DelayedIncomingQueue() = default;
+
 TaskQueueImpl::DelayedIncomingQueue::~DelayedIncomingQueue() = default;
 
 void TaskQueueImpl::DelayedIncomingQueue::push(Task&& task) {
   if (task.is_high_res)
     pending_high_res_tasks_++;
-  queue_.push(std::move(task));
+  if (!wheel_ && queue_.empty() &&
+      g_use_timer_wheel_for_delayed_tasks.load(std::memory_order_relaxed)) {
+    wheel_ = std::make_unique<TaskWheel>();
+  }
+  if (wheel_)
+    wheel_->insert(std::move(task));
+  else
+    queue_.push(std::move(task));
 }
 
 void TaskQueueImpl::DelayedIncomingQueue::pop() {
@@ -1347,17 +1514,35 @@ void TaskQueueImpl::DelayedIncomingQueue::pop() {
     pending_high_res_tasks_--;
     DCHECK_GE(pending_high_res_tasks_, 0);
   }
-  queue_.pop();
+  if (wheel_)
+    wheel_->Pop();
+  else
+    queue_.pop();
 }
 
 void TaskQueueImpl::DelayedIncomingQueue::swap(DelayedIncomingQueue* rhs) {
   std::swap(pending_high_res_tasks_, rhs->pending_high_res_tasks_);
   std::swap(queue_, rhs->queue_);
+  std::swap(wheel_, rhs->wheel_);
 }
 
 void TaskQueueImpl::DelayedIncomingQueue::SweepCancelledTasks(
     SequenceManagerImpl* sequence_manager) {
-  pending_high_res_tasks_ -= queue_.SweepCancelledTasks(sequence_manager);
+  if (!wheel_) {
+    pending_high_res_tasks_ -= queue_.SweepCancelledTasks(sequence_manager);
+    return;
+  }
+
+  // As for |queue_|, the canceled tasks are deleted after being removed from
+  // the wheel, since their destructors could post new tasks.
+  std::vector<Task> tasks_to_delete;
+  wheel_->TakeIf([](const Task& task) { return task.task.IsCancelled(); },
+                 &tasks_to_delete);
+  for (const Task& task : tasks_to_delete) {
+    if (task.is_high_res)
+      pending_high_res_tasks_--;
+  }
+  DCHECK_GE(pending_high_res_tasks_, 0);
 }
 
 size_t TaskQueueImpl::DelayedIncomingQueue::PQueue::SweepCancelledTasks(
@@ -1393,7 +1578,13 @@ size_t TaskQueueImpl::DelayedIncomingQueue::PQueue::SweepCancelledTasks(
 }
 
 Value TaskQueueImpl::DelayedIncomingQueue::AsValue(TimeTicks now) const {
-  return queue_.AsValue(now);
+  if (!wheel_)
+    return queue_.AsValue(now);
+  Value state(Value::Type::LIST);
+  wheel_->ForEach([&state, now](const Task& task) {
+    state.Append(TaskAsValue(task, now));
+  });
+  return state;
 }
 
 Value TaskQueueImpl::DelayedIncomingQueue::PQueue::AsValue(
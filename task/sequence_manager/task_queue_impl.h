@@ -7,20 +7,25 @@
 
 #include <stddef.h>
 
+#include <atomic>
 #include <memory>
 #include <queue>
 #include <set>
 #include <utility>
+#include <vector>
 
 #include "base/callback.h"
+#include "base/containers/span.h"
 #include "base/memory/weak_ptr.h"
 #include "base/observer_list.h"
 #include "base/pending_task.h"
 #include "base/task/common/checked_lock.h"
 #include "base/task/common/intrusive_heap.h"
 #include "base/task/common/operations_controller.h"
+#include "base/task/common/timer_wheel.h"
 #include "base/task/sequence_manager/associated_thread_id.h"
 #include "base/task/sequence_manager/atomic_flag_set.h"
+#include "base/task/sequence_manager/atomic_task_list.h"
 #include "base/task/sequence_manager/enqueue_order.h"
 #include "base/task/sequence_manager/lazily_deallocated_deque.h"
 #include "base/task/sequence_manager/sequenced_task_source.h"
@@ -53,10 +58,10 @@ class WorkQueueSets;
 //    |delayed_incoming_queue| - PostDelayedTask enqueues tasks here.
 //    |delayed_work_queue| - SequenceManager takes delayed tasks here.
 //
-// The |immediate_incoming_queue| can be accessed from any thread, the other
-// queues are main-thread only. To reduce the overhead of locking,
-// |immediate_work_queue| is swapped with |immediate_incoming_queue| when
-// |immediate_work_queue| becomes empty.
+// The |immediate_incoming_queue| can be pushed to from any thread without
+// locking, the other queues are main-thread only. All the tasks in
+// |immediate_incoming_queue| are moved to |immediate_work_queue| in a single
+// batch when |immediate_work_queue| becomes empty.
 //
 // Delayed tasks are initially posted to |delayed_incoming_queue| and a wake-up
 // is scheduled with the TimeDomain.  When the delay has elapsed, the TimeDomain
@@ -100,6 +105,10 @@ class BASE_EXPORT TaskQueueImpl {
       RepeatingCallback<void(const Task&, TaskQueue::TaskTiming*, LazyNow*)>;
   using OnTaskPostedHandler = RepeatingCallback<void(const Task&)>;
 
+  // Initializes the state of the features used by task queues. Called by
+  // SequenceManagerImpl::InitializeFeatures().
+  static void InitializeFeatures();
+
   // May be called from any thread.
   scoped_refptr<SingleThreadTaskRunner> CreateTaskRunner(
       TaskType task_type) const;
@@ -267,6 +276,7 @@ class BASE_EXPORT TaskQueueImpl {
     explicit GuardedTaskPoster(TaskQueueImpl* outer);
 
     bool PostTask(PostedTask task);
+    bool PostTasks(std::vector<PostedTask> tasks);
 
     void StartAcceptingOperations() {
       operations_controller_.StartAcceptingOperations();
@@ -295,9 +305,14 @@ class BASE_EXPORT TaskQueueImpl {
     bool PostDelayedTask(const Location& location,
                          OnceClosure callback,
                          TimeDelta delay) final;
+    bool PostDelayedTaskWithLeeway(const Location& location,
+                                   OnceClosure callback,
+                                   TimeDelta delay,
+                                   TimeDelta leeway) final;
     bool PostNonNestableDelayedTask(const Location& location,
                                     OnceClosure callback,
                                     TimeDelta delay) final;
+    bool PostTasks(const Location& location, span<OnceClosure> tasks) final;
     bool RunsTasksInCurrentSequence() const final;
 
    private:
@@ -308,7 +323,13 @@ class BASE_EXPORT TaskQueueImpl {
     const TaskType task_type_;
   };
 
-  // A queue for holding delayed tasks before their delay has expired.
+  // A queue for holding delayed tasks before their delay has expired. Backed by
+  // a priority queue, or by a timer wheel once kUseTimerWheelForDelayedTasks is
+  // enabled. The backend can only change while the queue is empty, so a queue
+  // created before InitializeFeatures() switches to the wheel the next time a
+  // task is pushed onto it while it is empty. The wheel only replaces the heap:
+  // tasks can't be canceled through the queue, so canceled tasks are still
+  // removed when they reach the top or by SweepCancelledTasks(), in O(n).
   struct DelayedIncomingQueue {
    public:
     DelayedIncomingQueue();
@@ -318,9 +339,9 @@ class BASE_EXPORT TaskQueueImpl {
 
     void push(Task&& task);
     void pop();
-    bool empty() const { return queue_.empty(); }
-    size_t size() const { return queue_.size(); }
-    const Task& top() const { return queue_.top(); }
+    bool empty() const { return wheel_ ? wheel_->empty() : queue_.empty(); }
+    size_t size() const { return wheel_ ? wheel_->size() : queue_.size(); }
+    const Task& top() const { return wheel_ ? wheel_->Min() : queue_.top(); }
     void swap(DelayedIncomingQueue* other);
 
     bool has_pending_high_resolution_tasks() const {
@@ -330,10 +351,27 @@ class BASE_EXPORT TaskQueueImpl {
     // TODO(crbug.com/1155905): we pass SequenceManager to be able to record
     // crash keys. Remove this parameter after chasing down this crash.
     void SweepCancelledTasks(SequenceManagerImpl* sequence_manager);
-    std::priority_queue<Task> TakeTasks() { return std::move(queue_); }
+    std::priority_queue<Task> TakeTasks() {
+      DCHECK(!wheel_);
+      return std::move(queue_);
+    }
     Value AsValue(TimeTicks now) const;
 
    private:
+    struct TaskRunsBefore {
+      // PendingTask's operator< is inverted for std::priority_queue.
+      bool operator()(const Task& a, const Task& b) const { return b < a; }
+    };
+
+    struct TaskRunTime {
+      TimeTicks operator()(const Task& task) const {
+        return task.delayed_run_time;
+      }
+    };
+
+    using TaskWheel =
+        base::internal::TimerWheel<Task, TaskRunsBefore, TaskRunTime>;
+
     struct PQueue : public std::priority_queue<Task> {
       // Removes all cancelled tasks from the queue. Returns the number of
       // removed high resolution tasks (which could be lower than the total
@@ -347,6 +385,9 @@ class BASE_EXPORT TaskQueueImpl {
 
     PQueue queue_;
 
+    // Used instead of |queue_| if non-null.
+    std::unique_ptr<TaskWheel> wheel_;
+
     // Number of pending tasks in the queue that need high resolution timing.
     int pending_high_res_tasks_ = 0;
   };
@@ -409,8 +450,13 @@ class BASE_EXPORT TaskQueueImpl {
   };
 
   void PostTask(PostedTask task);
+  void PostTasks(std::vector<PostedTask> tasks);
 
   void PostImmediateTaskImpl(PostedTask task, CurrentThread current_thread);
+  // Posts immediate |tasks| in order, acquiring |any_thread_lock_| at most once
+  // and scheduling work at most once.
+  void PostImmediateTasksImpl(std::vector<PostedTask> tasks,
+                              CurrentThread current_thread);
   void PostDelayedTaskImpl(PostedTask task, CurrentThread current_thread);
 
   // Push the task onto the |delayed_incoming_queue|. Lock-free main thread
@@ -433,13 +479,31 @@ class BASE_EXPORT TaskQueueImpl {
   using TaskDeque =
       LazilyDeallocatedDeque<Task, subtle::TimeTicksNowIgnoringOverride>;
 
-  // Extracts all the tasks from the immediate incoming queue and swaps it with
-  // |queue| which must be empty.
+  // Extracts all the tasks from the immediate incoming queue and appends them
+  // to |queue| which must be empty.
   // Can be called from any thread.
   void TakeImmediateIncomingQueueTasks(TaskDeque* queue);
 
+  // Called after a task was pushed to an empty |immediate_incoming_queue_|.
+  // Requests a reload of |immediate_work_queue| if it is empty and returns
+  // true if the SequenceManager must be scheduled to do work.
+  bool OnImmediateIncomingQueueBecameNonEmptyLocked()
+      EXCLUSIVE_LOCKS_REQUIRED(any_thread_lock_);
+
+  // Pushes |task| onto |immediate_incoming_queue_| from the slow path, which
+  // holds |any_thread_lock_|. Returns true if the SequenceManager must be
+  // scheduled to do work.
+  bool PushOntoImmediateIncomingQueueLocked(PostedTask task,
+                                            CurrentThread current_thread,
+                                            LazyNow* lazy_now)
+      EXCLUSIVE_LOCKS_REQUIRED(any_thread_lock_);
+
+  // Returns true if immediate tasks can be pushed onto
+  // |immediate_incoming_queue_| without acquiring |any_thread_lock_|.
+  bool CanPostImmediateTaskLockFree() const;
+
   void TraceQueueSize() const;
-  static Value QueueAsValue(const TaskDeque& queue, TimeTicks now);
+  static Value QueueAsValue(const AtomicTaskList& queue, TimeTicks now);
   static Value TaskAsValue(const Task& task, TimeTicks now);
 
   // Activate a delayed fence if a time has come.
@@ -500,8 +564,6 @@ class BASE_EXPORT TaskQueueImpl {
     // locked before accessing from other threads.
     TimeDomain* time_domain;
 
-    TaskDeque immediate_incoming_queue;
-
     // True if main_thread_only().immediate_work_queue is empty.
     bool immediate_work_queue_empty = true;
 
@@ -524,6 +586,15 @@ class BASE_EXPORT TaskQueueImpl {
 
   AnyThread any_thread_ GUARDED_BY(any_thread_lock_);
 
+  // Immediate tasks posted to this queue. Pushed to from any thread without
+  // |any_thread_lock_|, unless the post needs state guarded by it. Tasks are
+  // only inspected or taken with |any_thread_lock_| held.
+  AtomicTaskList immediate_incoming_queue_;
+
+  // Mirrors whether |any_thread_.on_task_posted_handler| is set, so that posts
+  // which don't need to notify it can skip |any_thread_lock_|.
+  std::atomic<bool> has_on_task_posted_handler_{false};
+
   MainThreadOnly main_thread_only_;
   MainThreadOnly& main_thread_only() {
     DCHECK_CALLED_ON_VALID_THREAD(associated_thread_->thread_checker);
@@ -41,10 +41,12 @@ PostedTask::PostedTask(scoped_refptr<SequencedTaskRunner> task_runner,
                        Location location,
                        TimeDelta delay,
                        Nestable nestable,
-                       TaskType task_type)
+                       TaskType task_type,
+                       TimeDelta leeway)
     : callback(std::move(callback)),
       location(location),
       delay(delay),
+      leeway(leeway),
       nestable(nestable),
       task_type(task_type),
       task_runner(std::move(task_runner)) {}
@@ -53,6 +55,7 @@ PostedTask::PostedTask(PostedTask&& move_from) noexcept
     : callback(std::move(move_from.callback)),
       location(move_from.location),
       delay(move_from.delay),
+      leeway(move_from.leeway),
       nestable(move_from.nestable),
       task_type(move_from.task_type),
       task_runner(std::move(move_from.task_runner)),
@@ -17,6 +17,8 @@ constexpr TaskType kTaskTypeNone = 0;
 
 namespace internal {
 
+class AtomicTaskList;
+
 // Wrapper around PostTask method arguments and the assigned task type.
 // Eventually it becomes a PendingTask once accepted by a TaskQueueImpl.
 struct BASE_EXPORT PostedTask {
@@ -25,7 +27,8 @@ struct BASE_EXPORT PostedTask {
                       Location location = Location(),
                       TimeDelta delay = TimeDelta(),
                       Nestable nestable = Nestable::kNestable,
-                      TaskType task_type = kTaskTypeNone);
+                      TaskType task_type = kTaskTypeNone,
+                      TimeDelta leeway = TimeDelta());
   PostedTask(PostedTask&& move_from) noexcept;
   PostedTask(const PostedTask&) = delete;
   PostedTask& operator=(const PostedTask&) = delete;
@@ -34,6 +37,9 @@ struct BASE_EXPORT PostedTask {
   OnceClosure callback;
   Location location;
   TimeDelta delay;
+  // How late the task may run after |delay| has passed, so that its wake up
+  // can be aligned with those of other tasks.
+  TimeDelta leeway;
   Nestable nestable;
   TaskType task_type;
   // The task runner this task is running on. Can be used by task runners that
@@ -113,6 +119,9 @@ struct BASE_EXPORT Task : public PendingTask {
 #endif
 
  private:
+  // Assigns |enqueue_order_| when a Task is pushed to an AtomicTaskList.
+  friend class internal::AtomicTaskList;
+
   // Similar to |sequence_num|, but ultimately the |enqueue_order| is what
   // the scheduler uses for task ordering. For immediate tasks |enqueue_order|
   // is set when posted, but for delayed tasks it's not defined until they are
@@ -227,9 +227,9 @@ bool WorkQueue::RemoveAllCanceledTasksFromFront() {
       // capacity if we're wasting memory.
       tasks_.MaybeShrinkQueue();
     }
-    // If we have a valid |heap_handle_| (i.e. we're not blocked by a fence or
+    // If we're in a work queue set (i.e. we're not blocked by a fence or
     // disabled) then |work_queue_sets_| needs to be told.
-    if (heap_handle_.IsValid())
+    if (IsInWorkQueueSet())
       work_queue_sets_->OnQueuesFrontTaskChanged(this);
     task_queue_->TraceQueueSize();
   }
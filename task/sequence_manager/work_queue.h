@@ -6,6 +6,7 @@
 #define BASE_TASK_SEQUENCE_MANAGER_WORK_QUEUE_H_
 
 #include "base/base_export.h"
+#include "base/containers/linked_list.h"
 #include "base/task/common/intrusive_heap.h"
 #include "base/task/sequence_manager/enqueue_order.h"
 #include "base/task/sequence_manager/sequenced_task_source.h"
@@ -27,7 +28,10 @@ class WorkQueueSets;
 // API subset used by WorkQueueSets pretends the WorkQueue is empty until the
 // fence is removed.  This functionality is a primitive intended for use by
 // throttling mechanisms.
-class BASE_EXPORT WorkQueue {
+//
+// The LinkNode is used by WorkQueueSets to keep this queue in the sorted list
+// of its set.
+class BASE_EXPORT WorkQueue : public LinkNode<WorkQueue> {
  public:
   using QueueType = internal::TaskQueueImpl::WorkQueueType;
 
@@ -124,6 +128,18 @@ class BASE_EXPORT WorkQueue {
     heap_handle_ = handle;
   }
 
+  // The enqueue order under which this queue is in the sorted list of its
+  // WorkQueueSets set. Only meaningful while it is in that list.
+  EnqueueOrder sorted_list_key() const { return sorted_list_key_; }
+
+  void set_sorted_list_key(EnqueueOrder key) { sorted_list_key_ = key; }
+
+  // Returns true if this queue is in its WorkQueueSets set, i.e. it isn't
+  // empty (or appearing to be empty due to a fence).
+  bool IsInWorkQueueSet() const {
+    return heap_handle_.IsValid() || next() != nullptr;
+  }
+
   QueueType queue_type() const { return queue_type_; }
 
   // Returns true if the front task in this queue has an older enqueue order
@@ -173,9 +189,11 @@ class BASE_EXPORT WorkQueue {
   size_t work_queue_set_index_ = 0;
 
   // Iff the queue isn't empty (or appearing to be empty due to a fence) then
-  // |heap_handle_| will be valid and correspond to this queue's location within
-  // an IntrusiveHeap inside the WorkQueueSet.
+  // either |heap_handle_| will be valid and correspond to this queue's location
+  // within an IntrusiveHeap inside the WorkQueueSet, or this queue will be in
+  // the sorted list of the WorkQueueSet under |sorted_list_key_|.
   base::internal::HeapHandle heap_handle_;
+  EnqueueOrder sorted_list_key_;
   const char* const name_;
   EnqueueOrder fence_;
   const QueueType queue_type_;
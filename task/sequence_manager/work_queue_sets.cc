@@ -24,16 +24,16 @@ WorkQueueSets::~WorkQueueSets() = default;
 
 void WorkQueueSets::AddQueue(WorkQueue* work_queue, size_t set_index) {
   DCHECK(!work_queue->work_queue_sets());
-  DCHECK_LT(set_index, work_queue_heaps_.size());
-  DCHECK(!work_queue->heap_handle().IsValid());
+  DCHECK_LT(set_index, sets_.size());
+  DCHECK(!work_queue->IsInWorkQueueSet());
   EnqueueOrder enqueue_order;
   bool has_enqueue_order = work_queue->GetFrontTaskEnqueueOrder(&enqueue_order);
   work_queue->AssignToWorkQueueSets(this);
   work_queue->AssignSetIndex(set_index);
   if (!has_enqueue_order)
     return;
-  bool was_empty = work_queue_heaps_[set_index].empty();
-  work_queue_heaps_[set_index].insert({enqueue_order, work_queue});
+  bool was_empty = sets_[set_index].empty();
+  InsertQueue(work_queue, set_index, enqueue_order);
   if (was_empty)
     observer_->WorkQueueSetBecameNonEmpty(set_index);
 }
@@ -41,32 +41,32 @@ void WorkQueueSets::AddQueue(WorkQueue* work_queue, size_t set_index) {
 void WorkQueueSets::RemoveQueue(WorkQueue* work_queue) {
   DCHECK_EQ(this, work_queue->work_queue_sets());
   work_queue->AssignToWorkQueueSets(nullptr);
-  if (!work_queue->heap_handle().IsValid())
+  if (!work_queue->IsInWorkQueueSet())
     return;
   size_t set_index = work_queue->work_queue_set_index();
-  DCHECK_LT(set_index, work_queue_heaps_.size());
-  work_queue_heaps_[set_index].erase(work_queue->heap_handle());
-  if (work_queue_heaps_[set_index].empty())
+  DCHECK_LT(set_index, sets_.size());
+  EraseQueue(work_queue, set_index);
+  if (sets_[set_index].empty())
     observer_->WorkQueueSetBecameEmpty(set_index);
-  DCHECK(!work_queue->heap_handle().IsValid());
+  DCHECK(!work_queue->IsInWorkQueueSet());
 }
 
 void WorkQueueSets::ChangeSetIndex(WorkQueue* work_queue, size_t set_index) {
   DCHECK_EQ(this, work_queue->work_queue_sets());
-  DCHECK_LT(set_index, work_queue_heaps_.size());
+  DCHECK_LT(set_index, sets_.size());
   EnqueueOrder enqueue_order;
   bool has_enqueue_order = work_queue->GetFrontTaskEnqueueOrder(&enqueue_order);
   size_t old_set = work_queue->work_queue_set_index();
-  DCHECK_LT(old_set, work_queue_heaps_.size());
+  DCHECK_LT(old_set, sets_.size());
   DCHECK_NE(old_set, set_index);
   work_queue->AssignSetIndex(set_index);
-  DCHECK_EQ(has_enqueue_order, work_queue->heap_handle().IsValid());
+  DCHECK_EQ(has_enqueue_order, work_queue->IsInWorkQueueSet());
   if (!has_enqueue_order)
     return;
-  work_queue_heaps_[old_set].erase(work_queue->heap_handle());
-  bool was_empty = work_queue_heaps_[set_index].empty();
-  work_queue_heaps_[set_index].insert({enqueue_order, work_queue});
-  if (work_queue_heaps_[old_set].empty())
+  EraseQueue(work_queue, old_set);
+  bool was_empty = sets_[set_index].empty();
+  InsertQueue(work_queue, set_index, enqueue_order);
+  if (sets_[old_set].empty())
     observer_->WorkQueueSetBecameEmpty(old_set);
   if (was_empty)
     observer_->WorkQueueSetBecameNonEmpty(set_index);
@@ -76,18 +76,25 @@ void WorkQueueSets::OnQueuesFrontTaskChanged(WorkQueue* work_queue) {
   EnqueueOrder enqueue_order;
   size_t set_index = work_queue->work_queue_set_index();
   DCHECK_EQ(this, work_queue->work_queue_sets());
-  DCHECK_LT(set_index, work_queue_heaps_.size());
-  DCHECK(work_queue->heap_handle().IsValid());
-  DCHECK(!work_queue_heaps_[set_index].empty()) << " set_index = " << set_index;
+  DCHECK_LT(set_index, sets_.size());
+  DCHECK(work_queue->IsInWorkQueueSet());
+  DCHECK(!sets_[set_index].empty()) << " set_index = " << set_index;
+  WorkQueueSet& set = sets_[set_index];
   if (work_queue->GetFrontTaskEnqueueOrder(&enqueue_order)) {
-    // O(log n)
-    work_queue_heaps_[set_index].ChangeKey(work_queue->heap_handle(),
-                                           {enqueue_order, work_queue});
+    if (work_queue->heap_handle().IsValid() &&
+        !set.sorted_queues.empty() &&
+        enqueue_order < set.sorted_queues.tail()->value()->sorted_list_key()) {
+      // O(log n)
+      set.heap.ChangeKey(work_queue->heap_handle(),
+                         {enqueue_order, work_queue});
+      return;
+    }
+    EraseQueue(work_queue, set_index);
+    InsertQueue(work_queue, set_index, enqueue_order);
   } else {
-    // O(log n)
-    work_queue_heaps_[set_index].erase(work_queue->heap_handle());
-    DCHECK(!work_queue->heap_handle().IsValid());
-    if (work_queue_heaps_[set_index].empty())
+    EraseQueue(work_queue, set_index);
+    DCHECK(!work_queue->IsInWorkQueueSet());
+    if (set.empty())
       observer_->WorkQueueSetBecameEmpty(set_index);
   }
 }
@@ -100,12 +107,11 @@ void WorkQueueSets::OnTaskPushedToEmptyQueue(WorkQueue* work_queue) {
   bool has_enqueue_order = work_queue->GetFrontTaskEnqueueOrder(&enqueue_order);
   DCHECK(has_enqueue_order);
   size_t set_index = work_queue->work_queue_set_index();
-  DCHECK_LT(set_index, work_queue_heaps_.size())
-      << " set_index = " << set_index;
-  // |work_queue| should not be in work_queue_heaps_[set_index].
-  DCHECK(!work_queue->heap_handle().IsValid());
-  bool was_empty = work_queue_heaps_[set_index].empty();
-  work_queue_heaps_[set_index].insert({enqueue_order, work_queue});
+  DCHECK_LT(set_index, sets_.size()) << " set_index = " << set_index;
+  // |work_queue| should not be in sets_[set_index].
+  DCHECK(!work_queue->IsInWorkQueueSet());
+  bool was_empty = sets_[set_index].empty();
+  InsertQueue(work_queue, set_index, enqueue_order);
   if (was_empty)
     observer_->WorkQueueSetBecameNonEmpty(set_index);
 }
@@ -114,100 +120,103 @@ void WorkQueueSets::OnPopMinQueueInSet(WorkQueue* work_queue) {
   // Assume that |work_queue| contains the lowest enqueue_order.
   size_t set_index = work_queue->work_queue_set_index();
   DCHECK_EQ(this, work_queue->work_queue_sets());
-  DCHECK_LT(set_index, work_queue_heaps_.size());
-  DCHECK(!work_queue_heaps_[set_index].empty()) << " set_index = " << set_index;
-  DCHECK_EQ(work_queue_heaps_[set_index].Min().value, work_queue)
-      << " set_index = " << set_index;
-  DCHECK(work_queue->heap_handle().IsValid());
+  DCHECK_LT(set_index, sets_.size());
+  DCHECK(!sets_[set_index].empty()) << " set_index = " << set_index;
+  DCHECK(work_queue->IsInWorkQueueSet());
+  WorkQueueSet& set = sets_[set_index];
   EnqueueOrder enqueue_order;
   if (work_queue->GetFrontTaskEnqueueOrder(&enqueue_order)) {
-    // O(log n)
-    work_queue_heaps_[set_index].ReplaceMin({enqueue_order, work_queue});
+    if (work_queue->heap_handle().IsValid()) {
+      DCHECK_EQ(set.heap.Min().value, work_queue)
+          << " set_index = " << set_index;
+      if (!set.sorted_queues.empty() &&
+          enqueue_order <
+              set.sorted_queues.tail()->value()->sorted_list_key()) {
+        // O(log n)
+        set.heap.ReplaceMin({enqueue_order, work_queue});
+        return;
+      }
+      // O(log n)
+      set.heap.Pop();
+    } else {
+      DCHECK_EQ(set.sorted_queues.head()->value(), work_queue)
+          << " set_index = " << set_index;
+      // O(1)
+      EraseQueue(work_queue, set_index);
+    }
+    InsertQueue(work_queue, set_index, enqueue_order);
   } else {
-    // O(log n)
-    work_queue_heaps_[set_index].Pop();
-    DCHECK(!work_queue->heap_handle().IsValid());
-    DCHECK(work_queue_heaps_[set_index].empty() ||
-           work_queue_heaps_[set_index].Min().value != work_queue);
-    if (work_queue_heaps_[set_index].empty()) {
+    EraseQueue(work_queue, set_index);
+    DCHECK(!work_queue->IsInWorkQueueSet());
+    if (set.empty())
       observer_->WorkQueueSetBecameEmpty(set_index);
-    }
   }
 }
 
 void WorkQueueSets::OnQueueBlocked(WorkQueue* work_queue) {
   DCHECK_EQ(this, work_queue->work_queue_sets());
-  base::internal::HeapHandle heap_handle = work_queue->heap_handle();
-  if (!heap_handle.IsValid())
+  if (!work_queue->IsInWorkQueueSet())
     return;
   size_t set_index = work_queue->work_queue_set_index();
-  DCHECK_LT(set_index, work_queue_heaps_.size());
-  work_queue_heaps_[set_index].erase(heap_handle);
-  if (work_queue_heaps_[set_index].empty())
+  DCHECK_LT(set_index, sets_.size());
+  EraseQueue(work_queue, set_index);
+  if (sets_[set_index].empty())
     observer_->WorkQueueSetBecameEmpty(set_index);
 }
 
 WorkQueue* WorkQueueSets::GetOldestQueueInSet(size_t set_index) const {
-  DCHECK_LT(set_index, work_queue_heaps_.size());
-  if (work_queue_heaps_[set_index].empty())
-    return nullptr;
-  WorkQueue* queue = work_queue_heaps_[set_index].Min().value;
-  DCHECK_EQ(set_index, queue->work_queue_set_index());
-  DCHECK(queue->heap_handle().IsValid());
+  DCHECK_LT(set_index, sets_.size());
+  EnqueueOrder enqueue_order;
+  WorkQueue* queue = GetOldestQueueAndKey(set_index, &enqueue_order);
+  DCHECK(!queue || set_index == queue->work_queue_set_index());
   return queue;
 }
 
 WorkQueue* WorkQueueSets::GetOldestQueueAndEnqueueOrderInSet(
     size_t set_index,
     EnqueueOrder* out_enqueue_order) const {
-  DCHECK_LT(set_index, work_queue_heaps_.size());
-  if (work_queue_heaps_[set_index].empty())
+  DCHECK_LT(set_index, sets_.size());
+  WorkQueue* queue = GetOldestQueueAndKey(set_index, out_enqueue_order);
+  if (!queue)
     return nullptr;
-  const OldestTaskEnqueueOrder& oldest = work_queue_heaps_[set_index].Min();
-  DCHECK(oldest.value->heap_handle().IsValid());
-  *out_enqueue_order = oldest.key;
   EnqueueOrder enqueue_order;
-  DCHECK(oldest.value->GetFrontTaskEnqueueOrder(&enqueue_order) &&
-         oldest.key == enqueue_order);
-  return oldest.value;
+  DCHECK(queue->GetFrontTaskEnqueueOrder(&enqueue_order) &&
+         *out_enqueue_order == enqueue_order);
+  return queue;
 }
 
 #if DCHECK_IS_ON()
 WorkQueue* WorkQueueSets::GetRandomQueueInSet(size_t set_index) const {
-  DCHECK_LT(set_index, work_queue_heaps_.size());
-  if (work_queue_heaps_[set_index].empty())
+  DCHECK_LT(set_index, sets_.size());
+  if (sets_[set_index].empty())
     return nullptr;
 
-  WorkQueue* queue =
-      work_queue_heaps_[set_index]
-          .begin()[Random() % work_queue_heaps_[set_index].size()]
-          .value;
+  EnqueueOrder enqueue_order;
+  WorkQueue* queue = GetQueueAndKeyAt(
+      set_index, Random() % sets_[set_index].size(), &enqueue_order);
   DCHECK_EQ(set_index, queue->work_queue_set_index());
-  DCHECK(queue->heap_handle().IsValid());
+  DCHECK(queue->IsInWorkQueueSet());
   return queue;
 }
 
 WorkQueue* WorkQueueSets::GetRandomQueueAndEnqueueOrderInSet(
     size_t set_index,
     EnqueueOrder* out_enqueue_order) const {
-  DCHECK_LT(set_index, work_queue_heaps_.size());
-  if (work_queue_heaps_[set_index].empty())
+  DCHECK_LT(set_index, sets_.size());
+  if (sets_[set_index].empty())
     return nullptr;
-  const OldestTaskEnqueueOrder& chosen =
-      work_queue_heaps_[set_index]
-          .begin()[Random() % work_queue_heaps_[set_index].size()];
-  *out_enqueue_order = chosen.key;
+  WorkQueue* queue = GetQueueAndKeyAt(
+      set_index, Random() % sets_[set_index].size(), out_enqueue_order);
   EnqueueOrder enqueue_order;
-  DCHECK(chosen.value->GetFrontTaskEnqueueOrder(&enqueue_order) &&
-         chosen.key == enqueue_order);
-  return chosen.value;
+  DCHECK(queue->GetFrontTaskEnqueueOrder(&enqueue_order) &&
+         *out_enqueue_order == enqueue_order);
+  return queue;
 }
 #endif
 
 bool WorkQueueSets::IsSetEmpty(size_t set_index) const {
-  DCHECK_LT(set_index, work_queue_heaps_.size())
-      << " set_index = " << set_index;
-  return work_queue_heaps_[set_index].empty();
+  DCHECK_LT(set_index, sets_.size()) << " set_index = " << set_index;
+  return sets_[set_index].empty();
 }
 
 #if DCHECK_IS_ON() || !defined(NDEBUG)
@@ -216,9 +225,8 @@ bool WorkQueueSets::ContainsWorkQueueForTest(
   EnqueueOrder enqueue_order;
   bool has_enqueue_order = work_queue->GetFrontTaskEnqueueOrder(&enqueue_order);
 
-  for (const base::internal::IntrusiveHeap<OldestTaskEnqueueOrder>& heap :
-       work_queue_heaps_) {
-    for (const OldestTaskEnqueueOrder& heap_value_pair : heap) {
+  for (const WorkQueueSet& set : sets_) {
+    for (const OldestTaskEnqueueOrder& heap_value_pair : set.heap) {
       if (heap_value_pair.value == work_queue) {
         DCHECK(has_enqueue_order);
         DCHECK_EQ(heap_value_pair.key, enqueue_order);
@@ -226,6 +234,15 @@ bool WorkQueueSets::ContainsWorkQueueForTest(
         return true;
       }
     }
+    for (const LinkNode<WorkQueue>* node = set.sorted_queues.head();
+         node != set.sorted_queues.end(); node = node->next()) {
+      if (node->value() == work_queue) {
+        DCHECK(has_enqueue_order);
+        DCHECK_EQ(work_queue->sorted_list_key(), enqueue_order);
+        DCHECK_EQ(this, work_queue->work_queue_sets());
+        return true;
+      }
+    }
   }
 
   if (work_queue->work_queue_sets() == this) {
@@ -237,6 +254,74 @@ bool WorkQueueSets::ContainsWorkQueueForTest(
 }
 #endif
 
+void WorkQueueSets::InsertQueue(WorkQueue* work_queue,
+                                size_t set_index,
+                                EnqueueOrder enqueue_order) {
+  DCHECK(!work_queue->IsInWorkQueueSet());
+  WorkQueueSet& set = sets_[set_index];
+  if (set.sorted_queues.empty() ||
+      set.sorted_queues.tail()->value()->sorted_list_key() < enqueue_order) {
+    // O(1)
+    work_queue->set_sorted_list_key(enqueue_order);
+    set.sorted_queues.Append(work_queue);
+    ++set.num_sorted_queues;
+  } else {
+    // O(log n)
+    set.heap.insert({enqueue_order, work_queue});
+  }
+}
+
+void WorkQueueSets::EraseQueue(WorkQueue* work_queue, size_t set_index) {
+  WorkQueueSet& set = sets_[set_index];
+  if (work_queue->heap_handle().IsValid()) {
+    // O(log n)
+    set.heap.erase(work_queue->heap_handle());
+  } else {
+    // O(1)
+    DCHECK(work_queue->next());
+    work_queue->RemoveFromList();
+    --set.num_sorted_queues;
+  }
+}
+
+WorkQueue* WorkQueueSets::GetOldestQueueAndKey(
+    size_t set_index,
+    EnqueueOrder* out_enqueue_order) const {
+  const WorkQueueSet& set = sets_[set_index];
+  if (set.sorted_queues.empty()) {
+    if (set.heap.empty())
+      return nullptr;
+    *out_enqueue_order = set.heap.Min().key;
+    return set.heap.Min().value;
+  }
+  WorkQueue* queue = set.sorted_queues.head()->value();
+  if (!set.heap.empty() && set.heap.Min().key < queue->sorted_list_key()) {
+    *out_enqueue_order = set.heap.Min().key;
+    return set.heap.Min().value;
+  }
+  *out_enqueue_order = queue->sorted_list_key();
+  return queue;
+}
+
+WorkQueue* WorkQueueSets::GetQueueAndKeyAt(
+    size_t set_index,
+    size_t index,
+    EnqueueOrder* out_enqueue_order) const {
+  const WorkQueueSet& set = sets_[set_index];
+  DCHECK_LT(index, set.size());
+  if (index < set.heap.size()) {
+    const OldestTaskEnqueueOrder& entry = set.heap.begin()[index];
+    *out_enqueue_order = entry.key;
+    return entry.value;
+  }
+  index -= set.heap.size();
+  const LinkNode<WorkQueue>* node = set.sorted_queues.head();
+  for (; index > 0; --index)
+    node = node->next();
+  *out_enqueue_order = node->value()->sorted_list_key();
+  return const_cast<WorkQueue*>(node->value());
+}
+
 void WorkQueueSets::CollectSkippedOverLowerPriorityTasks(
     const internal::WorkQueue* selected_work_queue,
     std::vector<const Task*>* result) const {
@@ -244,9 +329,14 @@ void WorkQueueSets::CollectSkippedOverLowerPriorityTasks(
   CHECK(selected_work_queue->GetFrontTaskEnqueueOrder(&selected_enqueue_order));
   for (size_t priority = selected_work_queue->work_queue_set_index() + 1;
        priority < TaskQueue::kQueuePriorityCount; priority++) {
-    for (const OldestTaskEnqueueOrder& pair : work_queue_heaps_[priority]) {
+    const WorkQueueSet& set = sets_[priority];
+    for (const OldestTaskEnqueueOrder& pair : set.heap) {
       pair.value->CollectTasksOlderThan(selected_enqueue_order, result);
     }
+    for (const LinkNode<WorkQueue>* node = set.sorted_queues.head();
+         node != set.sorted_queues.end(); node = node->next()) {
+      node->value()->CollectTasksOlderThan(selected_enqueue_order, result);
+    }
   }
 }
 
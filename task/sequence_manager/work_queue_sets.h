@@ -11,6 +11,7 @@
 
 #include "base/base_export.h"
 #include "base/check_op.h"
+#include "base/containers/linked_list.h"
 #include "base/task/common/intrusive_heap.h"
 #include "base/task/sequence_manager/sequence_manager.h"
 #include "base/task/sequence_manager/task_queue_impl.h"
@@ -21,11 +22,16 @@ namespace sequence_manager {
 namespace internal {
 
 // There is a WorkQueueSet for each scheduler priority and each WorkQueueSet
-// uses a EnqueueOrderToWorkQueueMap to keep track of which queue in the set has
-// the oldest task (i.e. the one that should be run next if the
-// TaskQueueSelector chooses to run a task a given priority).  The reason this
-// works is because std::map is a tree based associative container and all the
-// values are kept in sorted order.
+// keeps track of which queue in the set has the oldest task (i.e. the one that
+// should be run next if the TaskQueueSelector chooses to run a task a given
+// priority).
+//
+// Each set keeps its queues ordered by the enqueue order of their front task in
+// two containers: a list sorted by enqueue order, and an IntrusiveHeap. Since
+// enqueue orders increase over time, a queue's new front task is usually newer
+// than the front task of every other queue in the set, in which case the queue
+// is appended to the list in O(1). Other queues go to the heap. The oldest
+// queue of the set is the oldest of the list's head and of the heap's min.
 class BASE_EXPORT WorkQueueSets {
  public:
   class Observer {
@@ -44,27 +50,23 @@ class BASE_EXPORT WorkQueueSets {
   WorkQueueSets& operator=(const WorkQueueSets&) = delete;
   ~WorkQueueSets();
 
-  // O(log num queues)
+  // The operations below are O(1) if the queues involved are, or go to, the
+  // sorted list of their set, and O(log num queues) otherwise.
+
   void AddQueue(WorkQueue* queue, size_t set_index);
 
-  // O(log num queues)
   void RemoveQueue(WorkQueue* work_queue);
 
-  // O(log num queues)
   void ChangeSetIndex(WorkQueue* queue, size_t set_index);
 
-  // O(log num queues)
   void OnQueuesFrontTaskChanged(WorkQueue* queue);
 
-  // O(log num queues)
   void OnTaskPushedToEmptyQueue(WorkQueue* work_queue);
 
-  // If empty it's O(1) amortized, otherwise it's O(log num queues). Slightly
-  // faster on average than OnQueuesFrontTaskChanged.
+  // Slightly faster on average than OnQueuesFrontTaskChanged.
   // Assumes |work_queue| contains the lowest enqueue order in the set.
   void OnPopMinQueueInSet(WorkQueue* work_queue);
 
-  // O(log num queues)
   void OnQueueBlocked(WorkQueue* work_queue);
 
   // O(1)
@@ -76,10 +78,10 @@ class BASE_EXPORT WorkQueueSets {
       EnqueueOrder* out_enqueue_order) const;
 
 #if DCHECK_IS_ON()
-  // O(1)
+  // O(num queues)
   WorkQueue* GetRandomQueueInSet(size_t set_index) const;
 
-  // O(1)
+  // O(num queues)
   WorkQueue* GetRandomQueueAndEnqueueOrderInSet(
       size_t set_index,
       EnqueueOrder* out_enqueue_order) const;
@@ -89,7 +91,7 @@ class BASE_EXPORT WorkQueueSets {
   bool IsSetEmpty(size_t set_index) const;
 
 #if DCHECK_IS_ON() || !defined(NDEBUG)
-  // Note this iterates over everything in |work_queue_heaps_|.
+  // Note this iterates over everything in |sets_|.
   // It's intended for use with DCHECKS and for testing
   bool ContainsWorkQueueForTest(const WorkQueue* queue) const;
 #endif
@@ -122,13 +124,42 @@ class BASE_EXPORT WorkQueueSets {
     HeapHandle GetHeapHandle() const { return value->heap_handle(); }
   };
 
+  struct WorkQueueSet {
+    bool empty() const { return sorted_queues.empty() && heap.empty(); }
+    size_t size() const { return num_sorted_queues + heap.size(); }
+
+    // Queues in increasing order of |WorkQueue::sorted_list_key()|.
+    LinkedList<WorkQueue> sorted_queues;
+    size_t num_sorted_queues = 0;
+
+    // Queues which were added out of order.
+    base::internal::IntrusiveHeap<OldestTaskEnqueueOrder> heap;
+  };
+
+  // Adds |work_queue|, whose front task has |enqueue_order|, to the set
+  // |set_index|. Doesn't notify |observer_|.
+  void InsertQueue(WorkQueue* work_queue,
+                   size_t set_index,
+                   EnqueueOrder enqueue_order);
+
+  // Removes |work_queue| from the set |set_index|. Doesn't notify |observer_|.
+  void EraseQueue(WorkQueue* work_queue, size_t set_index);
+
+  // Returns the queue with the oldest front task in the set |set_index|, and
+  // its enqueue order, or null if the set is empty.
+  WorkQueue* GetOldestQueueAndKey(size_t set_index,
+                                  EnqueueOrder* out_enqueue_order) const;
+
+  // Returns the |index|-th queue of the set |set_index|, in no particular
+  // order, and its enqueue order.
+  WorkQueue* GetQueueAndKeyAt(size_t set_index,
+                              size_t index,
+                              EnqueueOrder* out_enqueue_order) const;
+
   const char* const name_;
 
-  // For each set |work_queue_heaps_| has a queue of WorkQueue ordered by the
-  // oldest task in each WorkQueue.
-  std::array<base::internal::IntrusiveHeap<OldestTaskEnqueueOrder>,
-             TaskQueue::kQueuePriorityCount>
-      work_queue_heaps_;
+  // The queues of each set, ordered by the oldest task in each WorkQueue.
+  std::array<WorkQueueSet, TaskQueue::kQueuePriorityCount> sets_;
 
 #if DCHECK_IS_ON()
   static inline uint64_t MurmurHash3(uint64_t value) {
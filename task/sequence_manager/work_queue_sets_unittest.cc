@@ -359,6 +359,59 @@ TEST_F(WorkQueueSetsTest, CollectSkippedOverLowerPriorityTasks) {
   EXPECT_EQ(2u, result[2]->enqueue_order());
 }
 
+TEST_F(WorkQueueSetsTest, GetOldestQueueInSet_QueuesAddedOutOfOrder) {
+  constexpr int kNumQueues = 20;
+  constexpr int kNumTasksPerQueue = 3;
+  size_t set = TaskQueue::kControlPriority;
+  for (int i = 0; i < kNumQueues; i++) {
+    WorkQueue* queue = NewTaskQueue("queue");
+    // Front tasks are pushed in a scrambled order, so that some queues are
+    // newer than all the others when they are added and some aren't.
+    int enqueue_order = (i * 7) % kNumQueues + 1;
+    for (int j = 0; j < kNumTasksPerQueue; j++)
+      queue->Push(FakeTaskWithEnqueueOrder(enqueue_order + j * kNumQueues));
+  }
+
+  for (int expected = 1; expected <= kNumQueues * kNumTasksPerQueue;
+       expected++) {
+    EnqueueOrder enqueue_order;
+    WorkQueue* queue = work_queue_sets_->GetOldestQueueAndEnqueueOrderInSet(
+        set, &enqueue_order);
+    ASSERT_TRUE(queue);
+    EXPECT_EQ(static_cast<uint64_t>(expected), enqueue_order);
+    queue->PopTaskForTesting();
+    work_queue_sets_->OnPopMinQueueInSet(queue);
+  }
+  EXPECT_TRUE(work_queue_sets_->IsSetEmpty(set));
+}
+
+TEST_F(WorkQueueSetsTest, RemoveFence_OlderThanNewestQueue) {
+  WorkQueue* queue1 = NewTaskQueue("queue1");
+  WorkQueue* queue2 = NewTaskQueue("queue2");
+  WorkQueue* queue3 = NewTaskQueue("queue3");
+  queue1->Push(FakeTaskWithEnqueueOrder(1));
+  queue2->Push(FakeTaskWithEnqueueOrder(2));
+  queue3->Push(FakeTaskWithEnqueueOrder(3));
+  queue2->Push(FakeTaskWithEnqueueOrder(4));
+  size_t set = TaskQueue::kControlPriority;
+
+  queue1->InsertFence(EnqueueOrder::blocking_fence());
+  EXPECT_EQ(queue2, work_queue_sets_->GetOldestQueueInSet(set));
+  queue2->PopTaskForTesting();
+  work_queue_sets_->OnPopMinQueueInSet(queue2);
+  EXPECT_EQ(queue3, work_queue_sets_->GetOldestQueueInSet(set));
+
+  // |queue1| comes back with a task older than the other queues' tasks.
+  queue1->RemoveFence();
+  EXPECT_EQ(queue1, work_queue_sets_->GetOldestQueueInSet(set));
+  queue1->PopTaskForTesting();
+  work_queue_sets_->OnPopMinQueueInSet(queue1);
+  EXPECT_EQ(queue3, work_queue_sets_->GetOldestQueueInSet(set));
+  queue3->PopTaskForTesting();
+  work_queue_sets_->OnPopMinQueueInSet(queue3);
+  EXPECT_EQ(queue2, work_queue_sets_->GetOldestQueueInSet(set));
+}
+
 }  // namespace internal
 }  // namespace sequence_manager
 }  // namespace base
@@ -36,6 +36,40 @@ const base::FeatureParam<WakeUpStrategy> kWakeUpStrategyParam{
 const Feature kWakeUpAfterGetWork = {"WakeUpAfterGetWork",
                                      base::FEATURE_DISABLED_BY_DEFAULT};
 
+const Feature kUseWorkerLocalQueues = {"UseWorkerLocalQueues",
+                                       base::FEATURE_DISABLED_BY_DEFAULT};
+
+const Feature kUseTimerWheelForDelayedTasks = {
+    "UseTimerWheelForDelayedTasks", base::FEATURE_DISABLED_BY_DEFAULT};
+
+const Feature kUseNumaAwareThreadGroups = {"UseNumaAwareThreadGroups",
+                                           base::FEATURE_DISABLED_BY_DEFAULT};
+
+const Feature kSpinIdleWorkers = {"SpinIdleWorkers",
+                                  base::FEATURE_DISABLED_BY_DEFAULT};
+
+const base::FeatureParam<TimeDelta> kMaxIdleWorkerSpinDuration{
+    &kSpinIdleWorkers, "max_spin_duration", TimeDelta::FromMicroseconds(50)};
+
+const Feature kSampleTaskLatency = {"SampleTaskLatency",
+                                    base::FEATURE_DISABLED_BY_DEFAULT};
+
+const base::FeatureParam<int> kTaskLatencySamplingInterval{
+    &kSampleTaskLatency, "sampling_interval", 16};
+
+const Feature kBatchTaskSourceDraining = {"BatchTaskSourceDraining",
+                                          base::FEATURE_DISABLED_BY_DEFAULT};
+
+const base::FeatureParam<int> kMaxBatchedTasks{&kBatchTaskSourceDraining,
+                                               "max_batched_tasks", 16};
+
+const base::FeatureParam<TimeDelta> kMaxBatchDuration{
+    &kBatchTaskSourceDraining, "max_batch_duration",
+    TimeDelta::FromMicroseconds(100)};
+
+const Feature kCoalesceWakeUps = {"CoalesceWakeUps",
+                                  base::FEATURE_DISABLED_BY_DEFAULT};
+
 #if HAS_NATIVE_THREAD_POOL()
 const Feature kUseNativeThreadPool = {"UseNativeThreadPool",
                                       base::FEATURE_DISABLED_BY_DEFAULT};
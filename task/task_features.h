@@ -27,6 +27,48 @@ extern const BASE_EXPORT Feature kDisableJobUpdatePriority;
 // Under this feature, another WorkerThread is signaled only after the current
 // thread was assigned work.
 extern const BASE_EXPORT Feature kWakeUpAfterGetWork;
+// Under this feature, each worker of a ThreadGroupImpl keeps a local queue of
+// foreground sequences that it runs without acquiring the thread group's lock,
+// and idle workers steal from their siblings' local queues.
+extern const BASE_EXPORT Feature kUseWorkerLocalQueues;
+// Under this feature, delayed tasks waiting in the ThreadPool's
+// DelayedTaskManager and in SequenceManager task queues are kept in a
+// hierarchical timer wheel instead of a binary heap.
+extern const BASE_EXPORT Feature kUseTimerWheelForDelayedTasks;
+// Under this feature, on machines with several NUMA nodes (or last-level cache
+// domains), ThreadPoolImpl runs foreground tasks in one thread group per node,
+// with workers pinned to the CPUs of their node. Each sequence keeps running
+// on the node where it first ran.
+extern const BASE_EXPORT Feature kUseNumaAwareThreadGroups;
+
+// Under this feature, idle workers of foreground ThreadGroupImpls spin for up
+// to |kMaxIdleWorkerSpinDuration| before sleeping, when recent wake ups were
+// closer together than that.
+extern const BASE_EXPORT Feature kSpinIdleWorkers;
+extern const BASE_EXPORT base::FeatureParam<TimeDelta>
+    kMaxIdleWorkerSpinDuration;
+
+// Under this feature, ThreadPool samples one task out of
+// |kTaskLatencySamplingInterval| on each worker and aggregates its queueing
+// delay and run time by post site and traits, in a registry which can be
+// snapshotted at any time.
+extern const BASE_EXPORT Feature kSampleTaskLatency;
+extern const BASE_EXPORT base::FeatureParam<int> kTaskLatencySamplingInterval;
+
+// Under this feature, a ThreadGroupImpl worker which picked up a sequence runs
+// up to |kMaxBatchedTasks| of its tasks, or keeps running them for up to
+// |kMaxBatchDuration|, without going back through the thread group's lock in
+// between. The batch ends early when higher priority work is waiting for a
+// worker.
+extern const BASE_EXPORT Feature kBatchTaskSourceDraining;
+extern const BASE_EXPORT base::FeatureParam<int> kMaxBatchedTasks;
+extern const BASE_EXPORT base::FeatureParam<TimeDelta> kMaxBatchDuration;
+
+// Under this feature, a ThreadGroupImpl doesn't wake up workers when new work
+// arrives while a worker it woke up hasn't gotten work yet. That worker wakes
+// up as many workers as the work left requires once it gets work, so a burst
+// of posts doesn't wake up workers for work that gets done by others first.
+extern const BASE_EXPORT Feature kCoalesceWakeUps;
 
 // Strategy affecting how WorkerThreads are signaled to pick up pending work.
 enum class WakeUpStrategy {
@@ -15,6 +15,7 @@
 #include "base/base_export.h"
 #include "base/check_op.h"
 #include "base/task/task_traits_extension.h"
+#include "base/time/time.h"
 #include "base/traits_bag.h"
 #include "build/build_config.h"
 
@@ -194,6 +195,26 @@ struct MayBlock {};
 // In doubt, consult with //base/task/OWNERS.
 struct WithBaseSyncPrimitives {};
 
+// Tasks with this trait should start running at most |delay| after they are
+// ready to run (i.e. after they are posted, or after their delay expires).
+// Within a priority, the thread pool runs task sources with a deadline in
+// earliest deadline first order, before task sources without one.
+// Tasks which start running after their deadline are counted as missed
+// deadlines. |delay| must be positive.
+//
+// E.g.
+// base::ThreadPool::PostTask(
+//     FROM_HERE,
+//     {base::TaskPriority::USER_VISIBLE,
+//      base::TaskDeadline(base::TimeDelta::FromMilliseconds(5))},
+//     base::BindOnce(...));
+struct TaskDeadline {
+  constexpr explicit TaskDeadline(TimeDelta delay) : delay(delay) {
+    DCHECK_GT(delay, TimeDelta());
+  }
+  TimeDelta delay;
+};
+
 // Describes metadata for a single task or a group of tasks.
 class BASE_EXPORT TaskTraits {
  public:
@@ -204,6 +225,7 @@ class BASE_EXPORT TaskTraits {
     ValidTrait(ThreadPolicy);
     ValidTrait(MayBlock);
     ValidTrait(WithBaseSyncPrimitives);
+    ValidTrait(TaskDeadline);
   };
 
   // Invoking this constructor without arguments produces default TaskTraits
@@ -238,7 +260,9 @@ class BASE_EXPORT TaskTraits {
                 trait_helpers::AreValidTraits<ValidTrait, ArgTypes...>::value ||
                 trait_helpers::AreValidTraitsForExtension<ArgTypes...>::value>>
   constexpr TaskTraits(ArgTypes... args)
-      : extension_(trait_helpers::GetTaskTraitsExtension(
+      : deadline_(trait_helpers::GetTraitFromArgList<DeadlineTraitFilter>(
+            args...)),
+        extension_(trait_helpers::GetTaskTraitsExtension(
             trait_helpers::AreValidTraits<ValidTrait, ArgTypes...>{},
             args...)),
         priority_(
@@ -269,9 +293,10 @@ class BASE_EXPORT TaskTraits {
 
   // TODO(eseckler): Default the comparison operator once C++20 arrives.
   bool operator==(const TaskTraits& other) const {
-    static_assert(sizeof(TaskTraits) == 15,
+    static_assert(sizeof(TaskTraits) == 24,
                   "Update comparison operator when TaskTraits change");
-    return extension_ == other.extension_ && priority_ == other.priority_ &&
+    return deadline_ == other.deadline_ && extension_ == other.extension_ &&
+           priority_ == other.priority_ &&
            shutdown_behavior_ == other.shutdown_behavior_ &&
            thread_policy_ == other.thread_policy_ &&
            may_block_ == other.may_block_ &&
@@ -309,6 +334,10 @@ class BASE_EXPORT TaskTraits {
   // Returns true if tasks with these traits may block.
   constexpr bool may_block() const { return may_block_; }
 
+  // Returns the delay after which tasks with these traits should have started
+  // running once ready, or zero if they have no deadline.
+  constexpr TimeDelta deadline() const { return deadline_; }
+
   // Returns true if tasks with these traits may use base/ sync primitives.
   constexpr bool with_base_sync_primitives() const {
     return with_base_sync_primitives_;
@@ -345,7 +374,7 @@ class BASE_EXPORT TaskTraits {
         may_block_(may_block),
         with_base_sync_primitives_(false),
         use_thread_pool_(use_thread_pool) {
-    static_assert(sizeof(TaskTraits) == 15, "Keep this constructor up to date");
+    static_assert(sizeof(TaskTraits) == 24, "Keep this constructor up to date");
 
     // Java is expected to provide an explicit destination. See TODO in
     // TaskTraits.java to move towards API-as-a-destination there as well.
@@ -355,11 +384,19 @@ class BASE_EXPORT TaskTraits {
     DCHECK(use_thread_pool_ ^ has_extension);
   }
 
+  struct DeadlineTraitFilter
+      : public trait_helpers::BasicTraitFilter<TaskDeadline, TimeDelta> {
+    constexpr DeadlineTraitFilter() : BasicTraitFilter(TimeDelta()) {}
+    constexpr DeadlineTraitFilter(TaskDeadline deadline)
+        : BasicTraitFilter(deadline.delay) {}
+  };
+
   // This bit is set in |priority_|, |shutdown_behavior_| and |thread_policy_|
   // when the value was set explicitly.
   static constexpr uint8_t kIsExplicitFlag = 0x80;
 
   // Ordered for packing.
+  TimeDelta deadline_;
   TaskTraitsExtensionStorage extension_;
   TaskPriority priority_;
   uint8_t shutdown_behavior_;
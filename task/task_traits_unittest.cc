@@ -74,6 +74,18 @@ TEST(TaskTraitsTest, WithBaseSyncPrimitives) {
   EXPECT_TRUE(traits.with_base_sync_primitives());
 }
 
+TEST(TaskTraitsTest, TaskDeadline) {
+  constexpr TaskTraits traits = {
+      TaskDeadline(TimeDelta::FromMilliseconds(5))};
+  EXPECT_EQ(TaskPriority::USER_BLOCKING, traits.priority());
+  EXPECT_EQ(TimeDelta::FromMilliseconds(5), traits.deadline());
+  EXPECT_FALSE(traits.may_block());
+
+  constexpr TaskTraits default_traits = {};
+  EXPECT_TRUE(default_traits.deadline().is_zero());
+  EXPECT_FALSE(default_traits == traits);
+}
+
 TEST(TaskTraitsTest, UpdatePriority) {
   {
     TaskTraits traits = {};
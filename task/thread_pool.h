@@ -179,7 +179,8 @@ class BASE_EXPORT ThreadPool {
   // using |traits|. The priority in |traits| can be updated at any time via
   // UpdateableSequencedTaskRunner::UpdatePriority(). An update affects all
   // tasks posted to the task runner that aren't running yet. Tasks run one at a
-  // time in posting order.
+  // time in posting order. A ScopedSequencePriorityBoost can also raise the
+  // priority of these tasks while a higher priority task waits for them.
   //
   // |traits| requirements:
   // - base::ThreadPolicy must be specified if the priority of the task runner
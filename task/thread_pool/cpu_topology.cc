@@ -0,0 +1,167 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/thread_pool/cpu_topology.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "base/check.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "build/build_config.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/strings/string_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/thread_restrictions.h"
+#endif
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// Upper bound on CPU numbers, to reject corrupt lists.
+constexpr int kMaxNumCpus = 1 << 16;
+
+const std::vector<CpuList>* g_numa_nodes_for_testing = nullptr;
+const std::vector<CpuList>* g_last_level_cache_domains_for_testing = nullptr;
+
+// Whether to use the last-level cache |domains| of a machine with a single
+// NUMA node as its CPU nodes. Each node gets a thread group which doesn't
+// steal work from the others, so domains of one CPU, e.g. when each core has
+// its own last-level cache, would leave work queued behind a busy CPU.
+bool ShouldUseLastLevelCacheDomains(const std::vector<CpuList>& domains) {
+  return domains.size() > 1 &&
+         std::all_of(domains.begin(), domains.end(),
+                     [](const CpuList& domain) { return domain.size() > 1; });
+}
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+
+// Reads a CPU or node list from |path|. Returns an empty list on failure.
+CpuList ReadCpuList(const FilePath& path) {
+  std::string contents;
+  if (!ReadFileToString(path, &contents))
+    return CpuList();
+  return ParseCpuList(TrimWhitespaceASCII(contents, TRIM_ALL));
+}
+
+std::vector<CpuList> GetNumaNodes() {
+  std::vector<CpuList> nodes;
+  for (int node : ReadCpuList(FilePath("/sys/devices/system/node/online"))) {
+    CpuList cpus = ReadCpuList(FilePath(
+        StringPrintf("/sys/devices/system/node/node%d/cpulist", node)));
+    // Nodes with memory only don't have CPUs.
+    if (!cpus.empty())
+      nodes.push_back(std::move(cpus));
+  }
+  return nodes;
+}
+
+std::vector<CpuList> GetLastLevelCacheDomains() {
+  std::vector<CpuList> domains;
+  for (int cpu : ReadCpuList(FilePath("/sys/devices/system/cpu/online"))) {
+    // Find the highest level cache of |cpu|.
+    int last_level = 0;
+    CpuList last_level_cpus;
+    for (int index = 0;; ++index) {
+      const FilePath cache_path(StringPrintf(
+          "/sys/devices/system/cpu/cpu%d/cache/index%d", cpu, index));
+      std::string level_string;
+      int level = 0;
+      if (!ReadFileToString(cache_path.Append("level"), &level_string) ||
+          !StringToInt(TrimWhitespaceASCII(level_string, TRIM_ALL), &level)) {
+        break;
+      }
+      if (level > last_level) {
+        last_level = level;
+        last_level_cpus = ReadCpuList(cache_path.Append("shared_cpu_list"));
+      }
+    }
+    if (last_level_cpus.empty())
+      return std::vector<CpuList>();
+    if (std::find(domains.begin(), domains.end(), last_level_cpus) ==
+        domains.end()) {
+      domains.push_back(std::move(last_level_cpus));
+    }
+  }
+  return domains;
+}
+
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+
+}  // namespace
+
+std::vector<CpuList> GetCpuNodes() {
+  if (g_numa_nodes_for_testing) {
+    if (g_numa_nodes_for_testing->size() <= 1 &&
+        ShouldUseLastLevelCacheDomains(
+            *g_last_level_cache_domains_for_testing)) {
+      return *g_last_level_cache_domains_for_testing;
+    }
+    return *g_numa_nodes_for_testing;
+  }
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+  // sysfs is backed by memory, so reading it doesn't block in practice.
+  ThreadRestrictions::ScopedAllowIO allow_io;
+  std::vector<CpuList> nodes = GetNumaNodes();
+  if (nodes.size() <= 1) {
+    std::vector<CpuList> domains = GetLastLevelCacheDomains();
+    if (ShouldUseLastLevelCacheDomains(domains))
+      nodes = std::move(domains);
+  }
+  std::sort(nodes.begin(), nodes.end());
+  return nodes;
+#else
+  return std::vector<CpuList>();
+#endif
+}
+
+CpuList ParseCpuList(StringPiece cpu_list) {
+  CpuList cpus;
+  for (StringPiece range : SplitStringPiece(cpu_list, ",", TRIM_WHITESPACE,
+                                            SPLIT_WANT_NONEMPTY)) {
+    const std::vector<StringPiece> bounds =
+        SplitStringPiece(range, "-", KEEP_WHITESPACE, SPLIT_WANT_ALL);
+    int first = 0;
+    int last = 0;
+    if (bounds.size() > 2 || !StringToInt(bounds.front(), &first) ||
+        !StringToInt(bounds.back(), &last) || first < 0 || first > last ||
+        last >= kMaxNumCpus) {
+      return CpuList();
+    }
+    for (int cpu = first; cpu <= last; ++cpu)
+      cpus.push_back(cpu);
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+ScopedCpuNodesForTesting::ScopedCpuNodesForTesting(
+    std::vector<CpuList> numa_nodes,
+    std::vector<CpuList> last_level_cache_domains)
+    : numa_nodes_(std::move(numa_nodes)),
+      last_level_cache_domains_(std::move(last_level_cache_domains)),
+      previous_numa_nodes_(g_numa_nodes_for_testing),
+      previous_last_level_cache_domains_(
+          g_last_level_cache_domains_for_testing) {
+  g_numa_nodes_for_testing = &numa_nodes_;
+  g_last_level_cache_domains_for_testing = &last_level_cache_domains_;
+}
+
+ScopedCpuNodesForTesting::~ScopedCpuNodesForTesting() {
+  DCHECK_EQ(g_numa_nodes_for_testing, &numa_nodes_);
+  g_numa_nodes_for_testing = previous_numa_nodes_;
+  g_last_level_cache_domains_for_testing = previous_last_level_cache_domains_;
+}
+
+}  // namespace internal
+}  // namespace base
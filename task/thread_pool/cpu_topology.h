@@ -0,0 +1,54 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TASK_THREAD_POOL_CPU_TOPOLOGY_H_
+#define BASE_TASK_THREAD_POOL_CPU_TOPOLOGY_H_
+
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+namespace internal {
+
+// Logical CPU numbers, sorted in increasing order.
+using CpuList = std::vector<int>;
+
+// Returns the logical CPUs of each NUMA node of the machine which has CPUs, as
+// reported by /sys/devices/system/node. On a machine with a single NUMA node,
+// returns the CPUs sharing each last-level cache instead, if there are several
+// such groups and each has several CPUs. Returns an empty vector if the
+// topology can't be determined, which is always the case on platforms other
+// than Linux, ChromeOS and Android. Nodes are sorted by their first CPU. This
+// reads sysfs and is expected to be called once, at startup.
+BASE_EXPORT std::vector<CpuList> GetCpuNodes();
+
+// Parses a list in the format used by sysfs, e.g. "0-3,8,10-11". Returns an
+// empty list if |cpu_list| is malformed.
+BASE_EXPORT CpuList ParseCpuList(StringPiece cpu_list);
+
+// Overrides the NUMA nodes and last-level cache domains from which
+// GetCpuNodes() picks its result while in scope, to simulate other machines in
+// tests.
+class BASE_EXPORT ScopedCpuNodesForTesting {
+ public:
+  ScopedCpuNodesForTesting(std::vector<CpuList> numa_nodes,
+                           std::vector<CpuList> last_level_cache_domains);
+  ScopedCpuNodesForTesting(const ScopedCpuNodesForTesting&) = delete;
+  ScopedCpuNodesForTesting& operator=(const ScopedCpuNodesForTesting&) =
+      delete;
+  ~ScopedCpuNodesForTesting();
+
+ private:
+  const std::vector<CpuList> numa_nodes_;
+  const std::vector<CpuList> last_level_cache_domains_;
+  const std::vector<CpuList>* const previous_numa_nodes_;
+  const std::vector<CpuList>* const previous_last_level_cache_domains_;
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_TASK_THREAD_POOL_CPU_TOPOLOGY_H_
@@ -0,0 +1,70 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/thread_pool/cpu_topology.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace internal {
+
+TEST(ThreadPoolCpuTopologyTest, ParseCpuList) {
+  EXPECT_EQ(CpuList({0}), ParseCpuList("0"));
+  EXPECT_EQ(CpuList({0, 1, 2, 3, 8, 10, 11}), ParseCpuList("0-3,8,10-11"));
+  EXPECT_EQ(CpuList({1, 2, 3}), ParseCpuList("3,1-2,2"));
+  EXPECT_EQ(CpuList(), ParseCpuList(""));
+}
+
+TEST(ThreadPoolCpuTopologyTest, ParseMalformedCpuList) {
+  EXPECT_EQ(CpuList(), ParseCpuList("a"));
+  EXPECT_EQ(CpuList(), ParseCpuList("0-"));
+  EXPECT_EQ(CpuList(), ParseCpuList("3-1"));
+  EXPECT_EQ(CpuList(), ParseCpuList("0-1-2"));
+  EXPECT_EQ(CpuList(), ParseCpuList("-1"));
+  EXPECT_EQ(CpuList(), ParseCpuList("0,1-1000000000"));
+}
+
+// Each CPU belongs to at most one node.
+TEST(ThreadPoolCpuTopologyTest, GetCpuNodes) {
+  std::vector<int> all_cpus;
+  for (const CpuList& node : GetCpuNodes()) {
+    EXPECT_FALSE(node.empty());
+    all_cpus.insert(all_cpus.end(), node.begin(), node.end());
+  }
+  std::sort(all_cpus.begin(), all_cpus.end());
+  EXPECT_EQ(all_cpus.end(),
+            std::adjacent_find(all_cpus.begin(), all_cpus.end()));
+}
+
+TEST(ThreadPoolCpuTopologyTest, ScopedCpuNodesForTesting) {
+  const std::vector<CpuList> nodes = {{0, 1}, {2, 3}};
+  ScopedCpuNodesForTesting scoped_cpu_nodes(nodes, {});
+  EXPECT_EQ(nodes, GetCpuNodes());
+}
+
+// A single NUMA node is split by last-level cache, if each cache is shared by
+// several CPUs.
+TEST(ThreadPoolCpuTopologyTest, SharedLastLevelCaches) {
+  const std::vector<CpuList> domains = {{0, 1}, {2, 3}};
+  ScopedCpuNodesForTesting scoped_cpu_nodes({{0, 1, 2, 3}}, domains);
+  EXPECT_EQ(domains, GetCpuNodes());
+}
+
+// Per-core last-level caches would give each CPU its own thread group, so the
+// single NUMA node is used instead.
+TEST(ThreadPoolCpuTopologyTest, PerCoreLastLevelCaches) {
+  const std::vector<CpuList> nodes = {{0, 1, 2, 3}};
+  ScopedCpuNodesForTesting scoped_cpu_nodes(nodes, {{0}, {1}, {2}, {3}});
+  EXPECT_EQ(nodes, GetCpuNodes());
+
+  // Also when only some of the caches are per-core.
+  ScopedCpuNodesForTesting nested_cpu_nodes(nodes, {{0, 1}, {2}, {3}});
+  EXPECT_EQ(nodes, GetCpuNodes());
+}
+
+}  // namespace internal
+}  // namespace base
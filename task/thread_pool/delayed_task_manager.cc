@@ -8,8 +8,10 @@
 
 #include "base/bind.h"
 #include "base/check.h"
+#include "base/feature_list.h"
 #include "base/sequenced_task_runner.h"
 #include "base/task/post_task.h"
+#include "base/task/task_features.h"
 #include "base/task/thread_pool/task.h"
 #include "base/task_runner.h"
 #include "third_party/abseil-cpp/absl/types/optional.h"
@@ -70,6 +72,11 @@ void DelayedTaskManager::Start(
     CheckedAutoLock auto_lock(queue_lock_);
     DCHECK(!service_thread_task_runner_);
     service_thread_task_runner_ = std::move(service_thread_task_runner);
+    if (FeatureList::IsEnabled(kUseTimerWheelForDelayedTasks)) {
+      while (!IsEmptyLockRequired())
+        delayed_task_wheel_.insert(TakeMinLockRequired());
+      use_timer_wheel_ = true;
+    }
     process_ripe_tasks_time = GetTimeToScheduleProcessRipeTasksLockRequired();
   }
   ScheduleProcessRipeTasksOnServiceThread(process_ripe_tasks_time);
@@ -88,9 +95,9 @@ void DelayedTaskManager::AddDelayedTask(
   TimeTicks process_ripe_tasks_time;
   {
     CheckedAutoLock auto_lock(queue_lock_);
-    delayed_task_queue_.insert(DelayedTask(std::move(task),
-                                           std::move(post_task_now_callback),
-                                           std::move(task_runner)));
+    InsertLockRequired(DelayedTask(std::move(task),
+                                   std::move(post_task_now_callback),
+                                   std::move(task_runner)));
     // Not started yet.
     if (service_thread_task_runner_ == nullptr)
       return;
@@ -110,15 +117,10 @@ void DelayedTaskManager::ProcessRipeTasks() {
     // canceled. If it is canceled, schedule its deletion on the correct
     // sequence now rather than in the future, to minimize CPU wake ups and save
     // power.
-    while (!delayed_task_queue_.empty() &&
-           (delayed_task_queue_.Min().task.delayed_run_time <= now ||
-            !delayed_task_queue_.Min().task.task.MaybeValid())) {
-      // The const_cast on top is okay since the DelayedTask is
-      // transactionally being popped from |delayed_task_queue_| right after
-      // and the move doesn't alter the sort order.
-      ripe_delayed_tasks.push_back(
-          std::move(const_cast<DelayedTask&>(delayed_task_queue_.Min())));
-      delayed_task_queue_.Pop();
+    while (!IsEmptyLockRequired() &&
+           (MinLockRequired().task.delayed_run_time <= now ||
+            !MinLockRequired().task.task.MaybeValid())) {
+      ripe_delayed_tasks.push_back(TakeMinLockRequired());
     }
     process_ripe_tasks_time = GetTimeToScheduleProcessRipeTasksLockRequired();
   }
@@ -131,25 +133,55 @@ void DelayedTaskManager::ProcessRipeTasks() {
 
 absl::optional<TimeTicks> DelayedTaskManager::NextScheduledRunTime() const {
   CheckedAutoLock auto_lock(queue_lock_);
-  if (delayed_task_queue_.empty())
+  if (IsEmptyLockRequired())
     return absl::nullopt;
-  return delayed_task_queue_.Min().task.delayed_run_time;
+  return MinLockRequired().task.delayed_run_time;
 }
 
 TimeTicks DelayedTaskManager::GetTimeToScheduleProcessRipeTasksLockRequired() {
   queue_lock_.AssertAcquired();
-  if (delayed_task_queue_.empty())
+  if (IsEmptyLockRequired())
     return TimeTicks::Max();
   // The const_cast on top is okay since |IsScheduled()| and |SetScheduled()|
   // don't alter the sort order.
   DelayedTask& ripest_delayed_task =
-      const_cast<DelayedTask&>(delayed_task_queue_.Min());
+      const_cast<DelayedTask&>(MinLockRequired());
   if (ripest_delayed_task.IsScheduled())
     return TimeTicks::Max();
   ripest_delayed_task.SetScheduled();
   return ripest_delayed_task.task.delayed_run_time;
 }
 
+bool DelayedTaskManager::IsEmptyLockRequired() const {
+  return use_timer_wheel_ ? delayed_task_wheel_.empty()
+                          : delayed_task_queue_.empty();
+}
+
+const DelayedTaskManager::DelayedTask& DelayedTaskManager::MinLockRequired()
+    const {
+  return use_timer_wheel_ ? delayed_task_wheel_.Min()
+                          : delayed_task_queue_.Min();
+}
+
+DelayedTaskManager::DelayedTask DelayedTaskManager::TakeMinLockRequired() {
+  if (use_timer_wheel_)
+    return delayed_task_wheel_.TakeMin();
+  // The const_cast on top is okay since the DelayedTask is transactionally
+  // being popped from |delayed_task_queue_| right after and the move doesn't
+  // alter the sort order.
+  DelayedTask delayed_task =
+      std::move(const_cast<DelayedTask&>(delayed_task_queue_.Min()));
+  delayed_task_queue_.Pop();
+  return delayed_task;
+}
+
+void DelayedTaskManager::InsertLockRequired(DelayedTask delayed_task) {
+  if (use_timer_wheel_)
+    delayed_task_wheel_.insert(std::move(delayed_task));
+  else
+    delayed_task_queue_.insert(std::move(delayed_task));
+}
+
 void DelayedTaskManager::ScheduleProcessRipeTasksOnServiceThread(
     TimeTicks next_delayed_task_run_time) {
   DCHECK(!next_delayed_task_run_time.is_null());
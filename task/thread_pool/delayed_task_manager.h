@@ -12,6 +12,7 @@
 #include "base/synchronization/atomic_flag.h"
 #include "base/task/common/checked_lock.h"
 #include "base/task/common/intrusive_heap.h"
+#include "base/task/common/timer_wheel.h"
 #include "base/task/thread_pool/task.h"
 #include "base/thread_annotations.h"
 #include "base/time/default_tick_clock.h"
@@ -27,6 +28,9 @@ namespace internal {
 // The DelayedTaskManager forwards tasks to post task callbacks when they become
 // ripe for execution. Tasks are not forwarded before Start() is called. This
 // class is thread-safe.
+//
+// Delayed tasks are kept in a binary heap, or in a hierarchical timer wheel
+// with O(1) insertion under the kUseTimerWheelForDelayedTasks feature.
 class BASE_EXPORT DelayedTaskManager {
  public:
   // Posts |task| for execution immediately.
@@ -40,7 +44,9 @@ class BASE_EXPORT DelayedTaskManager {
   ~DelayedTaskManager();
 
   // Starts the delayed task manager, allowing past and future tasks to be
-  // forwarded to their callbacks as they become ripe for execution.
+  // forwarded to their callbacks as they become ripe for execution. Tasks added
+  // before this are moved to the timer wheel if kUseTimerWheelForDelayedTasks
+  // is enabled.
   // |service_thread_task_runner| posts tasks to the ThreadPool service
   // thread.
   void Start(scoped_refptr<SequencedTaskRunner> service_thread_task_runner);
@@ -99,6 +105,29 @@ class BASE_EXPORT DelayedTaskManager {
     bool scheduled_ = false;
   };
 
+  // Required by TimerWheel.
+  struct DelayedTaskRunsBefore {
+    bool operator()(const DelayedTask& a, const DelayedTask& b) const {
+      return a <= b && !(b <= a);
+    }
+  };
+
+  // Required by TimerWheel.
+  struct DelayedTaskRunTime {
+    TimeTicks operator()(const DelayedTask& delayed_task) const {
+      return delayed_task.task.delayed_run_time;
+    }
+  };
+
+  // Accessors that abstract whether |delayed_task_queue_| or
+  // |delayed_task_wheel_| is used.
+  bool IsEmptyLockRequired() const EXCLUSIVE_LOCKS_REQUIRED(queue_lock_);
+  const DelayedTask& MinLockRequired() const
+      EXCLUSIVE_LOCKS_REQUIRED(queue_lock_);
+  DelayedTask TakeMinLockRequired() EXCLUSIVE_LOCKS_REQUIRED(queue_lock_);
+  void InsertLockRequired(DelayedTask delayed_task)
+      EXCLUSIVE_LOCKS_REQUIRED(queue_lock_);
+
   // Get the time at which to schedule the next |ProcessRipeTasks()| execution,
   // or TimeTicks::Max() if none needs to be scheduled (i.e. no task, or next
   // task already scheduled).
@@ -125,6 +154,12 @@ class BASE_EXPORT DelayedTaskManager {
   scoped_refptr<SequencedTaskRunner> service_thread_task_runner_;
 
   IntrusiveHeap<DelayedTask> delayed_task_queue_ GUARDED_BY(queue_lock_);
+
+  // Used instead of |delayed_task_queue_| once Start() observed that
+  // kUseTimerWheelForDelayedTasks is enabled.
+  bool use_timer_wheel_ GUARDED_BY(queue_lock_) = false;
+  TimerWheel<DelayedTask, DelayedTaskRunsBefore, DelayedTaskRunTime>
+      delayed_task_wheel_ GUARDED_BY(queue_lock_);
 };
 
 }  // namespace internal
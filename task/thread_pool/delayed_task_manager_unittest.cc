@@ -13,8 +13,10 @@
 #include "base/memory/ptr_util.h"
 #include "base/memory/ref_counted.h"
 #include "base/synchronization/waitable_event.h"
+#include "base/task/task_features.h"
 #include "base/task/thread_pool/task.h"
 #include "base/test/bind.h"
+#include "base/test/scoped_feature_list.h"
 #include "base/test/test_mock_time_task_runner.h"
 #include "base/threading/thread.h"
 #include "base/time/time.h"
@@ -45,7 +47,8 @@ Task ConstructMockedTask(testing::StrictMock<MockCallback>& mock_task,
   return task;
 }
 
-class ThreadPoolDelayedTaskManagerTest : public testing::Test {
+// The parameter is whether kUseTimerWheelForDelayedTasks is enabled.
+class ThreadPoolDelayedTaskManagerTest : public testing::TestWithParam<bool> {
  public:
   ThreadPoolDelayedTaskManagerTest(const ThreadPoolDelayedTaskManagerTest&) =
       delete;
@@ -53,9 +56,13 @@ class ThreadPoolDelayedTaskManagerTest : public testing::Test {
       const ThreadPoolDelayedTaskManagerTest&) = delete;
 
  protected:
-  ThreadPoolDelayedTaskManagerTest() = default;
+  ThreadPoolDelayedTaskManagerTest() {
+    feature_list_.InitWithFeatureState(kUseTimerWheelForDelayedTasks,
+                                       GetParam());
+  }
   ~ThreadPoolDelayedTaskManagerTest() override = default;
 
+  base::test::ScopedFeatureList feature_list_;
   const scoped_refptr<TestMockTimeTaskRunner> service_thread_task_runner_ =
       MakeRefCounted<TestMockTimeTaskRunner>();
   DelayedTaskManager delayed_task_manager_{
@@ -69,7 +76,7 @@ class ThreadPoolDelayedTaskManagerTest : public testing::Test {
 }  // namespace
 
 // Verify that a delayed task isn't forwarded before Start().
-TEST_F(ThreadPoolDelayedTaskManagerTest, DelayedTaskDoesNotRunBeforeStart) {
+TEST_P(ThreadPoolDelayedTaskManagerTest, DelayedTaskDoesNotRunBeforeStart) {
   // Send |task| to the DelayedTaskManager.
   delayed_task_manager_.AddDelayedTask(std::move(task_), BindOnce(&PostTaskNow),
                                        nullptr);
@@ -83,7 +90,7 @@ TEST_F(ThreadPoolDelayedTaskManagerTest, DelayedTaskDoesNotRunBeforeStart) {
 
 // Verify that a delayed task added before Start() and whose delay expires after
 // Start() is forwarded when its delay expires.
-TEST_F(ThreadPoolDelayedTaskManagerTest,
+TEST_P(ThreadPoolDelayedTaskManagerTest,
        DelayedTaskPostedBeforeStartExpiresAfterStartRunsOnExpire) {
   // Send |task| to the DelayedTaskManager.
   delayed_task_manager_.AddDelayedTask(std::move(task_), BindOnce(&PostTaskNow),
@@ -103,7 +110,7 @@ TEST_F(ThreadPoolDelayedTaskManagerTest,
 
 // Verify that a delayed task added before Start() and whose delay expires
 // before Start() is forwarded when Start() is called.
-TEST_F(ThreadPoolDelayedTaskManagerTest,
+TEST_P(ThreadPoolDelayedTaskManagerTest,
        DelayedTaskPostedBeforeStartExpiresBeforeStartRunsOnStart) {
   // Send |task| to the DelayedTaskManager.
   delayed_task_manager_.AddDelayedTask(std::move(task_), BindOnce(&PostTaskNow),
@@ -126,7 +133,7 @@ TEST_F(ThreadPoolDelayedTaskManagerTest,
 
 // Verify that a delayed task added after Start() isn't forwarded before it is
 // ripe for execution.
-TEST_F(ThreadPoolDelayedTaskManagerTest, DelayedTaskDoesNotRunTooEarly) {
+TEST_P(ThreadPoolDelayedTaskManagerTest, DelayedTaskDoesNotRunTooEarly) {
   delayed_task_manager_.Start(service_thread_task_runner_);
 
   // Send |task| to the DelayedTaskManager.
@@ -140,7 +147,7 @@ TEST_F(ThreadPoolDelayedTaskManagerTest, DelayedTaskDoesNotRunTooEarly) {
 
 // Verify that a delayed task added after Start() is forwarded when it is ripe
 // for execution.
-TEST_F(ThreadPoolDelayedTaskManagerTest, DelayedTaskRunsAfterDelay) {
+TEST_P(ThreadPoolDelayedTaskManagerTest, DelayedTaskRunsAfterDelay) {
   delayed_task_manager_.Start(service_thread_task_runner_);
 
   // Send |task| to the DelayedTaskManager.
@@ -154,7 +161,7 @@ TEST_F(ThreadPoolDelayedTaskManagerTest, DelayedTaskRunsAfterDelay) {
 
 // Verify that a delayed task added after Start() is forwarded when it is
 // canceled, even if its delay hasn't expired.
-TEST_F(ThreadPoolDelayedTaskManagerTest, DelayedTaskRunsAfterCancelled) {
+TEST_P(ThreadPoolDelayedTaskManagerTest, DelayedTaskRunsAfterCancelled) {
   static_assert(kLongerDelay > kLongDelay, "");
 
   delayed_task_manager_.Start(service_thread_task_runner_);
@@ -187,7 +194,7 @@ TEST_F(ThreadPoolDelayedTaskManagerTest, DelayedTaskRunsAfterCancelled) {
 
 // Verify that multiple delayed tasks added after Start() are forwarded when
 // they are ripe for execution.
-TEST_F(ThreadPoolDelayedTaskManagerTest, DelayedTasksRunAfterDelay) {
+TEST_P(ThreadPoolDelayedTaskManagerTest, DelayedTasksRunAfterDelay) {
   delayed_task_manager_.Start(service_thread_task_runner_);
 
   testing::StrictMock<MockCallback> mock_callback_a;
@@ -231,7 +238,7 @@ TEST_F(ThreadPoolDelayedTaskManagerTest, DelayedTasksRunAfterDelay) {
   testing::Mock::VerifyAndClear(&mock_callback_b);
 }
 
-TEST_F(ThreadPoolDelayedTaskManagerTest, PostTaskDuringStart) {
+TEST_P(ThreadPoolDelayedTaskManagerTest, PostTaskDuringStart) {
   Thread other_thread("Test");
   other_thread.StartAndWaitForTesting();
 
@@ -257,5 +264,9 @@ TEST_F(ThreadPoolDelayedTaskManagerTest, PostTaskDuringStart) {
   service_thread_task_runner_->FastForwardBy(kLongDelay);
 }
 
+INSTANTIATE_TEST_SUITE_P(All,
+                         ThreadPoolDelayedTaskManagerTest,
+                         testing::Bool());
+
 }  // namespace internal
 }  // namespace base
@@ -357,10 +357,12 @@ bool JobTaskSource::DidProcessTask(TaskSource::Transaction* /*transaction*/) {
 TaskSourceSortKey JobTaskSource::GetSortKey(
     bool disable_fair_scheduling) const {
   if (disable_fair_scheduling) {
-    return TaskSourceSortKey(priority_racy(), ready_time_);
+    return TaskSourceSortKey(priority_racy(), ready_time_,
+                             /* worker_count=*/0, traits_.deadline());
   }
   return TaskSourceSortKey(priority_racy(), ready_time_,
-                           TS_UNCHECKED_READ(state_).Load().worker_count());
+                           TS_UNCHECKED_READ(state_).Load().worker_count(),
+                           traits_.deadline());
 }
 
 Task JobTaskSource::Clear(TaskSource::Transaction* transaction) {
@@ -39,6 +39,12 @@ class MockPooledTaskRunnerDelegate : public PooledTaskRunnerDelegate {
   MOCK_METHOD2(UpdateJobPriority,
                void(scoped_refptr<TaskSource> task_source,
                     TaskPriority priority));
+  MOCK_METHOD2(AddPriorityBoost,
+               void(scoped_refptr<TaskSource> task_source,
+                    TaskPriority priority));
+  MOCK_METHOD2(RemovePriorityBoost,
+               void(scoped_refptr<TaskSource> task_source,
+                    TaskPriority priority));
 };
 
 class ThreadPoolJobTaskSourceTest : public testing::Test {
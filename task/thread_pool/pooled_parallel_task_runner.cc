@@ -21,6 +21,15 @@ PooledParallelTaskRunner::~PooledParallelTaskRunner() = default;
 bool PooledParallelTaskRunner::PostDelayedTask(const Location& from_here,
                                                OnceClosure closure,
                                                TimeDelta delay) {
+  return PostDelayedTaskWithLeeway(from_here, std::move(closure), delay,
+                                   TimeDelta());
+}
+
+bool PooledParallelTaskRunner::PostDelayedTaskWithLeeway(
+    const Location& from_here,
+    OnceClosure closure,
+    TimeDelta delay,
+    TimeDelta leeway) {
   if (!PooledTaskRunnerDelegate::MatchesCurrentDelegate(
           pooled_task_runner_delegate_)) {
     return false;
@@ -28,7 +37,8 @@ bool PooledParallelTaskRunner::PostDelayedTask(const Location& from_here,
 
   // Post the task as part of a one-off single-task Sequence.
   scoped_refptr<Sequence> sequence = MakeRefCounted<Sequence>(
-      traits_, this, TaskSourceExecutionMode::kParallel);
+      traits_, this, TaskSourceExecutionMode::kParallel,
+      pooled_task_runner_delegate_->GetTaskNodePool(traits_));
 
   {
     CheckedAutoLock auto_lock(lock_);
@@ -36,7 +46,7 @@ bool PooledParallelTaskRunner::PostDelayedTask(const Location& from_here,
   }
 
   return pooled_task_runner_delegate_->PostTaskWithSequence(
-      Task(from_here, std::move(closure), TimeTicks::Now(), delay),
+      Task(from_here, std::move(closure), TimeTicks::Now(), delay, leeway),
       std::move(sequence));
 }
 
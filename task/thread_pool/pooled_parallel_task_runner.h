@@ -35,6 +35,10 @@ class BASE_EXPORT PooledParallelTaskRunner : public TaskRunner {
   bool PostDelayedTask(const Location& from_here,
                        OnceClosure closure,
                        TimeDelta delay) override;
+  bool PostDelayedTaskWithLeeway(const Location& from_here,
+                                 OnceClosure closure,
+                                 TimeDelta delay,
+                                 TimeDelta leeway) override;
 
   // Removes |sequence| from |sequences_|.
   void UnregisterSequence(Sequence* sequence);
@@ -4,6 +4,9 @@
 
 #include "base/task/thread_pool/pooled_sequenced_task_runner.h"
 
+#include <utility>
+#include <vector>
+
 #include "base/sequence_token.h"
 
 namespace base {
@@ -13,22 +16,32 @@ PooledSequencedTaskRunner::PooledSequencedTaskRunner(
     const TaskTraits& traits,
     PooledTaskRunnerDelegate* pooled_task_runner_delegate)
     : pooled_task_runner_delegate_(pooled_task_runner_delegate),
-      sequence_(MakeRefCounted<Sequence>(traits,
-                                         this,
-                                         TaskSourceExecutionMode::kSequenced)) {
-}
+      sequence_(MakeRefCounted<Sequence>(
+          traits,
+          this,
+          TaskSourceExecutionMode::kSequenced,
+          pooled_task_runner_delegate->GetTaskNodePool(traits))) {}
 
 PooledSequencedTaskRunner::~PooledSequencedTaskRunner() = default;
 
 bool PooledSequencedTaskRunner::PostDelayedTask(const Location& from_here,
                                                 OnceClosure closure,
                                                 TimeDelta delay) {
+  return PostDelayedTaskWithLeeway(from_here, std::move(closure), delay,
+                                   TimeDelta());
+}
+
+bool PooledSequencedTaskRunner::PostDelayedTaskWithLeeway(
+    const Location& from_here,
+    OnceClosure closure,
+    TimeDelta delay,
+    TimeDelta leeway) {
   if (!PooledTaskRunnerDelegate::MatchesCurrentDelegate(
           pooled_task_runner_delegate_)) {
     return false;
   }
 
-  Task task(from_here, std::move(closure), TimeTicks::Now(), delay);
+  Task task(from_here, std::move(closure), TimeTicks::Now(), delay, leeway);
 
   // Post the task as part of |sequence_|.
   return pooled_task_runner_delegate_->PostTaskWithSequence(std::move(task),
@@ -43,6 +56,26 @@ bool PooledSequencedTaskRunner::PostNonNestableDelayedTask(
   return PostDelayedTask(from_here, std::move(closure), delay);
 }
 
+bool PooledSequencedTaskRunner::PostTasks(const Location& from_here,
+                                          span<OnceClosure> tasks) {
+  if (!PooledTaskRunnerDelegate::MatchesCurrentDelegate(
+          pooled_task_runner_delegate_)) {
+    return false;
+  }
+
+  const TimeTicks queue_time = TimeTicks::Now();
+  std::vector<Task> pooled_tasks;
+  pooled_tasks.reserve(tasks.size());
+  for (OnceClosure& closure : tasks) {
+    pooled_tasks.emplace_back(from_here, std::move(closure), queue_time,
+                              TimeDelta());
+  }
+
+  // Post the tasks as part of |sequence_|.
+  return pooled_task_runner_delegate_->PostTasksWithSequence(
+      std::move(pooled_tasks), sequence_);
+}
+
 bool PooledSequencedTaskRunner::RunsTasksInCurrentSequence() const {
   return sequence_->token() == SequenceToken::GetForCurrentThread();
 }
@@ -51,5 +84,13 @@ void PooledSequencedTaskRunner::UpdatePriority(TaskPriority priority) {
   pooled_task_runner_delegate_->UpdatePriority(sequence_, priority);
 }
 
+void PooledSequencedTaskRunner::AddPriorityBoost(TaskPriority priority) {
+  pooled_task_runner_delegate_->AddPriorityBoost(sequence_, priority);
+}
+
+void PooledSequencedTaskRunner::RemovePriorityBoost(TaskPriority priority) {
+  pooled_task_runner_delegate_->RemovePriorityBoost(sequence_, priority);
+}
+
 }  // namespace internal
 }  // namespace base
@@ -7,6 +7,7 @@
 
 #include "base/base_export.h"
 #include "base/callback_forward.h"
+#include "base/containers/span.h"
 #include "base/location.h"
 #include "base/task/task_traits.h"
 #include "base/task/thread_pool/pooled_task_runner_delegate.h"
@@ -34,13 +35,21 @@ class BASE_EXPORT PooledSequencedTaskRunner
                        OnceClosure closure,
                        TimeDelta delay) override;
 
+  bool PostDelayedTaskWithLeeway(const Location& from_here,
+                                 OnceClosure closure,
+                                 TimeDelta delay,
+                                 TimeDelta leeway) override;
   bool PostNonNestableDelayedTask(const Location& from_here,
                                   OnceClosure closure,
                                   TimeDelta delay) override;
 
+  bool PostTasks(const Location& from_here, span<OnceClosure> tasks) override;
+
   bool RunsTasksInCurrentSequence() const override;
 
   void UpdatePriority(TaskPriority priority) override;
+  void AddPriorityBoost(TaskPriority priority) override;
+  void RemovePriorityBoost(TaskPriority priority) override;
 
  private:
   ~PooledSequencedTaskRunner() override;
@@ -407,10 +407,18 @@ class PooledSingleThreadTaskRunnerManager::PooledSingleThreadTaskRunner
   bool PostDelayedTask(const Location& from_here,
                        OnceClosure closure,
                        TimeDelta delay) override {
+    return PostDelayedTaskWithLeeway(from_here, std::move(closure), delay,
+                                     TimeDelta());
+  }
+
+  bool PostDelayedTaskWithLeeway(const Location& from_here,
+                                 OnceClosure closure,
+                                 TimeDelta delay,
+                                 TimeDelta leeway) override {
     if (!g_manager_is_alive)
       return false;
 
-    Task task(from_here, std::move(closure), TimeTicks::Now(), delay);
+    Task task(from_here, std::move(closure), TimeTicks::Now(), delay, leeway);
 
     if (!outer_->task_tracker_->WillPostTask(&task,
                                              sequence_->shutdown_behavior())) {
@@ -5,11 +5,14 @@
 #ifndef BASE_TASK_THREAD_POOL_POOLED_TASK_RUNNER_DELEGATE_H_
 #define BASE_TASK_THREAD_POOL_POOLED_TASK_RUNNER_DELEGATE_H_
 
+#include <vector>
+
 #include "base/base_export.h"
 #include "base/task/task_traits.h"
 #include "base/task/thread_pool/job_task_source.h"
 #include "base/task/thread_pool/sequence.h"
 #include "base/task/thread_pool/task.h"
+#include "base/task/thread_pool/task_node_pool.h"
 #include "base/task/thread_pool/task_source.h"
 
 namespace base {
@@ -41,6 +44,18 @@ class BASE_EXPORT PooledTaskRunnerDelegate {
   virtual bool PostTaskWithSequence(Task task,
                                     scoped_refptr<Sequence> sequence) = 0;
 
+  // Invoked when a batch of immediate |tasks| is posted to the
+  // PooledSequencedTaskRunner. The implementation must post |tasks| to
+  // |sequence| in order. Returns true if all tasks were successfully posted.
+  // The default implementation calls PostTaskWithSequence() for each task.
+  virtual bool PostTasksWithSequence(std::vector<Task> tasks,
+                                     scoped_refptr<Sequence> sequence);
+
+  // Returns the pool from which a Sequence with |traits| should allocate the
+  // nodes of its Tasks, or null to allocate them from the heap. The default
+  // implementation returns null.
+  virtual scoped_refptr<TaskNodePool> GetTaskNodePool(const TaskTraits& traits);
+
   // Invoked when a task is posted as a Job. The implementation must add
   // |task_source| to the appropriate priority queue, depending on |task_source|
   // traits, if it's not there already. Returns true if task source was
@@ -60,6 +75,15 @@ class BASE_EXPORT PooledTaskRunnerDelegate {
                               TaskPriority priority) = 0;
   virtual void UpdateJobPriority(scoped_refptr<TaskSource> task_source,
                                  TaskPriority priority) = 0;
+
+  // Invoked when a task of |priority| starts or stops waiting for work queued
+  // in |task_source|. The implementation must add or remove a priority boost
+  // to |task_source|, then place it in the correct priority-queue position
+  // within the appropriate thread group if its priority changed.
+  virtual void AddPriorityBoost(scoped_refptr<TaskSource> task_source,
+                                TaskPriority priority) = 0;
+  virtual void RemovePriorityBoost(scoped_refptr<TaskSource> task_source,
+                                   TaskPriority priority) = 0;
 };
 
 }  // namespace internal
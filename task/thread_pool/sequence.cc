@@ -110,7 +110,8 @@ bool Sequence::DidProcessTask(TaskSource::Transaction* transaction) {
 TaskSourceSortKey Sequence::GetSortKey(
     bool /* disable_fair_scheduling */) const {
   return TaskSourceSortKey(priority_racy(),
-                           ready_time_.load(std::memory_order_relaxed));
+                           ready_time_.load(std::memory_order_relaxed),
+                           /* worker_count=*/0, traits_.deadline());
 }
 
 Task Sequence::Clear(TaskSource::Transaction* transaction) {
@@ -120,7 +121,7 @@ Task Sequence::Clear(TaskSource::Transaction* transaction) {
     ReleaseTaskRunner();
   return Task(FROM_HERE,
               base::BindOnce(
-                  [](base::queue<Task> queue) {
+                  [](TaskNodeQueue queue) {
                     while (!queue.empty())
                       queue.pop();
                   },
@@ -143,7 +144,14 @@ void Sequence::ReleaseTaskRunner() {
 Sequence::Sequence(const TaskTraits& traits,
                    TaskRunner* task_runner,
                    TaskSourceExecutionMode execution_mode)
-    : TaskSource(traits, task_runner, execution_mode) {}
+    : Sequence(traits, task_runner, execution_mode, nullptr) {}
+
+Sequence::Sequence(const TaskTraits& traits,
+                   TaskRunner* task_runner,
+                   TaskSourceExecutionMode execution_mode,
+                   scoped_refptr<TaskNodePool> task_node_pool)
+    : TaskSource(traits, task_runner, execution_mode),
+      queue_(std::move(task_node_pool)) {}
 
 Sequence::~Sequence() = default;
 
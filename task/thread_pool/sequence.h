@@ -9,11 +9,11 @@
 
 #include "base/base_export.h"
 #include "base/compiler_specific.h"
-#include "base/containers/queue.h"
 #include "base/sequence_token.h"
 #include "base/task/task_traits.h"
 #include "base/task/thread_pool/pooled_parallel_task_runner.h"
 #include "base/task/thread_pool/task.h"
+#include "base/task/thread_pool/task_node_pool.h"
 #include "base/task/thread_pool/task_source.h"
 #include "base/task/thread_pool/task_source_sort_key.h"
 #include "base/threading/sequence_local_storage_map.h"
@@ -72,10 +72,15 @@ class BASE_EXPORT Sequence : public TaskSource {
   // |task_runner| is a reference to the TaskRunner feeding this TaskSource.
   // |task_runner| can be nullptr only for tasks with no TaskRunner, in which
   // case |execution_mode| must be kParallel. Otherwise, |execution_mode| is the
-  // execution mode of |task_runner|.
+  // execution mode of |task_runner|. Tasks are queued in nodes allocated from
+  // |task_node_pool|, or from the heap if it is null.
   Sequence(const TaskTraits& traits,
            TaskRunner* task_runner,
            TaskSourceExecutionMode execution_mode);
+  Sequence(const TaskTraits& traits,
+           TaskRunner* task_runner,
+           TaskSourceExecutionMode execution_mode,
+           scoped_refptr<TaskNodePool> task_node_pool);
   Sequence(const Sequence&) = delete;
   Sequence& operator=(const Sequence&) = delete;
 
@@ -111,7 +116,7 @@ class BASE_EXPORT Sequence : public TaskSource {
   const SequenceToken token_ = SequenceToken::Create();
 
   // Queue of tasks to execute.
-  base::queue<Task> queue_;
+  TaskNodeQueue queue_;
 
   std::atomic<TimeTicks> ready_time_{TimeTicks()};
 
@@ -222,6 +222,40 @@ TEST(ThreadPoolSequenceTest, TakeEmptyFrontSlot) {
 }
 
 // Verify that a DCHECK fires if TakeTask() is called on an empty sequence.
+// Verifies that priority boosts raise the priority of a sequence to that of
+// its highest active boost, and that UpdatePriority() applies below them.
+TEST(ThreadPoolSequenceTest, PriorityBoost) {
+  scoped_refptr<Sequence> sequence =
+      MakeRefCounted<Sequence>(TaskTraits(TaskPriority::BEST_EFFORT), nullptr,
+                               TaskSourceExecutionMode::kParallel);
+  Sequence::Transaction transaction(sequence->BeginTransaction());
+  transaction.PushTask(
+      Task(FROM_HERE, DoNothing(), TimeTicks::Now(), TimeDelta()));
+
+  transaction.AddPriorityBoost(TaskPriority::USER_VISIBLE);
+  EXPECT_EQ(TaskPriority::USER_VISIBLE, transaction.traits().priority());
+  EXPECT_EQ(TaskPriority::USER_VISIBLE, sequence->GetSortKey().priority());
+
+  transaction.AddPriorityBoost(TaskPriority::USER_BLOCKING);
+  transaction.AddPriorityBoost(TaskPriority::USER_BLOCKING);
+  EXPECT_EQ(TaskPriority::USER_BLOCKING, sequence->GetSortKey().priority());
+
+  transaction.RemovePriorityBoost(TaskPriority::USER_BLOCKING);
+  EXPECT_EQ(TaskPriority::USER_BLOCKING, sequence->GetSortKey().priority());
+  transaction.RemovePriorityBoost(TaskPriority::USER_BLOCKING);
+  EXPECT_EQ(TaskPriority::USER_VISIBLE, sequence->GetSortKey().priority());
+
+  // A boost doesn't lower the priority, and the priority set while boosted
+  // applies once the boost is removed.
+  transaction.UpdatePriority(TaskPriority::USER_BLOCKING);
+  EXPECT_EQ(TaskPriority::USER_BLOCKING, sequence->GetSortKey().priority());
+  transaction.UpdatePriority(TaskPriority::BEST_EFFORT);
+  EXPECT_EQ(TaskPriority::USER_VISIBLE, sequence->GetSortKey().priority());
+  transaction.RemovePriorityBoost(TaskPriority::USER_VISIBLE);
+  EXPECT_EQ(TaskPriority::BEST_EFFORT, transaction.traits().priority());
+  EXPECT_EQ(TaskPriority::BEST_EFFORT, sequence->priority_racy());
+}
+
 TEST(ThreadPoolSequenceTest, TakeEmptySequence) {
   scoped_refptr<Sequence> sequence = MakeRefCounted<Sequence>(
       TaskTraits(), nullptr, TaskSourceExecutionMode::kParallel);
@@ -7,6 +7,7 @@
 #include <utility>
 
 #include "base/atomic_sequence_num.h"
+#include "base/task/common/delayed_task_leeway.h"
 
 namespace base {
 namespace internal {
@@ -20,11 +21,14 @@ AtomicSequenceNumber g_sequence_nums_for_tracing;
 Task::Task(const Location& posted_from,
            OnceClosure task,
            TimeTicks queue_time,
-           TimeDelta delay)
+           TimeDelta delay,
+           TimeDelta leeway)
     : PendingTask(posted_from,
                   std::move(task),
                   queue_time,
-                  delay.is_zero() ? TimeTicks() : queue_time + delay) {
+                  delay.is_zero()
+                      ? TimeTicks()
+                      : AlignDelayedRunTime(queue_time + delay, leeway)) {
   // ThreadPoolImpl doesn't use |sequence_num| but tracing (toplevel.flow)
   // relies on it being unique. While this subtle dependency is a bit
   // overreaching, ThreadPoolImpl is the only task system that doesn't use
@@ -24,11 +24,13 @@ struct BASE_EXPORT Task : public PendingTask {
   Task() = default;
 
   // |posted_from| is the site the task was posted from. |task| is the closure
-  // to run. |delay| is a delay that must expire before the Task runs.
+  // to run. |delay| is a delay that must expire before the Task runs. The Task
+  // may run up to |leeway| after |delay| expires (see AlignDelayedRunTime()).
   Task(const Location& posted_from,
        OnceClosure task,
        TimeTicks queue_time,
-       TimeDelta delay);
+       TimeDelta delay,
+       TimeDelta leeway = TimeDelta());
 
   // Task is move-only to avoid mistakes that cause reference counts to be
   // accidentally bumped.
@@ -0,0 +1,281 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/thread_pool/task_latency_registry.h"
+
+#include <atomic>
+#include <utility>
+
+#include "base/bits.h"
+#include "base/check_op.h"
+#include "base/hash/hash.h"
+#include "base/ranges/algorithm.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// Packs the traits recorded by TaskLatencyRegistry in an integer.
+uint32_t PackTraits(TaskPriority priority,
+                    TaskShutdownBehavior shutdown_behavior,
+                    bool may_block) {
+  return static_cast<uint32_t>(priority) |
+         static_cast<uint32_t>(shutdown_behavior) << 8 |
+         static_cast<uint32_t>(may_block) << 16;
+}
+
+}  // namespace
+
+// Buckets in which a single thread records samples. Other threads read them
+// concurrently to merge snapshots: each entry is published with a release
+// store of |used| once its key is set, and its counters are relaxed atomics
+// which only the owning thread writes.
+class TaskLatencyRegistry::ThreadBuckets {
+ public:
+  ThreadBuckets() = default;
+  ThreadBuckets(const ThreadBuckets&) = delete;
+  ThreadBuckets& operator=(const ThreadBuckets&) = delete;
+  ~ThreadBuckets() = default;
+
+  // Takes ownership of these buckets for the current thread. Returns false if
+  // they are owned by another thread.
+  bool TryClaim() {
+    bool expected = false;
+    return owned_.compare_exchange_strong(expected, true,
+                                          std::memory_order_acquire,
+                                          std::memory_order_relaxed);
+  }
+
+  // Gives up ownership of these buckets. Happens-before the next TryClaim().
+  void Release() { owned_.store(false, std::memory_order_release); }
+
+  // Must be called by the owning thread.
+  bool ShouldSampleNextTask(int sampling_interval) {
+    if (++num_tasks_since_last_sample_ < sampling_interval)
+      return false;
+    num_tasks_since_last_sample_ = 0;
+    return true;
+  }
+
+  // Must be called by the owning thread.
+  void RecordSample(const Location& posted_from,
+                    uint32_t packed_traits,
+                    absl::optional<TimeDelta> queueing_delay,
+                    TimeDelta run_time,
+                    absl::optional<TimeDelta> run_thread_time) {
+    EntryBuckets* const entry = FindOrAddEntry(posted_from, packed_traits);
+    if (queueing_delay)
+      entry->Add(Metric::kQueueingDelay, queueing_delay.value());
+    entry->Add(Metric::kRunTime, run_time);
+    if (run_thread_time)
+      entry->Add(Metric::kRunThreadTime, run_thread_time.value());
+  }
+
+  // May be called from any thread.
+  void MergeInto(std::vector<Entry>* entries) const {
+    for (const EntryBuckets& entry_buckets : entries_) {
+      if (!entry_buckets.used.load(std::memory_order_acquire))
+        continue;
+      auto it = ranges::find_if(*entries, [&](const Entry& entry) {
+        return entry.posted_from == entry_buckets.posted_from &&
+               PackTraits(entry.priority, entry.shutdown_behavior,
+                          entry.may_block) == entry_buckets.packed_traits;
+      });
+      if (it == entries->end()) {
+        Entry& entry = entries->emplace_back();
+        entry.posted_from = entry_buckets.posted_from;
+        entry.priority = static_cast<TaskPriority>(
+            entry_buckets.packed_traits & 0xff);
+        entry.shutdown_behavior = static_cast<TaskShutdownBehavior>(
+            (entry_buckets.packed_traits >> 8) & 0xff);
+        entry.may_block = (entry_buckets.packed_traits >> 16) & 1;
+        it = entries->end() - 1;
+      }
+      entry_buckets.MergeInto(&*it);
+    }
+  }
+
+ private:
+  struct AtomicDistribution {
+    // Must be called by the owning thread.
+    void Add(TimeDelta sample) {
+      Increment(&count, uint64_t{1});
+      Increment(&sum_us, sample.InMicroseconds());
+      Increment(&buckets[Distribution::GetBucketIndex(sample)], uint64_t{1});
+    }
+
+    void MergeInto(Distribution* distribution) const {
+      distribution->count += count.load(std::memory_order_relaxed);
+      distribution->sum += TimeDelta::FromMicroseconds(
+          sum_us.load(std::memory_order_relaxed));
+      for (size_t i = 0; i < kNumBuckets; ++i) {
+        distribution->buckets[i] +=
+            buckets[i].load(std::memory_order_relaxed);
+      }
+    }
+
+    // A load and a store are cheaper than an atomic read-modify-write, and
+    // are sufficient with a single writer.
+    template <typename T>
+    static void Increment(std::atomic<T>* value, T increment) {
+      value->store(value->load(std::memory_order_relaxed) + increment,
+                   std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> count{0};
+    std::atomic<int64_t> sum_us{0};
+    std::array<std::atomic<uint64_t>, kNumBuckets> buckets = {};
+  };
+
+  struct EntryBuckets {
+    void Add(Metric metric, TimeDelta sample) {
+      distributions[static_cast<size_t>(metric)].Add(sample);
+    }
+
+    void MergeInto(Entry* entry) const {
+      for (size_t i = 0; i < kNumMetrics; ++i)
+        distributions[i].MergeInto(&entry->distributions[i]);
+    }
+
+    std::atomic<bool> used{false};
+    // Set before |used| and never modified after.
+    Location posted_from;
+    uint32_t packed_traits = 0;
+    std::array<AtomicDistribution, kNumMetrics> distributions;
+  };
+
+  // Returns the entry for (|posted_from|, |packed_traits|), or the overflow
+  // entry if there is no room left for a new entry.
+  EntryBuckets* FindOrAddEntry(const Location& posted_from,
+                               uint32_t packed_traits) {
+    static_assert(bits::IsPowerOfTwo(kMaxEntriesPerThread),
+                  "Probing relies on a power of two number of entries.");
+    size_t index = HashInts(reinterpret_cast<uintptr_t>(
+                                posted_from.program_counter()),
+                            packed_traits) &
+                   (kMaxEntriesPerThread - 1);
+    for (size_t probe = 0; probe < kMaxEntriesPerThread; ++probe) {
+      EntryBuckets& entry = entries_[index];
+      // Only this thread writes |used|, so a relaxed load is enough.
+      if (!entry.used.load(std::memory_order_relaxed)) {
+        entry.posted_from = posted_from;
+        entry.packed_traits = packed_traits;
+        entry.used.store(true, std::memory_order_release);
+        return &entry;
+      }
+      if (entry.posted_from == posted_from &&
+          entry.packed_traits == packed_traits) {
+        return &entry;
+      }
+      index = (index + 1) & (kMaxEntriesPerThread - 1);
+    }
+
+    EntryBuckets& overflow_entry = entries_[kMaxEntriesPerThread];
+    if (!overflow_entry.used.load(std::memory_order_relaxed)) {
+      overflow_entry.packed_traits = packed_traits;
+      overflow_entry.used.store(true, std::memory_order_release);
+    }
+    return &overflow_entry;
+  }
+
+  std::atomic<bool> owned_{false};
+
+  // Number of tasks that ran on the owning thread since the last sample.
+  int num_tasks_since_last_sample_ = 0;
+
+  // Open-addressed entries, followed by the overflow entry.
+  std::array<EntryBuckets, kMaxEntriesPerThread + 1> entries_;
+};
+
+TaskLatencyRegistry::Distribution::Distribution() = default;
+TaskLatencyRegistry::Distribution::Distribution(const Distribution&) = default;
+TaskLatencyRegistry::Distribution& TaskLatencyRegistry::Distribution::operator=(
+    const Distribution&) = default;
+TaskLatencyRegistry::Distribution::~Distribution() = default;
+
+// static
+size_t TaskLatencyRegistry::Distribution::GetBucketIndex(TimeDelta sample) {
+  const int64_t sample_us = sample.InMicroseconds();
+  if (sample_us < 1)
+    return 0;
+  // The index of the bucket is the number of bits needed to represent the
+  // sample, which is in [2^(index-1), 2^index).
+  const size_t index =
+      static_cast<size_t>(bits::Log2Floor(static_cast<uint64_t>(sample_us))) +
+      1;
+  return std::min(index, kNumBuckets - 1);
+}
+
+TaskLatencyRegistry::Entry::Entry() = default;
+TaskLatencyRegistry::Entry::Entry(const Entry&) = default;
+TaskLatencyRegistry::Entry& TaskLatencyRegistry::Entry::operator=(
+    const Entry&) = default;
+TaskLatencyRegistry::Entry::~Entry() = default;
+
+TaskLatencyRegistry::TaskLatencyRegistry(int sampling_interval)
+    : sampling_interval_(sampling_interval) {
+  DCHECK_GE(sampling_interval_, 1);
+}
+
+TaskLatencyRegistry::~TaskLatencyRegistry() = default;
+
+bool TaskLatencyRegistry::ShouldSampleNextTask() {
+  return GetThreadBuckets()->ShouldSampleNextTask(sampling_interval_);
+}
+
+void TaskLatencyRegistry::RecordSample(
+    const Location& posted_from,
+    const TaskTraits& traits,
+    absl::optional<TimeDelta> queueing_delay,
+    TimeDelta run_time,
+    absl::optional<TimeDelta> run_thread_time) {
+  GetThreadBuckets()->RecordSample(
+      posted_from,
+      PackTraits(traits.priority(), traits.shutdown_behavior(),
+                 traits.may_block()),
+      queueing_delay, run_time, run_thread_time);
+}
+
+std::vector<TaskLatencyRegistry::Entry> TaskLatencyRegistry::GetSnapshot()
+    const {
+  std::vector<Entry> entries;
+  CheckedAutoLock auto_lock(lock_);
+  for (const auto& thread_buckets : thread_buckets_)
+    thread_buckets->MergeInto(&entries);
+  return entries;
+}
+
+TaskLatencyRegistry::ThreadBuckets* TaskLatencyRegistry::GetThreadBuckets() {
+  ThreadBuckets* thread_buckets =
+      static_cast<ThreadBuckets*>(current_thread_buckets_.Get());
+  if (thread_buckets)
+    return thread_buckets;
+
+  {
+    CheckedAutoLock auto_lock(lock_);
+    for (const auto& candidate : thread_buckets_) {
+      if (candidate->TryClaim()) {
+        thread_buckets = candidate.get();
+        break;
+      }
+    }
+    if (!thread_buckets) {
+      thread_buckets_.push_back(std::make_unique<ThreadBuckets>());
+      thread_buckets = thread_buckets_.back().get();
+      const bool claimed = thread_buckets->TryClaim();
+      DCHECK(claimed);
+    }
+  }
+  current_thread_buckets_.Set(thread_buckets);
+  return thread_buckets;
+}
+
+// static
+void TaskLatencyRegistry::OnThreadExit(void* thread_buckets) {
+  static_cast<ThreadBuckets*>(thread_buckets)->Release();
+}
+
+}  // namespace internal
+}  // namespace base
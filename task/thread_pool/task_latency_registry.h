@@ -0,0 +1,142 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TASK_THREAD_POOL_TASK_LATENCY_REGISTRY_H_
+#define BASE_TASK_THREAD_POOL_TASK_LATENCY_REGISTRY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/location.h"
+#include "base/task/common/checked_lock.h"
+#include "base/task/task_traits.h"
+#include "base/thread_annotations.h"
+#include "base/threading/thread_local_storage.h"
+#include "base/time/time.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+namespace internal {
+
+// Aggregates timing samples of ThreadPool tasks by post site and TaskTraits,
+// in process and without a tracing session. Samples are recorded without locks
+// into buckets owned by the recording thread, and are merged when a snapshot
+// is requested.
+//
+// Each sample has:
+// - The queueing delay: from the time the task was ready to run (posted, or
+//   delayed run time reached) until it started running.
+// - The run time: wall time spent running the task.
+// - The run thread time: CPU time spent running the task, if ThreadTicks are
+//   supported. Along with the run time, it tells how much of the task ran
+//   without being preempted.
+//
+// This class is thread-safe.
+class BASE_EXPORT TaskLatencyRegistry {
+ public:
+  enum class Metric {
+    kQueueingDelay,
+    kRunTime,
+    kRunThreadTime,
+    kMaxValue = kRunThreadTime,
+  };
+  static constexpr size_t kNumMetrics =
+      static_cast<size_t>(Metric::kMaxValue) + 1;
+
+  // Bucket 0 counts samples under 1us. Bucket i > 0 counts samples in
+  // [2^(i-1), 2^i) us. The last bucket also counts larger samples.
+  static constexpr size_t kNumBuckets = 20;
+
+  // Maximum number of distinct (post site, traits) pairs recorded by each
+  // thread. Samples for other pairs are aggregated in an entry with a default
+  // Location and the traits of the first such sample.
+  static constexpr size_t kMaxEntriesPerThread = 128;
+
+  struct BASE_EXPORT Distribution {
+    Distribution();
+    Distribution(const Distribution&);
+    Distribution& operator=(const Distribution&);
+    ~Distribution();
+
+    // Returns the index of the bucket counting |sample|.
+    static size_t GetBucketIndex(TimeDelta sample);
+
+    uint64_t count = 0;
+    TimeDelta sum;
+    std::array<uint64_t, kNumBuckets> buckets = {};
+  };
+
+  struct BASE_EXPORT Entry {
+    Entry();
+    Entry(const Entry&);
+    Entry& operator=(const Entry&);
+    ~Entry();
+
+    const Distribution& distribution(Metric metric) const {
+      return distributions[static_cast<size_t>(metric)];
+    }
+
+    Location posted_from;
+    TaskPriority priority = TaskPriority::USER_BLOCKING;
+    TaskShutdownBehavior shutdown_behavior =
+        TaskShutdownBehavior::SKIP_ON_SHUTDOWN;
+    bool may_block = false;
+    std::array<Distribution, kNumMetrics> distributions;
+  };
+
+  // One task out of |sampling_interval| is sampled on each thread.
+  explicit TaskLatencyRegistry(int sampling_interval);
+  TaskLatencyRegistry(const TaskLatencyRegistry&) = delete;
+  TaskLatencyRegistry& operator=(const TaskLatencyRegistry&) = delete;
+  ~TaskLatencyRegistry();
+
+  // Returns true if the next task to run on the current thread should be
+  // sampled.
+  bool ShouldSampleNextTask();
+
+  // Records a sample for a task posted from |posted_from| with |traits|.
+  // |queueing_delay| is nullopt if the task has no ready time (e.g. a job
+  // worker task). |run_thread_time| is nullopt if ThreadTicks aren't supported.
+  void RecordSample(const Location& posted_from,
+                    const TaskTraits& traits,
+                    absl::optional<TimeDelta> queueing_delay,
+                    TimeDelta run_time,
+                    absl::optional<TimeDelta> run_thread_time);
+
+  // Returns the merged samples of all threads, one Entry per (post site,
+  // traits) pair, in no particular order. Samples recorded concurrently may or
+  // may not be included.
+  std::vector<Entry> GetSnapshot() const;
+
+ private:
+  class ThreadBuckets;
+
+  // Returns the buckets of the current thread, creating or reusing them if
+  // needed.
+  ThreadBuckets* GetThreadBuckets();
+
+  // Releases |thread_buckets| when their thread exits, so that they can be
+  // reused by another thread. Their samples remain part of snapshots.
+  static void OnThreadExit(void* thread_buckets);
+
+  const int sampling_interval_;
+
+  ThreadLocalStorage::Slot current_thread_buckets_{&OnThreadExit};
+
+  mutable CheckedLock lock_;
+
+  // Buckets of all threads which recorded samples, current or exited.
+  std::vector<std::unique_ptr<ThreadBuckets>> thread_buckets_
+      GUARDED_BY(lock_);
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_TASK_THREAD_POOL_TASK_LATENCY_REGISTRY_H_
@@ -0,0 +1,191 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/thread_pool/task_latency_registry.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/bind.h"
+#include "base/callback.h"
+#include "base/location.h"
+#include "base/ranges/algorithm.h"
+#include "base/task/task_traits.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+using Metric = TaskLatencyRegistry::Metric;
+
+// Returns a Location with a distinct program counter for each |id|.
+Location MakeLocation(int id) {
+  return Location("Function", "file.cc", id,
+                  reinterpret_cast<const void*>(static_cast<uintptr_t>(id)));
+}
+
+const TaskLatencyRegistry::Entry* FindEntry(
+    const std::vector<TaskLatencyRegistry::Entry>& entries,
+    const Location& posted_from,
+    TaskPriority priority) {
+  auto it = ranges::find_if(entries, [&](const TaskLatencyRegistry::Entry& e) {
+    return e.posted_from == posted_from && e.priority == priority;
+  });
+  return it == entries.end() ? nullptr : &*it;
+}
+
+class CallbackThread : public SimpleThread {
+ public:
+  explicit CallbackThread(OnceClosure closure)
+      : SimpleThread("CallbackThread"), closure_(std::move(closure)) {}
+  CallbackThread(const CallbackThread&) = delete;
+  CallbackThread& operator=(const CallbackThread&) = delete;
+
+ private:
+  void Run() override { std::move(closure_).Run(); }
+
+  OnceClosure closure_;
+};
+
+void RecordSamples(TaskLatencyRegistry* registry,
+                   const Location& posted_from,
+                   int num_samples) {
+  for (int i = 0; i < num_samples; ++i) {
+    registry->RecordSample(posted_from, {}, TimeDelta::FromMicroseconds(10),
+                           TimeDelta::FromMicroseconds(100),
+                           TimeDelta::FromMicroseconds(50));
+  }
+}
+
+}  // namespace
+
+TEST(TaskLatencyRegistryTest, GetBucketIndex) {
+  using Distribution = TaskLatencyRegistry::Distribution;
+  EXPECT_EQ(0U, Distribution::GetBucketIndex(TimeDelta()));
+  EXPECT_EQ(0U, Distribution::GetBucketIndex(TimeDelta::FromNanoseconds(999)));
+  EXPECT_EQ(1U, Distribution::GetBucketIndex(TimeDelta::FromMicroseconds(1)));
+  EXPECT_EQ(2U, Distribution::GetBucketIndex(TimeDelta::FromMicroseconds(2)));
+  EXPECT_EQ(2U, Distribution::GetBucketIndex(TimeDelta::FromMicroseconds(3)));
+  EXPECT_EQ(11U,
+            Distribution::GetBucketIndex(TimeDelta::FromMicroseconds(1024)));
+  EXPECT_EQ(TaskLatencyRegistry::kNumBuckets - 1,
+            Distribution::GetBucketIndex(TimeDelta::FromHours(1)));
+}
+
+TEST(TaskLatencyRegistryTest, ShouldSampleNextTask) {
+  TaskLatencyRegistry registry(3);
+  EXPECT_FALSE(registry.ShouldSampleNextTask());
+  EXPECT_FALSE(registry.ShouldSampleNextTask());
+  EXPECT_TRUE(registry.ShouldSampleNextTask());
+  EXPECT_FALSE(registry.ShouldSampleNextTask());
+  EXPECT_FALSE(registry.ShouldSampleNextTask());
+  EXPECT_TRUE(registry.ShouldSampleNextTask());
+}
+
+// Samples are aggregated by post site and traits.
+TEST(TaskLatencyRegistryTest, AggregatesByPostSiteAndTraits) {
+  TaskLatencyRegistry registry(1);
+  EXPECT_TRUE(registry.GetSnapshot().empty());
+
+  registry.RecordSample(MakeLocation(1), {TaskPriority::USER_BLOCKING},
+                        TimeDelta::FromMicroseconds(3),
+                        TimeDelta::FromMicroseconds(100),
+                        TimeDelta::FromMicroseconds(50));
+  registry.RecordSample(MakeLocation(1), {TaskPriority::USER_BLOCKING},
+                        TimeDelta::FromMicroseconds(5),
+                        TimeDelta::FromMicroseconds(200), absl::nullopt);
+  registry.RecordSample(MakeLocation(1), {TaskPriority::BEST_EFFORT},
+                        absl::nullopt, TimeDelta::FromMicroseconds(1),
+                        TimeDelta::FromMicroseconds(1));
+  registry.RecordSample(MakeLocation(2), {TaskPriority::USER_BLOCKING},
+                        TimeDelta(), TimeDelta(), TimeDelta());
+
+  const std::vector<TaskLatencyRegistry::Entry> snapshot =
+      registry.GetSnapshot();
+  EXPECT_EQ(3U, snapshot.size());
+
+  const TaskLatencyRegistry::Entry* entry =
+      FindEntry(snapshot, MakeLocation(1), TaskPriority::USER_BLOCKING);
+  ASSERT_TRUE(entry);
+  const TaskLatencyRegistry::Distribution& queueing_delay =
+      entry->distribution(Metric::kQueueingDelay);
+  EXPECT_EQ(2U, queueing_delay.count);
+  EXPECT_EQ(TimeDelta::FromMicroseconds(8), queueing_delay.sum);
+  EXPECT_EQ(2U, queueing_delay.buckets[3]);
+  EXPECT_EQ(2U, entry->distribution(Metric::kRunTime).count);
+  EXPECT_EQ(TimeDelta::FromMicroseconds(300),
+            entry->distribution(Metric::kRunTime).sum);
+  EXPECT_EQ(1U, entry->distribution(Metric::kRunThreadTime).count);
+
+  entry = FindEntry(snapshot, MakeLocation(1), TaskPriority::BEST_EFFORT);
+  ASSERT_TRUE(entry);
+  EXPECT_EQ(0U, entry->distribution(Metric::kQueueingDelay).count);
+  EXPECT_EQ(1U, entry->distribution(Metric::kRunTime).count);
+
+  EXPECT_TRUE(
+      FindEntry(snapshot, MakeLocation(2), TaskPriority::USER_BLOCKING));
+}
+
+// Samples recorded on different threads are merged.
+TEST(TaskLatencyRegistryTest, MergesThreads) {
+  TaskLatencyRegistry registry(1);
+  RecordSamples(&registry, MakeLocation(1), 5);
+
+  CallbackThread thread(
+      BindOnce(&RecordSamples, Unretained(&registry), MakeLocation(1), 7));
+  thread.Start();
+  thread.Join();
+
+  const std::vector<TaskLatencyRegistry::Entry> snapshot =
+      registry.GetSnapshot();
+  ASSERT_EQ(1U, snapshot.size());
+  EXPECT_EQ(12U, snapshot[0].distribution(Metric::kRunTime).count);
+}
+
+// Samples of a thread which exited are kept when another thread reuses its
+// buckets.
+TEST(TaskLatencyRegistryTest, ReusesBucketsOfExitedThreads) {
+  TaskLatencyRegistry registry(1);
+  for (int i = 1; i <= 3; ++i) {
+    CallbackThread thread(
+        BindOnce(&RecordSamples, Unretained(&registry), MakeLocation(i), 1));
+    thread.Start();
+    thread.Join();
+  }
+
+  const std::vector<TaskLatencyRegistry::Entry> snapshot =
+      registry.GetSnapshot();
+  EXPECT_EQ(3U, snapshot.size());
+  for (int i = 1; i <= 3; ++i) {
+    const TaskLatencyRegistry::Entry* entry =
+        FindEntry(snapshot, MakeLocation(i), TaskPriority::USER_BLOCKING);
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(1U, entry->distribution(Metric::kRunTime).count);
+  }
+}
+
+// Samples for post sites beyond the capacity of a thread's buckets are
+// aggregated in an entry with a default Location.
+TEST(TaskLatencyRegistryTest, Overflow) {
+  constexpr int kNumPostSites = TaskLatencyRegistry::kMaxEntriesPerThread + 10;
+  TaskLatencyRegistry registry(1);
+  for (int i = 1; i <= kNumPostSites; ++i)
+    RecordSamples(&registry, MakeLocation(i), 1);
+
+  const std::vector<TaskLatencyRegistry::Entry> snapshot =
+      registry.GetSnapshot();
+  EXPECT_EQ(TaskLatencyRegistry::kMaxEntriesPerThread + 1, snapshot.size());
+  const TaskLatencyRegistry::Entry* overflow_entry =
+      FindEntry(snapshot, Location(), TaskPriority::USER_BLOCKING);
+  ASSERT_TRUE(overflow_entry);
+  EXPECT_EQ(10U, overflow_entry->distribution(Metric::kRunTime).count);
+}
+
+}  // namespace internal
+}  // namespace base
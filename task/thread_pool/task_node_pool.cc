@@ -0,0 +1,227 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/thread_pool/task_node_pool.h"
+
+#include <inttypes.h>
+#include <stdint.h>
+
+#include <set>
+#include <utility>
+
+#include "base/no_destructor.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "base/trace_event/base_tracing.h"
+#include "base/tracing_buildflags.h"
+
+#if BUILDFLAG(ENABLE_BASE_TRACING)
+#include "base/trace_event/memory_dump_manager.h"  // no-presubmit-check
+#include "base/trace_event/process_memory_dump.h"  // no-presubmit-check
+#endif  // BUILDFLAG(ENABLE_BASE_TRACING)
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// Reports the nodes of all live TaskNodePools to memory-infra.
+class TaskNodePoolRegistry : public trace_event::MemoryDumpProvider {
+ public:
+  static TaskNodePoolRegistry* GetInstance() {
+    static NoDestructor<TaskNodePoolRegistry> instance;
+    return instance.get();
+  }
+
+  TaskNodePoolRegistry() {
+#if BUILDFLAG(ENABLE_BASE_TRACING)
+    trace_event::MemoryDumpManager::GetInstance()->RegisterDumpProvider(
+        this, "ThreadPoolTaskNodes", nullptr);
+#endif  // BUILDFLAG(ENABLE_BASE_TRACING)
+  }
+  TaskNodePoolRegistry(const TaskNodePoolRegistry&) = delete;
+  TaskNodePoolRegistry& operator=(const TaskNodePoolRegistry&) = delete;
+
+  void AddPool(const TaskNodePool* pool) {
+    AutoLock auto_lock(lock_);
+    pools_.insert(pool);
+  }
+
+  void RemovePool(const TaskNodePool* pool) {
+    AutoLock auto_lock(lock_);
+    pools_.erase(pool);
+  }
+
+  // trace_event::MemoryDumpProvider:
+  bool OnMemoryDump(const trace_event::MemoryDumpArgs& args,
+                    trace_event::ProcessMemoryDump* pmd) override {
+#if BUILDFLAG(ENABLE_BASE_TRACING)
+    using trace_event::MemoryAllocatorDump;
+    const char* system_allocator_pool_name =
+        trace_event::MemoryDumpManager::GetInstance()
+            ->system_allocator_pool_name();
+
+    AutoLock auto_lock(lock_);
+    for (const TaskNodePool* pool : pools_) {
+      const TaskNodePool::Stats stats = pool->GetStats();
+      MemoryAllocatorDump* dump = pmd->CreateAllocatorDump(
+          StringPrintf("thread_pool/task_nodes/pool_0x%" PRIXPTR,
+                       reinterpret_cast<uintptr_t>(pool)));
+      dump->AddScalar(MemoryAllocatorDump::kNameSize,
+                      MemoryAllocatorDump::kUnitsBytes,
+                      stats.num_nodes * sizeof(TaskNode));
+      dump->AddScalar(MemoryAllocatorDump::kNameObjectCount,
+                      MemoryAllocatorDump::kUnitsObjects, stats.num_nodes);
+      dump->AddScalar("free_size", MemoryAllocatorDump::kUnitsBytes,
+                      stats.num_free_nodes * sizeof(TaskNode));
+      if (system_allocator_pool_name)
+        pmd->AddSuballocation(dump->guid(), system_allocator_pool_name);
+    }
+#endif  // BUILDFLAG(ENABLE_BASE_TRACING)
+    return true;
+  }
+
+ private:
+  Lock lock_;
+  std::set<const TaskNodePool*> pools_ GUARDED_BY(lock_);
+};
+
+}  // namespace
+
+TaskNode::TaskNode() = default;
+
+TaskNode::~TaskNode() = default;
+
+TaskNodePool::TaskNodePool() : TaskNodePool(kDefaultMaxFreeNodes) {}
+
+TaskNodePool::TaskNodePool(size_t max_free_nodes)
+    : max_free_nodes_(max_free_nodes) {
+  TaskNodePoolRegistry::GetInstance()->AddPool(this);
+}
+
+TaskNodePool::~TaskNodePool() {
+  TaskNodePoolRegistry::GetInstance()->RemovePool(this);
+  CheckedAutoLock auto_lock(lock_);
+  while (free_list_) {
+    TaskNode* const node = free_list_;
+    free_list_ = node->next;
+    delete node;
+  }
+}
+
+TaskNode* TaskNodePool::Allocate(Task task) {
+  TaskNode* node = nullptr;
+  {
+    CheckedAutoLock auto_lock(lock_);
+    if (free_list_) {
+      node = free_list_;
+      free_list_ = node->next;
+      --num_free_nodes_;
+    }
+  }
+  if (!node) {
+    node = new TaskNode;
+    num_nodes_.fetch_add(1, std::memory_order_relaxed);
+    num_heap_allocations_.fetch_add(1, std::memory_order_relaxed);
+  }
+  node->next = nullptr;
+  node->task = std::move(task);
+  return node;
+}
+
+void TaskNodePool::Free(TaskNode* node) {
+  DCHECK(!node->task.task);
+  {
+    CheckedAutoLock auto_lock(lock_);
+    if (num_free_nodes_ < max_free_nodes_) {
+      node->next = free_list_;
+      free_list_ = node;
+      ++num_free_nodes_;
+      return;
+    }
+  }
+  num_nodes_.fetch_sub(1, std::memory_order_relaxed);
+  delete node;
+}
+
+TaskNodePool::Stats TaskNodePool::GetStats() const {
+  Stats stats;
+  {
+    CheckedAutoLock auto_lock(lock_);
+    stats.num_free_nodes = num_free_nodes_;
+  }
+  stats.num_nodes = num_nodes_.load(std::memory_order_relaxed);
+  stats.num_heap_allocations =
+      num_heap_allocations_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+TaskNodeQueue::TaskNodeQueue(scoped_refptr<TaskNodePool> pool)
+    : pool_(std::move(pool)) {}
+
+TaskNodeQueue::TaskNodeQueue(TaskNodeQueue&& other)
+    : pool_(other.pool_), front_(other.front_), back_(other.back_) {
+  other.front_ = nullptr;
+  other.back_ = nullptr;
+}
+
+TaskNodeQueue::~TaskNodeQueue() {
+  while (!empty())
+    pop();
+  if (spare_node_) {
+    if (pool_)
+      pool_->Free(spare_node_);
+    else
+      delete spare_node_;
+  }
+}
+
+void TaskNodeQueue::push(Task task) {
+  TaskNode* const node = AllocateNode(std::move(task));
+  if (back_)
+    back_->next = node;
+  else
+    front_ = node;
+  back_ = node;
+}
+
+void TaskNodeQueue::pop() {
+  DCHECK(front_);
+  TaskNode* const node = front_;
+  front_ = node->next;
+  if (!front_)
+    back_ = nullptr;
+  // Destroyed after the node is freed.
+  Task task = std::move(node->task);
+  FreeNode(node);
+}
+
+TaskNode* TaskNodeQueue::AllocateNode(Task task) {
+  if (spare_node_) {
+    TaskNode* const node = spare_node_;
+    spare_node_ = nullptr;
+    node->next = nullptr;
+    node->task = std::move(task);
+    return node;
+  }
+  if (pool_)
+    return pool_->Allocate(std::move(task));
+  TaskNode* const node = new TaskNode;
+  node->task = std::move(task);
+  return node;
+}
+
+void TaskNodeQueue::FreeNode(TaskNode* node) {
+  if (!spare_node_) {
+    spare_node_ = node;
+    return;
+  }
+  if (pool_)
+    pool_->Free(node);
+  else
+    delete node;
+}
+
+}  // namespace internal
+}  // namespace base
@@ -0,0 +1,126 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TASK_THREAD_POOL_TASK_NODE_POOL_H_
+#define BASE_TASK_THREAD_POOL_TASK_NODE_POOL_H_
+
+#include <stddef.h>
+
+#include <atomic>
+
+#include "base/base_export.h"
+#include "base/check.h"
+#include "base/memory/ref_counted.h"
+#include "base/task/common/checked_lock.h"
+#include "base/task/thread_pool/task.h"
+#include "base/thread_annotations.h"
+
+namespace base {
+namespace internal {
+
+// A Task in a TaskNodeQueue.
+struct BASE_EXPORT TaskNode {
+  TaskNode();
+  TaskNode(const TaskNode&) = delete;
+  TaskNode& operator=(const TaskNode&) = delete;
+  ~TaskNode();
+
+  Task task;
+  TaskNode* next = nullptr;
+};
+
+// A freelist of TaskNodes, shared by the Sequences of a ThreadGroup so that
+// pushing and popping their Tasks doesn't allocate from the heap in steady
+// state. Free nodes hold a moved-from Task, so that no Task is destroyed while
+// |lock_| is held. The memory of all pools is reported to memory-infra.
+//
+// This class is thread-safe.
+class BASE_EXPORT TaskNodePool : public RefCountedThreadSafe<TaskNodePool> {
+ public:
+  struct Stats {
+    // Nodes allocated from the heap and not deleted yet, in use or free.
+    size_t num_nodes = 0;
+    size_t num_free_nodes = 0;
+    // Number of nodes ever allocated from the heap.
+    size_t num_heap_allocations = 0;
+  };
+
+  // Number of free nodes kept by default. Nodes freed beyond this are deleted.
+  static constexpr size_t kDefaultMaxFreeNodes = 256;
+
+  TaskNodePool();
+  explicit TaskNodePool(size_t max_free_nodes);
+  TaskNodePool(const TaskNodePool&) = delete;
+  TaskNodePool& operator=(const TaskNodePool&) = delete;
+
+  // Returns a node holding |task|, taken from the freelist if possible.
+  TaskNode* Allocate(Task task);
+
+  // Returns |node|, whose Task was moved out, to the freelist.
+  void Free(TaskNode* node);
+
+  Stats GetStats() const;
+
+ private:
+  friend class RefCountedThreadSafe<TaskNodePool>;
+
+  ~TaskNodePool();
+
+  const size_t max_free_nodes_;
+
+  mutable CheckedLock lock_{UniversalSuccessor()};
+  TaskNode* free_list_ GUARDED_BY(lock_) = nullptr;
+  size_t num_free_nodes_ GUARDED_BY(lock_) = 0;
+
+  std::atomic<size_t> num_nodes_{0};
+  std::atomic<size_t> num_heap_allocations_{0};
+};
+
+// A FIFO queue of Tasks, held in TaskNodes allocated from a TaskNodePool, or
+// from the heap if there is no pool. The queue keeps the last node it freed for
+// the next push, so that a Sequence which alternates pushing and popping Tasks
+// doesn't use the pool at all.
+//
+// This class is not thread-safe.
+class BASE_EXPORT TaskNodeQueue {
+ public:
+  explicit TaskNodeQueue(scoped_refptr<TaskNodePool> pool);
+
+  // Takes the Tasks of |other|, which remains usable and keeps its spare node.
+  TaskNodeQueue(TaskNodeQueue&& other);
+  TaskNodeQueue& operator=(TaskNodeQueue&& other) = delete;
+
+  // Destroys the Tasks left in the queue.
+  ~TaskNodeQueue();
+
+  bool empty() const { return !front_; }
+
+  Task& front() {
+    DCHECK(front_);
+    return front_->task;
+  }
+  const Task& front() const {
+    DCHECK(front_);
+    return front_->task;
+  }
+
+  void push(Task task);
+
+  // Removes the front Task, destroying it unless it was moved out.
+  void pop();
+
+ private:
+  TaskNode* AllocateNode(Task task);
+  void FreeNode(TaskNode* node);
+
+  const scoped_refptr<TaskNodePool> pool_;
+  TaskNode* front_ = nullptr;
+  TaskNode* back_ = nullptr;
+  TaskNode* spare_node_ = nullptr;
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_TASK_THREAD_POOL_TASK_NODE_POOL_H_
@@ -0,0 +1,106 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/thread_pool/task_node_pool.h"
+
+#include <stddef.h>
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// The perftest compares a TaskNodePool which keeps no free node, so that every
+// node is allocated from the heap, with a default TaskNodePool, for:
+// - One-off queues: A queue is created, receives one Task and is destroyed,
+//   like the Sequence of a parallel task runner.
+// - Bursts: A long-lived queue receives kBurstSize Tasks before they are all
+//   popped.
+
+constexpr char kMetricPrefixTaskNodePool[] = "TaskNodePool.";
+constexpr char kMetricTimePerTask[] = "time_per_task";
+constexpr char kMetricHeapAllocationsPerTask[] = "heap_allocations_per_task";
+constexpr char kStoryOneOffHeap[] = "one_off_heap";
+constexpr char kStoryOneOffPooled[] = "one_off_pooled";
+constexpr char kStoryBurstHeap[] = "burst_heap";
+constexpr char kStoryBurstPooled[] = "burst_pooled";
+
+constexpr size_t kNumTasks = 1000000;
+constexpr size_t kBurstSize = 64;
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixTaskNodePool,
+                                         story_name);
+  reporter.RegisterImportantMetric(kMetricTimePerTask, "ns");
+  reporter.RegisterImportantMetric(kMetricHeapAllocationsPerTask, "count");
+  return reporter;
+}
+
+Task CreateTask() {
+  return Task(FROM_HERE, DoNothing(), TimeTicks(), TimeDelta());
+}
+
+void Report(const std::string& story_name,
+            const TaskNodePool& pool,
+            TimeDelta duration) {
+  auto reporter = SetUpReporter(story_name);
+  reporter.AddResult(kMetricTimePerTask,
+                     duration.InNanoseconds() / static_cast<double>(kNumTasks));
+  reporter.AddResult(kMetricHeapAllocationsPerTask,
+                     pool.GetStats().num_heap_allocations /
+                         static_cast<double>(kNumTasks));
+}
+
+void RunOneOff(const std::string& story_name,
+               scoped_refptr<TaskNodePool> pool) {
+  const TimeTicks start = TimeTicks::Now();
+  for (size_t i = 0; i < kNumTasks; ++i) {
+    TaskNodeQueue queue(pool);
+    queue.push(CreateTask());
+    queue.pop();
+  }
+  Report(story_name, *pool, TimeTicks::Now() - start);
+}
+
+void RunBurst(const std::string& story_name,
+              scoped_refptr<TaskNodePool> pool) {
+  TaskNodeQueue queue(pool);
+  const TimeTicks start = TimeTicks::Now();
+  for (size_t i = 0; i < kNumTasks; i += kBurstSize) {
+    for (size_t j = 0; j < kBurstSize; ++j)
+      queue.push(CreateTask());
+    for (size_t j = 0; j < kBurstSize; ++j)
+      queue.pop();
+  }
+  Report(story_name, *pool, TimeTicks::Now() - start);
+}
+
+}  // namespace
+
+TEST(TaskNodePoolPerfTest, OneOffHeap) {
+  RunOneOff(kStoryOneOffHeap, MakeRefCounted<TaskNodePool>(0));
+}
+
+TEST(TaskNodePoolPerfTest, OneOffPooled) {
+  RunOneOff(kStoryOneOffPooled, MakeRefCounted<TaskNodePool>());
+}
+
+TEST(TaskNodePoolPerfTest, BurstHeap) {
+  RunBurst(kStoryBurstHeap, MakeRefCounted<TaskNodePool>(0));
+}
+
+TEST(TaskNodePoolPerfTest, BurstPooled) {
+  RunBurst(kStoryBurstPooled, MakeRefCounted<TaskNodePool>());
+}
+
+}  // namespace internal
+}  // namespace base
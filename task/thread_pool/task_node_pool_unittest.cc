@@ -0,0 +1,148 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/thread_pool/task_node_pool.h"
+
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/callback_helpers.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+Task CreateTask(std::vector<int>* run_order, int id) {
+  return Task(FROM_HERE,
+              BindOnce([](std::vector<int>* run_order,
+                          int id) { run_order->push_back(id); },
+                       Unretained(run_order), id),
+              TimeTicks::Now(), TimeDelta());
+}
+
+void PushAndPopTasks(TaskNodeQueue* queue, int num_tasks) {
+  std::vector<int> run_order;
+  for (int i = 0; i < num_tasks; ++i)
+    queue->push(CreateTask(&run_order, i));
+  for (int i = 0; i < num_tasks; ++i) {
+    std::move(queue->front().task).Run();
+    queue->pop();
+  }
+  ASSERT_EQ(static_cast<size_t>(num_tasks), run_order.size());
+  for (int i = 0; i < num_tasks; ++i)
+    EXPECT_EQ(i, run_order[i]);
+}
+
+}  // namespace
+
+TEST(ThreadPoolTaskNodePoolTest, FifoWithoutPool) {
+  TaskNodeQueue queue(nullptr);
+  EXPECT_TRUE(queue.empty());
+  PushAndPopTasks(&queue, 10);
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(ThreadPoolTaskNodePoolTest, FifoWithPool) {
+  auto pool = MakeRefCounted<TaskNodePool>();
+  TaskNodeQueue queue(pool);
+  PushAndPopTasks(&queue, 10);
+  EXPECT_TRUE(queue.empty());
+}
+
+// Verifies that a queue which alternates pushing and popping reuses its spare
+// node instead of using the pool.
+TEST(ThreadPoolTaskNodePoolTest, AlternatingPushPopUsesSpareNode) {
+  auto pool = MakeRefCounted<TaskNodePool>();
+  TaskNodeQueue queue(pool);
+  for (int i = 0; i < 100; ++i)
+    PushAndPopTasks(&queue, 1);
+  const TaskNodePool::Stats stats = pool->GetStats();
+  EXPECT_EQ(1u, stats.num_heap_allocations);
+  EXPECT_EQ(1u, stats.num_nodes);
+  EXPECT_EQ(0u, stats.num_free_nodes);
+}
+
+// Verifies that nodes are recycled through the pool, so that no node is
+// allocated from the heap in steady state.
+TEST(ThreadPoolTaskNodePoolTest, NodesAreReused) {
+  auto pool = MakeRefCounted<TaskNodePool>();
+  {
+    TaskNodeQueue queue(pool);
+    PushAndPopTasks(&queue, 20);
+  }
+  const TaskNodePool::Stats stats = pool->GetStats();
+  EXPECT_EQ(20u, stats.num_nodes);
+  EXPECT_EQ(20u, stats.num_free_nodes);
+  EXPECT_EQ(20u, stats.num_heap_allocations);
+
+  for (int i = 0; i < 10; ++i) {
+    TaskNodeQueue queue(pool);
+    PushAndPopTasks(&queue, 20);
+  }
+  EXPECT_EQ(20u, pool->GetStats().num_heap_allocations);
+  EXPECT_EQ(20u, pool->GetStats().num_free_nodes);
+}
+
+TEST(ThreadPoolTaskNodePoolTest, MaxFreeNodes) {
+  auto pool = MakeRefCounted<TaskNodePool>(5);
+  {
+    TaskNodeQueue queue(pool);
+    PushAndPopTasks(&queue, 20);
+  }
+  const TaskNodePool::Stats stats = pool->GetStats();
+  EXPECT_EQ(5u, stats.num_nodes);
+  EXPECT_EQ(5u, stats.num_free_nodes);
+  EXPECT_EQ(20u, stats.num_heap_allocations);
+}
+
+// Verifies that destroying a queue destroys the Tasks left in it and returns
+// its nodes to the pool.
+TEST(ThreadPoolTaskNodePoolTest, DestroyNonEmptyQueue) {
+  auto pool = MakeRefCounted<TaskNodePool>();
+  int num_destroyed = 0;
+  {
+    TaskNodeQueue queue(pool);
+    for (int i = 0; i < 3; ++i) {
+      queue.push(Task(FROM_HERE,
+                      BindOnce([](ScopedClosureRunner) {},
+                               ScopedClosureRunner(BindOnce(
+                                   [](int* num_destroyed) { ++*num_destroyed; },
+                                   Unretained(&num_destroyed)))),
+                      TimeTicks::Now(), TimeDelta()));
+    }
+    EXPECT_EQ(0, num_destroyed);
+  }
+  EXPECT_EQ(3, num_destroyed);
+  EXPECT_EQ(3u, pool->GetStats().num_free_nodes);
+}
+
+TEST(ThreadPoolTaskNodePoolTest, MoveConstruct) {
+  auto pool = MakeRefCounted<TaskNodePool>();
+  std::vector<int> run_order;
+  TaskNodeQueue queue(pool);
+  PushAndPopTasks(&queue, 1);
+  queue.push(CreateTask(&run_order, 0));
+  queue.push(CreateTask(&run_order, 1));
+
+  TaskNodeQueue other(std::move(queue));
+  EXPECT_TRUE(queue.empty());
+  ASSERT_FALSE(other.empty());
+  std::move(other.front().task).Run();
+  other.pop();
+  std::move(other.front().task).Run();
+  other.pop();
+  EXPECT_TRUE(other.empty());
+  EXPECT_EQ((std::vector<int>{0, 1}), run_order);
+
+  // The moved-from queue is still usable.
+  PushAndPopTasks(&queue, 3);
+}
+
+}  // namespace internal
+}  // namespace base
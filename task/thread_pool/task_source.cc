@@ -33,9 +33,19 @@ TaskSource::Transaction::~Transaction() {
 }
 
 void TaskSource::Transaction::UpdatePriority(TaskPriority priority) {
-  task_source_->traits_.UpdatePriority(priority);
-  task_source_->priority_racy_.store(task_source_->traits_.priority(),
-                                     std::memory_order_relaxed);
+  task_source_->unboosted_priority_ = priority;
+  task_source_->UpdateBoostedPriority();
+}
+
+void TaskSource::Transaction::AddPriorityBoost(TaskPriority priority) {
+  ++task_source_->num_priority_boosts_[static_cast<int>(priority)];
+  task_source_->UpdateBoostedPriority();
+}
+
+void TaskSource::Transaction::RemovePriorityBoost(TaskPriority priority) {
+  DCHECK_GT(task_source_->num_priority_boosts_[static_cast<int>(priority)], 0);
+  --task_source_->num_priority_boosts_[static_cast<int>(priority)];
+  task_source_->UpdateBoostedPriority();
 }
 
 void TaskSource::SetHeapHandle(const HeapHandle& handle) {
@@ -52,7 +62,8 @@ TaskSource::TaskSource(const TaskTraits& traits,
     : traits_(traits),
       priority_racy_(traits.priority()),
       task_runner_(task_runner),
-      execution_mode_(execution_mode) {
+      execution_mode_(execution_mode),
+      unboosted_priority_(traits.priority()) {
   DCHECK(task_runner_ ||
          execution_mode_ == TaskSourceExecutionMode::kParallel ||
          execution_mode_ == TaskSourceExecutionMode::kJob);
@@ -64,6 +75,20 @@ TaskSource::Transaction TaskSource::BeginTransaction() {
   return Transaction(this);
 }
 
+void TaskSource::UpdateBoostedPriority() {
+  lock_.AssertAcquired();
+  TaskPriority priority = unboosted_priority_;
+  for (int i = static_cast<int>(TaskPriority::HIGHEST);
+       i > static_cast<int>(priority); --i) {
+    if (num_priority_boosts_[i] > 0) {
+      priority = static_cast<TaskPriority>(i);
+      break;
+    }
+  }
+  traits_.UpdatePriority(priority);
+  priority_racy_.store(priority, std::memory_order_relaxed);
+}
+
 RegisteredTaskSource::RegisteredTaskSource() = default;
 
 RegisteredTaskSource::RegisteredTaskSource(std::nullptr_t)
@@ -7,6 +7,9 @@
 
 #include <stddef.h>
 
+#include <array>
+#include <atomic>
+
 #include "base/base_export.h"
 #include "base/compiler_specific.h"
 #include "base/memory/ref_counted.h"
@@ -105,10 +108,24 @@ class BASE_EXPORT TaskSource : public RefCountedThreadSafe<TaskSource> {
 
     operator bool() const { return !!task_source_; }
 
-    // Sets TaskSource priority to |priority|.
+    // Sets TaskSource priority to |priority|. Priority boosts still apply on
+    // top of it.
     void UpdatePriority(TaskPriority priority);
 
-    // Returns the traits of all Tasks in the TaskSource.
+    // Raises the TaskSource priority to at least |priority| until a matching
+    // call to RemovePriorityBoost(), e.g. while a task of |priority| waits for
+    // work queued in the TaskSource. Boosts can be nested.
+    void AddPriorityBoost(TaskPriority priority);
+    void RemovePriorityBoost(TaskPriority priority);
+
+    // Assigns the TaskSource to |node|. Must only be called while the
+    // TaskSource isn't queued in a thread group.
+    void set_node(int node) {
+      task_source_->node_.store(node, std::memory_order_relaxed);
+    }
+
+    // Returns the traits of all Tasks in the TaskSource. Their priority
+    // includes active priority boosts.
     TaskTraits traits() const { return task_source_->traits_; }
 
     TaskSource* task_source() const { return task_source_; }
@@ -176,6 +193,12 @@ class BASE_EXPORT TaskSource : public RefCountedThreadSafe<TaskSource> {
 
   TaskSourceExecutionMode execution_mode() const { return execution_mode_; }
 
+  // Returns the index of the node whose thread group runs this TaskSource's
+  // foreground tasks, or -1 if none was assigned (see
+  // kUseNumaAwareThreadGroups). Can be accessed without a Transaction but may
+  // return an outdated result.
+  int node() const { return node_.load(std::memory_order_relaxed); }
+
  protected:
   virtual ~TaskSource();
 
@@ -195,7 +218,8 @@ class BASE_EXPORT TaskSource : public RefCountedThreadSafe<TaskSource> {
   // Sets TaskSource priority to |priority|.
   void UpdatePriority(TaskPriority priority);
 
-  // The TaskTraits of all Tasks in the TaskSource.
+  // The TaskTraits of all Tasks in the TaskSource. The priority of |traits_|
+  // is the highest of |unboosted_priority_| and of active priority boosts.
   TaskTraits traits_;
 
   // The cached priority for atomic access.
@@ -208,6 +232,10 @@ class BASE_EXPORT TaskSource : public RefCountedThreadSafe<TaskSource> {
   friend class RefCountedThreadSafe<TaskSource>;
   friend class RegisteredTaskSource;
 
+  // Sets the priority of |traits_| and |priority_racy_| to the highest of
+  // |unboosted_priority_| and of active priority boosts. Requires |lock_|.
+  void UpdateBoostedPriority();
+
   // The TaskSource's position in its current PriorityQueue. Access is protected
   // by the PriorityQueue's lock.
   HeapHandle heap_handle_;
@@ -219,6 +247,18 @@ class BASE_EXPORT TaskSource : public RefCountedThreadSafe<TaskSource> {
   TaskRunner* task_runner_;
 
   TaskSourceExecutionMode execution_mode_;
+
+  // See node(). Written within a Transaction.
+  std::atomic<int> node_{-1};
+
+  // Priority set at construction or by the last UpdatePriority(), ignoring
+  // priority boosts. Protected by |lock_|.
+  TaskPriority unboosted_priority_;
+
+  // Number of active priority boosts, indexed by priority. Protected by
+  // |lock_|.
+  std::array<int, static_cast<int>(TaskPriority::HIGHEST) + 1>
+      num_priority_boosts_ = {};
 };
 
 // Wrapper around TaskSource to signify the intent to queue and run it.
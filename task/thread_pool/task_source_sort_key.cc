@@ -4,24 +4,44 @@
 
 #include "base/task/thread_pool/task_source_sort_key.h"
 
+#include <algorithm>
+
+#include "base/numerics/safe_conversions.h"
+
 namespace base {
 namespace internal {
 
+namespace {
+
+// A positive delay rounds up to at least 1us, as 0 means no deadline.
+uint32_t DeadlineDelayInMicroseconds(TimeDelta deadline_delay) {
+  if (deadline_delay.is_zero())
+    return 0;
+  return std::max<uint32_t>(
+      1, saturated_cast<uint32_t>(deadline_delay.InMicroseconds()));
+}
+
+}  // namespace
+
 static_assert(sizeof(TaskSourceSortKey) <= 2 * sizeof(uint64_t),
               "Members in TaskSourceSortKey should be ordered to be compact.");
 
 TaskSourceSortKey::TaskSourceSortKey(TaskPriority priority,
                                      TimeTicks ready_time,
-                                     uint8_t worker_count)
+                                     uint8_t worker_count,
+                                     TimeDelta deadline_delay)
     : priority_(priority),
       worker_count_(worker_count),
+      deadline_delay_us_(DeadlineDelayInMicroseconds(deadline_delay)),
       ready_time_(ready_time) {}
 
 bool TaskSourceSortKey::operator<=(const TaskSourceSortKey& other) const {
   // This TaskSourceSortKey is considered more important than |other| if it has
-  // a higher priority or if it has the same priority but fewer workers, or if
-  // it has the same priority and same worker count but its next task was
-  // posted sooner than |other|'s.
+  // a higher priority or if it has the same priority but fewer workers. With
+  // the same priority and worker count, task sources with a TaskDeadline come
+  // first, in earliest deadline first order. Task sources without one come
+  // last, in first-in first-out order: they would otherwise be due as soon as
+  // they are ready, and run before tagged work that was ready at the same time.
   const int priority_diff =
       static_cast<int>(priority_) - static_cast<int>(other.priority_);
   if (priority_diff > 0)
@@ -32,7 +52,9 @@ bool TaskSourceSortKey::operator<=(const TaskSourceSortKey& other) const {
     return true;
   if (worker_count_ > other.worker_count_)
     return false;
-  return ready_time_ <= other.ready_time_;
+  if (has_deadline() != other.has_deadline())
+    return has_deadline();
+  return deadline() <= other.deadline();
 }
 
 }  // namespace internal
@@ -5,6 +5,8 @@
 #ifndef BASE_TASK_THREAD_POOL_TASK_SOURCE_SORT_KEY_H_
 #define BASE_TASK_THREAD_POOL_TASK_SOURCE_SORT_KEY_H_
 
+#include <stdint.h>
+
 #include "base/base_export.h"
 #include "base/task/task_traits.h"
 #include "base/time/time.h"
@@ -18,11 +20,20 @@ class BASE_EXPORT TaskSourceSortKey final {
   TaskSourceSortKey() = default;
   TaskSourceSortKey(TaskPriority priority,
                     TimeTicks ready_time,
-                    uint8_t worker_count = 0);
+                    uint8_t worker_count = 0,
+                    TimeDelta deadline_delay = TimeDelta());
 
   TaskPriority priority() const { return priority_; }
   uint8_t worker_count() const { return worker_count_; }
   TimeTicks ready_time() const { return ready_time_; }
+  // Whether the next task of the task source has a TaskDeadline.
+  bool has_deadline() const { return deadline_delay_us_ != 0; }
+  // Time by which the next task of the task source should start running. Task
+  // sources without a TaskDeadline have no deadline, and return their ready
+  // time.
+  TimeTicks deadline() const {
+    return ready_time_ + TimeDelta::FromMicroseconds(deadline_delay_us_);
+  }
 
   // Lower sort key means more important.
   bool operator<=(const TaskSourceSortKey& other) const;
@@ -30,6 +41,7 @@ class BASE_EXPORT TaskSourceSortKey final {
   bool operator==(const TaskSourceSortKey& other) const {
     return priority_ == other.priority_ &&
            worker_count_ == other.worker_count_ &&
+           deadline_delay_us_ == other.deadline_delay_us_ &&
            ready_time_ == other.ready_time_;
   }
   bool operator!=(const TaskSourceSortKey& other) const {
@@ -48,8 +60,14 @@ class BASE_EXPORT TaskSourceSortKey final {
   // prioritizing task sources with fewer workers.
   uint8_t worker_count_;
 
-  // Time since the task source has been ready to run upcoming work, used as
-  // secondary sort key after |worker_count| prioritizing older task sources.
+  // Delay from |ready_time_| to the deadline of the next task, in
+  // microseconds, or 0 without a deadline. Stored compactly to fit in the
+  // padding before |ready_time_|.
+  uint32_t deadline_delay_us_;
+
+  // Time since the task source has been ready to run upcoming work. Along with
+  // |deadline_delay_us_|, used as secondary sort key after |worker_count|
+  // prioritizing task sources with earlier deadlines.
   TimeTicks ready_time_;
 };
 
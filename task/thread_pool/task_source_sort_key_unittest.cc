@@ -284,5 +284,72 @@ TEST(TaskSourceSortKeyTest, OperatorNotEqual) {
   EXPECT_FALSE(key_h != key_h);
 }
 
+// Within a priority and worker count, task sources are ordered by deadline.
+TEST(TaskSourceSortKeyTest, Deadline) {
+  TaskSourceSortKey key_a(TaskPriority::USER_VISIBLE,
+                          TimeTicks::FromInternalValue(1000), 0,
+                          TimeDelta::FromMicroseconds(500));
+  TaskSourceSortKey key_c(TaskPriority::USER_VISIBLE,
+                          TimeTicks::FromInternalValue(1100), 0,
+                          TimeDelta::FromMicroseconds(50));
+  TaskSourceSortKey key_d(TaskPriority::USER_BLOCKING,
+                          TimeTicks::FromInternalValue(2000), 0,
+                          TimeDelta::FromMicroseconds(1000));
+
+  EXPECT_TRUE(key_a.has_deadline());
+  EXPECT_EQ(TimeTicks::FromInternalValue(1500), key_a.deadline());
+
+  EXPECT_LE(key_c, key_a);
+  EXPECT_FALSE(key_a <= key_c);
+
+  // Priority takes precedence over deadlines.
+  EXPECT_LE(key_d, key_c);
+  EXPECT_FALSE(key_c <= key_d);
+
+  // A delay under 1us is still a deadline.
+  EXPECT_TRUE(TaskSourceSortKey(TaskPriority::USER_VISIBLE,
+                                TimeTicks::FromInternalValue(1000), 0,
+                                TimeDelta::FromNanoseconds(1))
+                  .has_deadline());
+
+  EXPECT_NE(key_a, TaskSourceSortKey(TaskPriority::USER_VISIBLE,
+                                     TimeTicks::FromInternalValue(1000)));
+}
+
+// Within a priority and worker count, task sources with a deadline run before
+// those without one, even those which were ready earlier than the deadline.
+// Those without one run in the order they became ready.
+TEST(TaskSourceSortKeyTest, DeadlineBeforeNoDeadline) {
+  TaskSourceSortKey tagged(TaskPriority::USER_VISIBLE,
+                           TimeTicks::FromInternalValue(1000), 0,
+                           TimeDelta::FromMilliseconds(5));
+  TaskSourceSortKey untagged_earlier(TaskPriority::USER_VISIBLE,
+                                     TimeTicks::FromInternalValue(500));
+  TaskSourceSortKey untagged_later(TaskPriority::USER_VISIBLE,
+                                   TimeTicks::FromInternalValue(2000));
+  TaskSourceSortKey untagged_higher_priority(
+      TaskPriority::USER_BLOCKING, TimeTicks::FromInternalValue(3000));
+  TaskSourceSortKey untagged_fewer_workers(
+      TaskPriority::USER_VISIBLE, TimeTicks::FromInternalValue(3000), 0);
+  TaskSourceSortKey tagged_more_workers(TaskPriority::USER_VISIBLE,
+                                        TimeTicks::FromInternalValue(1000), 1,
+                                        TimeDelta::FromMilliseconds(5));
+
+  EXPECT_FALSE(untagged_earlier.has_deadline());
+  EXPECT_LE(tagged, untagged_earlier);
+  EXPECT_LE(tagged, untagged_later);
+  EXPECT_FALSE(untagged_earlier <= tagged);
+  EXPECT_FALSE(untagged_later <= tagged);
+
+  EXPECT_LE(untagged_earlier, untagged_later);
+  EXPECT_FALSE(untagged_later <= untagged_earlier);
+
+  // Priority and worker count still take precedence.
+  EXPECT_LE(untagged_higher_priority, tagged);
+  EXPECT_FALSE(tagged <= untagged_higher_priority);
+  EXPECT_LE(untagged_fewer_workers, tagged_more_workers);
+  EXPECT_FALSE(tagged_more_workers <= untagged_fewer_workers);
+}
+
 }  // namespace internal
 }  // namespace base
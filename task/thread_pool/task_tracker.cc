@@ -4,6 +4,7 @@
 
 #include "base/task/thread_pool/task_tracker.h"
 
+#include <algorithm>
 #include <atomic>
 #include <string>
 #include <utility>
@@ -15,6 +16,7 @@
 #include "base/json/json_writer.h"
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
+#include "base/metrics/histogram_functions.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/sequence_token.h"
 #include "base/strings/string_util.h"
@@ -338,6 +340,19 @@ void TaskTracker::FlushAsyncForTesting(OnceClosure flush_callback) {
   }
 }
 
+void TaskTracker::StartSamplingTaskLatency(int sampling_interval) {
+  DCHECK(!task_latency_registry_);
+  task_latency_registry_ =
+      std::make_unique<TaskLatencyRegistry>(sampling_interval);
+}
+
+std::vector<TaskLatencyRegistry::Entry> TaskTracker::GetTaskLatencySnapshot()
+    const {
+  if (!task_latency_registry_)
+    return {};
+  return task_latency_registry_->GetSnapshot();
+}
+
 void TaskTracker::SetCanRunPolicy(CanRunPolicy can_run_policy) {
   can_run_policy_.store(can_run_policy);
 }
@@ -427,8 +442,15 @@ RegisteredTaskSource TaskTracker::RunAndPopNextTask(
   }
 
   if (task) {
+    if (should_run_tasks && !traits.deadline().is_zero())
+      RecordMissedDeadlineIfLate(task.value(), traits);
     // Run the |task| (whether it's a worker task or the Clear() closure).
-    RunTask(std::move(task.value()), task_source.get(), traits);
+    if (should_run_tasks && task_latency_registry_ &&
+        task_latency_registry_->ShouldSampleNextTask()) {
+      RunAndSampleTask(std::move(task.value()), task_source.get(), traits);
+    } else {
+      RunTask(std::move(task.value()), task_source.get(), traits);
+    }
   }
   if (should_run_tasks)
     AfterRunTask(task_source->shutdown_behavior());
@@ -530,6 +552,45 @@ void TaskTracker::RunTask(Task task,
   }
 }
 
+void TaskTracker::RecordMissedDeadlineIfLate(const Task& task,
+                                             const TaskTraits& traits) {
+  const TimeTicks ready_time = std::max(task.queue_time, task.delayed_run_time);
+  // Job worker tasks have no ready time; their task source's sort key already
+  // accounts for the deadline.
+  if (ready_time.is_null())
+    return;
+  const TimeDelta lateness =
+      TimeTicks::Now() - (ready_time + traits.deadline());
+  if (lateness <= TimeDelta())
+    return;
+  num_missed_deadlines_.fetch_add(1, std::memory_order_relaxed);
+  UmaHistogramMicrosecondsTimes("ThreadPool.TaskDeadlineMissedBy", lateness);
+}
+
+void TaskTracker::RunAndSampleTask(Task task,
+                                   TaskSource* task_source,
+                                   const TaskTraits& traits) {
+  // |task| is consumed by RunTask(), so copy what is recorded beforehand.
+  const Location posted_from = task.posted_from;
+  const TimeTicks ready_time = std::max(task.queue_time, task.delayed_run_time);
+  const bool has_thread_ticks = ThreadTicks::IsSupported();
+
+  const TimeTicks start_time = TimeTicks::Now();
+  const ThreadTicks start_thread_time =
+      has_thread_ticks ? ThreadTicks::Now() : ThreadTicks();
+  RunTask(std::move(task), task_source, traits);
+  absl::optional<TimeDelta> run_thread_time;
+  if (has_thread_ticks)
+    run_thread_time = ThreadTicks::Now() - start_thread_time;
+  const TimeTicks end_time = TimeTicks::Now();
+
+  absl::optional<TimeDelta> queueing_delay;
+  if (!ready_time.is_null())
+    queueing_delay = std::max(start_time - ready_time, TimeDelta());
+  task_latency_registry_->RecordSample(posted_from, traits, queueing_delay,
+                                       end_time - start_time, run_thread_time);
+}
+
 void TaskTracker::BeginCompleteShutdown(base::WaitableEvent& shutdown_event) {
   // Do nothing in production, tests may override this.
 }
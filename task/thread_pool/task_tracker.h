@@ -11,6 +11,7 @@
 #include <memory>
 #include <queue>
 #include <string>
+#include <vector>
 
 #include "base/atomicops.h"
 #include "base/base_export.h"
@@ -22,6 +23,7 @@
 #include "base/task/common/task_annotator.h"
 #include "base/task/task_traits.h"
 #include "base/task/thread_pool/task.h"
+#include "base/task/thread_pool/task_latency_registry.h"
 #include "base/task/thread_pool/task_source.h"
 #include "base/task/thread_pool/tracked_ref.h"
 #include "base/thread_annotations.h"
@@ -119,6 +121,21 @@ class BASE_EXPORT TaskTracker {
   // called.
   RegisteredTaskSource RunAndPopNextTask(RegisteredTaskSource task_source);
 
+  // Starts sampling one task out of |sampling_interval| on each thread that
+  // runs tasks, into a TaskLatencyRegistry. Must be called before any task
+  // runs.
+  void StartSamplingTaskLatency(int sampling_interval);
+
+  // Returns the task latency samples recorded so far, merged from all threads.
+  // Empty if StartSamplingTaskLatency() wasn't called. Thread-safe.
+  std::vector<TaskLatencyRegistry::Entry> GetTaskLatencySnapshot() const;
+
+  // Returns the number of tasks with a TaskDeadline which started running after
+  // their deadline. Thread-safe.
+  uint64_t GetNumMissedDeadlines() const {
+    return num_missed_deadlines_.load(std::memory_order_relaxed);
+  }
+
   // Returns true once shutdown has started (StartShutdown() was called).
   // Note: sequential consistency with the thread calling StartShutdown() isn't
   // guaranteed by this call.
@@ -195,6 +212,15 @@ class BASE_EXPORT TaskTracker {
   void RunTaskWithShutdownBehavior(TaskShutdownBehavior shutdown_behavior,
                                    Task* task);
 
+  // Counts |task| as a missed deadline if it is about to start running after
+  // the deadline of |traits|.
+  void RecordMissedDeadlineIfLate(const Task& task, const TaskTraits& traits);
+
+  // Calls RunTask() and records its timing in |task_latency_registry_|.
+  void RunAndSampleTask(Task task,
+                        TaskSource* task_source,
+                        const TaskTraits& traits);
+
   TaskAnnotator task_annotator_;
 
   // Suffix for histograms recorded by this TaskTracker.
@@ -218,6 +244,13 @@ class BASE_EXPORT TaskTracker {
   // visible when FlushForTesting() returns.
   std::atomic_int num_incomplete_task_sources_{0};
 
+  // Registry of sampled task latencies. Set by StartSamplingTaskLatency()
+  // before any task runs, so it can be read without synchronization after.
+  std::unique_ptr<TaskLatencyRegistry> task_latency_registry_;
+
+  // Number of tasks which started running after their TaskDeadline.
+  std::atomic<uint64_t> num_missed_deadlines_{0};
+
   // Global policy the determines result of CanRunPriority().
   std::atomic<CanRunPolicy> can_run_policy_;
 
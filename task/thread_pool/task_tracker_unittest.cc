@@ -286,6 +286,57 @@ TEST_P(ThreadPoolTaskTrackerTest, WillPostAndRunBeforeShutdown) {
   test::ShutdownTaskTracker(&tracker_);
 }
 
+// Verify that a task that runs while task latency is sampled is recorded by
+// post site and traits.
+TEST_P(ThreadPoolTaskTrackerTest, SampleTaskLatency) {
+  tracker_.StartSamplingTaskLatency(1);
+  EXPECT_TRUE(tracker_.GetTaskLatencySnapshot().empty());
+
+  Task task(CreateTask());
+  const Location posted_from = task.posted_from;
+  EXPECT_TRUE(tracker_.WillPostTask(&task, GetParam()));
+  test::QueueAndRunTaskSource(
+      &tracker_, test::CreateSequenceWithTask(std::move(task), {GetParam()}));
+  EXPECT_EQ(1U, NumTasksExecuted());
+
+  const std::vector<TaskLatencyRegistry::Entry> snapshot =
+      tracker_.GetTaskLatencySnapshot();
+  ASSERT_EQ(1U, snapshot.size());
+  EXPECT_EQ(posted_from, snapshot[0].posted_from);
+  EXPECT_EQ(GetParam(), snapshot[0].shutdown_behavior);
+  EXPECT_EQ(1U, snapshot[0]
+                    .distribution(TaskLatencyRegistry::Metric::kQueueingDelay)
+                    .count);
+  EXPECT_EQ(
+      1U,
+      snapshot[0].distribution(TaskLatencyRegistry::Metric::kRunTime).count);
+
+  test::ShutdownTaskTracker(&tracker_);
+}
+
+// Verify that a task which starts running after its deadline is counted as a
+// missed deadline, and that one which starts before isn't.
+TEST_P(ThreadPoolTaskTrackerTest, MissedDeadline) {
+  const TaskTraits traits = {GetParam(),
+                             TaskDeadline(TimeDelta::FromSeconds(1))};
+
+  Task late_task(CreateTask());
+  late_task.queue_time = TimeTicks::Now() - TimeDelta::FromSeconds(2);
+  EXPECT_TRUE(tracker_.WillPostTask(&late_task, GetParam()));
+  test::QueueAndRunTaskSource(
+      &tracker_, test::CreateSequenceWithTask(std::move(late_task), traits));
+  EXPECT_EQ(1U, tracker_.GetNumMissedDeadlines());
+
+  Task timely_task(CreateTask());
+  EXPECT_TRUE(tracker_.WillPostTask(&timely_task, GetParam()));
+  test::QueueAndRunTaskSource(
+      &tracker_, test::CreateSequenceWithTask(std::move(timely_task), traits));
+  EXPECT_EQ(2U, NumTasksExecuted());
+  EXPECT_EQ(1U, tracker_.GetNumMissedDeadlines());
+
+  test::ShutdownTaskTracker(&tracker_);
+}
+
 TEST_P(ThreadPoolTaskTrackerTest, WillPostAndRunLongTaskBeforeShutdown) {
   // Create a task that signals |task_running| and blocks until |task_barrier|
   // is signaled.
@@ -244,6 +244,22 @@ void MockPooledTaskRunnerDelegate::UpdateJobPriority(
   UpdatePriority(std::move(task_source), priority);
 }
 
+void MockPooledTaskRunnerDelegate::AddPriorityBoost(
+    scoped_refptr<TaskSource> task_source,
+    TaskPriority priority) {
+  auto transaction = task_source->BeginTransaction();
+  transaction.AddPriorityBoost(priority);
+  thread_group_->UpdateSortKey(std::move(transaction));
+}
+
+void MockPooledTaskRunnerDelegate::RemovePriorityBoost(
+    scoped_refptr<TaskSource> task_source,
+    TaskPriority priority) {
+  auto transaction = task_source->BeginTransaction();
+  transaction.RemovePriorityBoost(priority);
+  thread_group_->UpdateSortKey(std::move(transaction));
+}
+
 void MockPooledTaskRunnerDelegate::SetThreadGroup(ThreadGroup* thread_group) {
   thread_group_ = thread_group;
 }
@@ -69,6 +69,10 @@ class MockPooledTaskRunnerDelegate : public PooledTaskRunnerDelegate {
                       TaskPriority priority) override;
   void UpdateJobPriority(scoped_refptr<TaskSource> task_source,
                          TaskPriority priority) override;
+  void AddPriorityBoost(scoped_refptr<TaskSource> task_source,
+                        TaskPriority priority) override;
+  void RemovePriorityBoost(scoped_refptr<TaskSource> task_source,
+                           TaskPriority priority) override;
 
   void SetThreadGroup(ThreadGroup* thread_group);
 
@@ -38,6 +38,12 @@ const ThreadGroup* GetCurrentThreadGroup() {
 
 constexpr ThreadGroup::YieldSortKey ThreadGroup::kMaxYieldSortKey;
 
+ThreadGroup* ThreadGroup::Delegate::GetThreadGroupForTaskSource(
+    const TaskSource& task_source,
+    const TaskTraits& traits) {
+  return GetThreadGroupForTraits(traits);
+}
+
 void ThreadGroup::BaseScopedCommandsExecutor::ScheduleReleaseTaskSource(
     RegisteredTaskSource task_source) {
   task_sources_to_release_.push_back(std::move(task_source));
@@ -158,8 +164,10 @@ void ThreadGroup::ReEnqueueTaskSourceLockRequired(
     ScopedReenqueueExecutor* reenqueue_executor,
     TransactionWithRegisteredTaskSource transaction_with_task_source) {
   // Decide in which thread group the TaskSource should be reenqueued.
-  ThreadGroup* destination_thread_group = delegate_->GetThreadGroupForTraits(
-      transaction_with_task_source.transaction.traits());
+  ThreadGroup* destination_thread_group =
+      delegate_->GetThreadGroupForTaskSource(
+          *transaction_with_task_source.task_source.get(),
+          transaction_with_task_source.transaction.traits());
 
   if (destination_thread_group == this) {
     // Another worker that was running a task from this task source may have
@@ -238,7 +246,8 @@ void ThreadGroup::PushTaskSourceAndWakeUpWorkersImpl(
     TransactionWithRegisteredTaskSource transaction_with_task_source) {
   CheckedAutoLock auto_lock(lock_);
   DCHECK(!replacement_thread_group_);
-  DCHECK_EQ(delegate_->GetThreadGroupForTraits(
+  DCHECK_EQ(delegate_->GetThreadGroupForTaskSource(
+                *transaction_with_task_source.task_source.get(),
                 transaction_with_task_source.transaction.traits()),
             this);
   if (transaction_with_task_source.task_source->heap_handle().IsValid()) {
@@ -13,6 +13,7 @@
 #include "base/task/common/checked_lock.h"
 #include "base/task/thread_pool/priority_queue.h"
 #include "base/task/thread_pool/task.h"
+#include "base/task/thread_pool/task_node_pool.h"
 #include "base/task/thread_pool/task_source.h"
 #include "base/task/thread_pool/tracked_ref.h"
 #include "build/build_config.h"
@@ -41,6 +42,13 @@ class BASE_EXPORT ThreadGroup {
     // ThreadGroup has run a task from it. The implementation must return the
     // thread group in which the TaskSource should be reenqueued.
     virtual ThreadGroup* GetThreadGroupForTraits(const TaskTraits& traits) = 0;
+
+    // Same as GetThreadGroupForTraits(), for a specific |task_source| whose
+    // traits are |traits|. Implementations may override this to take into
+    // account other properties of |task_source|, e.g. its node().
+    virtual ThreadGroup* GetThreadGroupForTaskSource(
+        const TaskSource& task_source,
+        const TaskTraits& traits);
   };
 
   enum class WorkerEnvironment {
@@ -123,6 +131,12 @@ class BASE_EXPORT ThreadGroup {
   // called after an update to CanRunPolicy in TaskTracker.
   virtual void DidUpdateCanRunPolicy() = 0;
 
+  // Returns the pool from which Sequences expected to run in this ThreadGroup
+  // allocate the nodes of their Tasks.
+  const scoped_refptr<TaskNodePool>& task_node_pool() const {
+    return task_node_pool_;
+  }
+
  protected:
   // Derived classes must implement a ScopedCommandsExecutor that derives from
   // this to perform operations at the end of a scope, when all locks have been
@@ -261,6 +275,9 @@ class BASE_EXPORT ThreadGroup {
   // all task sources should be scheduled on |replacement_thread_group_|. Used
   // to support the UseNativeThreadPool experiment.
   ThreadGroup* replacement_thread_group_ = nullptr;
+
+  const scoped_refptr<TaskNodePool> task_node_pool_ =
+      MakeRefCounted<TaskNodePool>();
 };
 
 }  // namespace internal
@@ -37,6 +37,10 @@
 #include "build/build_config.h"
 #include "third_party/abseil-cpp/absl/types/optional.h"
 
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+#include "base/cpu_affinity_posix.h"
+#endif
+
 #if defined(OS_WIN)
 #include "base/win/scoped_com_initializer.h"
 #include "base/win/scoped_windows_thread_environment.h"
@@ -80,6 +84,21 @@ constexpr TimeDelta kForegroundBlockedWorkersPoll =
 constexpr TimeDelta kBackgroundMayBlockThreshold = TimeDelta::FromSeconds(10);
 constexpr TimeDelta kBackgroundBlockedWorkersPoll = TimeDelta::FromSeconds(12);
 
+// Maximum number of consecutive task sources that a worker runs from its
+// WorkerLocalQueue without acquiring |lock_|. Going through |lock_| once in a
+// while lets the worker pick up older task sources of the same priority from
+// |priority_queue_| and re-evaluate how many workers should be awake.
+constexpr size_t kMaxConsecutiveLocalQueueTaskSources = 64;
+
+// Wake up intervals are clamped to this value before being averaged, so that a
+// single long idle period doesn't prevent spinning for a long time after wake
+// ups become frequent again. It is larger than any sensible spin duration.
+constexpr int64_t kMaxWakeUpIntervalUs = 10 * Time::kMicrosecondsPerMillisecond;
+
+// Weight of a new sample in the moving average of wake up intervals, as a
+// power of two.
+constexpr int kWakeUpIntervalWeightShift = 3;
+
 // Only used in DCHECKs.
 bool ContainsWorker(const std::vector<scoped_refptr<WorkerThread>>& workers,
                     const WorkerThread* worker) {
@@ -176,6 +195,8 @@ class ThreadGroupImpl::ScopedCommandsExecutor
     CheckedLock::AssertNoLockHeldOnCurrentThread();
 
     // Wake up workers.
+    if (!workers_to_wake_up_.empty())
+      outer_->RecordWakeUp();
     workers_to_wake_up_.ForEachWorker(
         [](WorkerThread* worker) { worker->WakeUp(); });
 
@@ -236,6 +257,7 @@ class ThreadGroupImpl::WorkerThreadDelegateImpl : public WorkerThread::Delegate,
   void OnMainEntry(WorkerThread* worker) override;
   RegisteredTaskSource GetWork(WorkerThread* worker) override;
   void DidProcessTask(RegisteredTaskSource task_source) override;
+  TimeDelta GetSpinDuration() override;
   TimeDelta GetSleepTimeout() override;
   void OnMainExit(WorkerThread* worker) override;
 
@@ -266,7 +288,41 @@ class ThreadGroupImpl::WorkerThreadDelegateImpl : public WorkerThread::Delegate,
     return outer_->lock_;
   }
 
+  WorkerLocalQueue* local_queue() { return &local_queue_; }
+
+  // Called when |outer_| schedules a wake up of this worker while coalescing
+  // wake ups.
+  void OnWakeUpScheduledLockRequired() EXCLUSIVE_LOCKS_REQUIRED(outer_->lock_) {
+    DCHECK(!wake_up_pending_);
+    wake_up_pending_ = true;
+  }
+
  private:
+  // Returns a task source popped from |local_queue_| that this worker can run
+  // without acquiring |outer_->lock_|, or nullptr. Task sources which can't
+  // run that way are appended to |task_sources_to_requeue|.
+  RegisteredTaskSource GetWorkFromLocalQueue(
+      std::vector<RegisteredTaskSource>* task_sources_to_requeue);
+
+  // Called when GetWork() returns a task source other than
+  // |worker_only().batched_task_source|, to start counting a new batch.
+  void StartBatch();
+
+  // Returns true if |task_source|, which just ran a task on this worker, can
+  // run its next task as part of the current batch, without acquiring
+  // |outer_->lock_|.
+  bool CanContinueBatch(const RegisteredTaskSource& task_source);
+
+  // Returns true if the task source that just ran on this worker can be pushed
+  // to |local_queue_| by DidProcessTask().
+  bool CanPushToLocalQueue(const RegisteredTaskSource& task_source);
+
+  // Re-enqueues |task_sources| in the thread group associated with their
+  // current traits, if that isn't |outer_|. Those that belong to |outer_| are
+  // left in |task_sources|.
+  void ReEnqueueTaskSourcesInOtherThreadGroups(
+      std::vector<RegisteredTaskSource>* task_sources);
+
   // Returns true if |worker| is allowed to cleanup and remove itself from the
   // thread group. Called from GetWork() when no work is available.
   bool CanCleanupLockRequired(const WorkerThread* worker) const
@@ -297,6 +353,29 @@ class ThreadGroupImpl::WorkerThreadDelegateImpl : public WorkerThread::Delegate,
     // Associated WorkerThread, if any, initialized in OnMainEntry().
     WorkerThread* worker_thread_;
 
+    // Whether the worker is still accounted for in |outer_->num_running_tasks_|
+    // after DidProcessTask() pushed work to |local_queue_| without acquiring
+    // |outer_->lock_|.
+    bool holds_running_slot = false;
+
+    // Number of task sources run from |local_queue_| since the last time
+    // GetWork() acquired |outer_->lock_|.
+    size_t num_consecutive_local_queue_task_sources = 0;
+
+    // Task source kept by DidProcessTask() to run its next task as part of the
+    // current batch. The worker holds a running slot while this is set.
+    RegisteredTaskSource batched_task_source;
+
+    // Number of tasks run and start time of the current batch, i.e. since
+    // GetWork() last returned a task source other than |batched_task_source|.
+    size_t num_batched_tasks = 0;
+    TimeTicks batch_start_time;
+
+    // Whether |write_worker_read_any_.cumulative_blocking_time| belongs to a
+    // previous task. It can't be reset without |outer_->lock_| when a task
+    // source is taken from |local_queue_|, so it is reset lazily.
+    bool cumulative_blocking_time_is_stale = false;
+
 #if defined(OS_WIN)
     std::unique_ptr<win::ScopedWindowsThreadEnvironment> win_thread_environment;
 #endif  // defined(OS_WIN)
@@ -339,12 +418,21 @@ class ThreadGroupImpl::WorkerThreadDelegateImpl : public WorkerThread::Delegate,
 
   const TrackedRef<ThreadGroupImpl> outer_;
 
+  // Task sources that this worker runs next without acquiring
+  // |outer_->lock_|, unless sibling workers steal them first. Only used when
+  // |outer_->after_start().use_worker_local_queues| is true.
+  WorkerLocalQueue local_queue_;
+
   // Whether |outer_->max_tasks_|/|outer_->max_best_effort_tasks_| was
   // incremented due to a ScopedBlockingCall on the thread.
   bool incremented_max_tasks_since_blocked_ GUARDED_BY(outer_->lock_) = false;
   bool incremented_max_best_effort_tasks_since_blocked_
       GUARDED_BY(outer_->lock_) = false;
 
+  // Whether this worker was woken up by |outer_| and hasn't acquired
+  // |outer_->lock_| in GetWork() since. Only set when coalescing wake ups.
+  bool wake_up_pending_ GUARDED_BY(outer_->lock_) = false;
+
   // Verifies that specific calls are always made from the worker thread.
   THREAD_CHECKER(worker_thread_checker_);
 };
@@ -357,6 +445,7 @@ ThreadGroupImpl::ThreadGroupImpl(StringPiece histogram_label,
     : ThreadGroup(std::move(task_tracker), std::move(delegate)),
       thread_group_label_(thread_group_label),
       priority_hint_(priority_hint),
+      mean_wake_up_interval_us_(kMaxWakeUpIntervalUs),
       idle_workers_stack_cv_for_testing_(lock_.CreateConditionVariable()),
       // Mimics the UMA_HISTOGRAM_COUNTS_1000 macro. When a worker runs more
       // than 1000 tasks before detaching, there is no need to know the exact
@@ -376,6 +465,10 @@ ThreadGroupImpl::ThreadGroupImpl(StringPiece histogram_label,
   DCHECK(!thread_group_label_.empty());
 }
 
+void ThreadGroupImpl::SetWorkerCpuAffinity(std::vector<int> cpus) {
+  in_start().worker_cpu_affinity = std::move(cpus);
+}
+
 void ThreadGroupImpl::Start(
     int max_tasks,
     int max_best_effort_tasks,
@@ -393,6 +486,9 @@ void ThreadGroupImpl::Start(
   in_start().wakeup_strategy = kWakeUpStrategyParam.Get();
   in_start().may_block_without_delay =
       FeatureList::IsEnabled(kMayBlockWithoutDelay);
+  in_start().use_worker_local_queues =
+      FeatureList::IsEnabled(kUseWorkerLocalQueues);
+  in_start().coalesce_wake_ups = FeatureList::IsEnabled(kCoalesceWakeUps);
   in_start().may_block_threshold =
       may_block_threshold ? may_block_threshold.value()
                           : (priority_hint_ == ThreadPriority::NORMAL
@@ -401,6 +497,17 @@ void ThreadGroupImpl::Start(
   in_start().blocked_workers_poll_period =
       priority_hint_ == ThreadPriority::NORMAL ? kForegroundBlockedWorkersPoll
                                                : kBackgroundBlockedWorkersPoll;
+  // Background workers shouldn't burn CPU waiting for work.
+  in_start().max_spin_duration =
+      FeatureList::IsEnabled(kSpinIdleWorkers) &&
+              priority_hint_ != ThreadPriority::BACKGROUND
+          ? kMaxIdleWorkerSpinDuration.Get()
+          : TimeDelta();
+  if (FeatureList::IsEnabled(kBatchTaskSourceDraining)) {
+    in_start().max_batched_tasks =
+        static_cast<size_t>(std::max(kMaxBatchedTasks.Get(), 1));
+    in_start().max_batch_duration = kMaxBatchDuration.Get();
+  }
 
   ScopedCommandsExecutor executor(this);
   CheckedAutoLock auto_lock(lock_);
@@ -516,6 +623,21 @@ void ThreadGroupImpl::JoinForTesting() {
 
   CheckedAutoLock auto_lock(lock_);
   DCHECK(workers_ == workers_copy);
+
+  // Move task sources left in local queues to |priority_queue_| so that they
+  // are flushed along with it.
+  for (const auto& worker : workers_) {
+    std::vector<RegisteredTaskSource> task_sources;
+    static_cast<WorkerThreadDelegateImpl*>(worker->delegate())
+        ->local_queue()
+        ->TakeAll(&task_sources);
+    for (auto& task_source : task_sources) {
+      const TaskSourceSortKey sort_key =
+          task_source->GetSortKey(disable_fair_scheduling_);
+      priority_queue_.Push(std::move(task_source), sort_key);
+    }
+  }
+
   // Release |workers_| to clear their TrackedRef against |this|.
   workers_.clear();
 }
@@ -542,7 +664,8 @@ size_t ThreadGroupImpl::NumberOfIdleWorkersForTesting() const {
 
 ThreadGroupImpl::WorkerThreadDelegateImpl::WorkerThreadDelegateImpl(
     TrackedRef<ThreadGroupImpl> outer)
-    : outer_(std::move(outer)) {
+    : outer_(std::move(outer)),
+      local_queue_(&outer_->num_task_sources_in_local_queues_) {
   // Bound in OnMainEntry().
   DETACH_FROM_THREAD(worker_thread_checker_);
 }
@@ -571,6 +694,14 @@ void ThreadGroupImpl::WorkerThreadDelegateImpl::OnMainEntry(
   PlatformThread::SetName(
       StringPrintf("ThreadPool%sWorker", outer_->thread_group_label_.c_str()));
 
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+  if (!outer_->after_start().worker_cpu_affinity.empty()) {
+    // Failure is harmless: the worker then runs on any CPU.
+    SetThreadCpuAffinity(PlatformThread::CurrentId(),
+                         outer_->after_start().worker_cpu_affinity);
+  }
+#endif
+
   outer_->BindToCurrentThread();
   worker_only().worker_thread_ = worker;
   SetBlockingObserverForCurrentThread(this);
@@ -589,11 +720,61 @@ RegisteredTaskSource ThreadGroupImpl::WorkerThreadDelegateImpl::GetWork(
   DCHECK_CALLED_ON_VALID_THREAD(worker_thread_checker_);
   DCHECK(!worker_only().is_running_task);
 
+  // Continue the current batch. DidProcessTask() already checked that it is
+  // allowed to.
+  if (worker_only().batched_task_source) {
+    DCHECK(worker_only().holds_running_slot);
+    RegisteredTaskSource task_source =
+        std::move(worker_only().batched_task_source);
+    const TaskSource::RunStatus run_status = task_source.WillRunTask();
+    DCHECK_EQ(run_status, TaskSource::RunStatus::kAllowedSaturated);
+    worker_only().holds_running_slot = false;
+    worker_only().is_running_task = true;
+    worker_only().cumulative_blocking_time_is_stale = true;
+    return task_source;
+  }
+
+  // Task sources from |local_queue_| that must go back to |priority_queue_|.
+  std::vector<RegisteredTaskSource> task_sources_to_requeue;
+  if (worker_only().holds_running_slot) {
+    RegisteredTaskSource task_source =
+        GetWorkFromLocalQueue(&task_sources_to_requeue);
+    if (task_source) {
+      StartBatch();
+      return task_source;
+    }
+  }
+  // Going through |outer_->lock_| makes the task sources left in
+  // |local_queue_| visible to other workers again and lets them be ordered
+  // against other task sources in |priority_queue_|.
+  local_queue_.TakeAll(&task_sources_to_requeue);
+  ReEnqueueTaskSourcesInOtherThreadGroups(&task_sources_to_requeue);
+
   ScopedCommandsExecutor executor(outer_.get());
   CheckedAutoLock auto_lock(outer_->lock_);
 
   DCHECK(ContainsWorker(outer_->workers_, worker));
 
+  if (wake_up_pending_) {
+    wake_up_pending_ = false;
+    outer_->OnWokenUpWorkerGetsWorkLockRequired(&executor);
+  }
+
+  if (worker_only().holds_running_slot) {
+    worker_only().holds_running_slot = false;
+    outer_->DecrementTasksRunningLockRequired(
+        *read_worker().current_task_priority);
+  }
+  worker_only().num_consecutive_local_queue_task_sources = 0;
+  if (!task_sources_to_requeue.empty()) {
+    for (auto& task_source : task_sources_to_requeue) {
+      const TaskSourceSortKey sort_key =
+          task_source->GetSortKey(outer_->disable_fair_scheduling_);
+      outer_->priority_queue_.Push(std::move(task_source), sort_key);
+    }
+    outer_->EnsureEnoughWorkersLockRequired(&executor);
+  }
+
   // Use this opportunity, before assigning work to this worker, to create/wake
   // additional workers if needed (doing this here allows us to reduce
   // potentially expensive create/wake directly on PostTask()).
@@ -626,6 +807,15 @@ RegisteredTaskSource ThreadGroupImpl::WorkerThreadDelegateImpl::GetWork(
 
     task_source = outer_->TakeRegisteredTaskSource(&executor);
   }
+  if (!task_source && outer_->after_start().use_worker_local_queues &&
+      outer_->task_tracker_->CanRunPriority(TaskPriority::USER_VISIBLE)) {
+    task_source = outer_->StealTaskSourceLockRequired(worker);
+    if (task_source) {
+      priority = task_source->priority_racy();
+      const TaskSource::RunStatus run_status = task_source.WillRunTask();
+      DCHECK_EQ(run_status, TaskSource::RunStatus::kAllowedSaturated);
+    }
+  }
   if (!task_source) {
     OnWorkerBecomesIdleLockRequired(worker);
     return nullptr;
@@ -637,6 +827,13 @@ RegisteredTaskSource ThreadGroupImpl::WorkerThreadDelegateImpl::GetWork(
   DCHECK(!outer_->idle_workers_stack_.Contains(worker));
   write_worker().current_task_priority = priority;
   write_worker().cumulative_blocking_time = TimeDelta();
+  worker_only().cumulative_blocking_time_is_stale = false;
+
+  if (outer_->after_start().use_worker_local_queues &&
+      CanQueueInWorkerLocalQueue(*task_source.get())) {
+    outer_->MoveSurplusTaskSourcesToLocalQueueLockRequired(priority,
+                                                           &local_queue_);
+  }
 
   if (outer_->after_start().wakeup_after_getwork &&
       outer_->after_start().wakeup_strategy !=
@@ -644,6 +841,7 @@ RegisteredTaskSource ThreadGroupImpl::WorkerThreadDelegateImpl::GetWork(
     outer_->EnsureEnoughWorkersLockRequired(&executor);
   }
 
+  StartBatch();
   return task_source;
 }
 
@@ -655,6 +853,29 @@ void ThreadGroupImpl::WorkerThreadDelegateImpl::DidProcessTask(
 
   ++worker_only().num_tasks_since_last_detach;
 
+  // Run the next task of |task_source| without acquiring |outer_->lock_|. The
+  // worker remains accounted for as running a task until GetWork() acquires
+  // |outer_->lock_|.
+  if (task_source && CanContinueBatch(task_source)) {
+    worker_only().batched_task_source = std::move(task_source);
+    worker_only().is_running_task = false;
+    worker_only().holds_running_slot = true;
+    return;
+  }
+
+  // Keep running from |local_queue_| without acquiring |outer_->lock_|. The
+  // worker remains accounted for as running a task until GetWork() acquires
+  // |outer_->lock_|.
+  if (outer_->after_start().use_worker_local_queues &&
+      (task_source ? CanPushToLocalQueue(task_source)
+                   : !local_queue_.IsEmpty())) {
+    if (task_source)
+      local_queue_.Push(std::move(task_source));
+    worker_only().is_running_task = false;
+    worker_only().holds_running_slot = true;
+    return;
+  }
+
   // A transaction to the TaskSource to reenqueue, if any. Instantiated here as
   // |TaskSource::lock_| is a UniversalPredecessor and must always be acquired
   // prior to acquiring a second lock
@@ -685,6 +906,10 @@ void ThreadGroupImpl::WorkerThreadDelegateImpl::DidProcessTask(
   }
 }
 
+TimeDelta ThreadGroupImpl::WorkerThreadDelegateImpl::GetSpinDuration() {
+  return outer_->GetSpinDuration();
+}
+
 TimeDelta ThreadGroupImpl::WorkerThreadDelegateImpl::GetSleepTimeout() {
   DCHECK_CALLED_ON_VALID_THREAD(worker_thread_checker_);
   // Sleep for an extra 10% to avoid the following pathological case:
@@ -741,6 +966,8 @@ void ThreadGroupImpl::WorkerThreadDelegateImpl::CleanupLockRequired(
         outer_->num_tasks_before_detach_histogram_,
         worker_only().num_tasks_since_last_detach);
   }
+  DCHECK(local_queue_.IsEmpty());
+  DCHECK(!worker_only().batched_task_source);
   worker->Cleanup();
   outer_->idle_workers_stack_.Remove(worker);
 
@@ -821,6 +1048,10 @@ void ThreadGroupImpl::WorkerThreadDelegateImpl::BlockingStarted(
   DCHECK(!incremented_max_best_effort_tasks_since_blocked_);
   DCHECK(read_worker().blocking_start_time.is_null());
   write_worker().blocking_start_time = subtle::TimeTicksNowIgnoringOverride();
+  if (worker_only().cumulative_blocking_time_is_stale) {
+    write_worker().cumulative_blocking_time = TimeDelta();
+    worker_only().cumulative_blocking_time_is_stale = false;
+  }
 
   if (*read_worker().current_task_priority == TaskPriority::BEST_EFFORT)
     ++outer_->num_unresolved_best_effort_may_block_;
@@ -891,6 +1122,127 @@ void ThreadGroupImpl::WorkerThreadDelegateImpl::BlockingEnded() {
   write_worker().blocking_start_time = TimeTicks();
 }
 
+RegisteredTaskSource
+ThreadGroupImpl::WorkerThreadDelegateImpl::GetWorkFromLocalQueue(
+    std::vector<RegisteredTaskSource>* task_sources_to_requeue) {
+  DCHECK(worker_only().holds_running_slot);
+
+  if (worker_only().num_consecutive_local_queue_task_sources >=
+      kMaxConsecutiveLocalQueueTaskSources) {
+    return nullptr;
+  }
+
+  // The priority for which this worker is accounted in
+  // |outer_->num_running_tasks_|.
+  const TaskPriority priority = *read_worker().current_task_priority;
+  if (!outer_->task_tracker_->CanRunPriority(priority))
+    return nullptr;
+
+  // Defer to |outer_->priority_queue_| if it has higher priority work waiting
+  // for a worker. |max_allowed_sort_key_| is kMaxYieldSortKey unless the
+  // thread group is at capacity with pending work.
+  const YieldSortKey max_allowed_sort_key =
+      TS_UNCHECKED_READ(outer_->max_allowed_sort_key_)
+          .load(std::memory_order_relaxed);
+  if (max_allowed_sort_key.priority > priority)
+    return nullptr;
+
+  RegisteredTaskSource task_source = local_queue_.Pop();
+  if (!task_source)
+    return nullptr;
+
+  // The priority of |task_source| may have been updated while it was queued.
+  if (task_source->priority_racy() != priority) {
+    task_sources_to_requeue->push_back(std::move(task_source));
+    return nullptr;
+  }
+
+  const TaskSource::RunStatus run_status = task_source.WillRunTask();
+  DCHECK_EQ(run_status, TaskSource::RunStatus::kAllowedSaturated);
+
+  ++worker_only().num_consecutive_local_queue_task_sources;
+  worker_only().holds_running_slot = false;
+  worker_only().is_running_task = true;
+  worker_only().cumulative_blocking_time_is_stale = true;
+  return task_source;
+}
+
+void ThreadGroupImpl::WorkerThreadDelegateImpl::StartBatch() {
+  worker_only().num_batched_tasks = 0;
+  if (outer_->after_start().max_batched_tasks > 1)
+    worker_only().batch_start_time = TimeTicks::Now();
+}
+
+bool ThreadGroupImpl::WorkerThreadDelegateImpl::CanContinueBatch(
+    const RegisteredTaskSource& task_source) {
+  if (++worker_only().num_batched_tasks >=
+      outer_->after_start().max_batched_tasks) {
+    return false;
+  }
+  // Jobs already run worker tasks in a loop and must go through
+  // |outer_->priority_queue_| to get more workers.
+  if (task_source->execution_mode() != TaskSourceExecutionMode::kSequenced &&
+      task_source->execution_mode() != TaskSourceExecutionMode::kParallel) {
+    return false;
+  }
+
+  // The task source must keep the priority for which this worker is
+  // accounted in |outer_->num_running_tasks_| and stay in this thread group.
+  const TaskPriority priority = *read_worker().current_task_priority;
+  if (task_source->priority_racy() != priority ||
+      !outer_->task_tracker_->CanRunPriority(priority) ||
+      outer_->delegate_->GetThreadGroupForTaskSource(
+          *task_source.get(), {priority, task_source->thread_policy()}) !=
+          outer_.get()) {
+    return false;
+  }
+
+  // Yield to higher priority work waiting for a worker, so that a batch of
+  // lower priority tasks delays it by at most one task.
+  // |max_allowed_sort_key_| is kMaxYieldSortKey unless the thread group is at
+  // capacity with pending work.
+  const YieldSortKey max_allowed_sort_key =
+      TS_UNCHECKED_READ(outer_->max_allowed_sort_key_)
+          .load(std::memory_order_relaxed);
+  if (max_allowed_sort_key.priority > priority)
+    return false;
+
+  return TimeTicks::Now() - worker_only().batch_start_time <
+         outer_->after_start().max_batch_duration;
+}
+
+bool ThreadGroupImpl::WorkerThreadDelegateImpl::CanPushToLocalQueue(
+    const RegisteredTaskSource& task_source) {
+  if (!CanQueueInWorkerLocalQueue(*task_source.get()) || local_queue_.IsFull())
+    return false;
+  // The task source must stay in this thread group and keep the priority for
+  // which this worker is accounted in |outer_->num_running_tasks_|.
+  const TaskPriority priority = task_source->priority_racy();
+  return priority == *read_worker().current_task_priority &&
+         outer_->delegate_->GetThreadGroupForTaskSource(
+             *task_source.get(), {priority, task_source->thread_policy()}) ==
+             outer_.get();
+}
+
+void ThreadGroupImpl::WorkerThreadDelegateImpl::
+    ReEnqueueTaskSourcesInOtherThreadGroups(
+        std::vector<RegisteredTaskSource>* task_sources) {
+  CheckedLock::AssertNoLockHeldOnCurrentThread();
+  auto it = task_sources->begin();
+  while (it != task_sources->end()) {
+    ThreadGroup* const destination_thread_group =
+        outer_->delegate_->GetThreadGroupForTaskSource(
+            *it->get(), {(*it)->priority_racy(), (*it)->thread_policy()});
+    if (destination_thread_group == outer_.get()) {
+      ++it;
+      continue;
+    }
+    destination_thread_group->PushTaskSourceAndWakeUpWorkers(
+        TransactionWithRegisteredTaskSource::FromTaskSource(std::move(*it)));
+    it = task_sources->erase(it);
+  }
+}
+
 bool ThreadGroupImpl::WorkerThreadDelegateImpl::CanGetWorkLockRequired(
     ScopedCommandsExecutor* executor,
     WorkerThread* worker) {
@@ -1015,7 +1367,8 @@ size_t ThreadGroupImpl::GetDesiredNumAwakeWorkersLockRequired() const {
   // Number of USER_{VISIBLE|BLOCKING} task sources that are running or queued.
   const size_t num_running_or_queued_foreground_task_sources =
       (num_running_tasks_ - num_running_best_effort_tasks_) +
-      GetNumAdditionalWorkersForForegroundTaskSourcesLockRequired();
+      GetNumAdditionalWorkersForForegroundTaskSourcesLockRequired() +
+      num_task_sources_in_local_queues_.load(std::memory_order_relaxed);
 
   const size_t workers_for_foreground_task_sources =
       num_running_or_queued_foreground_task_sources;
@@ -1025,6 +1378,63 @@ size_t ThreadGroupImpl::GetDesiredNumAwakeWorkersLockRequired() const {
                    max_tasks_, kMaxNumberOfWorkers});
 }
 
+// static
+bool ThreadGroupImpl::CanQueueInWorkerLocalQueue(
+    const TaskSource& task_source) {
+  return (task_source.execution_mode() == TaskSourceExecutionMode::kParallel ||
+          task_source.execution_mode() ==
+              TaskSourceExecutionMode::kSequenced) &&
+         task_source.priority_racy() != TaskPriority::BEST_EFFORT;
+}
+
+void ThreadGroupImpl::MoveSurplusTaskSourcesToLocalQueueLockRequired(
+    TaskPriority priority,
+    WorkerLocalQueue* local_queue) {
+  // BEST_EFFORT task sources are subject to |max_best_effort_tasks_|, which
+  // is only enforced in GetWork().
+  if (priority == TaskPriority::BEST_EFFORT)
+    return;
+
+  // Leave enough task sources in |priority_queue_| for the workers that can
+  // still be woken up; only the surplus would otherwise wait for capacity.
+  const size_t num_available_workers = ClampSub(max_tasks_, num_running_tasks_);
+  const size_t num_queued =
+      priority_queue_.GetNumTaskSourcesWithPriority(priority);
+  if (num_queued <= num_available_workers)
+    return;
+  size_t num_to_move = std::min(num_queued - num_available_workers,
+                                WorkerLocalQueue::kCapacity -
+                                    local_queue->Size());
+
+  bool moved_task_sources = false;
+  while (num_to_move > 0 && !priority_queue_.IsEmpty() &&
+         priority_queue_.PeekSortKey().priority() == priority &&
+         CanQueueInWorkerLocalQueue(*priority_queue_.PeekTaskSource().get())) {
+    local_queue->Push(priority_queue_.PopTaskSource());
+    moved_task_sources = true;
+    --num_to_move;
+  }
+  if (moved_task_sources)
+    UpdateMinAllowedPriorityLockRequired();
+}
+
+RegisteredTaskSource ThreadGroupImpl::StealTaskSourceLockRequired(
+    const WorkerThread* worker) {
+  if (num_task_sources_in_local_queues_.load(std::memory_order_relaxed) == 0)
+    return nullptr;
+  for (const scoped_refptr<WorkerThread>& victim : workers_) {
+    if (victim.get() == worker)
+      continue;
+    RegisteredTaskSource task_source =
+        static_cast<WorkerThreadDelegateImpl*>(victim->delegate())
+            ->local_queue()
+            ->Steal();
+    if (task_source)
+      return task_source;
+  }
+  return nullptr;
+}
+
 void ThreadGroupImpl::DidUpdateCanRunPolicy() {
   ScopedCommandsExecutor executor(this);
   CheckedAutoLock auto_lock(lock_);
@@ -1046,6 +1456,13 @@ void ThreadGroupImpl::EnsureEnoughWorkersLockRequired(
 
   size_t num_workers_to_wake_up =
       ClampSub(desired_num_awake_workers, num_awake_workers);
+  if (after_start().coalesce_wake_ups && num_pending_wake_ups_ > 0) {
+    // A worker woken up earlier will wake up the workers still needed once it
+    // gets work, in OnWokenUpWorkerGetsWorkLockRequired().
+    num_deferred_wake_ups_ =
+        std::max(num_deferred_wake_ups_, num_workers_to_wake_up);
+    num_workers_to_wake_up = 0;
+  }
   if (after_start().wakeup_strategy == WakeUpStrategy::kExponentialWakeUps) {
     num_workers_to_wake_up = std::min(num_workers_to_wake_up, size_t(2U));
   } else if (after_start().wakeup_strategy ==
@@ -1058,6 +1475,11 @@ void ThreadGroupImpl::EnsureEnoughWorkersLockRequired(
     MaintainAtLeastOneIdleWorkerLockRequired(executor);
     WorkerThread* worker_to_wakeup = idle_workers_stack_.Pop();
     DCHECK(worker_to_wakeup);
+    if (after_start().coalesce_wake_ups) {
+      static_cast<WorkerThreadDelegateImpl*>(worker_to_wakeup->delegate())
+          ->OnWakeUpScheduledLockRequired();
+      ++num_pending_wake_ups_;
+    }
     executor->ScheduleWakeUp(worker_to_wakeup);
   }
 
@@ -1149,6 +1571,58 @@ bool ThreadGroupImpl::ShouldPeriodicallyAdjustMaxTasksLockRequired() {
          num_unresolved_may_block_ > 0;
 }
 
+void ThreadGroupImpl::RecordWakeUp() {
+  if (after_start().max_spin_duration.is_zero())
+    return;
+  const int64_t now_us =
+      (subtle::TimeTicksNowIgnoringOverride() - TimeTicks()).InMicroseconds();
+  const int64_t last_wake_up_time_us =
+      last_wake_up_time_us_.exchange(now_us, std::memory_order_relaxed);
+  const int64_t interval_us =
+      std::min(now_us - last_wake_up_time_us, kMaxWakeUpIntervalUs);
+  const int64_t mean_us =
+      mean_wake_up_interval_us_.load(std::memory_order_relaxed);
+  mean_wake_up_interval_us_.store(
+      mean_us + ((interval_us - mean_us) >> kWakeUpIntervalWeightShift),
+      std::memory_order_relaxed);
+}
+
+void ThreadGroupImpl::OnWokenUpWorkerGetsWorkLockRequired(
+    ScopedCommandsExecutor* executor) {
+  DCHECK(after_start().coalesce_wake_ups);
+  DCHECK_GT(num_pending_wake_ups_, 0U);
+  --num_pending_wake_ups_;
+  if (num_pending_wake_ups_ > 0 || num_deferred_wake_ups_ == 0)
+    return;
+  // Deferred wake ups for work that was done in the meantime were avoided.
+  const size_t num_needed_wake_ups =
+      ClampSub(GetDesiredNumAwakeWorkersLockRequired(),
+               GetNumAwakeWorkersLockRequired());
+  const size_t num_avoided_wake_ups =
+      ClampSub(num_deferred_wake_ups_, num_needed_wake_ups);
+  num_wake_ups_avoided_ += num_avoided_wake_ups;
+  num_deferred_wake_ups_ = 0;
+  EnsureEnoughWorkersLockRequired(executor);
+}
+
+size_t ThreadGroupImpl::GetNumWakeUpsAvoided() const {
+  CheckedAutoLock auto_lock(lock_);
+  return num_wake_ups_avoided_;
+}
+
+TimeDelta ThreadGroupImpl::GetSpinDuration() const {
+  const TimeDelta max_spin_duration = after_start().max_spin_duration;
+  if (max_spin_duration.is_zero())
+    return TimeDelta();
+  // Spin only if work is expected to arrive before the spin ends. Spinning for
+  // twice the mean interval catches most wake ups when they are regular.
+  const TimeDelta mean_interval = TimeDelta::FromMicroseconds(
+      mean_wake_up_interval_us_.load(std::memory_order_relaxed));
+  if (mean_interval > max_spin_duration)
+    return TimeDelta();
+  return std::min(max_spin_duration, 2 * mean_interval);
+}
+
 void ThreadGroupImpl::UpdateMinAllowedPriorityLockRequired() {
   if (priority_queue_.IsEmpty() || num_running_tasks_ < max_tasks_) {
     max_allowed_sort_key_.store(kMaxYieldSortKey, std::memory_order_relaxed);
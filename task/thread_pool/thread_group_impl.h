@@ -7,6 +7,7 @@
 
 #include <stddef.h>
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
@@ -25,6 +26,7 @@
 #include "base/task/thread_pool/task_source.h"
 #include "base/task/thread_pool/thread_group.h"
 #include "base/task/thread_pool/tracked_ref.h"
+#include "base/task/thread_pool/worker_local_queue.h"
 #include "base/task/thread_pool/worker_thread.h"
 #include "base/task/thread_pool/worker_thread_stack.h"
 #include "base/time/time.h"
@@ -85,6 +87,11 @@ class BASE_EXPORT ThreadGroupImpl : public ThreadGroup {
              absl::optional<TimeDelta> may_block_threshold =
                  absl::optional<TimeDelta>());
 
+  // Restricts the workers of this thread group to the logical CPUs in |cpus|.
+  // Only supported on Linux, ChromeOS and Android; ignored elsewhere. Must be
+  // called before Start().
+  void SetWorkerCpuAffinity(std::vector<int> cpus);
+
   ThreadGroupImpl(const ThreadGroupImpl&) = delete;
   ThreadGroupImpl& operator=(const ThreadGroupImpl&) = delete;
   // Destroying a ThreadGroupImpl returned by Create() is not allowed in
@@ -101,6 +108,12 @@ class BASE_EXPORT ThreadGroupImpl : public ThreadGroup {
     return num_tasks_before_detach_histogram_;
   }
 
+  // Returns the number of worker wake ups avoided by coalescing them with the
+  // wake up of a worker which hadn't gotten work yet (see kCoalesceWakeUps).
+  // This is the number of wake ups that were deferred minus the number that
+  // were still needed when the pending worker got work.
+  size_t GetNumWakeUpsAvoided() const;
+
   // Waits until at least |n| workers are idle. Note that while workers are
   // disallowed from cleaning up during this call: tests using a custom
   // |suggested_reclaim_time_| need to be careful to invoke this swiftly after
@@ -173,6 +186,21 @@ class BASE_EXPORT ThreadGroupImpl : public ThreadGroup {
   size_t GetDesiredNumAwakeWorkersLockRequired() const
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Returns true if |task_source| may be queued in a WorkerLocalQueue.
+  static bool CanQueueInWorkerLocalQueue(const TaskSource& task_source);
+
+  // Moves up to WorkerLocalQueue::kCapacity task sources with |priority| from
+  // |priority_queue_| to |local_queue|, if |priority_queue_| holds more of
+  // them than there are workers available to run them.
+  void MoveSurplusTaskSourcesToLocalQueueLockRequired(
+      TaskPriority priority,
+      WorkerLocalQueue* local_queue) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Steals a task source from the WorkerLocalQueue of a worker other than
+  // |worker|. Returns nullptr if no task source could be stolen.
+  RegisteredTaskSource StealTaskSourceLockRequired(const WorkerThread* worker)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Examines the list of WorkerThreads and increments |max_tasks_| for each
   // worker that has been within the scope of a MAY_BLOCK ScopedBlockingCall for
   // more than BlockedThreshold(). Reschedules a call if necessary.
@@ -204,6 +232,20 @@ class BASE_EXPORT ThreadGroupImpl : public ThreadGroup {
   bool ShouldPeriodicallyAdjustMaxTasksLockRequired()
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Records that an idle worker is being woken up, to estimate the interval
+  // between wake ups. Thread-safe.
+  void RecordWakeUp();
+
+  // Returns how long an idle worker should spin before sleeping, based on the
+  // recent interval between wake ups. Thread-safe.
+  TimeDelta GetSpinDuration() const;
+
+  // Called from GetWork() by a worker which was woken up by
+  // EnsureEnoughWorkersLockRequired(). Wakes up the workers for which wake ups
+  // were deferred while this worker's wake up was pending, if still needed.
+  void OnWokenUpWorkerGetsWorkLockRequired(ScopedCommandsExecutor* executor)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Updates the minimum priority allowed to run below which tasks should yield.
   // This should be called whenever |num_running_tasks_| or |max_tasks| changes,
   // or when a new task is added to |priority_queue_|.
@@ -249,9 +291,17 @@ class BASE_EXPORT ThreadGroupImpl : public ThreadGroup {
     // Optional observer notified when a worker enters and exits its main.
     WorkerThreadObserver* worker_thread_observer = nullptr;
 
+    // Logical CPUs to which workers are restricted. Empty if unrestricted.
+    std::vector<int> worker_cpu_affinity;
+
     WakeUpStrategy wakeup_strategy;
     bool wakeup_after_getwork;
     bool may_block_without_delay;
+    bool use_worker_local_queues;
+
+    // Whether EnsureEnoughWorkersLockRequired() leaves wake ups to workers
+    // which were woken up and haven't gotten work yet.
+    bool coalesce_wake_ups = false;
 
     // Threshold after which the max tasks is increased to compensate for a
     // worker that is within a MAY_BLOCK ScopedBlockingCall.
@@ -260,6 +310,16 @@ class BASE_EXPORT ThreadGroupImpl : public ThreadGroup {
     // The period between calls to AdjustMaxTasks() when the thread group is at
     // capacity.
     TimeDelta blocked_workers_poll_period;
+
+    // Maximum time an idle worker spins before sleeping. Zero if idle workers
+    // don't spin.
+    TimeDelta max_spin_duration;
+
+    // Maximum number of tasks and time for which a worker keeps running tasks
+    // from the task source it picked up without acquiring |lock_|. Batching
+    // is disabled if |max_batched_tasks| is 1.
+    size_t max_batched_tasks = 1;
+    TimeDelta max_batch_duration;
   } initialized_in_start_;
 
   InitializedInStart& in_start() {
@@ -297,6 +357,30 @@ class BASE_EXPORT ThreadGroupImpl : public ThreadGroup {
   int num_unresolved_may_block_ GUARDED_BY(lock_) = 0;
   int num_unresolved_best_effort_may_block_ GUARDED_BY(lock_) = 0;
 
+  // Number of task sources in the WorkerLocalQueues of |workers_|. These
+  // task sources are not in |priority_queue_| but still need a worker to run
+  // them. Atomic because WorkerLocalQueues are modified without |lock_|.
+  std::atomic_size_t num_task_sources_in_local_queues_{0};
+
+  // Time of the last wake up of an idle worker and exponentially weighted
+  // moving average of the interval between wake ups, in microseconds. Updated
+  // without |lock_| by RecordWakeUp(); concurrent updates may lose samples,
+  // which is fine for an estimate.
+  std::atomic<int64_t> last_wake_up_time_us_{0};
+  std::atomic<int64_t> mean_wake_up_interval_us_;
+
+  // Number of workers woken up by EnsureEnoughWorkersLockRequired() which
+  // haven't acquired |lock_| in GetWork() since. Only tracked when
+  // |after_start().coalesce_wake_ups| is true.
+  size_t num_pending_wake_ups_ GUARDED_BY(lock_) = 0;
+
+  // Largest number of workers that EnsureEnoughWorkersLockRequired() wanted to
+  // wake up while |num_pending_wake_ups_| was non-zero.
+  size_t num_deferred_wake_ups_ GUARDED_BY(lock_) = 0;
+
+  // See GetNumWakeUpsAvoided().
+  size_t num_wake_ups_avoided_ GUARDED_BY(lock_) = 0;
+
   // Stack of idle workers. Initially, all workers are on this stack. A worker
   // is removed from the stack before its WakeUp() function is called and when
   // it receives work from GetWork() (a worker calls GetWork() when its sleep
@@ -40,6 +40,7 @@
 #include "base/test/bind.h"
 #include "base/test/gtest_util.h"
 #include "base/test/metrics/histogram_tester.h"
+#include "base/test/scoped_feature_list.h"
 #include "base/test/test_simple_task_runner.h"
 #include "base/test/test_timeouts.h"
 #include "base/test/test_waitable_event.h"
@@ -421,6 +422,292 @@ INSTANTIATE_TEST_SUITE_P(Job,
 
 namespace {
 
+class ThreadGroupImplWorkerLocalQueuesTest
+    : public ThreadGroupImplImplTestBase,
+      public testing::TestWithParam<TaskSourceExecutionMode> {
+ public:
+  ThreadGroupImplWorkerLocalQueuesTest(
+      const ThreadGroupImplWorkerLocalQueuesTest&) = delete;
+  ThreadGroupImplWorkerLocalQueuesTest& operator=(
+      const ThreadGroupImplWorkerLocalQueuesTest&) = delete;
+
+ protected:
+  ThreadGroupImplWorkerLocalQueuesTest() {
+    feature_list_.InitAndEnableFeature(kUseWorkerLocalQueues);
+  }
+
+  void SetUp() override { CreateAndStartThreadGroup(); }
+
+  void TearDown() override { ThreadGroupImplImplTestBase::CommonTearDown(); }
+
+ private:
+  base::test::ScopedFeatureList feature_list_;
+};
+
+}  // namespace
+
+// Verify that tasks posted to more task sources than there are workers all run,
+// in posting order within each sequence, when workers keep task sources in
+// local queues and steal from each other.
+TEST_P(ThreadGroupImplWorkerLocalQueuesTest, PostTasksToManyTaskSources) {
+  std::vector<std::unique_ptr<test::TestTaskFactory>> factories;
+  for (size_t i = 0; i < kMaxTasks * WorkerLocalQueue::kCapacity; ++i) {
+    factories.push_back(std::make_unique<test::TestTaskFactory>(
+        CreatePooledTaskRunnerWithExecutionMode(
+            GetParam(), &mock_pooled_task_runner_delegate_),
+        GetParam()));
+  }
+  for (size_t i = 0; i < kNumTasksPostedPerThread; ++i) {
+    for (auto& factory : factories)
+      EXPECT_TRUE(factory->PostTask(PostNestedTask::YES, OnceClosure()));
+  }
+  for (auto& factory : factories)
+    factory->WaitForAllTasksToRun();
+
+  // Wait until all workers are idle to be sure that no task accesses its
+  // TestTaskFactory after it is destroyed.
+  thread_group_->WaitForAllWorkersIdleForTesting();
+}
+
+// Verify that a USER_BLOCKING task runs when all workers are busy running
+// USER_VISIBLE sequences from their local queues.
+TEST_P(ThreadGroupImplWorkerLocalQueuesTest, HigherPriorityIsNotStarved) {
+  std::atomic_bool user_blocking_task_ran{false};
+  TestWaitableEvent all_sequences_running;
+  RepeatingClosure all_sequences_running_barrier = BarrierClosure(
+      kMaxTasks, BindOnce(&TestWaitableEvent::Signal,
+                          Unretained(&all_sequences_running)));
+
+  std::vector<scoped_refptr<TaskRunner>> task_runners;
+  for (size_t i = 0; i < kMaxTasks; ++i) {
+    task_runners.push_back(CreatePooledTaskRunnerWithExecutionMode(
+        GetParam(), &mock_pooled_task_runner_delegate_,
+        {TaskPriority::USER_VISIBLE}));
+  }
+  // Each task re-posts itself until the USER_BLOCKING task ran, which keeps
+  // its sequence in the local queue of the worker that runs it when the
+  // execution mode is SEQUENCED.
+  RepeatingCallback<void(TaskRunner*, bool)> repost_task;
+  repost_task = BindLambdaForTesting([&](TaskRunner* task_runner,
+                                         bool first_run) {
+    if (first_run)
+      all_sequences_running_barrier.Run();
+    if (!user_blocking_task_ran.load())
+      task_runner->PostTask(FROM_HERE, BindOnce(repost_task, task_runner,
+                                                /* first_run=*/false));
+  });
+  for (auto& task_runner : task_runners) {
+    task_runner->PostTask(FROM_HERE, BindOnce(repost_task, task_runner.get(),
+                                              /* first_run=*/true));
+  }
+  all_sequences_running.Wait();
+
+  TestWaitableEvent user_blocking_task_running;
+  test::CreatePooledTaskRunner({TaskPriority::USER_BLOCKING},
+                               &mock_pooled_task_runner_delegate_)
+      ->PostTask(FROM_HERE, BindLambdaForTesting([&]() {
+                   user_blocking_task_ran.store(true);
+                   user_blocking_task_running.Signal();
+                 }));
+  user_blocking_task_running.Wait();
+
+  task_tracker_.FlushForTesting();
+}
+
+INSTANTIATE_TEST_SUITE_P(Parallel,
+                         ThreadGroupImplWorkerLocalQueuesTest,
+                         ::testing::Values(TaskSourceExecutionMode::kParallel));
+INSTANTIATE_TEST_SUITE_P(
+    Sequenced,
+    ThreadGroupImplWorkerLocalQueuesTest,
+    ::testing::Values(TaskSourceExecutionMode::kSequenced));
+
+namespace {
+
+class ThreadGroupImplBatchDrainingTest
+    : public ThreadGroupImplImplTestBase,
+      public testing::TestWithParam<TaskSourceExecutionMode> {
+ public:
+  ThreadGroupImplBatchDrainingTest(const ThreadGroupImplBatchDrainingTest&) =
+      delete;
+  ThreadGroupImplBatchDrainingTest& operator=(
+      const ThreadGroupImplBatchDrainingTest&) = delete;
+
+ protected:
+  ThreadGroupImplBatchDrainingTest() {
+    // Batches are only bounded by the priority of pending work.
+    feature_list_.InitAndEnableFeatureWithParameters(
+        kBatchTaskSourceDraining, {{"max_batched_tasks", "1000000"},
+                                   {"max_batch_duration", "60s"}});
+  }
+
+  void SetUp() override { CreateAndStartThreadGroup(); }
+
+  void TearDown() override { ThreadGroupImplImplTestBase::CommonTearDown(); }
+
+ private:
+  base::test::ScopedFeatureList feature_list_;
+};
+
+}  // namespace
+
+// Verify that tasks posted to many task sources all run, in posting order
+// within each sequence, when workers run them in batches.
+TEST_P(ThreadGroupImplBatchDrainingTest, PostTasks) {
+  std::vector<std::unique_ptr<test::TestTaskFactory>> factories;
+  for (size_t i = 0; i < kNumThreadsPostingTasks; ++i) {
+    factories.push_back(std::make_unique<test::TestTaskFactory>(
+        CreatePooledTaskRunnerWithExecutionMode(
+            GetParam(), &mock_pooled_task_runner_delegate_),
+        GetParam()));
+  }
+  for (size_t i = 0; i < kNumTasksPostedPerThread; ++i) {
+    for (auto& factory : factories)
+      EXPECT_TRUE(factory->PostTask(PostNestedTask::YES, OnceClosure()));
+  }
+  for (auto& factory : factories)
+    factory->WaitForAllTasksToRun();
+
+  // Wait until all workers are idle to be sure that no task accesses its
+  // TestTaskFactory after it is destroyed.
+  thread_group_->WaitForAllWorkersIdleForTesting();
+}
+
+// Verify that a USER_BLOCKING task runs when all workers are busy running
+// batches of BEST_EFFORT tasks which never run out.
+TEST_P(ThreadGroupImplBatchDrainingTest, HigherPriorityIsNotStarved) {
+  std::atomic_bool user_blocking_task_ran{false};
+  TestWaitableEvent all_task_sources_running;
+  RepeatingClosure all_task_sources_running_barrier = BarrierClosure(
+      kMaxTasks, BindOnce(&TestWaitableEvent::Signal,
+                          Unretained(&all_task_sources_running)));
+
+  std::vector<scoped_refptr<TaskRunner>> task_runners;
+  for (size_t i = 0; i < kMaxTasks; ++i) {
+    task_runners.push_back(CreatePooledTaskRunnerWithExecutionMode(
+        GetParam(), &mock_pooled_task_runner_delegate_,
+        {TaskPriority::BEST_EFFORT}));
+  }
+  // Each task re-posts itself until the USER_BLOCKING task ran, which gives
+  // the batch of its sequence another task when the execution mode is
+  // SEQUENCED.
+  RepeatingCallback<void(TaskRunner*, bool)> repost_task;
+  repost_task = BindLambdaForTesting([&](TaskRunner* task_runner,
+                                         bool first_run) {
+    if (first_run)
+      all_task_sources_running_barrier.Run();
+    if (!user_blocking_task_ran.load())
+      task_runner->PostTask(FROM_HERE, BindOnce(repost_task, task_runner,
+                                                /* first_run=*/false));
+  });
+  for (auto& task_runner : task_runners) {
+    task_runner->PostTask(FROM_HERE, BindOnce(repost_task, task_runner.get(),
+                                              /* first_run=*/true));
+  }
+  all_task_sources_running.Wait();
+
+  TestWaitableEvent user_blocking_task_running;
+  test::CreatePooledTaskRunner({TaskPriority::USER_BLOCKING},
+                               &mock_pooled_task_runner_delegate_)
+      ->PostTask(FROM_HERE, BindLambdaForTesting([&]() {
+                   user_blocking_task_ran.store(true);
+                   user_blocking_task_running.Signal();
+                 }));
+  user_blocking_task_running.Wait();
+
+  task_tracker_.FlushForTesting();
+}
+
+INSTANTIATE_TEST_SUITE_P(Parallel,
+                         ThreadGroupImplBatchDrainingTest,
+                         ::testing::Values(TaskSourceExecutionMode::kParallel));
+INSTANTIATE_TEST_SUITE_P(
+    Sequenced,
+    ThreadGroupImplBatchDrainingTest,
+    ::testing::Values(TaskSourceExecutionMode::kSequenced));
+
+namespace {
+
+class ThreadGroupImplCoalesceWakeUpsTest
+    : public ThreadGroupImplImplTestBase,
+      public testing::TestWithParam<TaskSourceExecutionMode> {
+ public:
+  ThreadGroupImplCoalesceWakeUpsTest(
+      const ThreadGroupImplCoalesceWakeUpsTest&) = delete;
+  ThreadGroupImplCoalesceWakeUpsTest& operator=(
+      const ThreadGroupImplCoalesceWakeUpsTest&) = delete;
+
+ protected:
+  ThreadGroupImplCoalesceWakeUpsTest() {
+    feature_list_.InitAndEnableFeature(kCoalesceWakeUps);
+  }
+
+  void SetUp() override { CreateAndStartThreadGroup(); }
+
+  void TearDown() override { ThreadGroupImplImplTestBase::CommonTearDown(); }
+
+ private:
+  base::test::ScopedFeatureList feature_list_;
+};
+
+}  // namespace
+
+// Verify that all tasks of a burst of posts run when wake ups are coalesced.
+TEST_P(ThreadGroupImplCoalesceWakeUpsTest, PostBurst) {
+  std::vector<std::unique_ptr<test::TestTaskFactory>> factories;
+  for (size_t i = 0; i < kNumThreadsPostingTasks; ++i) {
+    factories.push_back(std::make_unique<test::TestTaskFactory>(
+        CreatePooledTaskRunnerWithExecutionMode(
+            GetParam(), &mock_pooled_task_runner_delegate_),
+        GetParam()));
+  }
+  for (size_t i = 0; i < kNumTasksPostedPerThread; ++i) {
+    for (auto& factory : factories)
+      EXPECT_TRUE(factory->PostTask(PostNestedTask::NO, OnceClosure()));
+  }
+  for (auto& factory : factories)
+    factory->WaitForAllTasksToRun();
+
+  // Wait until all workers are idle to be sure that no task accesses its
+  // TestTaskFactory after it is destroyed.
+  thread_group_->WaitForAllWorkersIdleForTesting();
+}
+
+// Verify that coalescing wake ups doesn't prevent |kMaxTasks| blocking tasks
+// posted at once from running concurrently, and that no wake up that was
+// needed is counted as avoided.
+TEST_P(ThreadGroupImplCoalesceWakeUpsTest, Saturate) {
+  TestWaitableEvent all_tasks_running;
+  RepeatingClosure all_tasks_running_barrier = BarrierClosure(
+      kMaxTasks,
+      BindOnce(&TestWaitableEvent::Signal, Unretained(&all_tasks_running)));
+  TestWaitableEvent unblock_tasks;
+
+  for (size_t i = 0; i < kMaxTasks; ++i) {
+    CreatePooledTaskRunnerWithExecutionMode(GetParam(),
+                                            &mock_pooled_task_runner_delegate_)
+        ->PostTask(FROM_HERE, BindLambdaForTesting([&]() {
+                     all_tasks_running_barrier.Run();
+                     unblock_tasks.Wait();
+                   }));
+  }
+  all_tasks_running.Wait();
+  EXPECT_EQ(0U, thread_group_->GetNumWakeUpsAvoided());
+
+  unblock_tasks.Signal();
+  thread_group_->WaitForAllWorkersIdleForTesting();
+}
+
+INSTANTIATE_TEST_SUITE_P(Parallel,
+                         ThreadGroupImplCoalesceWakeUpsTest,
+                         ::testing::Values(TaskSourceExecutionMode::kParallel));
+INSTANTIATE_TEST_SUITE_P(
+    Sequenced,
+    ThreadGroupImplCoalesceWakeUpsTest,
+    ::testing::Values(TaskSourceExecutionMode::kSequenced));
+
+namespace {
+
 class ThreadGroupImplImplStartInBodyTest : public ThreadGroupImplImplTest {
  public:
   void SetUp() override {
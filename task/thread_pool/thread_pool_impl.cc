@@ -17,10 +17,13 @@
 #include "base/feature_list.h"
 #include "base/message_loop/message_pump_type.h"
 #include "base/metrics/field_trial_params.h"
+#include "base/metrics/histogram_functions.h"
 #include "base/no_destructor.h"
 #include "base/strings/string_util.h"
+#include "base/strings/stringprintf.h"
 #include "base/task/scoped_set_task_priority_for_current_thread.h"
 #include "base/task/task_features.h"
+#include "base/task/thread_pool/cpu_topology.h"
 #include "base/task/thread_pool/pooled_parallel_task_runner.h"
 #include "base/task/thread_pool/pooled_sequenced_task_runner.h"
 #include "base/task/thread_pool/task.h"
@@ -30,6 +33,7 @@
 #include "base/task/thread_pool/worker_thread.h"
 #include "base/threading/platform_thread.h"
 #include "base/time/time.h"
+#include "base/trace_event/base_tracing.h"
 #include "third_party/abseil-cpp/absl/types/optional.h"
 
 #if defined(OS_WIN)
@@ -45,6 +49,21 @@ namespace internal {
 
 namespace {
 
+// Raising the priority of a BEST_EFFORT task source, by an update or a boost,
+// requires an explicit ThreadPolicy. Otherwise, whether its tasks keep running
+// on background threads is unspecified.
+void DCheckPriorityIncreaseFromBestEffortAllowed(const TaskTraits& traits,
+                                                 TaskPriority old_priority,
+                                                 TaskPriority new_priority) {
+  if (old_priority == TaskPriority::BEST_EFFORT &&
+      new_priority != TaskPriority::BEST_EFFORT) {
+    DCHECK(traits.thread_policy_set_explicitly())
+        << "A ThreadPolicy must be specified in the TaskTraits of an "
+           "UpdateableSequencedTaskRunner whose priority is increased from "
+           "BEST_EFFORT, or boosted. See ThreadPolicy documentation.";
+  }
+}
+
 constexpr EnvironmentParams kForegroundPoolEnvironmentParams{
     "Foreground", base::ThreadPriority::NORMAL};
 
@@ -68,6 +87,12 @@ bool HasDisableBestEffortTasksSwitch() {
 // internal edge case.
 bool g_synchronous_thread_start_for_testing = false;
 
+// Returns the share of |max_tasks| of a node which has |num_node_cpus| out of
+// |num_cpus| logical CPUs. Each node can run at least one task.
+int GetMaxTasksForNode(int max_tasks, size_t num_node_cpus, size_t num_cpus) {
+  return std::max(1, static_cast<int>(max_tasks * num_node_cpus / num_cpus));
+}
+
 // Verifies that |traits| do not have properties that are banned in ThreadPool.
 void AssertNoExtensionInTraits(const base::TaskTraits& traits) {
   DCHECK_EQ(traits.extension_id(),
@@ -117,6 +142,7 @@ ThreadPoolImpl::~ThreadPoolImpl() {
   // Reset thread groups to release held TrackedRefs, which block teardown.
   foreground_thread_group_.reset();
   background_thread_group_.reset();
+  other_node_thread_groups_.clear();
 }
 
 void ThreadPoolImpl::Start(const ThreadPoolInstance::InitParams& init_params,
@@ -131,6 +157,12 @@ void ThreadPoolImpl::Start(const ThreadPoolInstance::InitParams& init_params,
   disable_job_update_priority_ =
       FeatureList::IsEnabled(kDisableJobUpdatePriority);
 
+  // Must happen before workers start running tasks.
+  if (FeatureList::IsEnabled(kSampleTaskLatency)) {
+    task_tracker_->StartSamplingTaskLatency(
+        kTaskLatencySamplingInterval.Get());
+  }
+
   // The max number of concurrent BEST_EFFORT tasks is |kMaxBestEffortTasks|,
   // unless the max number of foreground threads is lower.
   const int max_best_effort_tasks =
@@ -164,6 +196,34 @@ void ThreadPoolImpl::Start(const ThreadPoolInstance::InitParams& init_params,
   }
 #endif
 
+  // Create one foreground thread group per node, if there are several nodes.
+  std::vector<CpuList> cpu_nodes;
+  if (FeatureList::IsEnabled(kUseNumaAwareThreadGroups))
+    cpu_nodes = GetCpuNodes();
+#if HAS_NATIVE_THREAD_POOL()
+  // The workers of a native thread group can't be pinned to a node.
+  if (FeatureList::IsEnabled(kUseNativeThreadPool))
+    cpu_nodes.clear();
+#endif
+  if (cpu_nodes.size() > 1 &&
+      cpu_nodes.size() <=
+          static_cast<size_t>(init_params.max_num_foreground_threads)) {
+    for (size_t node = 1; node < cpu_nodes.size(); ++node) {
+      // Only the thread group of node 0 records histograms.
+      other_node_thread_groups_.push_back(std::make_unique<ThreadGroupImpl>(
+          std::string(),
+          StringPrintf("%sNode%zu",
+                       kForegroundPoolEnvironmentParams.name_suffix, node),
+          kForegroundPoolEnvironmentParams.priority_hint,
+          task_tracker_->GetTrackedRef(),
+          tracked_ref_factory_.GetTrackedRef()));
+    }
+    num_nodes_.store(static_cast<int>(cpu_nodes.size()),
+                     std::memory_order_release);
+  } else {
+    cpu_nodes.clear();
+  }
+
   // Start the service thread. On platforms that support it (POSIX except NaCL
   // SFI), the service thread runs a MessageLoopForIO which is used to support
   // FileDescriptorWatcher in the scope in which tasks run.
@@ -227,11 +287,33 @@ void ThreadPoolImpl::Start(const ThreadPoolInstance::InitParams& init_params,
     // tasks that can run in foreground pools to ensure that there is always
     // room for incoming foreground tasks and to minimize the performance impact
     // of best-effort tasks.
-    static_cast<ThreadGroupImpl*>(foreground_thread_group_.get())
-        ->Start(init_params.max_num_foreground_threads, max_best_effort_tasks,
-                suggested_reclaim_time, service_thread_task_runner,
-                worker_thread_observer, worker_environment,
-                g_synchronous_thread_start_for_testing);
+    if (cpu_nodes.empty()) {
+      static_cast<ThreadGroupImpl*>(foreground_thread_group_.get())
+          ->Start(init_params.max_num_foreground_threads,
+                  max_best_effort_tasks, suggested_reclaim_time,
+                  service_thread_task_runner, worker_thread_observer,
+                  worker_environment, g_synchronous_thread_start_for_testing);
+    } else {
+      // The max number of foreground threads is split between nodes in
+      // proportion to their number of CPUs. BEST_EFFORT tasks only run on
+      // node 0 (see GetThreadGroupForTaskSource()).
+      size_t num_cpus = 0;
+      for (const CpuList& cpus : cpu_nodes)
+        num_cpus += cpus.size();
+      for (size_t node = 0; node < cpu_nodes.size(); ++node) {
+        const int max_tasks =
+            GetMaxTasksForNode(init_params.max_num_foreground_threads,
+                               cpu_nodes[node].size(), num_cpus);
+        ThreadGroupImpl* const thread_group = static_cast<ThreadGroupImpl*>(
+            GetForegroundThreadGroupForNode(static_cast<int>(node)));
+        thread_group->SetWorkerCpuAffinity(std::move(cpu_nodes[node]));
+        thread_group->Start(
+            max_tasks, std::min(max_best_effort_tasks, max_tasks),
+            suggested_reclaim_time, service_thread_task_runner,
+            worker_thread_observer, worker_environment,
+            g_synchronous_thread_start_for_testing);
+      }
+    }
   }
 
   if (background_thread_group_) {
@@ -270,7 +352,8 @@ bool ThreadPoolImpl::PostDelayedTask(const Location& from_here,
   return PostTaskWithSequence(
       Task(from_here, std::move(task), TimeTicks::Now(), delay),
       MakeRefCounted<Sequence>(traits, nullptr,
-                               TaskSourceExecutionMode::kParallel));
+                               TaskSourceExecutionMode::kParallel,
+                               GetTaskNodePool(traits)));
 }
 
 scoped_refptr<TaskRunner> ThreadPoolImpl::CreateTaskRunner(
@@ -321,6 +404,15 @@ void ThreadPoolImpl::ProcessRipeDelayedTasksForTesting() {
   delayed_task_manager_.ProcessRipeTasks();
 }
 
+std::vector<TaskLatencyRegistry::Entry> ThreadPoolImpl::GetTaskLatencySnapshot()
+    const {
+  return task_tracker_->GetTaskLatencySnapshot();
+}
+
+uint64_t ThreadPoolImpl::GetNumMissedDeadlines() const {
+  return task_tracker_->GetNumMissedDeadlines();
+}
+
 // static
 void ThreadPoolImpl::SetSynchronousThreadStartForTesting(bool enabled) {
   DCHECK(!ThreadPoolInstance::Get());
@@ -332,8 +424,16 @@ int ThreadPoolImpl::GetMaxConcurrentNonBlockedTasksWithTraitsDeprecated(
   // This method does not support getting the maximum number of BEST_EFFORT
   // tasks that can run concurrently in a pool.
   DCHECK_NE(traits.priority(), TaskPriority::BEST_EFFORT);
-  return GetThreadGroupForTraits(traits)
-      ->GetMaxConcurrentNonBlockedTasksDeprecated();
+  const ThreadGroup* const thread_group = GetThreadGroupForTraits(traits);
+  size_t max_concurrent_tasks =
+      thread_group->GetMaxConcurrentNonBlockedTasksDeprecated();
+  if (thread_group == foreground_thread_group_.get()) {
+    for (const auto& node_thread_group : other_node_thread_groups_) {
+      max_concurrent_tasks +=
+          node_thread_group->GetMaxConcurrentNonBlockedTasksDeprecated();
+    }
+  }
+  return max_concurrent_tasks;
 }
 
 void ThreadPoolImpl::Shutdown() {
@@ -376,6 +476,8 @@ void ThreadPoolImpl::JoinForTesting() {
   service_thread_.Stop();
   single_thread_task_runner_manager_.JoinForTesting();
   foreground_thread_group_->JoinForTesting();
+  for (const auto& thread_group : other_node_thread_groups_)
+    thread_group->JoinForTesting();
   if (background_thread_group_)
     background_thread_group_->JoinForTesting();
 #if DCHECK_IS_ON()
@@ -424,9 +526,42 @@ bool ThreadPoolImpl::PostTaskWithSequenceNow(Task task,
     return false;
   transaction.PushTask(std::move(task));
   if (task_source) {
+    AssignNodeIfNeeded(&transaction);
     const TaskTraits traits = transaction.traits();
-    GetThreadGroupForTraits(traits)->PushTaskSourceAndWakeUpWorkers(
-        {std::move(task_source), std::move(transaction)});
+    GetThreadGroupForTaskSource(*sequence, traits)
+        ->PushTaskSourceAndWakeUpWorkers(
+            {std::move(task_source), std::move(transaction)});
+  }
+  return true;
+}
+
+bool ThreadPoolImpl::PostTasksWithSequenceNow(
+    std::vector<Task> tasks,
+    scoped_refptr<Sequence> sequence) {
+  auto transaction = sequence->BeginTransaction();
+  const TaskPriority priority = transaction.traits().priority();
+  // Check all tasks before pushing any, so that either all of them or none are
+  // pushed.
+  for (const Task& task : tasks) {
+    if (!task_tracker_->WillPostTaskNow(task, priority))
+      return false;
+  }
+  const bool sequence_should_be_queued = transaction.WillPushTask();
+  RegisteredTaskSource task_source;
+  if (sequence_should_be_queued) {
+    task_source = task_tracker_->RegisterTaskSource(sequence);
+    // We shouldn't push |tasks| if we're not allowed to queue |task_source|.
+    if (!task_source)
+      return false;
+  }
+  for (Task& task : tasks)
+    transaction.PushTask(std::move(task));
+  if (task_source) {
+    AssignNodeIfNeeded(&transaction);
+    const TaskTraits traits = transaction.traits();
+    GetThreadGroupForTaskSource(*sequence, traits)
+        ->PushTaskSourceAndWakeUpWorkers(
+            {std::move(task_source), std::move(transaction)});
   }
   return true;
 }
@@ -471,18 +606,42 @@ bool ThreadPoolImpl::PostTaskWithSequence(Task task,
   return true;
 }
 
+bool ThreadPoolImpl::PostTasksWithSequence(std::vector<Task> tasks,
+                                           scoped_refptr<Sequence> sequence) {
+  DCHECK(sequence);
+  if (tasks.empty())
+    return true;
+
+  const TaskShutdownBehavior shutdown_behavior = sequence->shutdown_behavior();
+  for (Task& task : tasks) {
+    // Use CHECK instead of DCHECK to crash earlier. See
+    // http://crbug.com/711167 for details.
+    CHECK(task.task);
+    DCHECK(task.delayed_run_time.is_null());
+    if (!task_tracker_->WillPostTask(&task, shutdown_behavior))
+      return false;
+  }
+
+  return PostTasksWithSequenceNow(std::move(tasks), std::move(sequence));
+}
+
+scoped_refptr<TaskNodePool> ThreadPoolImpl::GetTaskNodePool(
+    const TaskTraits& traits) {
+  return GetThreadGroupForTraits(traits)->task_node_pool();
+}
+
 bool ThreadPoolImpl::ShouldYield(const TaskSource* task_source) {
   if (disable_job_yield_)
     return false;
   const TaskPriority priority = task_source->priority_racy();
-  auto* const thread_group =
-      GetThreadGroupForTraits({priority, task_source->thread_policy()});
+  auto* const thread_group = GetThreadGroupForTaskSource(
+      *task_source, {priority, task_source->thread_policy()});
   // A task whose priority changed and is now running in the wrong thread group
   // should yield so it's rescheduled in the right one.
   if (!thread_group->IsBoundToCurrentThread())
     return true;
-  return GetThreadGroupForTraits({priority, task_source->thread_policy()})
-      ->ShouldYield(task_source->GetSortKey(disable_fair_scheduling_));
+  return thread_group->ShouldYield(
+      task_source->GetSortKey(disable_fair_scheduling_));
 }
 
 bool ThreadPoolImpl::EnqueueJobTaskSource(
@@ -492,9 +651,11 @@ bool ThreadPoolImpl::EnqueueJobTaskSource(
   if (!registered_task_source)
     return false;
   auto transaction = registered_task_source->BeginTransaction();
+  AssignNodeIfNeeded(&transaction);
   const TaskTraits traits = transaction.traits();
-  GetThreadGroupForTraits(traits)->PushTaskSourceAndWakeUpWorkers(
-      {std::move(registered_task_source), std::move(transaction)});
+  GetThreadGroupForTaskSource(*registered_task_source.get(), traits)
+      ->PushTaskSourceAndWakeUpWorkers(
+          {std::move(registered_task_source), std::move(transaction)});
   return true;
 }
 
@@ -502,29 +663,72 @@ void ThreadPoolImpl::RemoveJobTaskSource(
     scoped_refptr<JobTaskSource> task_source) {
   auto transaction = task_source->BeginTransaction();
   ThreadGroup* const current_thread_group =
-      GetThreadGroupForTraits(transaction.traits());
+      GetThreadGroupForTaskSource(*task_source, transaction.traits());
   current_thread_group->RemoveTaskSource(*task_source);
 }
 
 void ThreadPoolImpl::UpdatePriority(scoped_refptr<TaskSource> task_source,
                                     TaskPriority priority) {
   auto transaction = task_source->BeginTransaction();
+  const TaskPriority old_priority = transaction.traits().priority();
+  DCheckPriorityIncreaseFromBestEffortAllowed(transaction.traits(),
+                                              old_priority, priority);
 
-  if (transaction.traits().priority() == priority)
+  // The priority may be unchanged when |task_source| has priority boosts.
+  transaction.UpdatePriority(priority);
+  if (transaction.traits().priority() == old_priority)
     return;
+  OnTaskSourcePriorityChanged(std::move(transaction), old_priority);
+}
 
-  if (transaction.traits().priority() == TaskPriority::BEST_EFFORT) {
-    DCHECK(transaction.traits().thread_policy_set_explicitly())
-        << "A ThreadPolicy must be specified in the TaskTraits of an "
-           "UpdateableSequencedTaskRunner whose priority is increased from "
-           "BEST_EFFORT. See ThreadPolicy documentation.";
-  }
+void ThreadPoolImpl::UpdateJobPriority(scoped_refptr<TaskSource> task_source,
+                                       TaskPriority priority) {
+  if (disable_job_update_priority_)
+    return;
+  UpdatePriority(std::move(task_source), priority);
+}
 
-  ThreadGroup* const current_thread_group =
-      GetThreadGroupForTraits(transaction.traits());
-  transaction.UpdatePriority(priority);
+void ThreadPoolImpl::AddPriorityBoost(scoped_refptr<TaskSource> task_source,
+                                      TaskPriority priority) {
+  auto transaction = task_source->BeginTransaction();
+  const TaskPriority old_priority = transaction.traits().priority();
+  transaction.AddPriorityBoost(priority);
+  DCheckPriorityIncreaseFromBestEffortAllowed(
+      transaction.traits(), old_priority, transaction.traits().priority());
+  const bool raised_priority = transaction.traits().priority() != old_priority;
+  UmaHistogramBoolean("ThreadPool.PriorityBoost.RaisedPriority",
+                      raised_priority);
+  if (!raised_priority)
+    return;
+  TRACE_EVENT_INSTANT2("thread_pool", "ThreadPool_PriorityBoost",
+                       TRACE_EVENT_SCOPE_THREAD, "from",
+                       TaskPriorityToString(old_priority), "to",
+                       TaskPriorityToString(priority));
+  OnTaskSourcePriorityChanged(std::move(transaction), old_priority);
+}
+
+void ThreadPoolImpl::RemovePriorityBoost(scoped_refptr<TaskSource> task_source,
+                                         TaskPriority priority) {
+  auto transaction = task_source->BeginTransaction();
+  const TaskPriority old_priority = transaction.traits().priority();
+  transaction.RemovePriorityBoost(priority);
+  if (transaction.traits().priority() == old_priority)
+    return;
+  TRACE_EVENT_INSTANT2("thread_pool", "ThreadPool_PriorityUnboost",
+                       TRACE_EVENT_SCOPE_THREAD, "from",
+                       TaskPriorityToString(old_priority), "to",
+                       TaskPriorityToString(transaction.traits().priority()));
+  OnTaskSourcePriorityChanged(std::move(transaction), old_priority);
+}
+
+void ThreadPoolImpl::OnTaskSourcePriorityChanged(
+    TaskSource::Transaction transaction,
+    TaskPriority old_priority) {
+  TaskSource* const task_source = transaction.task_source();
+  ThreadGroup* const current_thread_group = GetThreadGroupForTaskSource(
+      *task_source, {old_priority, transaction.traits().thread_policy()});
   ThreadGroup* const new_thread_group =
-      GetThreadGroupForTraits(transaction.traits());
+      GetThreadGroupForTaskSource(*task_source, transaction.traits());
 
   if (new_thread_group == current_thread_group) {
     // |task_source|'s position needs to be updated within its current thread
@@ -543,13 +747,6 @@ void ThreadPoolImpl::UpdatePriority(scoped_refptr<TaskSource> task_source,
   }
 }
 
-void ThreadPoolImpl::UpdateJobPriority(scoped_refptr<TaskSource> task_source,
-                                       TaskPriority priority) {
-  if (disable_job_update_priority_)
-    return;
-  UpdatePriority(std::move(task_source), priority);
-}
-
 const ThreadGroup* ThreadPoolImpl::GetThreadGroupForTraits(
     const TaskTraits& traits) const {
   return const_cast<ThreadPoolImpl*>(this)->GetThreadGroupForTraits(traits);
@@ -565,6 +762,49 @@ ThreadGroup* ThreadPoolImpl::GetThreadGroupForTraits(const TaskTraits& traits) {
   return foreground_thread_group_.get();
 }
 
+ThreadGroup* ThreadPoolImpl::GetThreadGroupForTaskSource(
+    const TaskSource& task_source,
+    const TaskTraits& traits) {
+  ThreadGroup* const thread_group = GetThreadGroupForTraits(traits);
+  // BEST_EFFORT task sources aren't spread across nodes, to preserve the cap on
+  // the number of BEST_EFFORT tasks running in foreground thread groups.
+  if (thread_group != foreground_thread_group_.get() ||
+      traits.priority() == TaskPriority::BEST_EFFORT) {
+    return thread_group;
+  }
+  return GetForegroundThreadGroupForNode(task_source.node());
+}
+
+ThreadGroup* ThreadPoolImpl::GetForegroundThreadGroupForNode(int node) {
+  // Task sources without a node run on node 0. Acquire ordering ensures that
+  // |other_node_thread_groups_| is visible when |node| is valid.
+  if (node <= 0 || node >= num_nodes_.load(std::memory_order_acquire))
+    return foreground_thread_group_.get();
+  return other_node_thread_groups_[node - 1].get();
+}
+
+void ThreadPoolImpl::AssignNodeIfNeeded(TaskSource::Transaction* transaction) {
+  if (transaction->task_source()->node() >= 0)
+    return;
+  // Task sources queued before Start() are assigned to node 0.
+  const int num_nodes = num_nodes_.load(std::memory_order_acquire);
+  if (num_nodes == 1) {
+    transaction->set_node(0);
+    return;
+  }
+  // A task source posted from a foreground worker runs on the same node, where
+  // the data it uses is more likely to be cached.
+  for (int node = 0; node < num_nodes; ++node) {
+    if (GetForegroundThreadGroupForNode(node)->IsBoundToCurrentThread()) {
+      transaction->set_node(node);
+      return;
+    }
+  }
+  transaction->set_node(
+      static_cast<int>(next_node_.fetch_add(1, std::memory_order_relaxed) %
+                       static_cast<unsigned int>(num_nodes)));
+}
+
 void ThreadPoolImpl::UpdateCanRunPolicy() {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
 
@@ -582,6 +822,8 @@ void ThreadPoolImpl::UpdateCanRunPolicy() {
 
   task_tracker_->SetCanRunPolicy(can_run_policy);
   foreground_thread_group_->DidUpdateCanRunPolicy();
+  for (const auto& thread_group : other_node_thread_groups_)
+    thread_group->DidUpdateCanRunPolicy();
   if (background_thread_group_)
     background_thread_group_->DidUpdateCanRunPolicy();
   single_thread_task_runner_manager_.DidUpdateCanRunPolicy();
@@ -5,7 +5,9 @@
 #ifndef BASE_TASK_THREAD_POOL_THREAD_POOL_IMPL_H_
 #define BASE_TASK_THREAD_POOL_THREAD_POOL_IMPL_H_
 
+#include <atomic>
 #include <memory>
+#include <vector>
 
 #include "base/base_export.h"
 #include "base/callback.h"
@@ -109,6 +111,10 @@ class BASE_EXPORT ThreadPoolImpl : public ThreadPoolInstance,
                       TaskPriority priority) override;
   void UpdateJobPriority(scoped_refptr<TaskSource> task_source,
                          TaskPriority priority) override;
+  void AddPriorityBoost(scoped_refptr<TaskSource> task_source,
+                        TaskPriority priority) override;
+  void RemovePriorityBoost(scoped_refptr<TaskSource> task_source,
+                           TaskPriority priority) override;
 
   // Returns the TimeTicks of the next task scheduled on ThreadPool (Now() if
   // immediate, nullopt if none). This is thread-safe, i.e., it's safe if tasks
@@ -120,6 +126,14 @@ class BASE_EXPORT ThreadPoolImpl : public ThreadPoolInstance,
   // advances faster than the real-time delay on ServiceThread).
   void ProcessRipeDelayedTasksForTesting();
 
+  // Returns the latency samples of tasks that ran so far, by post site and
+  // traits, if kSampleTaskLatency is enabled. Empty otherwise. Thread-safe.
+  std::vector<TaskLatencyRegistry::Entry> GetTaskLatencySnapshot() const;
+
+  // Returns the number of tasks with a TaskDeadline which started running after
+  // their deadline. Thread-safe.
+  uint64_t GetNumMissedDeadlines() const;
+
   // Requests that all threads started by future ThreadPoolImpls in this process
   // have a synchronous start (if |enabled|; cancels this behavior otherwise).
   // Must be called while no ThreadPoolImpls are alive in this process. This is
@@ -136,15 +150,41 @@ class BASE_EXPORT ThreadPoolImpl : public ThreadPoolInstance,
 
   // ThreadGroup::Delegate:
   ThreadGroup* GetThreadGroupForTraits(const TaskTraits& traits) override;
+  ThreadGroup* GetThreadGroupForTaskSource(const TaskSource& task_source,
+                                           const TaskTraits& traits) override;
+
+  // Returns the thread group running foreground tasks on |node|.
+  ThreadGroup* GetForegroundThreadGroupForNode(int node);
+
+  // Assigns a node to the TaskSource of |transaction| if it doesn't have one
+  // yet. Must be called before the TaskSource is queued, so that a TaskSource
+  // never changes node while queued.
+  void AssignNodeIfNeeded(TaskSource::Transaction* transaction);
+
+  // Places the TaskSource of |transaction| in the correct priority-queue
+  // position within the appropriate thread group after its priority changed
+  // from |old_priority|.
+  void OnTaskSourcePriorityChanged(TaskSource::Transaction transaction,
+                                   TaskPriority old_priority);
 
   // Posts |task| to be executed by the appropriate thread group as part of
   // |sequence|. This must only be called after |task| has gone through
   // TaskTracker::WillPostTask() and after |task|'s delayed run time.
   bool PostTaskWithSequenceNow(Task task, scoped_refptr<Sequence> sequence);
 
+  // Same as PostTaskWithSequenceNow(), for a batch of immediate |tasks| which
+  // are pushed to |sequence| in order within a single Transaction. Workers
+  // are woken up at most once.
+  bool PostTasksWithSequenceNow(std::vector<Task> tasks,
+                                scoped_refptr<Sequence> sequence);
+
   // PooledTaskRunnerDelegate:
   bool PostTaskWithSequence(Task task,
                             scoped_refptr<Sequence> sequence) override;
+  bool PostTasksWithSequence(std::vector<Task> tasks,
+                             scoped_refptr<Sequence> sequence) override;
+  scoped_refptr<TaskNodePool> GetTaskNodePool(
+      const TaskTraits& traits) override;
   bool ShouldYield(const TaskSource* task_source) override;
 
   const std::unique_ptr<TaskTrackerImpl> task_tracker_;
@@ -155,6 +195,16 @@ class BASE_EXPORT ThreadPoolImpl : public ThreadPoolInstance,
   std::unique_ptr<ThreadGroup> foreground_thread_group_;
   std::unique_ptr<ThreadGroup> background_thread_group_;
 
+  // Under kUseNumaAwareThreadGroups, the thread groups running foreground tasks
+  // on nodes 1 to |num_nodes_| - 1. |foreground_thread_group_| runs foreground
+  // tasks on node 0. Only modified in Start(), before |num_nodes_| is set.
+  std::vector<std::unique_ptr<ThreadGroup>> other_node_thread_groups_;
+  std::atomic<int> num_nodes_{1};
+
+  // Used to assign nodes in turn to task sources posted from outside of the
+  // foreground thread groups.
+  std::atomic<unsigned int> next_node_{0};
+
   bool disable_job_yield_ = false;
   bool disable_fair_scheduling_ = false;
   std::atomic<bool> disable_job_update_priority_{false};
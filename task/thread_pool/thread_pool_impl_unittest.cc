@@ -24,6 +24,7 @@
 #include "base/system/sys_info.h"
 #include "base/task/task_features.h"
 #include "base/task/task_traits.h"
+#include "base/task/thread_pool/cpu_topology.h"
 #include "base/task/thread_pool/environment_config.h"
 #include "base/task/thread_pool/test_task_factory.h"
 #include "base/task/thread_pool/test_utils.h"
@@ -828,6 +829,90 @@ TEST_P(ThreadPoolImplTest, SingleThreadRunsTasksInCurrentSequence) {
   task_ran.Wait();
 }
 
+// Verify that tasks posted to a SequencedTaskRunner with PostTasks() run in
+// order, after the tasks posted before them.
+TEST_P(ThreadPoolImplTest, SequencedPostTasksRunInOrder) {
+  StartThreadPool();
+  auto sequenced_task_runner = thread_pool_->CreateSequencedTaskRunner({});
+
+  std::vector<int> run_order;
+  auto append = [](std::vector<int>* run_order, int value) {
+    run_order->push_back(value);
+  };
+  sequenced_task_runner->PostTask(FROM_HERE,
+                                  BindOnce(append, Unretained(&run_order), 0));
+  std::vector<OnceClosure> tasks;
+  for (int i = 1; i <= 10; ++i)
+    tasks.push_back(BindOnce(append, Unretained(&run_order), i));
+  EXPECT_TRUE(sequenced_task_runner->PostTasks(FROM_HERE, tasks));
+
+  TestWaitableEvent task_ran;
+  sequenced_task_runner->PostTask(
+      FROM_HERE,
+      BindOnce(&TestWaitableEvent::Signal, Unretained(&task_ran)));
+  task_ran.Wait();
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10}), run_order);
+}
+
+namespace {
+
+void AppendThreadName(std::vector<std::string>* thread_names) {
+  thread_names->push_back(PlatformThread::GetName());
+}
+
+}  // namespace
+
+// Verify that with kUseNumaAwareThreadGroups, sequences are spread across one
+// foreground thread group per node, and that each sequence always runs on the
+// same node.
+TEST(ThreadPoolImplTest_NumaAware, SequencesStayOnTheirNode) {
+  base::test::ScopedFeatureList feature_list(kUseNumaAwareThreadGroups);
+  ScopedCpuNodesForTesting cpu_nodes({{0}, {1}}, {});
+  ThreadPoolImpl thread_pool("Test");
+  thread_pool.Start(ThreadPoolInstance::InitParams(4), nullptr);
+  EXPECT_EQ(4, thread_pool.GetMaxConcurrentNonBlockedTasksWithTraitsDeprecated(
+                   {TaskPriority::USER_VISIBLE}));
+
+  // Sequences created outside of the thread pool are assigned nodes in turn.
+  auto first_task_runner = thread_pool.CreateSequencedTaskRunner({});
+  auto second_task_runner = thread_pool.CreateSequencedTaskRunner({});
+  std::vector<std::string> first_thread_names;
+  std::vector<std::string> second_thread_names;
+  for (int i = 0; i < 10; ++i) {
+    first_task_runner->PostTask(
+        FROM_HERE,
+        BindOnce(&AppendThreadName, Unretained(&first_thread_names)));
+    second_task_runner->PostTask(
+        FROM_HERE,
+        BindOnce(&AppendThreadName, Unretained(&second_thread_names)));
+  }
+
+  // A sequence created from a worker is assigned the node of that worker.
+  std::vector<std::string> nested_thread_names;
+  TestWaitableEvent nested_task_ran;
+  second_task_runner->PostTask(
+      FROM_HERE, BindLambdaForTesting([&]() {
+        thread_pool.CreateSequencedTaskRunner({})->PostTask(
+            FROM_HERE, BindLambdaForTesting([&]() {
+              AppendThreadName(&nested_thread_names);
+              nested_task_ran.Signal();
+            }));
+      }));
+  nested_task_ran.Wait();
+  thread_pool.FlushForTesting();
+
+  ASSERT_EQ(10u, first_thread_names.size());
+  ASSERT_EQ(10u, second_thread_names.size());
+  for (const std::string& thread_name : first_thread_names)
+    EXPECT_EQ("ThreadPoolForegroundWorker", thread_name);
+  for (const std::string& thread_name : second_thread_names)
+    EXPECT_EQ("ThreadPoolForegroundNode1Worker", thread_name);
+  EXPECT_EQ(std::vector<std::string>({"ThreadPoolForegroundNode1Worker"}),
+            nested_thread_names);
+
+  thread_pool.JoinForTesting();
+}
+
 #if defined(OS_WIN)
 TEST_P(ThreadPoolImplTest, COMSTATaskRunnersRunWithCOMSTA) {
   StartThreadPool();
@@ -3,17 +3,24 @@
 // found in the LICENSE file.
 
 #include <stddef.h>
+#include <algorithm>
 #include <atomic>
 #include <memory>
+#include <tuple>
 #include <vector>
 
 #include "base/barrier_closure.h"
 #include "base/bind.h"
 #include "base/callback.h"
 #include "base/callback_helpers.h"
+#include "base/strings/stringprintf.h"
 #include "base/synchronization/waitable_event.h"
+#include "base/system/sys_info.h"
+#include "base/task/task_features.h"
 #include "base/task/thread_pool.h"
 #include "base/task/thread_pool/thread_pool_instance.h"
+#include "base/test/scoped_feature_list.h"
+#include "base/threading/platform_thread.h"
 #include "base/threading/simple_thread.h"
 #include "base/time/time.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -40,6 +47,50 @@ constexpr char kStoryPostRunNoOpManyThreads[] =
     "post_run_noop_tasks_many_threads";
 constexpr char kStoryPostRunBusyManyThreads[] =
     "post_run_busy_tasks_many_threads";
+constexpr char kStoryPostRunNoOpScalingFormat[] =
+    "post_run_noop_tasks_%zu_posting_threads%s";
+constexpr char kStoryPostRunNoOpSequenced[] = "post_run_noop_sequenced_tasks";
+constexpr char kStoryBatchPostRunNoOpSequenced[] =
+    "batch_post_run_noop_sequenced_tasks";
+constexpr char kStoryPostThenRunNoOpSequencedFormat[] =
+    "post_then_run_noop_sequenced_tasks%s";
+constexpr char kStoryBurstPostRunNoOpFormat[] = "burst_post_run_noop_tasks%s";
+
+constexpr char kMetricWakeUpLatencyMean[] = "wake_up_latency_mean";
+constexpr char kMetricWakeUpLatencyP50[] = "wake_up_latency_p50";
+constexpr char kMetricWakeUpLatencyP90[] = "wake_up_latency_p90";
+constexpr char kMetricWakeUpLatencyP99[] = "wake_up_latency_p99";
+constexpr char kStoryWakeUpLatency[] = "wake_up_latency";
+constexpr char kStoryWakeUpLatencySpinning[] = "wake_up_latency_spinning";
+
+constexpr char kMetricDeadlineLatenessP50[] = "deadline_lateness_p50";
+constexpr char kMetricDeadlineLatenessP99[] = "deadline_lateness_p99";
+constexpr char kMetricNumMissedDeadlines[] = "num_missed_deadlines";
+constexpr char kStoryOverloadFifo[] = "overload_fifo";
+constexpr char kStoryOverloadDeadlines[] = "overload_deadlines";
+
+// Number of tasks posted one at a time to an idle worker in wake up latency
+// stories, and delay between the end of a task and the next post.
+constexpr size_t kNumWakeUpLatencySamples = 2000;
+constexpr TimeDelta kWakeUpLatencyPostInterval =
+    TimeDelta::FromMicroseconds(20);
+
+// In overload stories, a single worker is handed a backlog of busy tasks. One
+// in |kTightDeadlineInterval| of them has a tight deadline, others have a loose
+// one.
+constexpr size_t kNumOverloadTasks = 2000;
+constexpr size_t kTightDeadlineInterval = 10;
+constexpr TimeDelta kOverloadTaskDuration = TimeDelta::FromMicroseconds(20);
+constexpr TimeDelta kTightDeadline = TimeDelta::FromMilliseconds(5);
+constexpr TimeDelta kLooseDeadline = TimeDelta::FromMilliseconds(100);
+
+// Number of tasks per PostTasks() call in batch posting stories.
+constexpr size_t kBatchSize = 100;
+
+// In burst posting stories, tasks are posted |kBurstSize| at a time, with a
+// pause long enough for workers to go back to sleep between bursts.
+constexpr size_t kBurstSize = 64;
+constexpr TimeDelta kBurstInterval = TimeDelta::FromMilliseconds(1);
 
 perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
   perf_test::PerfResultReporter reporter(kMetricPrefixThreadPool, story_name);
@@ -121,6 +172,55 @@ class ThreadPoolPerfTest : public testing::Test {
     }
   }
 
+  // Posts |num_tasks| to a SequencedTaskRunner, one PostTask() at a time.
+  void ContinuouslyPostNoOpTasksToSequence(size_t num_tasks) {
+    scoped_refptr<SequencedTaskRunner> task_runner =
+        ThreadPool::CreateSequencedTaskRunner({});
+    base::RepeatingClosure closure = base::BindRepeating(
+        [](std::atomic_size_t* num_task_pending) { (*num_task_pending)--; },
+        &num_tasks_pending_);
+    for (size_t i = 0; i < num_tasks; ++i) {
+      ++num_tasks_pending_;
+      ++num_posted_tasks_;
+      task_runner->PostTask(FROM_HERE, closure);
+    }
+  }
+
+  // Same as above, with one PostTasks() call per |kBatchSize| tasks.
+  void ContinuouslyBatchPostNoOpTasksToSequence(size_t num_tasks) {
+    scoped_refptr<SequencedTaskRunner> task_runner =
+        ThreadPool::CreateSequencedTaskRunner({});
+    base::RepeatingClosure closure = base::BindRepeating(
+        [](std::atomic_size_t* num_task_pending) { (*num_task_pending)--; },
+        &num_tasks_pending_);
+    std::vector<OnceClosure> batch;
+    batch.reserve(kBatchSize);
+    for (size_t i = 0; i < num_tasks; i += kBatchSize) {
+      batch.clear();
+      for (size_t j = i; j < std::min(num_tasks, i + kBatchSize); ++j)
+        batch.push_back(closure);
+      num_tasks_pending_ += batch.size();
+      num_posted_tasks_ += batch.size();
+      task_runner->PostTasks(FROM_HERE, batch);
+    }
+  }
+
+  // Posts |num_bursts| bursts of |kBurstSize| tasks to a parallel TaskRunner.
+  void PostNoOpTaskBursts(size_t num_bursts) {
+    scoped_refptr<TaskRunner> task_runner = ThreadPool::CreateTaskRunner({});
+    base::RepeatingClosure closure = base::BindRepeating(
+        [](std::atomic_size_t* num_task_pending) { (*num_task_pending)--; },
+        &num_tasks_pending_);
+    for (size_t i = 0; i < num_bursts; ++i) {
+      for (size_t j = 0; j < kBurstSize; ++j) {
+        ++num_tasks_pending_;
+        ++num_posted_tasks_;
+        task_runner->PostTask(FROM_HERE, closure);
+      }
+      PlatformThread::Sleep(kBurstInterval);
+    }
+  }
+
   void ContinuouslyPostBusyWaitTasks(size_t num_tasks,
                                      base::TimeDelta duration) {
     scoped_refptr<TaskRunner> task_runner = ThreadPool::CreateTaskRunner({});
@@ -211,8 +311,283 @@ class ThreadPoolPerfTest : public testing::Test {
   std::vector<std::unique_ptr<PostingThread>> threads_;
 };
 
+// Measures how post-and-run throughput scales with the number of posting
+// threads, with and without worker local queues. The first parameter is the
+// number of posting threads, the second whether kUseWorkerLocalQueues is
+// enabled.
+class ThreadPoolScalingPerfTest
+    : public ThreadPoolPerfTest,
+      public testing::WithParamInterface<std::tuple<size_t, bool>> {
+ public:
+  ThreadPoolScalingPerfTest() {
+    if (use_worker_local_queues())
+      feature_list_.InitAndEnableFeature(kUseWorkerLocalQueues);
+    else
+      feature_list_.InitAndDisableFeature(kUseWorkerLocalQueues);
+  }
+  ThreadPoolScalingPerfTest(const ThreadPoolScalingPerfTest&) = delete;
+  ThreadPoolScalingPerfTest& operator=(const ThreadPoolScalingPerfTest&) =
+      delete;
+
+  size_t num_posting_threads() const { return std::get<0>(GetParam()); }
+  bool use_worker_local_queues() const { return std::get<1>(GetParam()); }
+
+ private:
+  base::test::ScopedFeatureList feature_list_;
+};
+
+// Measures how fast workers drain sequences holding many tiny tasks, with and
+// without kBatchTaskSourceDraining.
+class ThreadPoolBatchDrainingPerfTest
+    : public ThreadPoolPerfTest,
+      public testing::WithParamInterface<bool> {
+ public:
+  ThreadPoolBatchDrainingPerfTest() {
+    if (batch_task_source_draining())
+      feature_list_.InitAndEnableFeature(kBatchTaskSourceDraining);
+    else
+      feature_list_.InitAndDisableFeature(kBatchTaskSourceDraining);
+  }
+  ThreadPoolBatchDrainingPerfTest(const ThreadPoolBatchDrainingPerfTest&) =
+      delete;
+  ThreadPoolBatchDrainingPerfTest& operator=(
+      const ThreadPoolBatchDrainingPerfTest&) = delete;
+
+  bool batch_task_source_draining() const { return GetParam(); }
+
+ private:
+  base::test::ScopedFeatureList feature_list_;
+};
+
+// Measures how fast bursts of tiny tasks posted to idle workers run, with and
+// without kCoalesceWakeUps.
+class ThreadPoolCoalesceWakeUpsPerfTest
+    : public ThreadPoolPerfTest,
+      public testing::WithParamInterface<bool> {
+ public:
+  ThreadPoolCoalesceWakeUpsPerfTest() {
+    if (coalesce_wake_ups())
+      feature_list_.InitAndEnableFeature(kCoalesceWakeUps);
+    else
+      feature_list_.InitAndDisableFeature(kCoalesceWakeUps);
+  }
+  ThreadPoolCoalesceWakeUpsPerfTest(const ThreadPoolCoalesceWakeUpsPerfTest&) =
+      delete;
+  ThreadPoolCoalesceWakeUpsPerfTest& operator=(
+      const ThreadPoolCoalesceWakeUpsPerfTest&) = delete;
+
+  bool coalesce_wake_ups() const { return GetParam(); }
+
+ private:
+  base::test::ScopedFeatureList feature_list_;
+};
+
+// Measures the latency between posting a task to an idle thread group and the
+// task starting to run. The parameter is whether kSpinIdleWorkers is enabled.
+class ThreadPoolWakeUpLatencyPerfTest : public testing::TestWithParam<bool> {
+ public:
+  ThreadPoolWakeUpLatencyPerfTest() {
+    if (spin_idle_workers())
+      feature_list_.InitAndEnableFeature(kSpinIdleWorkers);
+    else
+      feature_list_.InitAndDisableFeature(kSpinIdleWorkers);
+    ThreadPoolInstance::Create("PerfTest");
+    ThreadPoolInstance::Get()->Start({1});
+  }
+  ThreadPoolWakeUpLatencyPerfTest(const ThreadPoolWakeUpLatencyPerfTest&) =
+      delete;
+  ThreadPoolWakeUpLatencyPerfTest& operator=(
+      const ThreadPoolWakeUpLatencyPerfTest&) = delete;
+
+  ~ThreadPoolWakeUpLatencyPerfTest() override {
+    ThreadPoolInstance::Get()->JoinForTesting();
+    ThreadPoolInstance::Set(nullptr);
+  }
+
+  bool spin_idle_workers() const { return GetParam(); }
+
+ private:
+  base::test::ScopedFeatureList feature_list_;
+};
+
+// Measures how late tasks start relative to their deadlines when a single
+// worker is overloaded. The parameter is whether tasks are posted with a
+// TaskDeadline, which makes the worker run them in earliest deadline first
+// order rather than first-in first-out.
+class ThreadPoolDeadlinePerfTest : public testing::TestWithParam<bool> {
+ public:
+  ThreadPoolDeadlinePerfTest() {
+    ThreadPoolInstance::Create("PerfTest");
+    ThreadPoolInstance::Get()->Start({1});
+  }
+  ThreadPoolDeadlinePerfTest(const ThreadPoolDeadlinePerfTest&) = delete;
+  ThreadPoolDeadlinePerfTest& operator=(const ThreadPoolDeadlinePerfTest&) =
+      delete;
+
+  ~ThreadPoolDeadlinePerfTest() override {
+    ThreadPoolInstance::Get()->JoinForTesting();
+    ThreadPoolInstance::Set(nullptr);
+  }
+
+  bool use_deadlines() const { return GetParam(); }
+};
+
 }  // namespace
 
+TEST_P(ThreadPoolWakeUpLatencyPerfTest, PostToIdleWorker) {
+  scoped_refptr<TaskRunner> task_runner = ThreadPool::CreateTaskRunner({});
+  std::vector<TimeDelta> latencies(kNumWakeUpLatencySamples);
+  std::atomic_bool task_done{false};
+
+  for (TimeDelta& latency : latencies) {
+    task_done.store(false, std::memory_order_relaxed);
+    task_runner->PostTask(
+        FROM_HERE, BindOnce(
+                       [](TimeTicks post_time, TimeDelta* latency,
+                          std::atomic_bool* task_done) {
+                         *latency = TimeTicks::Now() - post_time;
+                         task_done->store(true, std::memory_order_release);
+                       },
+                       TimeTicks::Now(), Unretained(&latency),
+                       Unretained(&task_done)));
+    while (!task_done.load(std::memory_order_acquire)) {
+    }
+    // Give the worker time to become idle before the next post.
+    const TimeTicks next_post_time =
+        TimeTicks::Now() + kWakeUpLatencyPostInterval;
+    while (TimeTicks::Now() < next_post_time) {
+    }
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  TimeDelta total;
+  for (TimeDelta latency : latencies)
+    total += latency;
+  auto percentile = [&latencies](size_t percent) {
+    return latencies[latencies.size() * percent / 100].InMicrosecondsF();
+  };
+
+  perf_test::PerfResultReporter reporter(
+      kMetricPrefixThreadPool, spin_idle_workers()
+                                   ? kStoryWakeUpLatencySpinning
+                                   : kStoryWakeUpLatency);
+  reporter.RegisterImportantMetric(kMetricWakeUpLatencyMean, "us");
+  reporter.RegisterImportantMetric(kMetricWakeUpLatencyP50, "us");
+  reporter.RegisterImportantMetric(kMetricWakeUpLatencyP90, "us");
+  reporter.RegisterImportantMetric(kMetricWakeUpLatencyP99, "us");
+  reporter.AddResult(kMetricWakeUpLatencyMean,
+                     total.InMicrosecondsF() / latencies.size());
+  reporter.AddResult(kMetricWakeUpLatencyP50, percentile(50));
+  reporter.AddResult(kMetricWakeUpLatencyP90, percentile(90));
+  reporter.AddResult(kMetricWakeUpLatencyP99, percentile(99));
+}
+
+INSTANTIATE_TEST_SUITE_P(All,
+                         ThreadPoolWakeUpLatencyPerfTest,
+                         testing::Bool());
+
+TEST_P(ThreadPoolDeadlinePerfTest, Overload) {
+  // Occupy the only worker until all tasks are posted, so that they queue up.
+  std::atomic_bool all_posted{false};
+  ThreadPool::PostTask(FROM_HERE, BindOnce(
+                                      [](std::atomic_bool* all_posted) {
+                                        while (!all_posted->load(
+                                            std::memory_order_acquire)) {
+                                        }
+                                      },
+                                      Unretained(&all_posted)));
+
+  std::vector<TimeDelta> lateness(kNumOverloadTasks);
+  WaitableEvent complete;
+  RepeatingClosure on_task_done =
+      BarrierClosure(kNumOverloadTasks,
+                     BindOnce(&WaitableEvent::Signal, Unretained(&complete)));
+  for (size_t i = 0; i < kNumOverloadTasks; ++i) {
+    const TimeDelta deadline = i % kTightDeadlineInterval == 0
+                                   ? kTightDeadline
+                                   : kLooseDeadline;
+    const TaskTraits traits =
+        use_deadlines() ? TaskTraits(TaskDeadline(deadline)) : TaskTraits();
+    ThreadPool::PostTask(
+        FROM_HERE, traits,
+        BindOnce(
+            [](TimeTicks deadline_time, TimeDelta* lateness,
+               RepeatingClosure on_task_done) {
+              const TimeTicks start_time = TimeTicks::Now();
+              *lateness = std::max(start_time - deadline_time, TimeDelta());
+              while (TimeTicks::Now() - start_time < kOverloadTaskDuration) {
+              }
+              on_task_done.Run();
+            },
+            TimeTicks::Now() + deadline, Unretained(&lateness[i]),
+            on_task_done));
+  }
+  all_posted.store(true, std::memory_order_release);
+  complete.Wait();
+
+  const size_t num_missed_deadlines = static_cast<size_t>(
+      std::count_if(lateness.begin(), lateness.end(),
+                    [](TimeDelta value) { return value > TimeDelta(); }));
+  std::sort(lateness.begin(), lateness.end());
+  auto percentile = [&lateness](size_t percent) {
+    return lateness[lateness.size() * percent / 100].InMicrosecondsF();
+  };
+
+  perf_test::PerfResultReporter reporter(
+      kMetricPrefixThreadPool,
+      use_deadlines() ? kStoryOverloadDeadlines : kStoryOverloadFifo);
+  reporter.RegisterImportantMetric(kMetricDeadlineLatenessP50, "us");
+  reporter.RegisterImportantMetric(kMetricDeadlineLatenessP99, "us");
+  reporter.RegisterImportantMetric(kMetricNumMissedDeadlines, "count");
+  reporter.AddResult(kMetricDeadlineLatenessP50, percentile(50));
+  reporter.AddResult(kMetricDeadlineLatenessP99, percentile(99));
+  reporter.AddResult(kMetricNumMissedDeadlines, num_missed_deadlines);
+}
+
+INSTANTIATE_TEST_SUITE_P(All, ThreadPoolDeadlinePerfTest, testing::Bool());
+
+TEST_P(ThreadPoolScalingPerfTest, PostRunNoOpTasks) {
+  StartThreadPool(
+      SysInfo::NumberOfProcessors(), num_posting_threads(),
+      BindRepeating(&ThreadPoolPerfTest::ContinuouslyPostNoOpTasks,
+                    Unretained(this), 100000 / num_posting_threads()));
+  Benchmark(StringPrintf(kStoryPostRunNoOpScalingFormat, num_posting_threads(),
+                         use_worker_local_queues() ? "_local_queues" : ""),
+            ExecutionMode::kPostAndRun);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    All,
+    ThreadPoolScalingPerfTest,
+    testing::Combine(testing::Values<size_t>(1, 2, 4, 8, 16), testing::Bool()));
+
+TEST_P(ThreadPoolBatchDrainingPerfTest, PostThenRunNoOpSequencedTasks) {
+  StartThreadPool(
+      4, 4,
+      BindRepeating(&ThreadPoolPerfTest::ContinuouslyPostNoOpTasksToSequence,
+                    Unretained(this), 10000));
+  Benchmark(StringPrintf(kStoryPostThenRunNoOpSequencedFormat,
+                         batch_task_source_draining() ? "_batched" : ""),
+            ExecutionMode::kPostThenRun);
+}
+
+INSTANTIATE_TEST_SUITE_P(All,
+                         ThreadPoolBatchDrainingPerfTest,
+                         testing::Bool());
+
+TEST_P(ThreadPoolCoalesceWakeUpsPerfTest, BurstPostRunNoOpTasks) {
+  StartThreadPool(SysInfo::NumberOfProcessors(), 1,
+                  BindRepeating(&ThreadPoolPerfTest::PostNoOpTaskBursts,
+                                Unretained(this), 1000));
+  Benchmark(StringPrintf(kStoryBurstPostRunNoOpFormat,
+                         coalesce_wake_ups() ? "_coalesced" : ""),
+            ExecutionMode::kPostAndRun);
+}
+
+INSTANTIATE_TEST_SUITE_P(All,
+                         ThreadPoolCoalesceWakeUpsPerfTest,
+                         testing::Bool());
+
 TEST_F(ThreadPoolPerfTest, BindPostThenRunNoOpTasks) {
   StartThreadPool(
       1, 1,
@@ -257,6 +632,25 @@ TEST_F(ThreadPoolPerfTest, PostRunNoOpTasksManyThreads) {
   Benchmark(kStoryPostRunNoOpManyThreads, ExecutionMode::kPostAndRun);
 }
 
+// Compares posting tasks to a sequence one at a time and in batches, with 4
+// posting threads contending for the thread group.
+TEST_F(ThreadPoolPerfTest, PostRunNoOpSequencedTasks) {
+  StartThreadPool(
+      4, 4,
+      BindRepeating(&ThreadPoolPerfTest::ContinuouslyPostNoOpTasksToSequence,
+                    Unretained(this), 10000));
+  Benchmark(kStoryPostRunNoOpSequenced, ExecutionMode::kPostAndRun);
+}
+
+TEST_F(ThreadPoolPerfTest, BatchPostRunNoOpSequencedTasks) {
+  StartThreadPool(
+      4, 4,
+      BindRepeating(
+          &ThreadPoolPerfTest::ContinuouslyBatchPostNoOpTasksToSequence,
+          Unretained(this), 10000));
+  Benchmark(kStoryBatchPostRunNoOpSequenced, ExecutionMode::kPostAndRun);
+}
+
 TEST_F(ThreadPoolPerfTest, PostRunBusyTasksManyThreads) {
   StartThreadPool(
       4, 4,
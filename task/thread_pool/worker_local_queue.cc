@@ -0,0 +1,91 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/thread_pool/worker_local_queue.h"
+
+#include <utility>
+
+#include "base/check_op.h"
+
+namespace base {
+namespace internal {
+
+// static
+constexpr size_t WorkerLocalQueue::kCapacity;
+
+WorkerLocalQueue::WorkerLocalQueue(std::atomic_size_t* num_queued_task_sources)
+    : num_queued_task_sources_(num_queued_task_sources) {}
+
+WorkerLocalQueue::~WorkerLocalQueue() = default;
+
+void WorkerLocalQueue::Push(RegisteredTaskSource task_source) {
+  DCHECK(task_source);
+  DCHECK(!task_source->heap_handle().IsValid());
+  DCHECK(task_source->execution_mode() == TaskSourceExecutionMode::kParallel ||
+         task_source->execution_mode() == TaskSourceExecutionMode::kSequenced);
+
+  CheckedAutoLock auto_lock(lock_);
+  DCHECK_LT(queue_.size(), kCapacity);
+  queue_.push_back(std::move(task_source));
+  UpdateSizeLockRequired();
+}
+
+RegisteredTaskSource WorkerLocalQueue::Pop() {
+  if (IsEmpty())
+    return nullptr;
+
+  CheckedAutoLock auto_lock(lock_);
+  // A sibling may have stolen the last TaskSource since IsEmpty() was called.
+  if (queue_.empty())
+    return nullptr;
+  RegisteredTaskSource task_source = std::move(queue_.front());
+  queue_.pop_front();
+  UpdateSizeLockRequired();
+  return task_source;
+}
+
+RegisteredTaskSource WorkerLocalQueue::Steal() {
+  if (IsEmpty())
+    return nullptr;
+
+  CheckedAutoLock auto_lock(lock_);
+  if (queue_.empty() ||
+      queue_.back()->priority_racy() == TaskPriority::BEST_EFFORT) {
+    return nullptr;
+  }
+  RegisteredTaskSource task_source = std::move(queue_.back());
+  queue_.pop_back();
+  UpdateSizeLockRequired();
+  return task_source;
+}
+
+void WorkerLocalQueue::TakeAll(
+    std::vector<RegisteredTaskSource>* task_sources) {
+  DCHECK(task_sources);
+  if (IsEmpty())
+    return;
+
+  CheckedAutoLock auto_lock(lock_);
+  for (auto& task_source : queue_)
+    task_sources->push_back(std::move(task_source));
+  queue_.clear();
+  UpdateSizeLockRequired();
+}
+
+void WorkerLocalQueue::UpdateSizeLockRequired() {
+  const size_t new_size = queue_.size();
+  const size_t old_size = size_.exchange(new_size, std::memory_order_relaxed);
+  if (!num_queued_task_sources_ || new_size == old_size)
+    return;
+  if (new_size > old_size) {
+    num_queued_task_sources_->fetch_add(new_size - old_size,
+                                        std::memory_order_relaxed);
+  } else {
+    num_queued_task_sources_->fetch_sub(old_size - new_size,
+                                        std::memory_order_relaxed);
+  }
+}
+
+}  // namespace internal
+}  // namespace base
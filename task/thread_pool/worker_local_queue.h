@@ -0,0 +1,91 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TASK_THREAD_POOL_WORKER_LOCAL_QUEUE_H_
+#define BASE_TASK_THREAD_POOL_WORKER_LOCAL_QUEUE_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/containers/circular_deque.h"
+#include "base/task/common/checked_lock.h"
+#include "base/task/thread_pool/task_source.h"
+#include "base/thread_annotations.h"
+
+namespace base {
+namespace internal {
+
+// A bounded queue of TaskSources owned by a single worker of a
+// ThreadGroupImpl. The owning worker pushes to the back and pops from the front
+// without acquiring its thread group's lock. Sibling workers of the same thread
+// group may steal from the back, which is the only time |lock_| is contended.
+//
+// Only TaskSources that are saturated once a worker runs them (i.e. Sequences)
+// may be queued: a WorkerLocalQueue doesn't maintain heap handles, so a
+// TaskSource that can be registered more than once (i.e. a JobTaskSource)
+// could otherwise be queued twice.
+//
+// This class is thread-safe.
+class BASE_EXPORT WorkerLocalQueue {
+ public:
+  // Maximum number of TaskSources in a WorkerLocalQueue.
+  static constexpr size_t kCapacity = 8;
+
+  // |num_queued_task_sources|, if not null, is incremented and decremented as
+  // TaskSources are added to and removed from this queue. It may be shared by
+  // all the WorkerLocalQueues of a thread group and must outlive this.
+  explicit WorkerLocalQueue(
+      std::atomic_size_t* num_queued_task_sources = nullptr);
+  WorkerLocalQueue(const WorkerLocalQueue&) = delete;
+  WorkerLocalQueue& operator=(const WorkerLocalQueue&) = delete;
+  ~WorkerLocalQueue();
+
+  // Inserts |task_source| at the back of the queue. Must only be called by the
+  // owning worker and when IsFull() returns false.
+  void Push(RegisteredTaskSource task_source);
+
+  // Removes and returns the TaskSource at the front of the queue, or nullptr
+  // if the queue is empty. Must only be called by the owning worker.
+  RegisteredTaskSource Pop();
+
+  // Removes and returns the TaskSource at the back of the queue, or nullptr if
+  // the queue is empty. Never steals a TaskSource whose priority was lowered to
+  // BEST_EFFORT while it was queued; it is up to the owning worker to route it
+  // to the appropriate thread group.
+  RegisteredTaskSource Steal();
+
+  // Removes all TaskSources from the queue and appends them to |task_sources|
+  // in queue order.
+  void TakeAll(std::vector<RegisteredTaskSource>* task_sources);
+
+  // Returns the number of TaskSources in the queue. Thread-safe but the
+  // returned value may immediately be obsolete when called from a thread other
+  // than the owning worker.
+  size_t Size() const { return size_.load(std::memory_order_relaxed); }
+
+  bool IsEmpty() const { return Size() == 0; }
+  bool IsFull() const { return Size() == kCapacity; }
+
+ private:
+  void UpdateSizeLockRequired() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Acquired after the thread group's lock when stealing, so it must be a
+  // leaf in the lock chain.
+  mutable CheckedLock lock_{UniversalSuccessor()};
+
+  circular_deque<RegisteredTaskSource> queue_ GUARDED_BY(lock_);
+
+  // Mirrors |queue_.size()| so that it can be read without |lock_|.
+  std::atomic_size_t size_{0};
+
+  std::atomic_size_t* const num_queued_task_sources_;
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_TASK_THREAD_POOL_WORKER_LOCAL_QUEUE_H_
@@ -0,0 +1,100 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/thread_pool/worker_local_queue.h"
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include "base/callback_helpers.h"
+#include "base/memory/ref_counted.h"
+#include "base/task/task_traits.h"
+#include "base/task/thread_pool/sequence.h"
+#include "base/task/thread_pool/task.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+scoped_refptr<Sequence> MakeSequenceWithTask(
+    TaskPriority priority = TaskPriority::USER_VISIBLE) {
+  scoped_refptr<Sequence> sequence = MakeRefCounted<Sequence>(
+      TaskTraits(priority), nullptr, TaskSourceExecutionMode::kParallel);
+  sequence->BeginTransaction().PushTask(
+      Task(FROM_HERE, DoNothing(), TimeTicks::Now(), TimeDelta()));
+  return sequence;
+}
+
+class ThreadPoolWorkerLocalQueueTest : public testing::Test {
+ protected:
+  std::atomic_size_t num_queued_task_sources_{0};
+  WorkerLocalQueue queue_{&num_queued_task_sources_};
+};
+
+}  // namespace
+
+TEST_F(ThreadPoolWorkerLocalQueueTest, PopInPushOrder) {
+  scoped_refptr<Sequence> sequence_a = MakeSequenceWithTask();
+  scoped_refptr<Sequence> sequence_b = MakeSequenceWithTask();
+  EXPECT_TRUE(queue_.IsEmpty());
+
+  queue_.Push(RegisteredTaskSource::CreateForTesting(sequence_a));
+  queue_.Push(RegisteredTaskSource::CreateForTesting(sequence_b));
+  EXPECT_EQ(2U, queue_.Size());
+  EXPECT_EQ(2U, num_queued_task_sources_.load());
+
+  EXPECT_EQ(sequence_a, queue_.Pop().Unregister());
+  EXPECT_EQ(sequence_b, queue_.Pop().Unregister());
+  EXPECT_FALSE(queue_.Pop());
+  EXPECT_TRUE(queue_.IsEmpty());
+  EXPECT_EQ(0U, num_queued_task_sources_.load());
+}
+
+TEST_F(ThreadPoolWorkerLocalQueueTest, StealFromBack) {
+  scoped_refptr<Sequence> sequence_a = MakeSequenceWithTask();
+  scoped_refptr<Sequence> sequence_b = MakeSequenceWithTask();
+  queue_.Push(RegisteredTaskSource::CreateForTesting(sequence_a));
+  queue_.Push(RegisteredTaskSource::CreateForTesting(sequence_b));
+
+  EXPECT_EQ(sequence_b, queue_.Steal().Unregister());
+  EXPECT_EQ(1U, num_queued_task_sources_.load());
+  EXPECT_EQ(sequence_a, queue_.Pop().Unregister());
+  EXPECT_FALSE(queue_.Steal());
+}
+
+// A task source whose priority was lowered to BEST_EFFORT while queued is left
+// for the owning worker to route.
+TEST_F(ThreadPoolWorkerLocalQueueTest, DoesNotStealBestEffort) {
+  scoped_refptr<Sequence> sequence = MakeSequenceWithTask();
+  queue_.Push(RegisteredTaskSource::CreateForTesting(sequence));
+  sequence->BeginTransaction().UpdatePriority(TaskPriority::BEST_EFFORT);
+
+  EXPECT_FALSE(queue_.Steal());
+  EXPECT_EQ(sequence, queue_.Pop().Unregister());
+}
+
+TEST_F(ThreadPoolWorkerLocalQueueTest, TakeAll) {
+  std::vector<scoped_refptr<Sequence>> sequences;
+  for (size_t i = 0; i < WorkerLocalQueue::kCapacity; ++i) {
+    sequences.push_back(MakeSequenceWithTask());
+    queue_.Push(RegisteredTaskSource::CreateForTesting(sequences.back()));
+  }
+  EXPECT_TRUE(queue_.IsFull());
+  EXPECT_EQ(WorkerLocalQueue::kCapacity, num_queued_task_sources_.load());
+
+  std::vector<RegisteredTaskSource> task_sources;
+  queue_.TakeAll(&task_sources);
+  EXPECT_TRUE(queue_.IsEmpty());
+  EXPECT_EQ(0U, num_queued_task_sources_.load());
+  ASSERT_EQ(sequences.size(), task_sources.size());
+  for (size_t i = 0; i < sequences.size(); ++i)
+    EXPECT_EQ(sequences[i], task_sources[i].Unregister());
+}
+
+}  // namespace internal
+}  // namespace base
@@ -11,6 +11,7 @@
 
 #include "base/allocator/buildflags.h"
 #include "base/allocator/partition_allocator/partition_alloc_config.h"
+#include "base/allocator/partition_allocator/yield_processor.h"
 #include "base/callback_helpers.h"
 #include "base/check_op.h"
 #include "base/compiler_specific.h"
@@ -35,8 +36,19 @@
 namespace base {
 namespace internal {
 
+namespace {
+
+// Number of spin iterations between checks of the time while spinning.
+constexpr int kSpinIterationsPerTimeCheck = 64;
+
+}  // namespace
+
 constexpr TimeDelta WorkerThread::Delegate::kPurgeThreadCacheIdleDelay;
 
+TimeDelta WorkerThread::Delegate::GetSpinDuration() {
+  return TimeDelta();
+}
+
 void WorkerThread::Delegate::WaitForWork(WaitableEvent* wake_up_event) {
   DCHECK(wake_up_event);
   const TimeDelta sleep_time = GetSleepTimeout();
@@ -126,12 +138,18 @@ void WorkerThread::WakeUp() {
   // WorkerThread cannot run more tasks.
   DCHECK(!join_called_for_testing_.IsSet());
   DCHECK(!should_exit_.IsSet());
-  wake_up_event_.Signal();
+  // Sequentially consistent ordering pairs with SpinUntilWokenUp(): either the
+  // thread sees |wake_up_pending_| before it stops spinning, or this sees that
+  // it stopped spinning and signals |wake_up_event_|.
+  wake_up_pending_.store(true, std::memory_order_seq_cst);
+  if (!is_spinning_.load(std::memory_order_seq_cst))
+    wake_up_event_.Signal();
 }
 
 void WorkerThread::JoinForTesting() {
   DCHECK(!join_called_for_testing_.IsSet());
   join_called_for_testing_.Set();
+  wake_up_pending_.store(true, std::memory_order_seq_cst);
   wake_up_event_.Signal();
 
   PlatformThreadHandle thread_handle;
@@ -168,6 +186,7 @@ WorkerThread::~WorkerThread() {
 void WorkerThread::Cleanup() {
   DCHECK(!should_exit_.IsSet());
   should_exit_.Set();
+  wake_up_pending_.store(true, std::memory_order_seq_cst);
   wake_up_event_.Signal();
 }
 
@@ -314,6 +333,31 @@ NOINLINE void WorkerThread::RunBackgroundDedicatedCOMWorker() {
 }
 #endif  // defined(OS_WIN)
 
+void WorkerThread::WaitForWork() {
+  const TimeDelta spin_duration = delegate_->GetSpinDuration();
+  if (!spin_duration.is_zero() && SpinUntilWokenUp(spin_duration))
+    return;
+  delegate_->WaitForWork(&wake_up_event_);
+  // A WakeUp() which happened while waiting also signaled |wake_up_event_|.
+  wake_up_pending_.store(false, std::memory_order_relaxed);
+}
+
+bool WorkerThread::SpinUntilWokenUp(TimeDelta spin_duration) {
+  is_spinning_.store(true, std::memory_order_seq_cst);
+  // Mock time doesn't advance while spinning, so ignore it.
+  const TimeTicks end_time =
+      subtle::TimeTicksNowIgnoringOverride() + spin_duration;
+  for (int i = 1; !wake_up_pending_.load(std::memory_order_relaxed); ++i) {
+    if (i % kSpinIterationsPerTimeCheck == 0 &&
+        subtle::TimeTicksNowIgnoringOverride() >= end_time) {
+      break;
+    }
+    YIELD_PROCESSOR;
+  }
+  is_spinning_.store(false, std::memory_order_seq_cst);
+  return wake_up_pending_.exchange(false, std::memory_order_seq_cst);
+}
+
 void WorkerThread::RunWorker() {
   DCHECK_EQ(self_, this);
   TRACE_EVENT_INSTANT0("base", "WorkerThread born", TRACE_EVENT_SCOPE_THREAD);
@@ -365,7 +409,7 @@ void WorkerThread::RunWorker() {
       // TODO(crbug.com/1021571): Remove this once fixed.
       PERFETTO_INTERNAL_ADD_EMPTY_EVENT();
       hang_watch_scope.reset();
-      delegate_->WaitForWork(&wake_up_event_);
+      WaitForWork();
       TRACE_EVENT_BEGIN0("base", "WorkerThread active");
       continue;
     }
@@ -393,6 +437,7 @@ void WorkerThread::RunWorker() {
     // invariant and avoids a useless loop iteration before going to sleep if
     // WakeUp() is called while this WorkerThread is awake.
     wake_up_event_.Reset();
+    wake_up_pending_.store(false, std::memory_order_relaxed);
   }
 
   // Important: It is unsafe to access unowned state (e.g. |task_tracker_|)
@@ -5,6 +5,7 @@
 #ifndef BASE_TASK_THREAD_POOL_WORKER_THREAD_H_
 #define BASE_TASK_THREAD_POOL_WORKER_THREAD_H_
 
+#include <atomic>
 #include <memory>
 
 #include "base/base_export.h"
@@ -80,6 +81,12 @@ class BASE_EXPORT WorkerThread : public RefCountedThreadSafe<WorkerThread>,
     // WakeUp() method is called.
     virtual TimeDelta GetSleepTimeout() = 0;
 
+    // Called to determine how long to spin, waiting for WakeUp() to be called,
+    // before calling WaitForWork(). Spinning avoids the cost of signaling
+    // |wake_up_event| and of rescheduling the thread when work is posted soon
+    // after the worker ran out of work. No spinning by default.
+    virtual TimeDelta GetSpinDuration();
+
     // Called by the WorkerThread's thread to wait for work. Override this
     // method if the thread in question needs special handling to go to sleep.
     // |wake_up_event| is a manually resettable event and is signaled on
@@ -205,6 +212,14 @@ class BASE_EXPORT WorkerThread : public RefCountedThreadSafe<WorkerThread>,
   // and used to easily identify threads in stack traces.
   void NOT_TAIL_CALLED RunWorker();
 
+  // Spins for up to the delegate's GetSpinDuration(), then waits on
+  // |wake_up_event_| if WakeUp() wasn't called in the meantime.
+  void WaitForWork();
+
+  // Spins until WakeUp() is called or |spin_duration| elapses. Returns true if
+  // WakeUp() was called.
+  bool SpinUntilWokenUp(TimeDelta spin_duration);
+
   // Self-reference to prevent destruction of |this| while the thread is alive.
   // Set in Start() before creating the thread. Reset in ThreadMain() before the
   // thread exits. No lock required because the first access occurs before the
@@ -224,6 +239,13 @@ class BASE_EXPORT WorkerThread : public RefCountedThreadSafe<WorkerThread>,
   WaitableEvent wake_up_event_{WaitableEvent::ResetPolicy::AUTOMATIC,
                                WaitableEvent::InitialState::NOT_SIGNALED};
 
+  // Set by WakeUp(). Consumed by the thread while it spins, in which case
+  // WakeUp() doesn't need to signal |wake_up_event_|.
+  std::atomic<bool> wake_up_pending_{false};
+
+  // Whether the thread is spinning in SpinUntilWokenUp().
+  std::atomic<bool> is_spinning_{false};
+
   // Whether the thread should exit. Set by Cleanup().
   AtomicFlag should_exit_;
 
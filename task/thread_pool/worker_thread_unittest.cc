@@ -835,6 +835,60 @@ TEST(ThreadPoolWorkerTest, WorkerThreadObserver) {
   Mock::VerifyAndClear(&observer);
 }
 
+namespace {
+
+class SpinningDelegate : public WorkerThreadDefaultDelegate {
+ public:
+  explicit SpinningDelegate(TimeDelta spin_duration)
+      : spin_duration_(spin_duration) {}
+  SpinningDelegate(const SpinningDelegate&) = delete;
+  SpinningDelegate& operator=(const SpinningDelegate&) = delete;
+
+  void WaitForGetWork() { get_work_event_.Wait(); }
+
+  // WorkerThread::Delegate:
+  RegisteredTaskSource GetWork(WorkerThread* worker) override {
+    get_work_event_.Signal();
+    return nullptr;
+  }
+  TimeDelta GetSpinDuration() override { return spin_duration_; }
+
+ private:
+  const TimeDelta spin_duration_;
+  TestWaitableEvent get_work_event_{WaitableEvent::ResetPolicy::AUTOMATIC};
+};
+
+void VerifyWakeUpsWithSpinDuration(TimeDelta spin_duration) {
+  TaskTracker task_tracker;
+  auto delegate = std::make_unique<SpinningDelegate>(spin_duration);
+  SpinningDelegate* const delegate_raw = delegate.get();
+  auto worker =
+      MakeRefCounted<WorkerThread>(ThreadPriority::NORMAL, std::move(delegate),
+                                   task_tracker.GetTrackedRef());
+  worker->Start();
+
+  for (int i = 0; i < 10; ++i) {
+    worker->WakeUp();
+    delegate_raw->WaitForGetWork();
+  }
+
+  worker->JoinForTesting();
+}
+
+}  // namespace
+
+// Verify that a worker which spins while idle gets work when it is woken up
+// while spinning.
+TEST(ThreadPoolWorkerTest, WakeUpWhileSpinning) {
+  VerifyWakeUpsWithSpinDuration(TestTimeouts::action_max_timeout());
+}
+
+// Verify that a worker which spins while idle gets work when it is woken up
+// after it stopped spinning and went to sleep.
+TEST(ThreadPoolWorkerTest, WakeUpAfterSpinning) {
+  VerifyWakeUpsWithSpinDuration(TimeDelta::FromMicroseconds(1));
+}
+
 // ThreadCache tests disabled when USE_BACKUP_REF_PTR is enabled, because the
 // "original" PartitionRoot has ThreadCache disabled.
 #if BUILDFLAG(USE_PARTITION_ALLOC_AS_MALLOC) && \
@@ -45,6 +45,21 @@ bool TaskRunner::PostTask(const Location& from_here, OnceClosure task) {
   return PostDelayedTask(from_here, std::move(task), base::TimeDelta());
 }
 
+bool TaskRunner::PostDelayedTaskWithLeeway(const Location& from_here,
+                                           OnceClosure task,
+                                           base::TimeDelta delay,
+                                           base::TimeDelta leeway) {
+  return PostDelayedTask(from_here, std::move(task), delay);
+}
+
+bool TaskRunner::PostTasks(const Location& from_here,
+                           span<OnceClosure> tasks) {
+  bool all_posted = true;
+  for (OnceClosure& task : tasks)
+    all_posted &= PostTask(from_here, std::move(task));
+  return all_posted;
+}
+
 bool TaskRunner::PostTaskAndReply(const Location& from_here,
                                   OnceClosure task,
                                   OnceClosure reply) {
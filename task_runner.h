@@ -12,6 +12,7 @@
 #include "base/callback.h"
 #include "base/callback_helpers.h"
 #include "base/check.h"
+#include "base/containers/span.h"
 #include "base/location.h"
 #include "base/memory/ref_counted.h"
 #include "base/post_task_and_reply_with_result_internal.h"
@@ -74,6 +75,27 @@ class BASE_EXPORT TaskRunner
                                OnceClosure task,
                                base::TimeDelta delay) = 0;
 
+  // Like PostDelayedTask, but allows the posted task to run up to |leeway|
+  // after |delay| has passed, so that its wake up can be aligned with the wake
+  // ups of other delayed tasks. Timeouts which don't need to fire promptly are
+  // good candidates for a large |leeway|.
+  //
+  // The default implementation ignores |leeway| and calls PostDelayedTask().
+  virtual bool PostDelayedTaskWithLeeway(const Location& from_here,
+                                         OnceClosure task,
+                                         base::TimeDelta delay,
+                                         base::TimeDelta leeway);
+
+  // Posts each of |tasks| as if by PostTask(), in order. The callbacks in
+  // |tasks| are consumed. Returns true if all the tasks may be run at some
+  // point in the future, and false if any of them definitely will not be run.
+  //
+  // The default implementation calls PostTask() for each task. Implementations
+  // can override this to enqueue all the tasks at once, e.g. with a single
+  // lock acquisition and a single wake-up. A sequenced implementation must
+  // run the tasks in the order of |tasks|.
+  virtual bool PostTasks(const Location& from_here, span<OnceClosure> tasks);
+
   // Posts |task| on the current TaskRunner.  On completion, |reply| is posted
   // to the sequence that called PostTaskAndReply().  On the success case,
   // |task| is destroyed on the target sequence and |reply| is destroyed on the
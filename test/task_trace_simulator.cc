@@ -0,0 +1,509 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/test/task_trace_simulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <set>
+#include <tuple>
+#include <utility>
+
+#include "base/check_op.h"
+#include "base/containers/circular_deque.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/json/json_reader.h"
+#include "base/strings/stringprintf.h"
+#include "base/values.h"
+
+namespace base {
+namespace test {
+
+namespace {
+
+using SchedulingPolicy = TaskTraceSimulator::SchedulingPolicy;
+using TaskRecord = TaskTraceSimulator::TaskRecord;
+
+constexpr TaskPriority kAllPriorities[] = {TaskPriority::BEST_EFFORT,
+                                           TaskPriority::USER_VISIBLE,
+                                           TaskPriority::USER_BLOCKING};
+
+// Returns the non-negative integer at |key| in |dict|, |default_value| if
+// |key| is absent or nullopt if it isn't a non-negative integer.
+absl::optional<int64_t> FindNonNegativeInt(const Value& dict,
+                                           StringPiece key,
+                                           absl::optional<int64_t>
+                                               default_value) {
+  const Value* value = dict.FindKey(key);
+  if (!value)
+    return default_value;
+  if (!value->is_int() && !value->is_double())
+    return absl::nullopt;
+  const double number = value->GetDouble();
+  if (!(number >= 0) ||
+      number >= static_cast<double>(std::numeric_limits<int64_t>::max()) ||
+      std::floor(number) != number) {
+    return absl::nullopt;
+  }
+  return static_cast<int64_t>(number);
+}
+
+absl::optional<TaskPriority> ParsePriority(const std::string& name) {
+  for (TaskPriority priority : kAllPriorities) {
+    if (name == TaskPriorityToString(priority))
+      return priority;
+  }
+  return absl::nullopt;
+}
+
+absl::optional<TaskRecord> ParseTaskRecord(const Value& dict) {
+  if (!dict.is_dict())
+    return absl::nullopt;
+  const absl::optional<int64_t> id =
+      FindNonNegativeInt(dict, "id", absl::nullopt);
+  const absl::optional<int64_t> sequence =
+      FindNonNegativeInt(dict, "sequence", 0);
+  const absl::optional<int64_t> post_time_us =
+      FindNonNegativeInt(dict, "post_time_us", absl::nullopt);
+  const absl::optional<int64_t> delay_us =
+      FindNonNegativeInt(dict, "delay_us", 0);
+  const absl::optional<int64_t> duration_us =
+      FindNonNegativeInt(dict, "duration_us", absl::nullopt);
+  const absl::optional<int64_t> parent = FindNonNegativeInt(dict, "parent", 0);
+  if (!id || *id == 0 || !sequence || !post_time_us || !delay_us ||
+      !duration_us || !parent) {
+    return absl::nullopt;
+  }
+
+  TaskRecord record;
+  record.id = static_cast<uint64_t>(*id);
+  record.sequence = static_cast<uint64_t>(*sequence);
+  record.post_time = TimeDelta::FromMicroseconds(*post_time_us);
+  record.delay = TimeDelta::FromMicroseconds(*delay_us);
+  record.duration = TimeDelta::FromMicroseconds(*duration_us);
+  record.parent = static_cast<uint64_t>(*parent);
+
+  if (const Value* target = dict.FindKey("target")) {
+    if (!target->is_string() || target->GetString().empty())
+      return absl::nullopt;
+    record.target = target->GetString();
+  }
+  if (const Value* priority_name = dict.FindKey("priority")) {
+    if (!priority_name->is_string())
+      return absl::nullopt;
+    const absl::optional<TaskPriority> priority =
+        ParsePriority(priority_name->GetString());
+    if (!priority)
+      return absl::nullopt;
+    record.priority = *priority;
+  }
+  return record;
+}
+
+// Returns false if a task is its own ancestor in |parent_indices|, where a
+// negative index denotes a task without parent.
+bool HasNoCycle(const std::vector<ptrdiff_t>& parent_indices) {
+  enum class State { kUnvisited, kVisiting, kVisited };
+  std::vector<State> states(parent_indices.size(), State::kUnvisited);
+  std::vector<size_t> chain;
+  for (size_t i = 0; i < parent_indices.size(); ++i) {
+    ptrdiff_t index = static_cast<ptrdiff_t>(i);
+    while (index >= 0 && states[index] == State::kUnvisited) {
+      states[index] = State::kVisiting;
+      chain.push_back(index);
+      index = parent_indices[index];
+    }
+    if (index >= 0 && states[index] == State::kVisiting)
+      return false;
+    for (size_t visited : chain)
+      states[visited] = State::kVisited;
+    chain.clear();
+  }
+  return true;
+}
+
+TaskTraceSimulator::DelayStats ComputeDelayStats(
+    std::vector<TimeDelta> delays) {
+  TaskTraceSimulator::DelayStats stats;
+  if (delays.empty())
+    return stats;
+  std::sort(delays.begin(), delays.end());
+  TimeDelta sum;
+  for (TimeDelta delay : delays)
+    sum += delay;
+  const size_t num_tasks = delays.size();
+  // Nearest-rank percentile.
+  auto percentile = [&](size_t percent) {
+    const size_t rank = (percent * num_tasks + 99) / 100;
+    return delays[std::max<size_t>(rank, 1) - 1];
+  };
+  stats.num_tasks = num_tasks;
+  stats.mean = sum / static_cast<int64_t>(num_tasks);
+  stats.percentile_50 = percentile(50);
+  stats.percentile_90 = percentile(90);
+  stats.percentile_99 = percentile(99);
+  stats.max = delays.back();
+  return stats;
+}
+
+void AppendDelayStats(StringPiece name,
+                      const TaskTraceSimulator::DelayStats& stats,
+                      std::string* output) {
+  StringAppendF(output,
+                "%s: %zu tasks, queueing delay mean %.3f ms, p50 %.3f ms, "
+                "p90 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+                std::string(name).c_str(), stats.num_tasks,
+                stats.mean.InMillisecondsF(),
+                stats.percentile_50.InMillisecondsF(),
+                stats.percentile_90.InMillisecondsF(),
+                stats.percentile_99.InMillisecondsF(),
+                stats.max.InMillisecondsF());
+}
+
+// Replays a trace. Tasks are referred to by their index in the trace.
+class Simulation {
+ public:
+  Simulation(const TaskTraceSimulator::Options& options,
+             const std::vector<TaskRecord>& trace)
+      : trace_(trace),
+        foreground_group_{kThreadPoolTarget,
+                          options.num_foreground_workers,
+                          options.max_best_effort_tasks,
+                          options.thread_pool_policy},
+        background_group_{kThreadPoolTarget,
+                          options.num_background_workers,
+                          options.max_best_effort_tasks,
+                          options.thread_pool_policy},
+        thread_policy_(options.thread_policy),
+        children_(trace.size()),
+        sequence_of_task_(trace.size()),
+        results_(trace.size()) {
+    DCHECK_GT(options.num_foreground_workers, 0u);
+    DCHECK_GT(options.max_best_effort_tasks, 0u);
+
+    std::map<uint64_t, size_t> index_of_id;
+    for (size_t i = 0; i < trace_.size(); ++i)
+      index_of_id.emplace(trace_[i].id, i);
+    for (size_t i = 0; i < trace_.size(); ++i) {
+      const TaskRecord& record = trace_[i];
+      if (record.parent == 0) {
+        roots_.push_back(i);
+      } else {
+        DCHECK(index_of_id.count(record.parent));
+        children_[index_of_id[record.parent]].push_back(i);
+      }
+      Group* const group = GetGroup(record);
+      const size_t parallel_task =
+          (record.sequence == 0 && record.target == kThreadPoolTarget)
+              ? i
+              : std::numeric_limits<size_t>::max();
+      Sequence& sequence =
+          sequences_[std::make_tuple(group, record.sequence, parallel_task)];
+      sequence.group = group;
+      sequence_of_task_[i] = &sequence;
+    }
+  }
+
+  Simulation(const Simulation&) = delete;
+  Simulation& operator=(const Simulation&) = delete;
+
+  TaskTraceSimulator::Report Run() {
+    for (size_t task : roots_)
+      PostTask(task, trace_[task].post_time);
+
+    while (!events_.empty()) {
+      now_ = events_.top().time;
+      // Handle all events which happen at |now_| before scheduling, so that
+      // the scheduling policy sees all the tasks which are ready.
+      while (!events_.empty() && events_.top().time == now_) {
+        const Event event = events_.top();
+        events_.pop();
+        if (event.type == Event::Type::kReady)
+          OnTaskReady(event.task);
+        else
+          OnTaskDone(event.task);
+      }
+      RunTasks(&foreground_group_);
+      RunTasks(&background_group_);
+      for (auto& target_and_group : thread_groups_)
+        RunTasks(&target_and_group.second);
+    }
+
+    TaskTraceSimulator::Report report;
+    report.end_time = now_;
+    std::vector<TimeDelta> delays;
+    std::map<std::string, std::vector<TimeDelta>> delays_by_target;
+    std::map<TaskPriority, std::vector<TimeDelta>> delays_by_priority;
+    for (size_t i = 0; i < trace_.size(); ++i) {
+      const TimeDelta delay = results_[i].queueing_delay();
+      delays.push_back(delay);
+      delays_by_target[trace_[i].target].push_back(delay);
+      delays_by_priority[trace_[i].priority].push_back(delay);
+    }
+    report.delays = ComputeDelayStats(std::move(delays));
+    for (auto& target_and_delays : delays_by_target) {
+      report.delays_by_target[target_and_delays.first] =
+          ComputeDelayStats(std::move(target_and_delays.second));
+    }
+    for (auto& priority_and_delays : delays_by_priority) {
+      report.delays_by_priority[priority_and_delays.first] =
+          ComputeDelayStats(std::move(priority_and_delays.second));
+    }
+    report.busy_time_by_target = std::move(busy_time_by_target_);
+    report.task_results = std::move(results_);
+    return report;
+  }
+
+ private:
+  static constexpr const char* kThreadPoolTarget =
+      TaskTraceSimulator::kThreadPoolTarget;
+
+  struct Sequence;
+
+  // Position of a Sequence in the queue of its Group.
+  struct SortKey {
+    int rank;
+    TimeDelta ready_time;
+    uint64_t order;
+    Sequence* sequence;
+
+    bool operator<(const SortKey& other) const {
+      return std::tie(rank, ready_time, order) <
+             std::tie(other.rank, other.ready_time, other.order);
+    }
+  };
+
+  // Workers which run tasks: a ThreadGroup or a thread.
+  struct Group {
+    std::string target;
+    size_t max_tasks;
+    size_t max_best_effort_tasks;
+    SchedulingPolicy policy;
+    size_t num_running_tasks = 0;
+    size_t num_running_best_effort_tasks = 0;
+    // Sequences which have a ready task and no running task.
+    std::set<SortKey> queue;
+  };
+
+  struct Sequence {
+    Group* group = nullptr;
+    circular_deque<size_t> ready_tasks;
+    bool is_running = false;
+  };
+
+  struct Event {
+    enum class Type { kReady, kDone };
+
+    TimeDelta time;
+    uint64_t order;
+    Type type;
+    size_t task;
+
+    bool operator>(const Event& other) const {
+      return std::tie(time, order) > std::tie(other.time, other.order);
+    }
+  };
+
+  Group* GetGroup(const TaskRecord& record) {
+    if (record.target != kThreadPoolTarget) {
+      auto it = thread_groups_.find(record.target);
+      if (it == thread_groups_.end()) {
+        // A thread has a single worker, which may run tasks of any priority.
+        it = thread_groups_
+                 .emplace(record.target, Group{record.target, 1, 1,
+                                               thread_policy_})
+                 .first;
+      }
+      return &it->second;
+    }
+    if (record.priority == TaskPriority::BEST_EFFORT &&
+        background_group_.max_tasks > 0) {
+      return &background_group_;
+    }
+    return &foreground_group_;
+  }
+
+  void PushEvent(TimeDelta time, Event::Type type, size_t task) {
+    events_.push(Event{time, next_order_++, type, task});
+  }
+
+  void PostTask(size_t task, TimeDelta post_time) {
+    PushEvent(post_time + trace_[task].delay, Event::Type::kReady, task);
+  }
+
+  void OnTaskReady(size_t task) {
+    results_[task].ready_time = now_;
+    Sequence* const sequence = sequence_of_task_[task];
+    sequence->ready_tasks.push_back(task);
+    if (!sequence->is_running && sequence->ready_tasks.size() == 1)
+      EnqueueSequence(sequence);
+  }
+
+  void OnTaskDone(size_t task) {
+    Sequence* const sequence = sequence_of_task_[task];
+    Group* const group = sequence->group;
+    DCHECK(sequence->is_running);
+    sequence->is_running = false;
+    --group->num_running_tasks;
+    if (trace_[task].priority == TaskPriority::BEST_EFFORT)
+      --group->num_running_best_effort_tasks;
+    if (!sequence->ready_tasks.empty())
+      EnqueueSequence(sequence);
+  }
+
+  void EnqueueSequence(Sequence* sequence) {
+    const size_t next_task = sequence->ready_tasks.front();
+    const int rank = sequence->group->policy == SchedulingPolicy::kPriority
+                         ? -static_cast<int>(trace_[next_task].priority)
+                         : 0;
+    sequence->group->queue.insert(
+        SortKey{rank, results_[next_task].ready_time, next_order_++, sequence});
+  }
+
+  // Starts the next tasks of |group| while it has idle workers.
+  void RunTasks(Group* group) {
+    while (group->num_running_tasks < group->max_tasks) {
+      auto it = std::find_if(
+          group->queue.begin(), group->queue.end(), [&](const SortKey& key) {
+            const size_t task = key.sequence->ready_tasks.front();
+            return trace_[task].priority != TaskPriority::BEST_EFFORT ||
+                   group->num_running_best_effort_tasks <
+                       group->max_best_effort_tasks;
+          });
+      if (it == group->queue.end())
+        return;
+      Sequence* const sequence = it->sequence;
+      group->queue.erase(it);
+
+      const size_t task = sequence->ready_tasks.front();
+      sequence->ready_tasks.pop_front();
+      sequence->is_running = true;
+      ++group->num_running_tasks;
+      if (trace_[task].priority == TaskPriority::BEST_EFFORT)
+        ++group->num_running_best_effort_tasks;
+
+      const TimeDelta duration = trace_[task].duration;
+      results_[task].start_time = now_;
+      results_[task].end_time = now_ + duration;
+      busy_time_by_target_[group->target] += duration;
+      PushEvent(now_ + duration, Event::Type::kDone, task);
+      for (size_t child : children_[task])
+        PostTask(child, now_ + trace_[child].post_time);
+    }
+  }
+
+  const std::vector<TaskRecord>& trace_;
+
+  Group foreground_group_;
+  Group background_group_;
+  const SchedulingPolicy thread_policy_;
+  // Groups of the threads, by target.
+  std::map<std::string, Group> thread_groups_;
+
+  // Sequences by group, sequence id and, for parallel tasks, task.
+  std::map<std::tuple<Group*, uint64_t, size_t>, Sequence> sequences_;
+
+  std::vector<size_t> roots_;
+  std::vector<std::vector<size_t>> children_;
+  std::vector<Sequence*> sequence_of_task_;
+
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+  // Breaks ties between events and between sequences, for determinism.
+  uint64_t next_order_ = 0;
+  TimeDelta now_;
+
+  std::vector<TaskTraceSimulator::TaskResult> results_;
+  std::map<std::string, TimeDelta> busy_time_by_target_;
+};
+
+}  // namespace
+
+constexpr char TaskTraceSimulator::kThreadPoolTarget[];
+
+TaskTraceSimulator::Report::Report() = default;
+TaskTraceSimulator::Report::Report(Report&&) = default;
+TaskTraceSimulator::Report& TaskTraceSimulator::Report::operator=(Report&&) =
+    default;
+TaskTraceSimulator::Report::~Report() = default;
+
+std::string TaskTraceSimulator::Report::ToString() const {
+  std::string output =
+      StringPrintf("end time: %.3f ms\n", end_time.InMillisecondsF());
+  AppendDelayStats("all", delays, &output);
+  for (const auto& target_and_stats : delays_by_target) {
+    AppendDelayStats(target_and_stats.first, target_and_stats.second, &output);
+    const auto busy_time = busy_time_by_target.find(target_and_stats.first);
+    if (busy_time != busy_time_by_target.end()) {
+      StringAppendF(&output, "%s: busy %.3f ms\n",
+                    target_and_stats.first.c_str(),
+                    busy_time->second.InMillisecondsF());
+    }
+  }
+  for (const auto& priority_and_stats : delays_by_priority) {
+    AppendDelayStats(TaskPriorityToString(priority_and_stats.first),
+                     priority_and_stats.second, &output);
+  }
+  return output;
+}
+
+// static
+absl::optional<std::vector<TaskTraceSimulator::TaskRecord>>
+TaskTraceSimulator::ParseTrace(StringPiece json) {
+  const absl::optional<Value> root = JSONReader::Read(json);
+  if (!root || !root->is_dict())
+    return absl::nullopt;
+  const Value* tasks = root->FindListKey("tasks");
+  if (!tasks)
+    return absl::nullopt;
+
+  std::vector<TaskRecord> trace;
+  std::map<uint64_t, size_t> index_of_id;
+  for (const Value& dict : tasks->GetList()) {
+    absl::optional<TaskRecord> record = ParseTaskRecord(dict);
+    if (!record || !index_of_id.emplace(record->id, trace.size()).second)
+      return absl::nullopt;
+    trace.push_back(std::move(*record));
+  }
+
+  std::vector<ptrdiff_t> parent_indices;
+  for (const TaskRecord& record : trace) {
+    if (record.parent == 0) {
+      parent_indices.push_back(-1);
+      continue;
+    }
+    const auto parent = index_of_id.find(record.parent);
+    if (parent == index_of_id.end())
+      return absl::nullopt;
+    parent_indices.push_back(static_cast<ptrdiff_t>(parent->second));
+  }
+  if (!HasNoCycle(parent_indices))
+    return absl::nullopt;
+  return trace;
+}
+
+// static
+absl::optional<std::vector<TaskTraceSimulator::TaskRecord>>
+TaskTraceSimulator::LoadTrace(const FilePath& path) {
+  std::string json;
+  if (!ReadFileToString(path, &json))
+    return absl::nullopt;
+  return ParseTrace(json);
+}
+
+TaskTraceSimulator::TaskTraceSimulator(const Options& options)
+    : options_(options) {}
+
+TaskTraceSimulator::~TaskTraceSimulator() = default;
+
+TaskTraceSimulator::Report TaskTraceSimulator::Run(
+    const std::vector<TaskRecord>& trace) const {
+  return Simulation(options_, trace).Run();
+}
+
+}  // namespace test
+}  // namespace base
@@ -0,0 +1,166 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TEST_TASK_TRACE_SIMULATOR_H_
+#define BASE_TEST_TASK_TRACE_SIMULATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/strings/string_piece.h"
+#include "base/task/task_traits.h"
+#include "base/time/time.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+
+class FilePath;
+
+namespace test {
+
+// TaskTraceSimulator replays a recorded trace of tasks against a model of the
+// ThreadPool and of SequenceManager threads, driven by a single virtual clock.
+// Each task occupies a simulated worker for its recorded duration, so a trace
+// which took minutes to record replays in milliseconds, deterministically.
+// This allows measuring how the queueing delays of a workload change with the
+// number of workers or the scheduling policy, offline.
+//
+// The model follows the real schedulers:
+//  - Tasks which target the ThreadPool run on one of |num_foreground_workers|
+//    workers, or on one of |num_background_workers| workers if they are
+//    BEST_EFFORT and there are background workers. At most
+//    |max_best_effort_tasks| BEST_EFFORT tasks run concurrently per group.
+//  - Tasks which target any other named thread run on a single worker, like
+//    the tasks of a SequenceManager.
+//  - Tasks in the same sequence run one at a time, in posting order. A
+//    sequence is ordered in its group by the priority and ready time of its
+//    next task.
+//
+// Trace files are JSON:
+//   {
+//     "tasks": [
+//       {
+//         "id": 1,                       // Unique and non-zero.
+//         "target": "thread_pool",       // Or the name of a thread.
+//         "sequence": 3,                 // Optional, see TaskRecord.
+//         "priority": "USER_VISIBLE",    // Optional, see TaskPriority.
+//         "post_time_us": 1000,          // See TaskRecord.
+//         "delay_us": 0,                 // Optional.
+//         "duration_us": 250,
+//         "parent": 0                    // Optional, see TaskRecord.
+//       },
+//       ...
+//     ]
+//   }
+class TaskTraceSimulator {
+ public:
+  // Name of the target of tasks posted to the ThreadPool.
+  static constexpr char kThreadPoolTarget[] = "thread_pool";
+
+  enum class SchedulingPolicy {
+    // Sequences with a higher priority run first, then those which became
+    // ready first. This is the policy of ThreadGroup and TaskQueueSelector.
+    kPriority,
+    // Sequences run in the order in which they became ready, regardless of
+    // priority.
+    kFifo,
+  };
+
+  struct Options {
+    size_t num_foreground_workers = 4;
+    // If 0, BEST_EFFORT ThreadPool tasks run on the foreground workers.
+    size_t num_background_workers = 0;
+    size_t max_best_effort_tasks = 2;
+    SchedulingPolicy thread_pool_policy = SchedulingPolicy::kPriority;
+    SchedulingPolicy thread_policy = SchedulingPolicy::kPriority;
+  };
+
+  struct TaskRecord {
+    uint64_t id = 0;
+    std::string target = kThreadPoolTarget;
+    // Tasks with the same non-zero |sequence| and |target| run in sequence.
+    // ThreadPool tasks with a zero |sequence| are parallel; tasks posted to a
+    // thread with a zero |sequence| share its default queue.
+    uint64_t sequence = 0;
+    TaskPriority priority = TaskPriority::USER_VISIBLE;
+    // Time at which the task is posted, relative to the start of the trace, or
+    // to the start of |parent| if it is not zero.
+    TimeDelta post_time;
+    TimeDelta delay;
+    TimeDelta duration;
+    // Id of the task which posted this task, or 0. Child tasks are posted
+    // relative to the simulated start of their parent, so that the causal
+    // chains of the trace stretch when their tasks are delayed.
+    uint64_t parent = 0;
+  };
+
+  // Times relative to the start of the trace.
+  struct TaskResult {
+    TimeDelta ready_time;
+    TimeDelta start_time;
+    TimeDelta end_time;
+
+    TimeDelta queueing_delay() const { return start_time - ready_time; }
+  };
+
+  struct DelayStats {
+    size_t num_tasks = 0;
+    TimeDelta mean;
+    TimeDelta percentile_50;
+    TimeDelta percentile_90;
+    TimeDelta percentile_99;
+    TimeDelta max;
+  };
+
+  struct Report {
+    Report();
+    Report(Report&&);
+    Report& operator=(Report&&);
+    ~Report();
+
+    // Returns a human readable summary of the report.
+    std::string ToString() const;
+
+    // Time at which the last task completed.
+    TimeDelta end_time;
+    // Queueing delays, excluding the delay with which tasks were posted.
+    DelayStats delays;
+    std::map<std::string, DelayStats> delays_by_target;
+    std::map<TaskPriority, DelayStats> delays_by_priority;
+    // Time during which workers were busy, per target.
+    std::map<std::string, TimeDelta> busy_time_by_target;
+    // Results of the tasks, in the order of the trace.
+    std::vector<TaskResult> task_results;
+  };
+
+  // Parses a trace in the format described above. Returns nullopt if |json| is
+  // malformed, if ids are duplicated or if a parent doesn't exist or is a
+  // descendant of its child.
+  static absl::optional<std::vector<TaskRecord>> ParseTrace(StringPiece json);
+
+  // Reads and parses the trace at |path|.
+  static absl::optional<std::vector<TaskRecord>> LoadTrace(
+      const FilePath& path);
+
+  explicit TaskTraceSimulator(const Options& options);
+  TaskTraceSimulator(const TaskTraceSimulator&) = delete;
+  TaskTraceSimulator& operator=(const TaskTraceSimulator&) = delete;
+  ~TaskTraceSimulator();
+
+  // Replays |trace|, which must be valid as per ParseTrace(), until all its
+  // tasks completed.
+  Report Run(const std::vector<TaskRecord>& trace) const;
+
+ private:
+  const Options options_;
+};
+
+}  // namespace test
+}  // namespace base
+
+#endif  // BASE_TEST_TASK_TRACE_SIMULATOR_H_
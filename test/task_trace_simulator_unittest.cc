@@ -0,0 +1,280 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/test/task_trace_simulator.h"
+
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace test {
+
+namespace {
+
+using TaskRecord = TaskTraceSimulator::TaskRecord;
+using SchedulingPolicy = TaskTraceSimulator::SchedulingPolicy;
+
+constexpr char kMainThread[] = "main";
+
+TaskRecord CreateTask(uint64_t id,
+                      TimeDelta post_time,
+                      TimeDelta duration,
+                      TaskPriority priority = TaskPriority::USER_VISIBLE) {
+  TaskRecord record;
+  record.id = id;
+  record.post_time = post_time;
+  record.duration = duration;
+  record.priority = priority;
+  return record;
+}
+
+TaskTraceSimulator::Options CreateOptions(size_t num_foreground_workers) {
+  TaskTraceSimulator::Options options;
+  options.num_foreground_workers = num_foreground_workers;
+  return options;
+}
+
+constexpr TimeDelta kMs = TimeDelta::FromMilliseconds(1);
+
+}  // namespace
+
+TEST(TaskTraceSimulatorTest, ParseTrace) {
+  const auto trace = TaskTraceSimulator::ParseTrace(R"({
+    "tasks": [
+      {"id": 1, "post_time_us": 10, "duration_us": 100},
+      {"id": 2, "target": "main", "sequence": 3, "priority": "USER_BLOCKING",
+       "post_time_us": 5, "delay_us": 20, "duration_us": 7, "parent": 1}
+    ]
+  })");
+  ASSERT_TRUE(trace);
+  ASSERT_EQ(2u, trace->size());
+
+  EXPECT_EQ(1u, (*trace)[0].id);
+  EXPECT_EQ(TaskTraceSimulator::kThreadPoolTarget, (*trace)[0].target);
+  EXPECT_EQ(0u, (*trace)[0].sequence);
+  EXPECT_EQ(TaskPriority::USER_VISIBLE, (*trace)[0].priority);
+  EXPECT_EQ(TimeDelta::FromMicroseconds(10), (*trace)[0].post_time);
+  EXPECT_EQ(TimeDelta(), (*trace)[0].delay);
+  EXPECT_EQ(TimeDelta::FromMicroseconds(100), (*trace)[0].duration);
+  EXPECT_EQ(0u, (*trace)[0].parent);
+
+  EXPECT_EQ(2u, (*trace)[1].id);
+  EXPECT_EQ(kMainThread, (*trace)[1].target);
+  EXPECT_EQ(3u, (*trace)[1].sequence);
+  EXPECT_EQ(TaskPriority::USER_BLOCKING, (*trace)[1].priority);
+  EXPECT_EQ(TimeDelta::FromMicroseconds(5), (*trace)[1].post_time);
+  EXPECT_EQ(TimeDelta::FromMicroseconds(20), (*trace)[1].delay);
+  EXPECT_EQ(TimeDelta::FromMicroseconds(7), (*trace)[1].duration);
+  EXPECT_EQ(1u, (*trace)[1].parent);
+}
+
+TEST(TaskTraceSimulatorTest, ParseInvalidTrace) {
+  const char* const kInvalidTraces[] = {
+      "",
+      "[]",
+      R"({"tasks": {}})",
+      // Missing id, duration or post time.
+      R"({"tasks": [{"post_time_us": 0, "duration_us": 1}]})",
+      R"({"tasks": [{"id": 1, "post_time_us": 0}]})",
+      R"({"tasks": [{"id": 1, "duration_us": 1}]})",
+      // Zero id, negative or fractional time.
+      R"({"tasks": [{"id": 0, "post_time_us": 0, "duration_us": 1}]})",
+      R"({"tasks": [{"id": 1, "post_time_us": -1, "duration_us": 1}]})",
+      R"({"tasks": [{"id": 1, "post_time_us": 0.5, "duration_us": 1}]})",
+      // Unknown priority.
+      R"({"tasks": [{"id": 1, "post_time_us": 0, "duration_us": 1,
+                     "priority": "HIGH"}]})",
+      // Duplicate id.
+      R"({"tasks": [{"id": 1, "post_time_us": 0, "duration_us": 1},
+                    {"id": 1, "post_time_us": 0, "duration_us": 1}]})",
+      // Unknown parent.
+      R"({"tasks": [{"id": 1, "post_time_us": 0, "duration_us": 1,
+                     "parent": 2}]})",
+      // Cycle.
+      R"({"tasks": [{"id": 1, "post_time_us": 0, "duration_us": 1,
+                     "parent": 2},
+                    {"id": 2, "post_time_us": 0, "duration_us": 1,
+                     "parent": 1}]})",
+  };
+  for (const char* trace : kInvalidTraces)
+    EXPECT_FALSE(TaskTraceSimulator::ParseTrace(trace)) << trace;
+}
+
+TEST(TaskTraceSimulatorTest, LoadTrace) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const FilePath path = temp_dir.GetPath().AppendASCII("trace.json");
+  ASSERT_TRUE(WriteFile(
+      path, R"({"tasks": [{"id": 1, "post_time_us": 0, "duration_us": 1}]})"));
+
+  const auto trace = TaskTraceSimulator::LoadTrace(path);
+  ASSERT_TRUE(trace);
+  EXPECT_EQ(1u, trace->size());
+  EXPECT_FALSE(
+      TaskTraceSimulator::LoadTrace(temp_dir.GetPath().AppendASCII("none")));
+}
+
+// Verifies that tasks wait for a free worker.
+TEST(TaskTraceSimulatorTest, ThreadPoolWorkers) {
+  std::vector<TaskRecord> trace;
+  for (uint64_t id = 1; id <= 4; ++id)
+    trace.push_back(CreateTask(id, TimeDelta(), 10 * kMs));
+
+  const auto report = TaskTraceSimulator(CreateOptions(2)).Run(trace);
+  EXPECT_EQ(20 * kMs, report.end_time);
+  EXPECT_EQ(TimeDelta(), report.task_results[0].start_time);
+  EXPECT_EQ(TimeDelta(), report.task_results[1].start_time);
+  EXPECT_EQ(10 * kMs, report.task_results[2].start_time);
+  EXPECT_EQ(10 * kMs, report.task_results[3].start_time);
+
+  EXPECT_EQ(4u, report.delays.num_tasks);
+  EXPECT_EQ(5 * kMs, report.delays.mean);
+  EXPECT_EQ(TimeDelta(), report.delays.percentile_50);
+  EXPECT_EQ(10 * kMs, report.delays.percentile_90);
+  EXPECT_EQ(10 * kMs, report.delays.max);
+  const std::string thread_pool = TaskTraceSimulator::kThreadPoolTarget;
+  EXPECT_EQ(4u, report.delays_by_target.at(thread_pool).num_tasks);
+  EXPECT_EQ(40 * kMs, report.busy_time_by_target.at(thread_pool));
+
+  // With more workers, no task waits.
+  const auto report_more_workers =
+      TaskTraceSimulator(CreateOptions(4)).Run(trace);
+  EXPECT_EQ(10 * kMs, report_more_workers.end_time);
+  EXPECT_EQ(TimeDelta(), report_more_workers.delays.max);
+}
+
+// Verifies that the delay of a delayed task isn't counted as queueing delay.
+TEST(TaskTraceSimulatorTest, DelayedTask) {
+  std::vector<TaskRecord> trace = {CreateTask(1, TimeDelta(), 10 * kMs),
+                                   CreateTask(2, 2 * kMs, 1 * kMs)};
+  trace[1].delay = 5 * kMs;
+
+  const auto report = TaskTraceSimulator(CreateOptions(1)).Run(trace);
+  EXPECT_EQ(7 * kMs, report.task_results[1].ready_time);
+  EXPECT_EQ(10 * kMs, report.task_results[1].start_time);
+  EXPECT_EQ(3 * kMs, report.task_results[1].queueing_delay());
+}
+
+TEST(TaskTraceSimulatorTest, SchedulingPolicy) {
+  // A BEST_EFFORT task and then a USER_BLOCKING task are posted while the only
+  // worker is busy.
+  std::vector<TaskRecord> trace = {
+      CreateTask(1, TimeDelta(), 10 * kMs),
+      CreateTask(2, 1 * kMs, 1 * kMs, TaskPriority::BEST_EFFORT),
+      CreateTask(3, 2 * kMs, 1 * kMs, TaskPriority::USER_BLOCKING)};
+
+  auto options = CreateOptions(1);
+  const auto priority_report = TaskTraceSimulator(options).Run(trace);
+  EXPECT_EQ(10 * kMs, priority_report.task_results[2].start_time);
+  EXPECT_EQ(11 * kMs, priority_report.task_results[1].start_time);
+  EXPECT_EQ(
+      8 * kMs,
+      priority_report.delays_by_priority.at(TaskPriority::USER_BLOCKING).max);
+
+  options.thread_pool_policy = SchedulingPolicy::kFifo;
+  const auto fifo_report = TaskTraceSimulator(options).Run(trace);
+  EXPECT_EQ(10 * kMs, fifo_report.task_results[1].start_time);
+  EXPECT_EQ(11 * kMs, fifo_report.task_results[2].start_time);
+}
+
+// Verifies that tasks of a sequence don't run concurrently.
+TEST(TaskTraceSimulatorTest, Sequence) {
+  std::vector<TaskRecord> trace;
+  for (uint64_t id = 1; id <= 3; ++id) {
+    trace.push_back(CreateTask(id, TimeDelta(), 10 * kMs));
+    trace.back().sequence = 1;
+  }
+  trace.push_back(CreateTask(4, TimeDelta(), 10 * kMs));
+
+  const auto report = TaskTraceSimulator(CreateOptions(4)).Run(trace);
+  EXPECT_EQ(TimeDelta(), report.task_results[0].start_time);
+  EXPECT_EQ(10 * kMs, report.task_results[1].start_time);
+  EXPECT_EQ(20 * kMs, report.task_results[2].start_time);
+  EXPECT_EQ(TimeDelta(), report.task_results[3].start_time);
+  EXPECT_EQ(30 * kMs, report.end_time);
+}
+
+// Verifies that tasks which target a thread run on a single worker, in
+// parallel with the ThreadPool.
+TEST(TaskTraceSimulatorTest, Thread) {
+  std::vector<TaskRecord> trace;
+  for (uint64_t id = 1; id <= 2; ++id) {
+    trace.push_back(CreateTask(id, TimeDelta(), 10 * kMs));
+    trace.back().target = kMainThread;
+  }
+  trace.push_back(CreateTask(3, TimeDelta(), 10 * kMs));
+
+  const auto report = TaskTraceSimulator(CreateOptions(4)).Run(trace);
+  EXPECT_EQ(TimeDelta(), report.task_results[0].start_time);
+  EXPECT_EQ(10 * kMs, report.task_results[1].start_time);
+  EXPECT_EQ(TimeDelta(), report.task_results[2].start_time);
+  EXPECT_EQ(10 * kMs, report.delays_by_target.at(kMainThread).max);
+  EXPECT_EQ(20 * kMs, report.busy_time_by_target.at(kMainThread));
+}
+
+// Verifies that child tasks are posted relative to the simulated start of
+// their parent.
+TEST(TaskTraceSimulatorTest, ChildTask) {
+  std::vector<TaskRecord> trace = {CreateTask(1, TimeDelta(), 10 * kMs),
+                                   CreateTask(2, TimeDelta(), 1 * kMs),
+                                   CreateTask(3, 3 * kMs, 1 * kMs)};
+  trace[2].parent = 2;
+  trace[2].target = kMainThread;
+
+  const auto report = TaskTraceSimulator(CreateOptions(1)).Run(trace);
+  EXPECT_EQ(10 * kMs, report.task_results[1].start_time);
+  EXPECT_EQ(13 * kMs, report.task_results[2].ready_time);
+  EXPECT_EQ(13 * kMs, report.task_results[2].start_time);
+  EXPECT_EQ(14 * kMs, report.end_time);
+}
+
+TEST(TaskTraceSimulatorTest, MaxBestEffortTasks) {
+  std::vector<TaskRecord> trace;
+  for (uint64_t id = 1; id <= 3; ++id) {
+    trace.push_back(
+        CreateTask(id, TimeDelta(), 10 * kMs, TaskPriority::BEST_EFFORT));
+  }
+  trace.push_back(CreateTask(4, 1 * kMs, 10 * kMs));
+
+  auto options = CreateOptions(4);
+  options.max_best_effort_tasks = 1;
+  const auto report = TaskTraceSimulator(options).Run(trace);
+  EXPECT_EQ(TimeDelta(), report.task_results[0].start_time);
+  EXPECT_EQ(10 * kMs, report.task_results[1].start_time);
+  EXPECT_EQ(20 * kMs, report.task_results[2].start_time);
+  EXPECT_EQ(1 * kMs, report.task_results[3].start_time);
+}
+
+// Verifies that BEST_EFFORT ThreadPool tasks run on the background workers
+// when there are some.
+TEST(TaskTraceSimulatorTest, BackgroundWorkers) {
+  std::vector<TaskRecord> trace = {
+      CreateTask(1, TimeDelta(), 10 * kMs),
+      CreateTask(2, TimeDelta(), 10 * kMs, TaskPriority::BEST_EFFORT)};
+
+  auto options = CreateOptions(1);
+  const auto shared_report = TaskTraceSimulator(options).Run(trace);
+  EXPECT_EQ(10 * kMs, shared_report.task_results[1].start_time);
+
+  options.num_background_workers = 1;
+  const auto background_report = TaskTraceSimulator(options).Run(trace);
+  EXPECT_EQ(TimeDelta(), background_report.task_results[1].start_time);
+  EXPECT_EQ(10 * kMs, background_report.end_time);
+}
+
+TEST(TaskTraceSimulatorTest, ReportToString) {
+  const std::vector<TaskRecord> trace = {CreateTask(1, TimeDelta(), kMs)};
+  const std::string output =
+      TaskTraceSimulator(CreateOptions(1)).Run(trace).ToString();
+  EXPECT_NE(std::string::npos, output.find("end time: 1.000 ms"));
+  EXPECT_NE(std::string::npos, output.find("thread_pool: 1 tasks"));
+  EXPECT_NE(std::string::npos, output.find("USER_VISIBLE: 1 tasks"));
+}
+
+}  // namespace test
+}  // namespace base
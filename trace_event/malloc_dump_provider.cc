@@ -312,6 +312,10 @@ void MemoryDumpPartitionStatsDumper::PartitionDumpTotals(
                             memory_stats->total_decommittable_bytes);
   allocator_dump->AddScalar("discardable_size", "bytes",
                             memory_stats->total_discardable_bytes);
+  allocator_dump->AddScalar("huge_page_advised_size", "bytes",
+                            memory_stats->total_huge_page_advised_bytes);
+  allocator_dump->AddScalar("huge_page_backed_size", "bytes",
+                            memory_stats->total_huge_page_backed_bytes);
 #if BUILDFLAG(USE_BACKUP_REF_PTR)
   allocator_dump->AddScalar("brp_quarantined_size", "bytes",
                             memory_stats->total_brp_quarantined_bytes);
@@ -395,8 +399,10 @@ void ReportPartitionAllocThreadCacheStats(ProcessMemoryDump* pmd,
   dump->AddScalar("cache_fill_misses", "scalar", stats.cache_fill_misses);
 
   dump->AddScalar("batch_fill_count", "scalar", stats.batch_fill_count);
+  dump->AddScalar("batch_free_count", "scalar", stats.batch_free_count);
 
   dump->AddScalar("size", "bytes", stats.bucket_total_memory);
+  dump->AddScalar("free_batch_size", "bytes", stats.free_batch_memory);
   dump->AddScalar("metadata_overhead", "bytes", stats.metadata_overhead);
 
   if (stats.alloc_count) {
@@ -20,6 +20,12 @@ class BASE_EXPORT UpdateableSequencedTaskRunner : public SequencedTaskRunner {
   // |priority|.
   virtual void UpdatePriority(TaskPriority priority) = 0;
 
+  // Raises the priority of tasks posted through this TaskRunner to at least
+  // |priority| until a matching call to RemovePriorityBoost(), without changing
+  // the priority set by UpdatePriority(). Prefer ScopedSequencePriorityBoost.
+  virtual void AddPriorityBoost(TaskPriority priority) = 0;
+  virtual void RemovePriorityBoost(TaskPriority priority) = 0;
+
  protected:
   UpdateableSequencedTaskRunner() = default;
   ~UpdateableSequencedTaskRunner() override = default;